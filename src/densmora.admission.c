@@ -0,0 +1,548 @@
+/***************************************************************************************
+ * File: densmora.admission.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		admit background launches. When a limit is set, runBackground asks
+ * 		deferBackgroundLaunch before each launch, which delays it (keeping a
+ * 		copy of the command in a queue) while the pressure on the cpu,
+ * 		memory, or io is over its threshold, or while launches exceed the
+ * 		rate allowed by a token bucket, or while no jobserver token is
+ * 		available (see densmora.jobserver.c). The queue is released, oldest
+ * 		first, once launches are admitted again: by a timer after the wait
+ * 		for the next bucket token or at the next pressure check, or once the
+ * 		jobserver's pool becomes readable. Pressure is the share of time
+ * 		some tasks were stalled over the last 10 seconds, read from
+ * 		/proc/pressure; without it, cpu pressure is the 1-minute load
+ * 		average per cpu and memory pressure is the share of memory that is
+ * 		not available. The files are kept open and read at most once per
+ * 		PRESSURE_SAMPLE_MS.
+ **************************************************************************************/
+
+#include "densmora.admission.h"
+#include "densmora.childProcesses.h"
+#include "densmora.jobserver.h"
+
+/* The admission controller, shared by every function in this file. It is global (rather than
+ * passed around like the other structs in smallsh) since its queue is released by a timer. */
+static struct AdmissionControl admission;
+
+/* Names of the resources in messages and in the names of their pressure files. */
+static const char* pressureNames[NUM_PRESSURE_RESOURCES] = { "cpu", "memory", "io" };
+
+
+/***************************************************************************************
+ * Function Name: initAdmission
+ * Description:	Receives the BackgroundCommands list. Reads the limits from the
+ * 		environment: SMALLSH_THROTTLE_CPU, SMALLSH_THROTTLE_MEMORY, and
+ * 		SMALLSH_THROTTLE_IO give the pressure (as a percentage) above which
+ * 		launches wait, and SMALLSH_LAUNCH_RATE the launches allowed per
+ * 		second, of which up to SMALLSH_LAUNCH_BURST (default the rate, and
+ * 		at least 1) may happen at once. Opens the files the pressure is read
+ * 		from. Launches are also limited while a jobserver is in use, so this
+ * 		is called after initJobserver. If no limit is set, launches are never
+ * 		delayed. Returns nothing.
+ **************************************************************************************/
+
+void initAdmission(struct BackgroundCommands* bgCommandsList)
+{
+	char* thresholdNames[NUM_PRESSURE_RESOURCES] = { "SMALLSH_THROTTLE_CPU", "SMALLSH_THROTTLE_MEMORY",
+							 "SMALLSH_THROTTLE_IO" };
+
+	memset(&admission, 0, sizeof(struct AdmissionControl));
+	admission.bgCommandsList = bgCommandsList;
+	admission.loadavgFd = -1;
+	admission.meminfoFd = -1;
+
+	/* Read the pressure thresholds, opening the pressure file of each resource that has one. */
+	for (int i = 0; i < NUM_PRESSURE_RESOURCES; i++)
+	{
+		admission.pressureFds[i] = -1;
+		admission.thresholds[i] = readThresholdSetting(thresholdNames[i]);
+		if (admission.thresholds[i] < 0)
+		{
+			continue;
+		}
+		admission.enabled = TRUE;
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/pressure/%s", pressureNames[i]);
+		admission.pressureFds[i] = raiseShellFd(open(path, O_RDONLY | O_CLOEXEC));
+	}
+
+	/* Without pressure information, fall back to the load average and available memory. */
+	if (admission.thresholds[PRESSURE_CPU] >= 0 && admission.pressureFds[PRESSURE_CPU] == -1)
+	{
+		admission.loadavgFd = raiseShellFd(open("/proc/loadavg", O_RDONLY | O_CLOEXEC));
+	}
+	if (admission.thresholds[PRESSURE_MEMORY] >= 0 && admission.pressureFds[PRESSURE_MEMORY] == -1)
+	{
+		admission.meminfoFd = raiseShellFd(open("/proc/meminfo", O_RDONLY | O_CLOEXEC));
+	}
+	if (admission.thresholds[PRESSURE_IO] >= 0 && admission.pressureFds[PRESSURE_IO] == -1)
+	{
+		fprintf(stderr, "SMALLSH_THROTTLE_IO: io pressure is not available, so it is ignored\n"); fflush(stderr);
+	}
+
+	/* Read the rate limit, starting with a full bucket. */
+	char* rateString = getenv("SMALLSH_LAUNCH_RATE");
+	char* burstString = getenv("SMALLSH_LAUNCH_BURST");
+	if (rateString != NULL && rateString[0] != '\0')
+	{
+		char* endPtr;
+		admission.launchRate = strtod(rateString, &endPtr);
+		if (*endPtr != '\0' || admission.launchRate <= 0)
+		{
+			fprintf(stderr, "SMALLSH_LAUNCH_RATE: must be a number of launches per second\n"); fflush(stderr);
+			admission.launchRate = 0;
+		}
+	}
+	if (admission.launchRate > 0)
+	{
+		admission.enabled = TRUE;
+		admission.burst = (admission.launchRate < 1) ? 1 : admission.launchRate;
+		if (burstString != NULL && burstString[0] != '\0')
+		{
+			char* endPtr;
+			double burst = strtod(burstString, &endPtr);
+			if (*endPtr != '\0' || burst < 1)
+			{
+				fprintf(stderr, "SMALLSH_LAUNCH_BURST: must be at least 1\n"); fflush(stderr);
+			}
+			else
+			{
+				admission.burst = burst;
+			}
+		}
+		admission.tokens = admission.burst;
+		clock_gettime(CLOCK_MONOTONIC, &admission.lastRefill);
+	}
+	if (isJobserverActive() == TRUE)
+	{
+		admission.enabled = TRUE;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: readThresholdSetting
+ * Description:	Receives the name of an environment variable holding a pressure
+ * 		threshold. Returns the threshold (a percentage from 0 to 100), or -1
+ * 		if it is not set (or invalid, after reporting it).
+ **************************************************************************************/
+
+double readThresholdSetting(char* name)
+{
+	char* value = getenv(name);
+	if (value == NULL || value[0] == '\0')
+	{
+		return -1;
+	}
+	char* endPtr;
+	double threshold = strtod(value, &endPtr);
+	if (*endPtr != '\0' || threshold < 0 || threshold > 100)
+	{
+		fprintf(stderr, "%s: must be a percentage from 0 to 100\n", name); fflush(stderr);
+		return -1;
+	}
+	return threshold;
+}
+
+
+/***************************************************************************************
+ * Function Name: deferBackgroundLaunch
+ * Description:	Called by runBackground before launching a command. Receives the
+ * 		command and its deadline (or NULL if it has none). If launches are not
+ * 		limited, or nothing is queued and the launch is admitted, returns
+ * 		FALSE so that the command is launched now. Otherwise, queues a copy of
+ * 		the command (and of its deadline) behind any launches
+ * 		already waiting, tells the user why it was delayed, makes sure a
+ * 		release is scheduled, and returns TRUE.
+ **************************************************************************************/
+
+int deferBackgroundLaunch(struct CommandInfo* myCommand, struct TimeoutRequest* timeoutRequest)
+{
+	char reason[128];
+	long waitUsec = 0;
+
+	if (admission.enabled == FALSE
+	    || (admission.head == NULL && checkAdmission(reason, sizeof(reason), &waitUsec) == TRUE))
+	{
+		return FALSE;
+	}
+	if (admission.head != NULL)
+	{
+		snprintf(reason, sizeof(reason), "%lu launch%s already delayed", shellStats.backgroundQueued,
+			 (shellStats.backgroundQueued == 1) ? "" : "es");
+	}
+
+	/* Queue a copy of the command and its deadline, which outlive the line they came from. */
+	struct QueuedLaunch* launch = (struct QueuedLaunch*)malloc(sizeof(struct QueuedLaunch));
+	launch->command = copyCommand(myCommand, 0);
+	launch->timeoutRequest = NULL;
+	if (timeoutRequest != NULL)
+	{
+		launch->timeoutRequest = (struct TimeoutRequest*)malloc(sizeof(struct TimeoutRequest));
+		*launch->timeoutRequest = *timeoutRequest;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &launch->queuedAt);
+	launch->next = NULL;
+	if (admission.tail == NULL)
+	{
+		admission.head = launch;
+	}
+	else
+	{
+		admission.tail->next = launch;
+	}
+	admission.tail = launch;
+	shellStats.backgroundQueued++;
+	fprintf(shellOutput, "background launch of %s delayed: %s\n", myCommand->commandArgs[0], reason); fflush(shellOutput);
+
+	if (admission.releaseTimer == NULL && admission.waitingForToken == FALSE)
+	{
+		scheduleRelease(waitUsec);
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: checkAdmission
+ * Description:	Receives a buffer for a reason, its size, and the address of a long.
+ * 		Decides whether a launch may happen now. If the pressure on a
+ * 		resource is over its threshold, no token is left in the bucket, or
+ * 		no jobserver token is available, writes the reason to the buffer,
+ * 		stores in *waitUsec how long to wait before asking again (-1 to wait
+ * 		for a jobserver token), and returns FALSE. Otherwise, takes a token
+ * 		from the bucket (if the rate is limited) and from the jobserver (if
+ * 		one is in use, to be attached to the job by attachJobToken), and
+ * 		returns TRUE.
+ **************************************************************************************/
+
+int checkAdmission(char* reason, int reasonSize, long* waitUsec)
+{
+	/* Wait while any resource is under too much pressure. */
+	samplePressure();
+	for (int i = 0; i < NUM_PRESSURE_RESOURCES; i++)
+	{
+		if (admission.thresholds[i] >= 0 && admission.pressure[i] > admission.thresholds[i])
+		{
+			snprintf(reason, reasonSize, "%s pressure %.1f%% is over %.1f%%", pressureNames[i],
+				 admission.pressure[i], admission.thresholds[i]);
+			*waitUsec = PRESSURE_RECHECK_MS * 1000L;
+			return FALSE;
+		}
+	}
+
+	/* Otherwise, wait for the next token if the bucket is empty. */
+	if (admission.launchRate > 0)
+	{
+		refillTokens();
+		if (admission.tokens < 1)
+		{
+			snprintf(reason, reasonSize, "more than %g launches per second", admission.launchRate);
+			*waitUsec = (long)((1 - admission.tokens) / admission.launchRate * 1000000) + 1;
+			return FALSE;
+		}
+	}
+
+	/* Otherwise, wait for a jobserver token if none is available. The bucket's token is only taken
+	 * once the launch is certain. */
+	if (isJobserverActive() == TRUE && acquireJobToken() == FALSE)
+	{
+		snprintf(reason, reasonSize, "waiting for a jobserver token");
+		*waitUsec = -1;
+		return FALSE;
+	}
+	if (admission.launchRate > 0)
+	{
+		admission.tokens -= 1;
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: samplePressure
+ * Description:	Reads the pressure on each resource that has a threshold, unless it
+ * 		was read less than PRESSURE_SAMPLE_MS ago. A resource whose pressure
+ * 		cannot be read is treated as under none. Receives and returns nothing.
+ **************************************************************************************/
+
+void samplePressure()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long elapsedMs = (now.tv_sec - admission.lastSample.tv_sec) * 1000
+			 + (now.tv_nsec - admission.lastSample.tv_nsec) / 1000000;
+	if (admission.lastSample.tv_sec != 0 && elapsedMs < PRESSURE_SAMPLE_MS)
+	{
+		return;
+	}
+	admission.lastSample = now;
+
+	for (int i = 0; i < NUM_PRESSURE_RESOURCES; i++)
+	{
+		admission.pressure[i] = 0;
+		if (admission.pressureFds[i] != -1)
+		{
+			admission.pressure[i] = readPsiAverage(admission.pressureFds[i]);
+		}
+	}
+	if (admission.loadavgFd != -1)
+	{
+		admission.pressure[PRESSURE_CPU] = readLoadPercent();
+	}
+	if (admission.meminfoFd != -1)
+	{
+		admission.pressure[PRESSURE_MEMORY] = readMemoryPercent();
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: readPsiAverage
+ * Description:	Receives an open /proc/pressure file. Returns the "some avg10" value
+ * 		in it (the percentage of the last 10 seconds in which at least one
+ * 		task was stalled on the resource), or 0 if it cannot be read.
+ **************************************************************************************/
+
+double readPsiAverage(int fd)
+{
+	char buffer[PRESSURE_READ_BYTES];
+	if (readProcFile(fd, buffer, sizeof(buffer)) == FALSE)
+	{
+		return 0;
+	}
+	char* average = strstr(buffer, "some avg10=");
+	return (average != NULL) ? strtod(average + strlen("some avg10="), NULL) : 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: readLoadPercent
+ * Description:	Returns the 1-minute load average as a percentage of the number of
+ * 		online cpus (so 100 means one runnable task per cpu), or 0 if it
+ * 		cannot be read.
+ **************************************************************************************/
+
+double readLoadPercent()
+{
+	char buffer[PRESSURE_READ_BYTES];
+	long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (readProcFile(admission.loadavgFd, buffer, sizeof(buffer)) == FALSE)
+	{
+		return 0;
+	}
+	return strtod(buffer, NULL) * 100 / ((numCpus > 0) ? numCpus : 1);
+}
+
+
+/***************************************************************************************
+ * Function Name: readMemoryPercent
+ * Description:	Returns the percentage of memory that is not available to new
+ * 		processes (from MemTotal and MemAvailable), or 0 if it cannot be read.
+ **************************************************************************************/
+
+double readMemoryPercent()
+{
+	char buffer[PRESSURE_READ_BYTES * 4];
+	if (readProcFile(admission.meminfoFd, buffer, sizeof(buffer)) == FALSE)
+	{
+		return 0;
+	}
+	char* total = strstr(buffer, "MemTotal:");
+	char* available = strstr(buffer, "MemAvailable:");
+	if (total == NULL || available == NULL)
+	{
+		return 0;
+	}
+	double totalKb = strtod(total + strlen("MemTotal:"), NULL);
+	double availableKb = strtod(available + strlen("MemAvailable:"), NULL);
+	return (totalKb > 0) ? 100 * (1 - availableKb / totalKb) : 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: readProcFile
+ * Description:	Receives an open /proc file, a buffer, and its size. Reads the start
+ * 		of the file into the buffer from offset 0 (so the file can be kept
+ * 		open and read again), null-terminating it. Returns TRUE, or FALSE if
+ * 		nothing could be read.
+ **************************************************************************************/
+
+int readProcFile(int fd, char* buffer, int bufferSize)
+{
+	ssize_t bytesRead = pread(fd, buffer, bufferSize - 1, 0);
+	if (bytesRead <= 0)
+	{
+		return FALSE;
+	}
+	buffer[bytesRead] = '\0';
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: refillTokens
+ * Description:	Adds the tokens earned at launchRate per second since the last refill,
+ * 		up to the size of the bucket. Receives and returns nothing.
+ **************************************************************************************/
+
+void refillTokens()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double elapsed = (now.tv_sec - admission.lastRefill.tv_sec) + (now.tv_nsec - admission.lastRefill.tv_nsec) / 1e9;
+	admission.lastRefill = now;
+	admission.tokens += elapsed * admission.launchRate;
+	if (admission.tokens > admission.burst)
+	{
+		admission.tokens = admission.burst;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: releaseQueuedLaunches
+ * Description:	Timer callback that launches delayed commands, oldest first, for as
+ * 		long as launches are admitted (starting the deadline of any launched
+ * 		by the timeout built-in), telling the user each one's pid and how
+ * 		long it waited. If any are still delayed, schedules the next attempt.
+ * 		Also called by onJobserverReadable. Receives an unused argument.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void releaseQueuedLaunches(void* arg)
+{
+	char reason[128];
+	long waitUsec;
+
+	/* The timer is freed once this returns. */
+	admission.releaseTimer = NULL;
+
+	while (admission.head != NULL)
+	{
+		if (checkAdmission(reason, sizeof(reason), &waitUsec) == FALSE)
+		{
+			scheduleRelease(waitUsec);
+			return;
+		}
+
+		/* Take the oldest launch off the queue and launch it. */
+		struct QueuedLaunch* launch = admission.head;
+		admission.head = launch->next;
+		if (admission.head == NULL)
+		{
+			admission.tail = NULL;
+		}
+		shellStats.backgroundQueued--;
+		struct BackgroundNode* newNode = launchBackground(launch->command, admission.bgCommandsList);
+		attachJobToken(admission.bgCommandsList, newNode);
+		if (newNode != NULL)
+		{
+			if (launch->timeoutRequest != NULL)
+			{
+				newNode->timeout = startJobTimeout(newNode->pid, launch->timeoutRequest);
+			}
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			double delayed = (now.tv_sec - launch->queuedAt.tv_sec) + (now.tv_nsec - launch->queuedAt.tv_nsec) / 1e9;
+			fprintf(shellOutput, "background pid is %d (delayed %.1f s)\n", (int)newNode->pid, delayed); fflush(shellOutput);
+		}
+		deleteCommand(launch->command);
+		free(launch->timeoutRequest);
+		free(launch);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: scheduleRelease
+ * Description:	Receives a number of microseconds. Sets the timer that releases the
+ * 		queue to fire after that long, or, if it is -1, releases the queue
+ * 		once the jobserver's pool may hold a token. Returns nothing.
+ **************************************************************************************/
+
+void scheduleRelease(long delayUsec)
+{
+	if (delayUsec == -1)
+	{
+		admission.waitingForToken = TRUE;
+		watchJobserver(onJobserverReadable);
+		return;
+	}
+	admission.releaseTimer = addTimer(delayUsec, releaseQueuedLaunches, NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: onJobserverReadable
+ * Description:	Event loop callback for the jobserver's pool while launches wait for
+ * 		a token. Receives the descriptor and an unused argument. Stops
+ * 		watching the pool and releases the queue (which watches it again if
+ * 		another process took the token first). Returns nothing.
+ **************************************************************************************/
+
+void onJobserverReadable(int fd, void* arg)
+{
+	admission.waitingForToken = FALSE;
+	stopWatchingJobserver();
+	releaseQueuedLaunches(NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: closeAdmission
+ * Description:	Cancels the pending release and discards every delayed launch
+ * 		(telling the user how many there were), and closes the pressure
+ * 		files. Called as the shell exits, before its jobs are stopped, so
+ * 		that nothing is launched meanwhile. Receives and returns nothing.
+ **************************************************************************************/
+
+void closeAdmission()
+{
+	if (admission.releaseTimer != NULL)
+	{
+		cancelTimer(admission.releaseTimer);
+		admission.releaseTimer = NULL;
+	}
+	if (admission.waitingForToken == TRUE)
+	{
+		stopWatchingJobserver();
+		admission.waitingForToken = FALSE;
+	}
+	if (shellStats.backgroundQueued > 0)
+	{
+		fprintf(shellOutput, "%lu delayed background launch%s discarded\n", shellStats.backgroundQueued,
+		       (shellStats.backgroundQueued == 1) ? "" : "es");
+		fflush(shellOutput);
+	}
+	while (admission.head != NULL)
+	{
+		struct QueuedLaunch* launch = admission.head;
+		admission.head = launch->next;
+		deleteCommand(launch->command);
+		free(launch->timeoutRequest);
+		free(launch);
+	}
+	admission.tail = NULL;
+	shellStats.backgroundQueued = 0;
+
+	for (int i = 0; i < NUM_PRESSURE_RESOURCES; i++)
+	{
+		if (admission.pressureFds[i] != -1)
+		{
+			close(admission.pressureFds[i]);
+		}
+	}
+	if (admission.loadavgFd != -1)
+	{
+		close(admission.loadavgFd);
+	}
+	if (admission.meminfoFd != -1)
+	{
+		close(admission.meminfoFd);
+	}
+	admission.enabled = FALSE;
+}
@@ -0,0 +1,93 @@
+/***************************************************************************************
+ * File: densmora.admission.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions that delay background launches while the host is under
+ * 		CPU, memory, or io pressure, while launches exceed a rate limit, or
+ * 		while no jobserver token is available, queueing them until they can be admitted. See densmora.admission.c
+ * 		for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_ADMISSION
+#define DENSMORA_ADMISSION
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.timers.h"
+#include "densmora.eventLoop.h"
+
+/* Resources whose pressure can delay launches, indexing the arrays below. */
+#define PRESSURE_CPU 0
+#define PRESSURE_MEMORY 1
+#define PRESSURE_IO 2
+#define NUM_PRESSURE_RESOURCES 3
+
+/* Minimum number of milliseconds between readings of the pressure files, so that a burst
+ * of launches reads them once. */
+#define PRESSURE_SAMPLE_MS 100
+
+/* Number of milliseconds between checks of the pressure while launches are held back by it
+ * (the kernel's shortest pressure average covers 10 seconds, so it falls gradually). */
+#define PRESSURE_RECHECK_MS 500
+
+/* Size of the buffer into which a pressure file is read. */
+#define PRESSURE_READ_BYTES 512
+
+/* Struct storing a background launch that was delayed. */
+
+struct QueuedLaunch
+{
+	struct CommandInfo* command;		/* Copy of the command to launch. */
+	struct TimeoutRequest* timeoutRequest;	/* Copy of its deadline set by the timeout built-in, or NULL. */
+	struct timespec queuedAt;		/* Time (CLOCK_MONOTONIC) at which it was delayed. */
+	struct QueuedLaunch* next;		/* Next launch in the queue. */
+};
+
+/* Struct storing the settings and state of the admission controller. */
+
+struct AdmissionControl
+{
+	int enabled;				/* Set to TRUE if any limit was set. */
+	double thresholds[NUM_PRESSURE_RESOURCES];	/* Percentages above which launches wait (-1 if unset). */
+	int pressureFds[NUM_PRESSURE_RESOURCES];	/* Open /proc/pressure files (-1 if unavailable). */
+	int loadavgFd;				/* Open /proc/loadavg, used for cpu without PSI (-1 if unavailable). */
+	int meminfoFd;				/* Open /proc/meminfo, used for memory without PSI (-1 if unavailable). */
+	double pressure[NUM_PRESSURE_RESOURCES];	/* Latest readings (percentages). */
+	struct timespec lastSample;		/* Time at which the readings were taken. */
+	double launchRate;			/* Launches allowed per second (0 for no limit). */
+	double burst;				/* Most launches allowed at once (size of the token bucket). */
+	double tokens;				/* Launches that may happen now. */
+	struct timespec lastRefill;		/* Time at which tokens was last brought up to date. */
+	struct QueuedLaunch* head;		/* Oldest delayed launch. */
+	struct QueuedLaunch* tail;		/* Newest delayed launch. */
+	struct Timer* releaseTimer;		/* Timer for the next attempt to release the queue, or NULL. */
+	int waitingForToken;			/* Set to TRUE while the queue waits for a jobserver token. */
+	struct BackgroundCommands* bgCommandsList;	/* List to which released launches are added. */
+};
+
+/* Function prototypes (see densmora.admission.c for function descriptions and implementations). */
+void initAdmission(struct BackgroundCommands* bgCommandsList);
+double readThresholdSetting(char* name);
+int deferBackgroundLaunch(struct CommandInfo* myCommand, struct TimeoutRequest* timeoutRequest);
+int checkAdmission(char* reason, int reasonSize, long* waitUsec);
+void samplePressure();
+double readPsiAverage(int fd);
+double readLoadPercent();
+double readMemoryPercent();
+int readProcFile(int fd, char* buffer, int bufferSize);
+void refillTokens();
+void releaseQueuedLaunches(void* arg);
+void scheduleRelease(long delayUsec);
+void onJobserverReadable(int fd, void* arg);
+void closeAdmission();
+
+#endif
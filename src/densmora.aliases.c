@@ -0,0 +1,337 @@
+/***************************************************************************************
+ * File: densmora.aliases.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		maintain the shell's aliases. Aliases live in a hash table keyed by
+ * 		name, and each value is stored already split into words joined by
+ * 		single spaces, so that expanding the first word of a command is one
+ * 		lookup and one copy. The value's first word is expanded in turn (but
+ * 		never an alias already used in the same expansion, so an alias such
+ * 		as ls=ls -F works).
+ **************************************************************************************/
+
+#include "densmora.aliases.h"
+
+/* Aliases defined in the shell. */
+static struct AliasTable aliasTable;
+
+
+/***************************************************************************************
+ * Function Name: initAliases
+ * Description:	Creates the empty hash table. Receives and returns nothing.
+ **************************************************************************************/
+
+void initAliases()
+{
+	aliasTable.numBuckets = INITIAL_ALIAS_BUCKETS;
+	aliasTable.buckets = (struct Alias**)calloc(aliasTable.numBuckets, sizeof(struct Alias*));
+	aliasTable.numAliases = 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: hashAliasName
+ * Description:	Receives an alias name and its length (the name need not be
+ * 		null-terminated). Returns its FNV-1a hash.
+ **************************************************************************************/
+
+unsigned int hashAliasName(const char* name, int nameLength)
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < nameLength; i++)
+	{
+		hash ^= (unsigned char)name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/***************************************************************************************
+ * Function Name: findAlias
+ * Description:	Receives an alias name, its length, and its hash. Returns the address
+ * 		of the link pointing at the alias (so that it can be replaced or
+ * 		removed), which holds NULL if there is no such alias.
+ **************************************************************************************/
+
+struct Alias** findAlias(const char* name, int nameLength, unsigned int hash)
+{
+	struct Alias** link = &aliasTable.buckets[hash & (aliasTable.numBuckets - 1)];
+	while (*link != NULL
+	       && ((*link)->hash != hash || strncmp((*link)->name, name, nameLength) != 0
+		   || (*link)->name[nameLength] != '\0'))
+	{
+		link = &(*link)->next;
+	}
+	return link;
+}
+
+
+/***************************************************************************************
+ * Function Name: getAlias
+ * Description:	Receives a word and its length (the word need not be null-terminated,
+ * 		so the first word of a command can be looked up in place). Returns the
+ * 		alias with that name, or NULL if there is none.
+ **************************************************************************************/
+
+struct Alias* getAlias(const char* name, int nameLength)
+{
+	if (aliasTable.numAliases == 0)
+	{
+		return NULL;
+	}
+	return *findAlias(name, nameLength, hashAliasName(name, nameLength));
+}
+
+
+/***************************************************************************************
+ * Function Name: setAlias
+ * Description:	Receives an alias name and the NULL-terminated words of its value.
+ * 		Defines the alias, replacing any earlier value. Returns nothing.
+ **************************************************************************************/
+
+void setAlias(const char* name, char** words)
+{
+	int nameLength = strlen(name);
+	unsigned int hash = hashAliasName(name, nameLength);
+	struct Alias** link = findAlias(name, nameLength, hash);
+
+	/* Join the words with single spaces. */
+	int valueLength = 0;
+	for (int i = 0; words[i] != NULL; i++)
+	{
+		valueLength += strlen(words[i]) + ((i > 0) ? 1 : 0);
+	}
+	char* value = (char*)malloc(valueLength + 1);
+	char* valueEnd = value;
+	for (int i = 0; words[i] != NULL; i++)
+	{
+		if (i > 0)
+		{
+			*valueEnd++ = ' ';
+		}
+		valueEnd = stpcpy(valueEnd, words[i]);
+	}
+	*valueEnd = '\0';
+
+	/* Replace the value of an existing alias. */
+	if (*link != NULL)
+	{
+		free((*link)->value);
+	}
+
+	/* Otherwise, add a new alias to the front of its bucket, growing the table if it is getting full. */
+	else
+	{
+		struct Alias* alias;
+		alias = (struct Alias*)malloc(sizeof(struct Alias));
+		alias->name = strdup(name);
+		alias->hash = hash;
+		alias->next = *link;
+		*link = alias;
+		aliasTable.numAliases++;
+		if (aliasTable.numAliases > aliasTable.numBuckets)
+		{
+			growAliasTable();
+			link = findAlias(name, nameLength, hash);
+		}
+	}
+	(*link)->value = value;
+	(*link)->valueLength = valueLength;
+}
+
+
+/***************************************************************************************
+ * Function Name: unsetAlias
+ * Description:	Receives an alias name. Removes the alias. Returns TRUE if it existed,
+ * 		or FALSE otherwise.
+ **************************************************************************************/
+
+int unsetAlias(const char* name)
+{
+	int nameLength = strlen(name);
+	struct Alias** link = findAlias(name, nameLength, hashAliasName(name, nameLength));
+	if (*link == NULL)
+	{
+		return FALSE;
+	}
+	struct Alias* alias = *link;
+	*link = alias->next;
+	free(alias->name);
+	free(alias->value);
+	free(alias);
+	aliasTable.numAliases--;
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: clearAliases
+ * Description:	Removes every alias. Receives and returns nothing.
+ **************************************************************************************/
+
+void clearAliases()
+{
+	for (int i = 0; i < aliasTable.numBuckets; i++)
+	{
+		while (aliasTable.buckets[i] != NULL)
+		{
+			struct Alias* alias = aliasTable.buckets[i];
+			aliasTable.buckets[i] = alias->next;
+			free(alias->name);
+			free(alias->value);
+			free(alias);
+		}
+	}
+	aliasTable.numAliases = 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: growAliasTable
+ * Description:	Doubles the number of buckets and moves every alias to its new
+ * 		bucket (using its stored hash). Receives and returns nothing.
+ **************************************************************************************/
+
+void growAliasTable()
+{
+	int newNumBuckets = 2 * aliasTable.numBuckets;
+	struct Alias** newBuckets = (struct Alias**)calloc(newNumBuckets, sizeof(struct Alias*));
+
+	for (int i = 0; i < aliasTable.numBuckets; i++)
+	{
+		struct Alias* alias = aliasTable.buckets[i];
+		while (alias != NULL)
+		{
+			struct Alias* nextAlias = alias->next;
+			alias->next = newBuckets[alias->hash & (newNumBuckets - 1)];
+			newBuckets[alias->hash & (newNumBuckets - 1)] = alias;
+			alias = nextAlias;
+		}
+	}
+	free(aliasTable.buckets);
+	aliasTable.buckets = newBuckets;
+	aliasTable.numBuckets = newNumBuckets;
+}
+
+
+/***************************************************************************************
+ * Function Name: isValidAliasName
+ * Description:	Receives a word. Returns TRUE if it can name an alias (it is not empty,
+ * 		is not a list operator, and contains no "/" or "$"), or FALSE
+ * 		otherwise.
+ **************************************************************************************/
+
+int isValidAliasName(const char* name)
+{
+	if (name[0] == '\0' || name[0] == '#' || strpbrk(name, "/$;") != NULL
+	    || strcmp(name, "&&") == 0 || strcmp(name, "||") == 0 || strcmp(name, "&") == 0)
+	{
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: expandAlias
+ * Description:	Receives the text of one command (words separated by single spaces).
+ * 		If the first word is an alias, returns a new string (which the caller
+ * 		must free) with the word replaced by the alias's value, repeating for
+ * 		the first word of the result while it is an alias not yet used in
+ * 		this expansion. Returns NULL if the first word is not an alias.
+ **************************************************************************************/
+
+char* expandAlias(char* text)
+{
+	struct Alias* chain[MAX_ALIAS_DEPTH];
+	int chainLength = 0;
+	char* expanded = NULL;
+	char* current = text;
+
+	while (chainLength < MAX_ALIAS_DEPTH)
+	{
+		/* Look up the first word in place, stopping if it is not an alias or was already expanded. */
+		int wordLength = strcspn(current, " ");
+		struct Alias* alias = getAlias(current, wordLength);
+		for (int i = 0; i < chainLength && alias != NULL; i++)
+		{
+			alias = (chain[i] == alias) ? NULL : alias;
+		}
+		if (alias == NULL)
+		{
+			break;
+		}
+
+		/* Substitute the value for the word, keeping the rest of the command as it is. */
+		char* rest = current + wordLength;
+		char* next = (char*)malloc(alias->valueLength + strlen(rest) + 1);
+		memcpy(next, alias->value, alias->valueLength);
+		strcpy(next + alias->valueLength, rest);
+		free(expanded);
+		expanded = current = next;
+		chain[chainLength++] = alias;
+	}
+	return expanded;
+}
+
+
+/***************************************************************************************
+ * Function Name: compareAliases
+ * Description:	qsort comparison function ordering alias pointers by name.
+ **************************************************************************************/
+
+static int compareAliases(const void* a, const void* b)
+{
+	return strcmp((*(struct Alias* const*)a)->name, (*(struct Alias* const*)b)->name);
+}
+
+
+/***************************************************************************************
+ * Function Name: printAlias
+ * Description:	Receives an alias. Prints it in the form accepted by the alias
+ * 		built-in. Returns nothing.
+ **************************************************************************************/
+
+void printAlias(struct Alias* alias)
+{
+	printf("alias %s=%s\n", alias->name, alias->value); fflush(stdout);
+}
+
+
+/***************************************************************************************
+ * Function Name: printAliases
+ * Description:	Prints every alias, sorted by name. Receives and returns nothing.
+ **************************************************************************************/
+
+void printAliases()
+{
+	struct Alias** sorted = (struct Alias**)malloc((aliasTable.numAliases + 1) * sizeof(struct Alias*));
+	int numSorted = 0;
+	for (int i = 0; i < aliasTable.numBuckets; i++)
+	{
+		for (struct Alias* alias = aliasTable.buckets[i]; alias != NULL; alias = alias->next)
+		{
+			sorted[numSorted++] = alias;
+		}
+	}
+	qsort(sorted, numSorted, sizeof(struct Alias*), compareAliases);
+	for (int i = 0; i < numSorted; i++)
+	{
+		printf("alias %s=%s\n", sorted[i]->name, sorted[i]->value);
+	}
+	fflush(stdout);
+	free(sorted);
+}
+
+
+/***************************************************************************************
+ * Function Name: countAliases
+ * Description:	Returns the number of aliases defined. Receives nothing.
+ **************************************************************************************/
+
+int countAliases()
+{
+	return aliasTable.numAliases;
+}
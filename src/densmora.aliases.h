@@ -0,0 +1,65 @@
+/***************************************************************************************
+ * File: densmora.aliases.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions that store the aliases defined with the alias
+ * 		built-in (usually from ~/.smallshrc) and expand them at the start of
+ * 		each command. See densmora.aliases.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_ALIASES
+#define DENSMORA_ALIASES
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* My own header file inclusion. */
+#include "densmora.smallshConstants.h"
+
+/* Initial number of buckets in the hash table (must be a power of 2; doubles as it fills). */
+#define INITIAL_ALIAS_BUCKETS 64
+
+/* Largest number of aliases expanded one after another at the start of a command. */
+#define MAX_ALIAS_DEPTH 16
+
+/* Struct storing one alias. The value is stored as it will be substituted (its words
+ * separated by single spaces), so expanding it never requires splitting it again. It
+ * cannot contain list operators, since they always end the alias command. */
+
+struct Alias
+{
+	char* name;				/* Word replaced by the alias. */
+	char* value;				/* Words substituted for the name. */
+	int valueLength;			/* Number of chars in value. */
+	unsigned int hash;			/* Hash of name. */
+	struct Alias* next;			/* Address of next alias in the same bucket. */
+};
+
+/* Struct storing every alias. */
+
+struct AliasTable
+{
+	struct Alias** buckets;			/* Chains of aliases, indexed by hash. */
+	int numBuckets;				/* Number of buckets (a power of 2). */
+	int numAliases;				/* Number of aliases defined. */
+};
+
+/* Function prototypes (see densmora.aliases.c for function descriptions and implementations). */
+void initAliases();
+unsigned int hashAliasName(const char* name, int nameLength);
+struct Alias** findAlias(const char* name, int nameLength, unsigned int hash);
+struct Alias* getAlias(const char* name, int nameLength);
+void setAlias(const char* name, char** words);
+int unsetAlias(const char* name);
+void clearAliases();
+void growAliasTable();
+int isValidAliasName(const char* name);
+char* expandAlias(char* text);
+void printAlias(struct Alias* alias);
+void printAliases();
+int countAliases();
+
+#endif
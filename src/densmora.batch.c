@@ -0,0 +1,470 @@
+/***************************************************************************************
+ * File: densmora.batch.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions behind
+ * 		the batch built-in. Items are read from the < file (or stdin) in
+ * 		large reads, one per line, and appended to the command's args until
+ * 		the next one would not fit in ARG_MAX (less the environment) or -n
+ * 		items have been gathered. Each batch is then forked off with its
+ * 		stdin set to /dev/null and tracked in the BackgroundCommands list
+ * 		(with an onDone handler, so it is reaped and logged like any job but
+ * 		not reported), and up to -P batches run at once. The exit statuses
+ * 		are combined like xargs: 0 if every invocation succeeded, 123 if any
+ * 		failed, or the signal of an invocation that was killed.
+ **************************************************************************************/
+
+#include "densmora.batch.h"
+
+
+/***************************************************************************************
+ * Function Name: runBatchCommand
+ * Description:	Receives a batch command whose commandArgs start with the command to
+ * 		run (the options having been removed), a BatchRun struct whose
+ * 		maxItems and maxJobs are set, the ForegroundExitMethod struct, and
+ * 		the BackgroundCommands list. Runs the command over every item and
+ * 		waits for all invocations to finish before storing their combined
+ * 		status. Returns nothing.
+ **************************************************************************************/
+
+void runBatchCommand(struct CommandInfo* myCommand, struct BatchRun* run, struct ForegroundExitMethod* lastFgStatus,
+		     struct BackgroundCommands* bgCommandsList)
+{
+	long maxItems = run->maxItems;
+	int maxJobs = run->maxJobs;
+
+	/* Start from a copy of the command with its own args vector, whose redirections are
+	 * handled by the shell (the < file holds the items, and the > file is shared by every invocation). */
+	memset(run, 0, sizeof(struct BatchRun));
+	run->maxItems = maxItems;
+	run->maxJobs = maxJobs;
+	run->command = *myCommand;
+	run->command.commandArgs = NULL;
+	run->command.argsCapacity = 0;
+	run->command.inputFlag = FALSE;
+	run->command.outputFlag = FALSE;
+	run->command.backgroundFlag = FALSE;
+	while (myCommand->commandArgs[run->numFixedArgs] != NULL)
+	{
+		run->numFixedArgs++;
+	}
+	growCommandArgs(&run->command, run->numFixedArgs + 1);
+	memcpy(run->command.commandArgs, myCommand->commandArgs, run->numFixedArgs * sizeof(char*));
+
+	/* Open the files, and make sure the command leaves room for at least a short item. */
+	if (openBatchFiles(myCommand, run) == FALSE)
+	{
+		free(run->command.commandArgs);
+		setExitMethod(lastFgStatus, 1 << 8);
+		return;
+	}
+	run->itemBytesLimit = getBatchItemBytesLimit(run);
+	if (run->itemBytesLimit <= (long)sizeof(char*) + 1)
+	{
+		fprintf(stderr, "batch: the command and environment leave no room for items\n"); fflush(stderr);
+		run->itemBytesLimit = 0;
+		run->stopped = TRUE;
+		run->numSkipped++;
+	}
+
+	/* Each item takes a pointer as well as its chars, so the copies always fit in itemBytesLimit bytes. */
+	run->readBuffer = (char*)malloc(BATCH_READ_BYTES + 1);
+	run->itemBuffer = (char*)malloc(run->itemBytesLimit + 1);
+
+	/* Gather and run the batches, sleeping in the event loop while waiting for a free slot,
+	 * and then wait for the last ones. SIGINT stops reading (the invocations receive it too). */
+	interruptOnSIGINT();
+	run->sigchldWatcher = addEventWatcher(sigchldPipe[0], wakeOnChildExit, NULL);
+	runBatches(run, bgCommandsList);
+	waitForBatches(run, bgCommandsList, 0);
+	if (run->sigchldWatcher != NULL)
+	{
+		removeEventWatcher(run->sigchldWatcher);
+		freeRemovedWatchers();
+	}
+	ignoreSIGINT();
+
+	/* Close the files, free the buffers, and store the combined status. */
+	if (run->inputFd != STDIN_FILENO)
+	{
+		close(run->inputFd);
+	}
+	if (run->outputFd != -1)
+	{
+		close(run->outputFd);
+	}
+	free(run->readBuffer);
+	free(run->itemBuffer);
+	free(run->command.commandArgs);
+	setBatchStatus(run, lastFgStatus);
+}
+
+
+/***************************************************************************************
+ * Function Name: openBatchFiles
+ * Description:	Receives the batch command and its BatchRun struct. Opens the > file
+ * 		(once, so that invocations append to each other's output instead of
+ * 		truncating it) and then the < file holding the items, reporting
+ * 		failures like executeChild would. Items are read from stdin if there
+ * 		is no < file. Returns TRUE on success, or FALSE otherwise.
+ **************************************************************************************/
+
+int openBatchFiles(struct CommandInfo* myCommand, struct BatchRun* run)
+{
+	run->inputFd = STDIN_FILENO;
+	run->outputFd = -1;
+	if (myCommand->outputFlag == TRUE)
+	{
+		run->outputFd = open(myCommand->outputRedirDest, O_WRONLY | O_TRUNC | O_CREAT | O_CLOEXEC, FILE_PERMISSIONS);
+		if (run->outputFd == -1)
+		{
+			fprintf(stderr, "cannot open %s for output\n", myCommand->outputRedirDest); fflush(stderr);
+			return FALSE;
+		}
+	}
+	if (myCommand->inputFlag == TRUE)
+	{
+		run->inputFd = open(myCommand->inputRedirDest, O_RDONLY | O_CLOEXEC);
+		if (run->inputFd == -1)
+		{
+			fprintf(stderr, "cannot open %s for input\n", myCommand->inputRedirDest); fflush(stderr);
+			if (run->outputFd != -1)
+			{
+				close(run->outputFd);
+			}
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: getBatchItemBytesLimit
+ * Description:	Receives a BatchRun struct whose fixed args are set. Returns the
+ * 		number of bytes of args (strings, null terminators, and pointers)
+ * 		left for items: ARG_MAX less the environment, the variables
+ * 		assigned for the command, the fixed args, the terminating NULL, and
+ * 		BATCH_ARG_HEADROOM.
+ **************************************************************************************/
+
+long getBatchItemBytesLimit(struct BatchRun* run)
+{
+	long limit = getArgListLimit() - BATCH_ARG_HEADROOM - sizeof(char*);
+
+	/* Assignments may replace variables already counted, so this can only overestimate their room. */
+	for (int i = 0; i < run->command.numEnvAssignments; i++)
+	{
+		limit -= strlen(run->command.envAssignments[i]) + 1 + sizeof(char*);
+	}
+	for (int i = 0; i < run->numFixedArgs; i++)
+	{
+		limit -= strlen(run->command.commandArgs[i]) + 1 + sizeof(char*);
+	}
+	return limit;
+}
+
+
+/***************************************************************************************
+ * Function Name: runBatches
+ * Description:	Receives a BatchRun struct and the BackgroundCommands list. Reads
+ * 		every item, skipping empty lines and reporting items too long to be
+ * 		passed to a command, and launches a batch whenever the next item
+ * 		would not fit (or -n items have been gathered), and once more for
+ * 		the items left at the end. Returns nothing.
+ **************************************************************************************/
+
+void runBatches(struct BatchRun* run, struct BackgroundCommands* bgCommandsList)
+{
+	char* item;
+	size_t length;
+
+	while (run->stopped == FALSE && readBatchItem(run, &item, &length) == TRUE)
+	{
+		long itemBytes = length + 1 + sizeof(char*);
+		if (length == 0)
+		{
+			continue;
+		}
+		if (length + 1 > BATCH_MAX_ITEM_BYTES || itemBytes > run->itemBytesLimit)
+		{
+			fprintf(stderr, "batch: skipping an item of %zu bytes, too long for the command's args\n", length);
+			fflush(stderr);
+			run->numSkipped++;
+			continue;
+		}
+
+		/* Launch the items gathered so far if this one does not fit with them. */
+		if (run->numItems > 0
+		    && (run->itemBytes + itemBytes > run->itemBytesLimit || (run->maxItems > 0 && run->numItems == run->maxItems)))
+		{
+			launchBatch(run, bgCommandsList);
+		}
+		addBatchItem(run, item, length);
+	}
+	if (run->numItems > 0)
+	{
+		launchBatch(run, bgCommandsList);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: readBatchItem
+ * Description:	Receives a BatchRun struct and addresses into which to store the
+ * 		next item and its length. Finds the next line in readBuffer
+ * 		(refilling it with BATCH_READ_BYTES reads as needed), replacing its
+ * 		newline with a null terminator. The item stays valid until the next
+ * 		call. A line too long to fit in the buffer is reported and skipped.
+ * 		Returns TRUE if an item was found, or FALSE at end-of-file or once
+ * 		SIGINT has been received.
+ **************************************************************************************/
+
+int readBatchItem(struct BatchRun* run, char** item, size_t* length)
+{
+	while (TRUE)
+	{
+		/* Return the next complete line if the buffer holds one (discarding it if it ends a long item). */
+		char* start = run->readBuffer + run->readStart;
+		char* newline = (char*)memchr(start, '\n', run->readEnd - run->readStart);
+		if (newline != NULL)
+		{
+			*newline = '\0';
+			run->readStart += newline - start + 1;
+			if (run->discardingItem == TRUE)
+			{
+				run->discardingItem = FALSE;
+				continue;
+			}
+			*item = start;
+			*length = newline - start;
+			return TRUE;
+		}
+
+		/* At end-of-file, return the unterminated last line, if any. */
+		if (run->atEOF == TRUE)
+		{
+			if (run->readStart == run->readEnd || run->discardingItem == TRUE)
+			{
+				return FALSE;
+			}
+			run->readBuffer[run->readEnd] = '\0';
+			*item = start;
+			*length = run->readEnd - run->readStart;
+			run->readStart = run->readEnd;
+			return TRUE;
+		}
+
+		/* Move the partial line to the front of the buffer, and if it fills the buffer, report it
+		 * and drop what has been read of it. */
+		memmove(run->readBuffer, start, run->readEnd - run->readStart);
+		run->readEnd -= run->readStart;
+		run->readStart = 0;
+		if (run->readEnd == BATCH_READ_BYTES)
+		{
+			if (run->discardingItem == FALSE)
+			{
+				fprintf(stderr, "batch: skipping an item of more than %d bytes, too long for the command's args\n",
+					BATCH_READ_BYTES);
+				fflush(stderr);
+				run->numSkipped++;
+				run->discardingItem = TRUE;
+			}
+			run->readEnd = 0;
+		}
+
+		/* Read more of the list, stopping if interrupted. */
+		ssize_t bytesRead = read(run->inputFd, run->readBuffer + run->readEnd, BATCH_READ_BYTES - run->readEnd);
+		if (bytesRead > 0)
+		{
+			run->readEnd += bytesRead;
+		}
+		else if (bytesRead == 0)
+		{
+			run->atEOF = TRUE;
+		}
+		else if (sigintReceived == TRUE)
+		{
+			return FALSE;
+		}
+		else if (errno != EINTR)
+		{
+			fprintf(stderr, "batch: cannot read items: %s\n", strerror(errno)); fflush(stderr);
+			run->numSkipped++;
+			run->atEOF = TRUE;
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: addBatchItem
+ * Description:	Receives a BatchRun struct and an item (and its length) that fits in
+ * 		the batch being gathered. Copies the item into itemBuffer and appends
+ * 		it to the command's args. Returns nothing.
+ **************************************************************************************/
+
+void addBatchItem(struct BatchRun* run, char* item, size_t length)
+{
+	char* copy = run->itemBuffer + run->itemBufferUsed;
+	memcpy(copy, item, length + 1);
+	run->itemBufferUsed += length + 1;
+
+	/* The args vector is reused by every batch, so terminate it here rather than relying on growCommandArgs. */
+	int argIndex = run->numFixedArgs + run->numItems;
+	growCommandArgs(&run->command, argIndex + 2);
+	run->command.commandArgs[argIndex] = copy;
+	run->command.commandArgs[argIndex + 1] = NULL;
+	run->numItems++;
+	run->itemBytes += length + 1 + sizeof(char*);
+}
+
+
+/***************************************************************************************
+ * Function Name: launchBatch
+ * Description:	Receives a BatchRun struct holding a gathered batch and the
+ * 		BackgroundCommands list. Waits until fewer than maxJobs invocations
+ * 		are running, and then forks off the command with the batch's items
+ * 		(unless the run has been stopped), adding it to bgCommandsList with
+ * 		finishBatch as its onDone handler. The batch's buffers can be
+ * 		reused right away, since the child has its own copy. Returns nothing.
+ **************************************************************************************/
+
+void launchBatch(struct BatchRun* run, struct BackgroundCommands* bgCommandsList)
+{
+	pid_t childPid;		/* Pid returned by fork() */
+	struct timespec forkStart;	/* Time at which fork() was called. */
+
+	waitForBatches(run, bgCommandsList, run->maxJobs - 1);
+	if (run->stopped == FALSE)
+	{
+		/* Bring the shell's envp up to date before forking, and record how long fork() took in stats. */
+		getEnvp();
+		clock_gettime(CLOCK_MONOTONIC, &forkStart);
+		childPid = fork();
+		if (childPid != 0)
+		{
+			recordLaunch(&forkStart, childPid);
+		}
+
+		/* If an error occurred when calling fork, report it and start no more batches. */
+		if (childPid == -1)
+		{
+			perror("fork()"); fflush(stderr);
+			run->numFailed++;
+			run->stopped = TRUE;
+		}
+
+		/* Otherwise, if this is the child process, read stdin from /dev/null (the items came from it
+		 * or the < file) and run the command in the foreground, writing to the shared > file if any. */
+		else if (childPid == 0)
+		{
+			int devNull = open("/dev/null", O_RDONLY);
+			if (devNull != -1)
+			{
+				dup2(devNull, 0);
+				close(devNull);
+			}
+			executeChild(&run->command, FALSE, -1, run->outputFd, -1);
+		}
+
+		/* Otherwise, track the invocation as a job that reports its exit to this run. */
+		else
+		{
+			struct BackgroundNode* newNode = addBackgroundNode(bgCommandsList, childPid);
+			newNode->onDone = finishBatch;
+			newNode->owner = run;
+			run->numRunning++;
+			logCommandStart(&run->command, childPid, TRUE);
+			publishJobStart(newNode, &run->command);
+		}
+	}
+
+	/* Empty the batch so that the next one can be gathered. */
+	run->numItems = 0;
+	run->itemBytes = 0;
+	run->itemBufferUsed = 0;
+	run->command.commandArgs[run->numFixedArgs] = NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: waitForBatches
+ * Description:	Receives a BatchRun struct, the BackgroundCommands list, and a number
+ * 		of invocations. Reaps finished jobs (sleeping in the event loop until
+ * 		SIGCHLD in between, or polling if the self-pipe could not be
+ * 		watched) until no more than maxRunning invocations are
+ * 		still running. Once SIGINT has been received, no more batches are
+ * 		started, but running ones are still waited for like any foreground
+ * 		command. Returns nothing.
+ **************************************************************************************/
+
+void waitForBatches(struct BatchRun* run, struct BackgroundCommands* bgCommandsList, int maxRunning)
+{
+	while (TRUE)
+	{
+		/* The self-pipe is drained before reaping, so an exit after reaping always wakes the loop. */
+		drainSIGCHLDPipe();
+		reapBackgroundCommands(bgCommandsList);
+		if (sigintReceived == TRUE)
+		{
+			run->stopped = TRUE;
+		}
+		if (run->numRunning <= maxRunning)
+		{
+			break;
+		}
+		runEventLoopOnce((run->sigchldWatcher != NULL) ? -1 : BATCH_POLL_MS);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: finishBatch
+ * Description:	onDone handler of the jobs started by the batch built-in. Receives the
+ * 		node of an invocation that finished and its exit method. Counts it
+ * 		as failed if it exited with a nonzero status, or records its signal
+ * 		and stops the run (as xargs does) if it was killed. Returns nothing.
+ **************************************************************************************/
+
+void finishBatch(struct BackgroundNode* node, int childExitMethod)
+{
+	struct BatchRun* run = (struct BatchRun*)node->owner;
+
+	run->numRunning--;
+	if (WIFSIGNALED(childExitMethod) != 0)
+	{
+		run->signalExitMethod = childExitMethod;
+		run->stopped = TRUE;
+	}
+	else if (WIFEXITED(childExitMethod) != 0 && WEXITSTATUS(childExitMethod) != 0)
+	{
+		run->numFailed++;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: setBatchStatus
+ * Description:	Receives a finished BatchRun struct and the ForegroundExitMethod
+ * 		struct. Reports and stores the signal that killed an invocation (or
+ * 		SIGINT if the run was interrupted), or otherwise stores
+ * 		BATCH_FAILED_STATUS if any invocation failed or item was skipped, or 0
+ * 		if everything succeeded. Returns nothing.
+ **************************************************************************************/
+
+void setBatchStatus(struct BatchRun* run, struct ForegroundExitMethod* lastFgStatus)
+{
+	int exitMethod = 0;
+
+	if (run->signalExitMethod != 0 || sigintReceived == TRUE)
+	{
+		exitMethod = (run->signalExitMethod != 0) ? run->signalExitMethod : SIGINT;
+		fprintf(shellOutput, "terminated by signal %d\n", WTERMSIG(exitMethod)); fflush(shellOutput);
+	}
+	else if (run->numFailed > 0 || run->numSkipped > 0)
+	{
+		exitMethod = BATCH_FAILED_STATUS << 8;
+	}
+	setExitMethod(lastFgStatus, exitMethod);
+}
@@ -0,0 +1,84 @@
+/***************************************************************************************
+ * File: densmora.batch.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions behind the batch built-in, which reads items (one
+ * 		per line) from its < file or stdin and runs a command with as many
+ * 		of them appended to its args as fit in a new process, optionally
+ * 		running several invocations at once. See densmora.batch.c for
+ * 		function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_BATCH
+#define DENSMORA_BATCH
+
+/* Built-in header file inclusions. */
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+
+/* Size of the reads of the item list (an item cannot be longer than this). */
+#define BATCH_READ_BYTES (1024 * 1024)
+
+/* Bytes of ARG_MAX left unused by every invocation, as room for what the kernel and the
+ * dynamic loader add to a new process (the program name, auxiliary vector, and so on). */
+#define BATCH_ARG_HEADROOM 2048
+
+/* Longest single argument the kernel accepts (MAX_ARG_STRLEN, counting the null terminator). */
+#define BATCH_MAX_ITEM_BYTES (32 * 4096)
+
+/* Milliseconds between checks for finished invocations if the SIGCHLD self-pipe cannot be watched. */
+#define BATCH_POLL_MS 10
+
+/* Largest number of invocations accepted by -P. */
+#define MAX_BATCH_JOBS 1024
+
+/* Exit value stored when any invocation fails or an item is skipped (as xargs does). */
+#define BATCH_FAILED_STATUS 123
+
+/* Struct storing the state of a running batch built-in. */
+
+struct BatchRun
+{
+	struct CommandInfo command;		/* Command being run, whose args are followed by the items of a batch. */
+	int numFixedArgs;			/* Number of args given before the items. */
+	long maxItems;				/* Most items per invocation (-n), or 0 for no limit. */
+	int maxJobs;				/* Most invocations running at once (-P). */
+	long itemBytesLimit;			/* Bytes of args (strings and pointers) left for items. */
+	int inputFd;				/* Descriptor the items are read from. */
+	int outputFd;				/* Descriptor of the > file opened by the shell, or -1. */
+	char* readBuffer;			/* Bytes read from inputFd (with room for a final null terminator). */
+	size_t readStart;			/* Offset in readBuffer of the next unconsumed byte. */
+	size_t readEnd;				/* Offset in readBuffer just past the bytes read. */
+	int atEOF;				/* Set to TRUE once inputFd has reached end-of-file. */
+	int discardingItem;			/* Set to TRUE while skipping the rest of an item too long to read. */
+	char* itemBuffer;			/* Copies of the items of the batch being gathered. */
+	size_t itemBufferUsed;			/* Bytes of itemBuffer in use. */
+	long numItems;				/* Number of items in the batch being gathered. */
+	long itemBytes;				/* Bytes of args taken by those items. */
+	int numRunning;				/* Number of invocations still running. */
+	int numFailed;				/* Number of invocations that exited with a nonzero status. */
+	int numSkipped;				/* Number of items that could not be passed to the command. */
+	int signalExitMethod;			/* Exit method of the last invocation killed by a signal, or 0. */
+	int stopped;				/* Set to TRUE once no more invocations should be started. */
+	struct EventWatcher* sigchldWatcher;	/* Event loop watcher of the SIGCHLD self-pipe, or NULL. */
+};
+
+/* Function prototypes (see densmora.batch.c for function descriptions and implementations). */
+void runBatchCommand(struct CommandInfo* myCommand, struct BatchRun* run, struct ForegroundExitMethod* lastFgStatus,
+		     struct BackgroundCommands* bgCommandsList);
+int openBatchFiles(struct CommandInfo* myCommand, struct BatchRun* run);
+long getBatchItemBytesLimit(struct BatchRun* run);
+void runBatches(struct BatchRun* run, struct BackgroundCommands* bgCommandsList);
+int readBatchItem(struct BatchRun* run, char** item, size_t* length);
+void addBatchItem(struct BatchRun* run, char* item, size_t length);
+void launchBatch(struct BatchRun* run, struct BackgroundCommands* bgCommandsList);
+void waitForBatches(struct BatchRun* run, struct BackgroundCommands* bgCommandsList, int maxRunning);
+void finishBatch(struct BackgroundNode* node, int childExitMethod);
+void setBatchStatus(struct BatchRun* run, struct ForegroundExitMethod* lastFgStatus);
+
+#endif
@@ -0,0 +1,321 @@
+/***************************************************************************************
+ * File: densmora.bench.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions behind
+ * 		the bench built-in. The command is run through runForeground (the same
+ * 		path as any foreground command) with its stdout sent to /dev/null
+ * 		unless it is redirected, first for the warmup runs and then for the
+ * 		timed runs. Wall time is measured around each run and CPU time is the
+ * 		change in the shell's RUSAGE_CHILDREN totals, so the cost of starting
+ * 		a shell is never part of the measurement.
+ **************************************************************************************/
+
+#include "densmora.bench.h"
+
+
+/***************************************************************************************
+ * Function Name: runBenchmark
+ * Description:	Receives the command to measure (with the bench built-in's own args
+ * 		already removed), the options given to the built-in, and the
+ * 		ForegroundExitMethod struct. Runs the warmup and timed runs, prints
+ * 		the statistics, and writes the requested exports. A run interrupted
+ * 		by SIGINT stops the benchmark. Stores exit value 0 in lastFgStatus if
+ * 		every timed run succeeded, or 1 otherwise. Returns TRUE if the
+ * 		benchmark completed, or FALSE if it was interrupted.
+ **************************************************************************************/
+
+int runBenchmark(struct CommandInfo* myCommand, struct BenchRequest* request, struct ForegroundExitMethod* lastFgStatus)
+{
+	struct BenchRun* runs = (struct BenchRun*)malloc(request->numRuns * sizeof(struct BenchRun));
+	struct BenchRun warmupRun;
+	struct BenchSummary summary;
+	int completed = TRUE;
+
+	/* Discard the command's output unless it is redirected. */
+	int outputWasRedirected = myCommand->outputFlag;
+	if (outputWasRedirected == FALSE)
+	{
+		myCommand->outputFlag = TRUE;
+		myCommand->outputRedirDest = "/dev/null";
+	}
+
+	/* Run the warmup runs, then the timed runs, stopping if one is interrupted. */
+	for (int i = 0; i < request->numWarmup && completed == TRUE; i++)
+	{
+		completed = runBenchIteration(myCommand, request, lastFgStatus, &warmupRun);
+	}
+	for (int i = 0; i < request->numRuns && completed == TRUE; i++)
+	{
+		completed = runBenchIteration(myCommand, request, lastFgStatus, &runs[i]);
+	}
+
+	if (outputWasRedirected == FALSE)
+	{
+		myCommand->outputFlag = FALSE;
+		myCommand->outputRedirDest = NULL;
+	}
+
+	/* Report the results of a completed benchmark. */
+	if (completed == TRUE)
+	{
+		summarizeBenchmark(runs, request->numRuns, &summary);
+		printBenchSummary(myCommand, request, &summary);
+		if (request->csvPath != NULL)
+		{
+			exportBenchCsv(request->csvPath, runs, request->numRuns);
+		}
+		if (request->jsonPath != NULL)
+		{
+			exportBenchJson(request->jsonPath, myCommand, runs, request->numRuns, &summary);
+		}
+		lastFgStatus->code = (summary.numFailures > 0) ? 1 : 0;
+		lastFgStatus->exitedNormally = TRUE;
+		lastFgStatus->timedOut = FALSE;
+	}
+	else
+	{
+		fprintf(shellOutput, "bench interrupted\n"); fflush(shellOutput);
+	}
+
+	free(runs);
+	return completed;
+}
+
+
+/***************************************************************************************
+ * Function Name: runBenchIteration
+ * Description:	Receives the command, the bench options, the ForegroundExitMethod
+ * 		struct, and a BenchRun to fill in. Runs the prepare command (if any,
+ * 		untimed) and then the command, recording its wall time, CPU time, and
+ * 		exit status. Returns FALSE if either was interrupted by SIGINT, or
+ * 		TRUE otherwise.
+ **************************************************************************************/
+
+int runBenchIteration(struct CommandInfo* myCommand, struct BenchRequest* request,
+		      struct ForegroundExitMethod* lastFgStatus, struct BenchRun* run)
+{
+	struct timespec startTime, endTime;
+	double userBefore, sysBefore, userAfter, sysAfter;
+
+	/* Run the prepare command. */
+	if (request->prepareCommand != NULL)
+	{
+		runForeground(request->prepareCommand, lastFgStatus, NULL);
+		if (lastFgStatus->exitedNormally == FALSE && lastFgStatus->code == SIGINT)
+		{
+			return FALSE;
+		}
+	}
+
+	/* Run the command, measuring it. */
+	getChildCpuMs(&userBefore, &sysBefore);
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	runForeground(myCommand, lastFgStatus, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	getChildCpuMs(&userAfter, &sysAfter);
+
+	run->wallMs = (endTime.tv_sec - startTime.tv_sec) * 1000.0 + (endTime.tv_nsec - startTime.tv_nsec) / 1000000.0;
+	run->userMs = userAfter - userBefore;
+	run->sysMs = sysAfter - sysBefore;
+	run->exitedNormally = lastFgStatus->exitedNormally;
+	run->code = lastFgStatus->code;
+	return (run->exitedNormally == FALSE && run->code == SIGINT) ? FALSE : TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: getChildCpuMs
+ * Description:	Receives addresses into which to store the total user and system CPU
+ * 		time (in milliseconds) of all children the shell has reaped.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void getChildCpuMs(double* userMs, double* sysMs)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_CHILDREN, &usage);
+	*userMs = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0;
+	*sysMs = usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+}
+
+
+/***************************************************************************************
+ * Function Name: compareDoubles
+ * Description:	qsort comparison function for an array of doubles. Receives pointers
+ * 		to two elements. Returns a negative, zero, or positive value.
+ **************************************************************************************/
+
+static int compareDoubles(const void* a, const void* b)
+{
+	double valueA = *(const double*)a;
+	double valueB = *(const double*)b;
+	return (valueA < valueB) ? -1 : (valueA > valueB);
+}
+
+
+/***************************************************************************************
+ * Function Name: summarizeBenchmark
+ * Description:	Receives the timed runs, their number, and a BenchSummary to fill in.
+ * 		Computes the mean, sample standard deviation, range, and percentiles
+ * 		of the wall times, the mean CPU times, and the number of runs that
+ * 		did not exit with status 0. Returns nothing.
+ **************************************************************************************/
+
+void summarizeBenchmark(struct BenchRun* runs, int numRuns, struct BenchSummary* summary)
+{
+	double* sortedMs = (double*)malloc(numRuns * sizeof(double));
+	double totalMs = 0.0, totalUserMs = 0.0, totalSysMs = 0.0, squaredDeviations = 0.0;
+
+	memset(summary, 0, sizeof(struct BenchSummary));
+	for (int i = 0; i < numRuns; i++)
+	{
+		sortedMs[i] = runs[i].wallMs;
+		totalMs += runs[i].wallMs;
+		totalUserMs += runs[i].userMs;
+		totalSysMs += runs[i].sysMs;
+		if (runs[i].exitedNormally == FALSE || runs[i].code != 0)
+		{
+			summary->numFailures++;
+		}
+	}
+	summary->meanMs = totalMs / numRuns;
+	summary->meanUserMs = totalUserMs / numRuns;
+	summary->meanSysMs = totalSysMs / numRuns;
+
+	for (int i = 0; i < numRuns; i++)
+	{
+		squaredDeviations += (runs[i].wallMs - summary->meanMs) * (runs[i].wallMs - summary->meanMs);
+	}
+	summary->stddevMs = (numRuns > 1) ? sqrt(squaredDeviations / (numRuns - 1)) : 0.0;
+
+	qsort(sortedMs, numRuns, sizeof(double), compareDoubles);
+	summary->minMs = sortedMs[0];
+	summary->maxMs = sortedMs[numRuns - 1];
+	summary->p50Ms = benchPercentile(sortedMs, numRuns, 50.0);
+	summary->p95Ms = benchPercentile(sortedMs, numRuns, 95.0);
+	summary->p99Ms = benchPercentile(sortedMs, numRuns, 99.0);
+	free(sortedMs);
+}
+
+
+/***************************************************************************************
+ * Function Name: benchPercentile
+ * Description:	Receives sorted wall times, their number, and a percentage. Returns
+ * 		the percentile, interpolating linearly between the closest ranks.
+ **************************************************************************************/
+
+double benchPercentile(double* sortedMs, int numRuns, double percent)
+{
+	double rank = percent / 100.0 * (numRuns - 1);
+	int lower = (int)rank;
+	if (lower >= numRuns - 1)
+	{
+		return sortedMs[numRuns - 1];
+	}
+	return sortedMs[lower] + (rank - lower) * (sortedMs[lower + 1] - sortedMs[lower]);
+}
+
+
+/***************************************************************************************
+ * Function Name: printBenchSummary
+ * Description:	Receives the measured command, the bench options, and the computed
+ * 		statistics. Prints the statistics. Returns nothing.
+ **************************************************************************************/
+
+void printBenchSummary(struct CommandInfo* myCommand, struct BenchRequest* request, struct BenchSummary* summary)
+{
+	printf("Benchmark:");
+	for (int i = 0; myCommand->commandArgs[i] != NULL; i++)
+	{
+		printf(" %s", myCommand->commandArgs[i]);
+	}
+	printf(" (%d runs, %d warmup)\n", request->numRuns, request->numWarmup);
+	printf("  Time (mean +/- sd):  %9.3f ms +/- %.3f ms\n", summary->meanMs, summary->stddevMs);
+	printf("  Range (min .. max):  %9.3f ms .. %.3f ms\n", summary->minMs, summary->maxMs);
+	printf("  Percentiles:         p50 %.3f ms, p95 %.3f ms, p99 %.3f ms\n",
+	       summary->p50Ms, summary->p95Ms, summary->p99Ms);
+	printf("  CPU (mean):          user %.3f ms, sys %.3f ms\n", summary->meanUserMs, summary->meanSysMs);
+	printf("  Failures:            %d\n", summary->numFailures);
+	fflush(stdout);
+}
+
+
+/***************************************************************************************
+ * Function Name: exportBenchCsv
+ * Description:	Receives a path, the timed runs, and their number. Writes one CSV row
+ * 		per run (after a header row) to the file. Returns nothing.
+ **************************************************************************************/
+
+void exportBenchCsv(char* path, struct BenchRun* runs, int numRuns)
+{
+	FILE* csvFile = fopen(path, "w");
+	if (csvFile == NULL)
+	{
+		perror(path); fflush(stderr);
+		return;
+	}
+	fprintf(csvFile, "run,wall_ms,user_ms,sys_ms,exit_code,signal\n");
+	for (int i = 0; i < numRuns; i++)
+	{
+		fprintf(csvFile, "%d,%.6f,%.6f,%.6f,%d,%d\n", i + 1, runs[i].wallMs, runs[i].userMs, runs[i].sysMs,
+			(runs[i].exitedNormally == TRUE) ? runs[i].code : -1,
+			(runs[i].exitedNormally == TRUE) ? 0 : runs[i].code);
+	}
+	fclose(csvFile);
+}
+
+
+/***************************************************************************************
+ * Function Name: exportBenchJson
+ * Description:	Receives a path, the measured command, the timed runs, their number,
+ * 		and the computed statistics. Writes them to the file as one JSON
+ * 		object. Returns nothing.
+ **************************************************************************************/
+
+void exportBenchJson(char* path, struct CommandInfo* myCommand, struct BenchRun* runs, int numRuns,
+		     struct BenchSummary* summary)
+{
+	FILE* jsonFile = fopen(path, "w");
+	if (jsonFile == NULL)
+	{
+		perror(path); fflush(stderr);
+		return;
+	}
+
+	/* Write the command as an array of strings, escaping quotes, backslashes, and control chars. */
+	fprintf(jsonFile, "{\"command\":[");
+	for (int i = 0; myCommand->commandArgs[i] != NULL; i++)
+	{
+		fprintf(jsonFile, "%s\"", (i > 0) ? "," : "");
+		for (char* c = myCommand->commandArgs[i]; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fprintf(jsonFile, "\\%c", *c);
+			}
+			else if ((unsigned char)*c < 0x20)
+			{
+				fprintf(jsonFile, "\\u%04x", (unsigned char)*c);
+			}
+			else
+			{
+				fputc(*c, jsonFile);
+			}
+		}
+		fputc('"', jsonFile);
+	}
+
+	/* Write the statistics and the runs. */
+	fprintf(jsonFile, "],\"runs\":%d,\"mean_ms\":%.6f,\"stddev_ms\":%.6f,\"min_ms\":%.6f,\"max_ms\":%.6f,"
+		"\"p50_ms\":%.6f,\"p95_ms\":%.6f,\"p99_ms\":%.6f,\"user_ms\":%.6f,\"sys_ms\":%.6f,\"failures\":%d,"
+		"\"times_ms\":[",
+		numRuns, summary->meanMs, summary->stddevMs, summary->minMs, summary->maxMs, summary->p50Ms,
+		summary->p95Ms, summary->p99Ms, summary->meanUserMs, summary->meanSysMs, summary->numFailures);
+	for (int i = 0; i < numRuns; i++)
+	{
+		fprintf(jsonFile, "%s%.6f", (i > 0) ? "," : "", runs[i].wallMs);
+	}
+	fprintf(jsonFile, "]}\n");
+	fclose(jsonFile);
+}
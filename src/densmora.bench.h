@@ -0,0 +1,77 @@
+/***************************************************************************************
+ * File: densmora.bench.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions behind the bench built-in, which runs a command
+ * 		repeatedly and reports latency statistics. See densmora.bench.c for
+ * 		function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_BENCH
+#define DENSMORA_BENCH
+
+/* Built-in header file inclusions. */
+#include <math.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+
+/* Default number of timed and warmup runs. */
+#define DEFAULT_BENCH_RUNS 10
+#define DEFAULT_BENCH_WARMUP 0
+
+/* Largest number of runs accepted by -n and -w. */
+#define MAX_BENCH_RUNS 1000000
+
+/* Struct storing the options given to the bench built-in. */
+
+struct BenchRequest
+{
+	int numRuns;				/* Number of timed runs. */
+	int numWarmup;				/* Number of untimed runs before the timed ones. */
+	struct CommandInfo* prepareCommand;	/* Command run before every run (NULL if none). */
+	char* csvPath;				/* File to which per-run results are written as CSV (or NULL). */
+	char* jsonPath;				/* File to which the summary and results are written as JSON (or NULL). */
+};
+
+/* Struct storing the measurements of one timed run. */
+
+struct BenchRun
+{
+	double wallMs;				/* Wall-clock time from fork to reap. */
+	double userMs;				/* User CPU time of the command. */
+	double sysMs;				/* System CPU time of the command. */
+	int exitedNormally;			/* Copied from lastFgStatus after the run. */
+	int code;				/* Exit value or terminating signal. */
+};
+
+/* Struct storing the statistics computed over all timed runs. */
+
+struct BenchSummary
+{
+	double meanMs;
+	double stddevMs;
+	double minMs;
+	double maxMs;
+	double p50Ms;
+	double p95Ms;
+	double p99Ms;
+	double meanUserMs;
+	double meanSysMs;
+	int numFailures;
+};
+
+/* Function prototypes (see densmora.bench.c for function descriptions and implementations). */
+int runBenchmark(struct CommandInfo* myCommand, struct BenchRequest* request, struct ForegroundExitMethod* lastFgStatus);
+int runBenchIteration(struct CommandInfo* myCommand, struct BenchRequest* request,
+		      struct ForegroundExitMethod* lastFgStatus, struct BenchRun* run);
+void getChildCpuMs(double* userMs, double* sysMs);
+void summarizeBenchmark(struct BenchRun* runs, int numRuns, struct BenchSummary* summary);
+double benchPercentile(double* sortedMs, int numRuns, double percent);
+void printBenchSummary(struct CommandInfo* myCommand, struct BenchRequest* request, struct BenchSummary* summary);
+void exportBenchCsv(char* path, struct BenchRun* runs, int numRuns);
+void exportBenchJson(char* path, struct CommandInfo* myCommand, struct BenchRun* runs, int numRuns,
+		     struct BenchSummary* summary);
+
+#endif
@@ -0,0 +1,570 @@
+/***************************************************************************************
+ * File: densmora.braces.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		carry out brace expansion. A word is parsed once into a sequence of
+ * 		parts, from which the number and total size of its expansions are
+ * 		worked out without generating them, so that an expansion too large
+ * 		to pass to a command is rejected up front. Otherwise, the expansions
+ * 		are generated one after another (like an odometer, the last part
+ * 		changing fastest) straight into a single buffer of exactly the
+ * 		right size that the command's args point into.
+ **************************************************************************************/
+
+#include "densmora.braces.h"
+#include <ctype.h>
+
+
+/***************************************************************************************
+ * Function Name: capBraceSum
+ * Description:	Receives two sizes and a limit. Returns their sum, or limit + 1 if the
+ * 		sum is larger than the limit.
+ **************************************************************************************/
+
+static unsigned long long capBraceSum(unsigned long long a, unsigned long long b, unsigned long long limit)
+{
+	unsigned long long sum;
+	if (__builtin_add_overflow(a, b, &sum) || sum > limit)
+	{
+		return limit + 1;
+	}
+	return sum;
+}
+
+
+/***************************************************************************************
+ * Function Name: capBraceProduct
+ * Description:	Receives two sizes and a limit. Returns their product, or limit + 1 if
+ * 		the product is larger than the limit.
+ **************************************************************************************/
+
+static unsigned long long capBraceProduct(unsigned long long a, unsigned long long b, unsigned long long limit)
+{
+	unsigned long long product;
+	if (__builtin_mul_overflow(a, b, &product) || product > limit)
+	{
+		return limit + 1;
+	}
+	return product;
+}
+
+
+/***************************************************************************************
+ * Function Name: braceNumberLength
+ * Description:	Receives a number and the width it is padded to. Returns the number of
+ * 		chars it is written with.
+ **************************************************************************************/
+
+static int braceNumberLength(long long value, int width)
+{
+	unsigned long long magnitude = (value < 0) ? -(unsigned long long)value : (unsigned long long)value;
+	int length = (value < 0) ? 2 : 1;
+	while (magnitude >= 10)
+	{
+		magnitude /= 10;
+		length++;
+	}
+	return (length < width) ? width : length;
+}
+
+
+/***************************************************************************************
+ * Function Name: expandBraces
+ * Description:	Receives a CommandInfo pointer, a word containing '{', and the
+ * 		address of the number of elements stored in commandArgs. If the word
+ * 		contains a brace list or sequence, stores its expansions at the end
+ * 		of commandArgs (each of which may then be matched against files,
+ * 		and dropping empty ones), updates the number of elements, and
+ * 		returns TRUE. Returns FALSE, storing nothing, if the word has no
+ * 		brace expansion. Returns -1, storing nothing, if the expansions
+ * 		would not fit in the args of a new process (after reporting it).
+ **************************************************************************************/
+
+int expandBraces(struct CommandInfo* myCommand, char* word, int* vectSize)
+{
+	struct BraceSeq seq;
+
+	if (parseBraceSeq(word, strlen(word), &seq) == FALSE)
+	{
+		freeBraceSeq(&seq);
+		return FALSE;
+	}
+
+	/* Work out the room the expansions need (a pointer and a null terminator each, plus their chars). */
+	long argLimit = getArgListLimit();
+	unsigned long long limit = (argLimit > 0) ? (unsigned long long)argLimit : 0;
+	unsigned long long numWords = countBraceSeq(&seq, limit);
+	unsigned long long numChars = sizeBraceSeq(&seq, limit);
+	unsigned long long needed = capBraceSum(capBraceProduct(numWords, sizeof(char*) + 1, limit), numChars, limit);
+	if (needed > limit)
+	{
+		fprintf(stderr, "Arg List Error: %s expands to more than the %ld bytes of args a command can be given.\n",
+			word, argLimit);
+		fflush(stderr);
+		freeBraceSeq(&seq);
+		return -1;
+	}
+
+	/* Generate every expansion into one buffer, which the command frees with its other expanded words. */
+	char* words = (char*)malloc(numChars + numWords);
+	char* out = words;
+	if (myCommand->expansionList == NULL)
+	{
+		myCommand->expansionList = newPidExpansions();
+	}
+	addPidNode(myCommand->expansionList, words);
+	growCommandArgs(myCommand, *vectSize + numWords + 1);
+	do
+	{
+		char* wordStart = out;
+		out = writeBraceSeq(&seq, out);
+		*out++ = '\0';
+		if (wordStart[0] != '\0')
+		{
+			addExpandedWord(myCommand, wordStart, vectSize);
+		}
+	} while (advanceBraceSeq(&seq) == TRUE);
+
+	freeBraceSeq(&seq);
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseBraceSeq
+ * Description:	Receives text (which need not be null-terminated), its length, and a
+ * 		BraceSeq pointer. Parses the text into parts: each {...} holding a
+ * 		comma at its top level becomes a list (each alternative parsed in
+ * 		turn), each {x..y} or {x..y..step} a sequence, and everything else
+ * 		(including braces that are neither) text. Returns TRUE if any list
+ * 		or sequence was found, or FALSE otherwise. The caller frees the
+ * 		parts with freeBraceSeq either way.
+ **************************************************************************************/
+
+int parseBraceSeq(const char* text, int length, struct BraceSeq* seq)
+{
+	int hasExpansions = FALSE;
+	int textStart = 0;
+
+	seq->parts = NULL;
+	seq->numParts = 0;
+	for (int i = 0; i < length; i++)
+	{
+		struct BracePart range;
+		int depth = 0;
+		int close = -1;
+		int numCommas = 0;
+
+		if (text[i] != '{')
+		{
+			continue;
+		}
+
+		/* Find the matching '}', counting the commas between them that are not inside nested braces. */
+		for (int j = i; j < length && close == -1; j++)
+		{
+			if (text[j] == '{')
+			{
+				depth++;
+			}
+			else if (text[j] == '}' && --depth == 0)
+			{
+				close = j;
+			}
+			else if (text[j] == ',' && depth == 1)
+			{
+				numCommas++;
+			}
+		}
+		memset(&range, 0, sizeof(struct BracePart));
+		if (close == -1 || (numCommas == 0 && parseBraceRange(text + i + 1, close - i - 1, &range) == FALSE))
+		{
+			continue;
+		}
+
+		/* End the text before the braces, and add the list or sequence. */
+		if (i > textStart)
+		{
+			struct BracePart* textPart = addBracePart(seq, BRACE_TEXT);
+			textPart->text = text + textStart;
+			textPart->textLength = i - textStart;
+		}
+		if (numCommas == 0)
+		{
+			*addBracePart(seq, BRACE_RANGE) = range;
+		}
+		else
+		{
+			struct BracePart* list = addBracePart(seq, BRACE_LIST);
+			int altStart = i + 1;
+			list->alternatives = (struct BraceSeq*)malloc((numCommas + 1) * sizeof(struct BraceSeq));
+			depth = 0;
+			for (int j = i + 1; j <= close; j++)
+			{
+				if (j == close || (text[j] == ',' && depth == 0))
+				{
+					parseBraceSeq(text + altStart, j - altStart, &list->alternatives[list->numAlternatives++]);
+					altStart = j + 1;
+				}
+				else if (text[j] == '{')
+				{
+					depth++;
+				}
+				else if (text[j] == '}')
+				{
+					depth--;
+				}
+			}
+		}
+		hasExpansions = TRUE;
+		textStart = close + 1;
+		i = close;
+	}
+
+	/* End the text after the last braces. */
+	if (length > textStart)
+	{
+		struct BracePart* textPart = addBracePart(seq, BRACE_TEXT);
+		textPart->text = text + textStart;
+		textPart->textLength = length - textStart;
+	}
+	return hasExpansions;
+}
+
+
+/***************************************************************************************
+ * Function Name: addBracePart
+ * Description:	Receives a BraceSeq pointer and a part type. Appends a part of that
+ * 		type (with every other member zeroed) and returns its address.
+ **************************************************************************************/
+
+struct BracePart* addBracePart(struct BraceSeq* seq, int type)
+{
+	seq->parts = (struct BracePart*)realloc(seq->parts, (seq->numParts + 1) * sizeof(struct BracePart));
+	struct BracePart* part = &seq->parts[seq->numParts++];
+	memset(part, 0, sizeof(struct BracePart));
+	part->type = type;
+	return part;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseBraceRange
+ * Description:	Receives the text between a pair of braces (not null-terminated), its
+ * 		length, and a BracePart pointer. If the text is x..y or x..y..step,
+ * 		where x and y are both integers or both letters, fills the part in as
+ * 		that sequence and returns TRUE. Numbers are zero-padded to the width
+ * 		of the longer of x and y if either has a leading zero. Returns FALSE
+ * 		otherwise.
+ **************************************************************************************/
+
+int parseBraceRange(const char* text, int length, struct BracePart* part)
+{
+	const char* firstDots = memmem(text, length, "..", 2);
+	long long start, end;
+	long long step = 1;
+
+	if (firstDots == NULL)
+	{
+		return FALSE;
+	}
+	const char* endText = firstDots + 2;
+	const char* secondDots = memmem(endText, text + length - endText, "..", 2);
+	int startLength = firstDots - text;
+	int endLength = ((secondDots != NULL) ? secondDots : text + length) - endText;
+	if (secondDots != NULL && parseBraceNumber(secondDots + 2, text + length - secondDots - 2, &step) == FALSE)
+	{
+		return FALSE;
+	}
+
+	/* Take x and y as numbers, noting whether either asks for zero padding. */
+	if (parseBraceNumber(text, startLength, &start) == TRUE && parseBraceNumber(endText, endLength, &end) == TRUE)
+	{
+		int startDigit = (text[0] == '-' || text[0] == '+') ? 1 : 0;
+		int endDigit = (endText[0] == '-' || endText[0] == '+') ? 1 : 0;
+		if ((text[startDigit] == '0' && startLength > startDigit + 1)
+		    || (endText[endDigit] == '0' && endLength > endDigit + 1))
+		{
+			part->width = (startLength > endLength) ? startLength : endLength;
+		}
+	}
+
+	/* Otherwise, take them as letters. */
+	else if (startLength == 1 && endLength == 1 && isalpha((unsigned char)text[0]) && isalpha((unsigned char)endText[0]))
+	{
+		start = (unsigned char)text[0];
+		end = (unsigned char)endText[0];
+		part->isChar = TRUE;
+	}
+	else
+	{
+		return FALSE;
+	}
+
+	/* Count the values, stepping toward y whatever the sign of step. */
+	unsigned long long distance = (end >= start) ? (unsigned long long)end - (unsigned long long)start
+						      : (unsigned long long)start - (unsigned long long)end;
+	unsigned long long stepSize = (step < 0) ? -(unsigned long long)step : (unsigned long long)step;
+	if (stepSize == 0)
+	{
+		stepSize = 1;
+	}
+	if (stepSize > (unsigned long long)LLONG_MAX)
+	{
+		stepSize = distance + 1;
+	}
+	part->type = BRACE_RANGE;
+	part->start = start;
+	part->step = (end >= start) ? (long long)stepSize : -(long long)stepSize;
+	part->numValues = distance / stepSize + 1;
+	part->index = 0;
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseBraceNumber
+ * Description:	Receives text (not null-terminated) and its length. If the text is an
+ * 		integer (an optional sign and then digits) that fits in a long long,
+ * 		stores it in value and returns TRUE. Returns FALSE otherwise.
+ **************************************************************************************/
+
+int parseBraceNumber(const char* text, int length, long long* value)
+{
+	char digits[32];
+	int first = (length > 0 && (text[0] == '-' || text[0] == '+')) ? 1 : 0;
+
+	if (length <= first || length >= (int)sizeof(digits))
+	{
+		return FALSE;
+	}
+	for (int i = first; i < length; i++)
+	{
+		if (!isdigit((unsigned char)text[i]))
+		{
+			return FALSE;
+		}
+	}
+	memcpy(digits, text, length);
+	digits[length] = '\0';
+	errno = 0;
+	*value = strtoll(digits, NULL, 10);
+	return (errno == 0) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: freeBraceSeq
+ * Description:	Receives a BraceSeq pointer. Frees its parts and every alternative
+ * 		of its lists (but not the BraceSeq itself). Returns nothing.
+ **************************************************************************************/
+
+void freeBraceSeq(struct BraceSeq* seq)
+{
+	for (int i = 0; i < seq->numParts; i++)
+	{
+		for (int j = 0; j < seq->parts[i].numAlternatives; j++)
+		{
+			freeBraceSeq(&seq->parts[i].alternatives[j]);
+		}
+		free(seq->parts[i].alternatives);
+	}
+	free(seq->parts);
+}
+
+
+/***************************************************************************************
+ * Function Name: countBraceSeq
+ * Description:	Receives a BraceSeq pointer and a limit. Returns the number of words it
+ * 		expands to, or limit + 1 if that is more than the limit.
+ **************************************************************************************/
+
+unsigned long long countBraceSeq(struct BraceSeq* seq, unsigned long long limit)
+{
+	unsigned long long count = 1;
+	for (int i = 0; i < seq->numParts; i++)
+	{
+		count = capBraceProduct(count, countBracePart(&seq->parts[i], limit), limit);
+	}
+	return count;
+}
+
+
+/***************************************************************************************
+ * Function Name: countBracePart
+ * Description:	Receives a BracePart pointer and a limit. Returns the number of words
+ * 		the part can be replaced by, or limit + 1 if that is more than the
+ * 		limit.
+ **************************************************************************************/
+
+unsigned long long countBracePart(struct BracePart* part, unsigned long long limit)
+{
+	unsigned long long count = 0;
+	if (part->type == BRACE_TEXT)
+	{
+		return 1;
+	}
+	if (part->type == BRACE_RANGE)
+	{
+		return (part->numValues > limit) ? limit + 1 : part->numValues;
+	}
+	for (int i = 0; i < part->numAlternatives; i++)
+	{
+		count = capBraceSum(count, countBraceSeq(&part->alternatives[i], limit), limit);
+	}
+	return count;
+}
+
+
+/***************************************************************************************
+ * Function Name: sizeBraceSeq
+ * Description:	Receives a BraceSeq pointer and a limit. Returns the total number of
+ * 		chars (not counting null terminators) in the words it expands to, or
+ * 		limit + 1 if that is more than the limit. Each part contributes its
+ * 		own chars once for every combination of the other parts.
+ **************************************************************************************/
+
+unsigned long long sizeBraceSeq(struct BraceSeq* seq, unsigned long long limit)
+{
+	unsigned long long size = 0;
+	for (int i = 0; i < seq->numParts; i++)
+	{
+		unsigned long long partSize = sizeBracePart(&seq->parts[i], limit);
+		for (int j = 0; j < seq->numParts; j++)
+		{
+			if (j != i)
+			{
+				partSize = capBraceProduct(partSize, countBracePart(&seq->parts[j], limit), limit);
+			}
+		}
+		size = capBraceSum(size, partSize, limit);
+	}
+	return size;
+}
+
+
+/***************************************************************************************
+ * Function Name: sizeBracePart
+ * Description:	Receives a BracePart pointer and a limit. Returns the total number of
+ * 		chars in the words the part can be replaced by, or limit + 1 if that
+ * 		is more than the limit.
+ **************************************************************************************/
+
+unsigned long long sizeBracePart(struct BracePart* part, unsigned long long limit)
+{
+	unsigned long long size = 0;
+	if (part->type == BRACE_TEXT)
+	{
+		return capBraceSum(0, part->textLength, limit);
+	}
+	if (part->type == BRACE_LIST)
+	{
+		for (int i = 0; i < part->numAlternatives; i++)
+		{
+			size = capBraceSum(size, sizeBraceSeq(&part->alternatives[i], limit), limit);
+		}
+		return size;
+	}
+
+	/* Every value of a sequence takes at least one char, so only short enough sequences are measured. */
+	if (part->numValues > limit)
+	{
+		return limit + 1;
+	}
+	if (part->isChar == TRUE)
+	{
+		return part->numValues;
+	}
+	for (unsigned long long i = 0; i < part->numValues && size <= limit; i++)
+	{
+		size += braceNumberLength((long long)((unsigned long long)part->start + i * (unsigned long long)part->step), part->width);
+	}
+	return (size > limit) ? limit + 1 : size;
+}
+
+
+/***************************************************************************************
+ * Function Name: writeBraceSeq
+ * Description:	Receives a BraceSeq pointer and the address to write at. Writes the
+ * 		expansion currently selected by the parts (without a null terminator)
+ * 		and returns the address just past it.
+ **************************************************************************************/
+
+char* writeBraceSeq(struct BraceSeq* seq, char* out)
+{
+	for (int i = 0; i < seq->numParts; i++)
+	{
+		struct BracePart* part = &seq->parts[i];
+		if (part->type == BRACE_TEXT)
+		{
+			memcpy(out, part->text, part->textLength);
+			out += part->textLength;
+		}
+		else if (part->type == BRACE_LIST)
+		{
+			out = writeBraceSeq(&part->alternatives[part->current], out);
+		}
+		else
+		{
+			long long value = (long long)((unsigned long long)part->start + part->index * (unsigned long long)part->step);
+			if (part->isChar == TRUE)
+			{
+				*out++ = (char)value;
+			}
+			else
+			{
+				out += sprintf(out, "%0*lld", part->width, value);
+			}
+		}
+	}
+	return out;
+}
+
+
+/***************************************************************************************
+ * Function Name: advanceBraceSeq
+ * Description:	Receives a BraceSeq pointer. Selects its next expansion by advancing
+ * 		its last part, carrying into the part before it whenever a part
+ * 		wraps around. Returns FALSE (with every part back at its first
+ * 		word) once every expansion has been selected, or TRUE otherwise.
+ **************************************************************************************/
+
+int advanceBraceSeq(struct BraceSeq* seq)
+{
+	for (int i = seq->numParts - 1; i >= 0; i--)
+	{
+		if (advanceBracePart(&seq->parts[i]) == TRUE)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: advanceBracePart
+ * Description:	Receives a BracePart pointer. Selects its next word. Returns FALSE
+ * 		(having gone back to its first word) if it had none left, or TRUE
+ * 		otherwise.
+ **************************************************************************************/
+
+int advanceBracePart(struct BracePart* part)
+{
+	if (part->type == BRACE_RANGE)
+	{
+		part->index = (part->index + 1 < part->numValues) ? part->index + 1 : 0;
+		return (part->index != 0) ? TRUE : FALSE;
+	}
+	if (part->type == BRACE_LIST)
+	{
+		if (advanceBraceSeq(&part->alternatives[part->current]) == TRUE)
+		{
+			return TRUE;
+		}
+		part->current = (part->current + 1 < part->numAlternatives) ? part->current + 1 : 0;
+		return (part->current != 0) ? TRUE : FALSE;
+	}
+	return FALSE;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************************
+ * File: densmora.braces.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions that carry out brace expansion of command words,
+ * 		both lists ({a,b,c}) and sequences ({1..100}, {01..10..3}, {a..z}).
+ * 		See densmora.braces.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_BRACES
+#define DENSMORA_BRACES
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+
+/* Kinds of part in a parsed word. */
+#define BRACE_TEXT 0
+#define BRACE_LIST 1
+#define BRACE_RANGE 2
+
+struct BraceSeq;
+
+/* Struct storing one part of a word: plain text, a list of alternatives, or a sequence. */
+
+struct BracePart
+{
+	int type;				/* BRACE_TEXT, BRACE_LIST, or BRACE_RANGE. */
+	const char* text;			/* Text of a BRACE_TEXT part (pointing into the word). */
+	int textLength;				/* Number of chars in text. */
+	struct BraceSeq* alternatives;		/* Alternatives of a BRACE_LIST part. */
+	int numAlternatives;			/* Number of elements in alternatives. */
+	int current;				/* Index of the alternative being generated. */
+	long long start;			/* First value of a BRACE_RANGE part. */
+	long long step;				/* Difference between consecutive values (negative if descending). */
+	unsigned long long numValues;		/* Number of values in the sequence. */
+	unsigned long long index;		/* Index of the value being generated. */
+	int width;				/* Width to zero-pad numbers to (0 for none). */
+	int isChar;				/* Set to TRUE if the values are chars rather than numbers. */
+};
+
+/* Struct storing a word (or an alternative of a list) as a sequence of parts. Its
+ * expansions are every combination of one word from each part, in order. */
+
+struct BraceSeq
+{
+	struct BracePart* parts;		/* Parts of the word. */
+	int numParts;				/* Number of elements in parts. */
+};
+
+/* Function prototypes (see densmora.braces.c for function descriptions and implementations). */
+int expandBraces(struct CommandInfo* myCommand, char* word, int* vectSize);
+int parseBraceSeq(const char* text, int length, struct BraceSeq* seq);
+struct BracePart* addBracePart(struct BraceSeq* seq, int type);
+int parseBraceRange(const char* text, int length, struct BracePart* part);
+int parseBraceNumber(const char* text, int length, long long* value);
+void freeBraceSeq(struct BraceSeq* seq);
+unsigned long long countBraceSeq(struct BraceSeq* seq, unsigned long long limit);
+unsigned long long countBracePart(struct BracePart* part, unsigned long long limit);
+unsigned long long sizeBraceSeq(struct BraceSeq* seq, unsigned long long limit);
+unsigned long long sizeBracePart(struct BracePart* part, unsigned long long limit);
+char* writeBraceSeq(struct BraceSeq* seq, char* out);
+int advanceBraceSeq(struct BraceSeq* seq);
+int advanceBracePart(struct BracePart* part);
+
+#endif
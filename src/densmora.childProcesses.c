@@ -9,6 +9,9 @@
 
 #include "densmora.childProcesses.h"
 
+/* Pid of the child run by runForeground while the shell waits for it (see densmora.childProcesses.h). */
+pid_t foregroundPid = 0;
+
 
 /***************************************************************************************
  * Function Name: initForegroundExitMethod
@@ -30,6 +33,7 @@ struct ForegroundExitMethod* initForegroundExitMethod()
 	 * child process is executed. */
 	initialStatus->code = 0;
 	initialStatus->exitedNormally = TRUE;
+	initialStatus->timedOut = FALSE;
 
 	/* Return pointer to ForegroundExitStatus struct to calling function. */
 	return initialStatus;
@@ -39,126 +43,380 @@ struct ForegroundExitMethod* initForegroundExitMethod()
 /***************************************************************************************
  * Function Name: runForeground
  * Description:	Receives a CommandInfo struct pointer with information about a command
- * 		the user would like to have executed in the foreground and a
+ * 		the user would like to have executed in the foreground, a
  * 		ForegroundExitMethod struct pointer into which to write information
- * 		about the exit status of the foregroud process.
+ * 		about the exit status of the foregroud process, and the limits
+ * 		requested by the timeout built-in (NULL if there are none).
  * 		Creates a child process with fork() and has the child process
- * 		execute the requested command. Waits for child process to exit or be
- * 		terminated by a signal. Returns nothing since child exit status is
- * 		written into lastFgStatus.
+ * 		execute the requested command (sending its output through a FanOut
+ * 		if it has several output files). Waits for child process to exit or
+ * 		be terminated by a signal (signaling it if it runs past its deadline).
+ * 		Returns nothing since child exit status is written into lastFgStatus.
  **************************************************************************************/
 
-void runForeground(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus)
+void runForeground(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		   struct TimeoutRequest* timeoutRequest)
 {
 	pid_t childPid;		/* Pid returned by fork() */
-	int childExitMethod;	/* Exit status variable sent to waitpid() function. */
+	int childExitMethod;	/* Exit status variable sent to wait4() function. */
+	struct rusage usage;	/* Resource usage variable sent to wait4() function. */
+	struct timespec startTime;	/* Time at which the child was forked, for the event log. */
+	struct FanOut* fanOut = NULL;	/* Copies the output to several files, or NULL if there is at most one. */
+	int timingPipe[2];		/* Close-on-exec pipe through which the child reports its setup and exec times. */
+
+	/* Open every output file first if there are several, failing like the child would if one cannot be opened. */
+	if (myCommand->numExtraOutputDests > 0)
+	{
+		fanOut = openFanOut(myCommand);
+		if (fanOut == NULL)
+		{
+			setExitMethod(lastFgStatus, 1 << 8);
+			return;
+		}
+	}
 	
-	/* Fork off child process to run foreground command. */
+	/* Bring the shell's envp up to date before forking, so that the child inherits it and
+	 * later launches can reuse it. */
+	getEnvp();
+	openChildTimingPipe(timingPipe);
+
+	/* Record the launch time and fork off child process to run foreground command,
+	 * recording how long fork() took in stats. */
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
 	childPid = fork();
+	if (childPid != 0)
+	{
+		recordLaunch(&startTime, childPid);
+	}
 
 	/* If an error occurred when calling fork, report the error to the user. */
 	if (childPid == -1)
 	{
 		perror("fork()"); fflush(stderr);
+		if (fanOut != NULL)
+		{
+			closeFanOut(fanOut);
+		}
+		if (timingPipe[0] != -1)
+		{
+			close(timingPipe[0]);
+			close(timingPipe[1]);
+		}
 	}
 	
 	/* Otherwise, if this is the child process, execute the command in the foreground,
 	 * setting up file redirection as needed. */
 	else if (childPid == 0)
 	{
-		executeChild(myCommand, FALSE);
+		executeChild(myCommand, FALSE, -1, (fanOut != NULL) ? fanOut->writeFd : -1, timingPipe[1]);
 	}
 
 	/* Otherwise, if this is the parent process, wait for the child to finish and process appropriately. */
 	else
 	{
-		/* Have the parent wait for the child to complete. */
-		waitpid(childPid, &childExitMethod, 0);
+		/* Start copying the output to its files and listening for the child's timing while it runs. */
+		if (fanOut != NULL)
+		{
+			attachFanOut(fanOut, FALSE);
+		}
+		struct ChildTimingReader* timingReader = NULL;
+		if (timingPipe[0] != -1)
+		{
+			close(timingPipe[1]);
+			timingReader = watchChildTiming(timingPipe[0]);
+		}
 
-		/* If the child was killed by a signal,
-		 * have the parent report it immediately and then update fgExitMethod. */
-		if (WIFSIGNALED(childExitMethod) != 0)
+		/* Record the start of the command and start its deadline if one was requested. */
+		struct JobTimeout* jobTimeout = NULL;
+		logCommandStart(myCommand, childPid, FALSE);
+		if (timeoutRequest != NULL)
+		{
+			jobTimeout = startJobTimeout(childPid, timeoutRequest);
+		}
+
+		/* Have the parent wait for the child to complete before recording its exit and the times of its phases. */
+		foregroundPid = childPid;
+		waitForChild(childPid, &childExitMethod, &usage);
+		foregroundPid = 0;
+		if (timingReader != NULL)
 		{
-			/* Get terminating signal and report to user immediately. */
-			int termSig = WTERMSIG(childExitMethod);
-			printf("terminated by signal %d\n", termSig); fflush(stdout);
+			struct timespec reapTime;
+			clock_gettime(CLOCK_MONOTONIC, &reapTime);
+			finishChildTiming(timingReader, &reapTime);
+		}
+		if (fanOut != NULL)
+		{
+			finishFanOut(fanOut);
+		}
+		logCommandExit(childPid, FALSE, childExitMethod, &startTime, &usage);
+		recordExitMethod(childExitMethod);
+
+		/* Stop the deadline now that the child has been reaped, noting whether it expired. */
+		int timedOut = FALSE;
+		if (jobTimeout != NULL)
+		{
+			timedOut = jobTimeout->expired;
+			stopJobTimeout(jobTimeout);
+		}
 
-			/* Store terminating signal in lastFgStatus->code, and set exitedNormally flag to FALSE. */
-			lastFgStatus->code = termSig;
-			lastFgStatus->exitedNormally = FALSE;
+		/* If the child was killed by a signal, have the parent report it immediately. */
+		if (WIFSIGNALED(childExitMethod) != 0)
+		{
+			fprintf(shellOutput, "terminated by signal %d%s\n", WTERMSIG(childExitMethod), (timedOut == TRUE) ? " (timed out)" : "");
+			fflush(shellOutput);
 		}
 
-		/* Otherwise, if the child exited normally, simply store the exit status in fgExitMethod. */
-		else if (WIFEXITED(childExitMethod) != 0)
+		/* Store the exit status or terminating signal in lastFgStatus. */
+		setExitMethod(lastFgStatus, childExitMethod);
+		lastFgStatus->timedOut = timedOut;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: waitForChild
+ * Description:	Receives the pid of a child and addresses into which to store its exit
+ * 		method and resource usage. Waits for the child to exit by sleeping in
+ * 		the event loop until SIGCHLD, so that timers (such as deadlines set by
+ * 		the timeout built-in) and other watched descriptors are serviced while
+ * 		the child runs. Returns nothing.
+ **************************************************************************************/
+
+void waitForChild(pid_t childPid, int* childExitMethod, struct rusage* usage)
+{
+	/* If the SIGCHLD self-pipe cannot be watched, simply block until the child exits. */
+	struct EventWatcher* sigchldWatcher = addEventWatcher(sigchldPipe[0], wakeOnChildExit, NULL);
+	if (sigchldWatcher == NULL)
+	{
+		wait4(childPid, childExitMethod, 0, usage);
+		return;
+	}
+
+	/* Check whether the child has exited, sleeping in the event loop until the next SIGCHLD if not.
+	 * The self-pipe is drained before checking, so an exit after the check always wakes the loop. */
+	while (TRUE)
+	{
+		drainSIGCHLDPipe();
+		pid_t pidReturned = wait4(childPid, childExitMethod, WNOHANG, usage);
+		if (pidReturned == childPid || (pidReturned == -1 && errno != EINTR))
 		{
-			int exitStatus = WEXITSTATUS(childExitMethod);
-			lastFgStatus->code = exitStatus;
-			lastFgStatus->exitedNormally = TRUE;
+			break;
 		}
+		runEventLoopOnce(-1);
+	}
+
+	/* Flush the event log if commands run one after another (which may never sleep in the event loop)
+	 * have half filled it. */
+	drainEventLog(FALSE);
+
+	/* Stop watching the self-pipe. */
+	removeEventWatcher(sigchldWatcher);
+	freeRemovedWatchers();
+}
+
+
+/***************************************************************************************
+ * Function Name: wakeOnChildExit
+ * Description:	Event loop callback for the SIGCHLD self-pipe used while the shell
+ * 		waits for children. Receives the descriptor and an unused argument.
+ * 		Drains the pipe (its only purpose is to wake the event loop, after
+ * 		which the caller reaps children itself). Returns nothing.
+ **************************************************************************************/
+
+void wakeOnChildExit(int fd, void* arg)
+{
+	drainSIGCHLDPipe();
+}
+
+
+/***************************************************************************************
+ * Function Name: setExitMethod
+ * Description:	Receives a ForegroundExitMethod struct pointer and the exit method of a
+ * 		child returned by waitpid or wait4. Stores the child's exit status or
+ * 		terminating signal in the struct so that it is reported by status.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void setExitMethod(struct ForegroundExitMethod* lastFgStatus, int childExitMethod)
+{
+	/* If the child was killed by a signal, store terminating signal in lastFgStatus->code,
+	 * and set exitedNormally flag to FALSE. */
+	lastFgStatus->timedOut = FALSE;
+	if (WIFSIGNALED(childExitMethod) != 0)
+	{
+		lastFgStatus->code = WTERMSIG(childExitMethod);
+		lastFgStatus->exitedNormally = FALSE;
+	}
+
+	/* Otherwise, if the child exited normally, simply store the exit status. */
+	else if (WIFEXITED(childExitMethod) != 0)
+	{
+		lastFgStatus->code = WEXITSTATUS(childExitMethod);
+		lastFgStatus->exitedNormally = TRUE;
 	}
 }
 
 
 /***************************************************************************************
  * Function Name: runBackground
+ * Description:	Receives pointers to a CommandInfo struct, a BackgroundCommands
+ * 		linked list, and a TimeoutRequest (or NULL if the timeout built-in
+ * 		did not set a deadline). Launches the command in the background with
+ * 		launchBackground, starts its deadline (if any), and notifies the user
+ * 		of the new child's pid, unless
+ * 		the admission controller delays the launch (see
+ * 		densmora.admission.c), as it does until a token is available when a
+ * 		jobserver is in use. Returns nothing.
+ **************************************************************************************/
+
+void runBackground(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList,
+		   struct TimeoutRequest* timeoutRequest)
+{
+	/* Leave the command to the admission controller if it must wait. */
+	if (deferBackgroundLaunch(myCommand, timeoutRequest) == TRUE)
+	{
+		return;
+	}
+
+	/* Otherwise, launch the command (handing it the jobserver token taken for it, if any), and
+	 * notify the user of the pid if it was launched. */
+	struct BackgroundNode* newNode = launchBackground(myCommand, bgCommandsList);
+	attachJobToken(bgCommandsList, newNode);
+	if (newNode != NULL)
+	{
+		if (timeoutRequest != NULL)
+		{
+			newNode->timeout = startJobTimeout(newNode->pid, timeoutRequest);
+		}
+		fprintf(shellOutput, "background pid is %d\n", (int)newNode->pid); fflush(shellOutput);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: launchBackground
  * Description:	Receives pointers to a CommandInfo struct and a BackgroundCommands
- * 		linked list. Parent forks off child process and then adds new child's
- * 		pid to bgCommandsList. Returns nothing.
+ * 		linked list. Parent forks off child process to run the command in the
+ * 		background (capturing its output in memory if output capture is
+ * 		enabled, and copying it to every output file if there are several)
+ * 		and then adds new child's pid to bgCommandsList. Returns the new
+ * 		child's node of bgCommandsList, or NULL if an output file could not be
+ * 		opened or fork failed.
  **************************************************************************************/
 
-void runBackground(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList)
+struct BackgroundNode* launchBackground(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList)
 {
 	pid_t childPid;		/* Pid returned by fork() */
+	struct timespec forkStart;	/* Time at which fork() was called. */
+	struct BackgroundNode* newNode = NULL;	/* Node of bgCommandsList added for the new child. */
+	struct JobLog* jobLog;		/* Capture buffer for the child's output, or NULL if not capturing. */
+	struct FanOut* fanOut = NULL;	/* Copies the output to several files, or NULL if there is at most one. */
 
-	/* Fork off child process to run background command. */
+	/* Open every output file first if there are several, not launching the job if one cannot be opened. */
+	if (myCommand->numExtraOutputDests > 0)
+	{
+		fanOut = openFanOut(myCommand);
+		if (fanOut == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	/* Create the capture pipe before forking so that the child can write to it. */
+	jobLog = openJobLog(myCommand->commandArgs[0]);
+
+	/* Bring the shell's envp up to date before forking, so that the child inherits it and
+	 * later launches can reuse it. */
+	getEnvp();
+
+	/* Fork off child process to run background command, recording how long fork() took in stats. */
+	clock_gettime(CLOCK_MONOTONIC, &forkStart);
 	childPid = fork();
+	if (childPid != 0)
+	{
+		recordLaunch(&forkStart, childPid);
+	}
 
 	/* If an error occurred when calling fork, report the error to the user. */
 	if (childPid == -1)
 	{
 		perror("fork()"); fflush(stderr);
+		if (jobLog != NULL)
+		{
+			discardJobLog(jobLog);
+		}
+		if (fanOut != NULL)
+		{
+			closeFanOut(fanOut);
+		}
 	}
 	
 	/* Otherwise, if this is the child process, execute the command in the background,
 	 * setting up file redirection as needed. */
 	else if (childPid == 0)
 	{
-		executeChild(myCommand, TRUE);
+		executeChild(myCommand, TRUE, (jobLog != NULL) ? jobLog->writeFd : -1, (fanOut != NULL) ? fanOut->writeFd : -1, -1);
 	}
 
-	/* Otherwise, this is the parent process. Have the parent add the new child to bgCommandsList,
-	 * and notify the user of the pid. */
+	/* Otherwise, this is the parent process. Have the parent add the new child to bgCommandsList
+	 * and start draining its output if it is being captured. */
 	else
 	{
-		addBackgroundNode(bgCommandsList, childPid);
-		printf("background pid is %d\n", (int)childPid); fflush(stdout);
+		if (jobLog != NULL)
+		{
+			attachJobLog(jobLog, childPid);
+		}
+		if (fanOut != NULL)
+		{
+			attachFanOut(fanOut, TRUE);
+		}
+		newNode = addBackgroundNode(bgCommandsList, childPid);
+		logCommandStart(myCommand, childPid, TRUE);
+		publishJobStart(newNode, myCommand);
 	}
+
+	return newNode;
 }
 
 
 /***************************************************************************************
  * Function Name: executedChild
- * Description:	Receives a command to be executed by child process and a flag
- * 		indicating whether or not it should be run in the background. Executes
- * 		the requested command after setting up any requested io redirection,
- * 		exiting child process with 1 and reporting error
+ * Description:	Receives a command to be executed by child process, a flag
+ * 		indicating whether or not it should be run in the background, the
+ * 		write end of the pipe capturing its output (-1 if not capturing), and
+ * 		the write end of the pipe fanning its output out to several files
+ * 		(-1 if the > file, if any, should be opened directly), and the write
+ * 		end of the pipe reporting its setup and exec times (-1 if untimed).
+ * 		Executes the requested command after setting up any requested io
+ * 		redirection, exiting child process with 1 and reporting error
  * 		if command cannot be executed or an io file cannot be opened.
  * 		Returns nothing.
  **************************************************************************************/
 
-void executeChild(struct CommandInfo* myCommand, int isBgCommand)
+void executeChild(struct CommandInfo* myCommand, int isBgCommand, int captureFd, int outputFd, int timingFd)
 {
-	/* Set foreground child processes to use default action on SIGINT,
-	 * and set all child processes to ignore SIGTSTP. */
+	/* Note when setup started, to report it to the shell along with the time of the exec. */
+	struct timespec setupStart;
+	clock_gettime(CLOCK_MONOTONIC, &setupStart);
+
+	/* Set foreground child processes to use default action on SIGINT, background ones to ignore it
+	 * (even if the shell was catching it, as it does during loops), and all child processes to ignore SIGTSTP. */
 	if (isBgCommand == FALSE)
 	{
 		reenableSIGINT();
 	}
+	else
+	{
+		ignoreSIGINT();
+	}
 	ignoreSIGTSTP(); 
 
-	/* If this is a background process and either of the io flags is not set,
-	 * open /dev/null for reading and writing and redirect input and/or output to /dev/null. */
-	if (isBgCommand == TRUE && (myCommand->inputFlag == FALSE || myCommand->outputFlag == FALSE))
+	/* If this is a background process and either of the io flags is not set, open /dev/null for
+	 * reading and writing and redirect input and/or output to it. Only a terminal is replaced, so that
+	 * descriptors the shell was given (or set with the exec built-in) are inherited like any other. */
+	int replaceInput = (myCommand->inputFlag == FALSE && isatty(0)) ? TRUE : FALSE;
+	int replaceOutput = (myCommand->outputFlag == FALSE && (captureFd != -1 || isatty(1))) ? TRUE : FALSE;
+	if (isBgCommand == TRUE && (replaceInput == TRUE || replaceOutput == TRUE))
 	{
 		/* Declare file descriptor for /dev/null and open it for reading and writing
 		 * so that input and/or output can be redirected to it. */
@@ -173,21 +431,33 @@ void executeChild(struct CommandInfo* myCommand, int isBgCommand)
 			exit(1);
 		}
 
-		/* If output is not redirected, redirect it to /dev/null for this background process. */
-		if (myCommand->outputFlag == FALSE)
+		/* If output is not redirected, redirect it to /dev/null (or the capture pipe) for this background process. */
+		if (replaceOutput == TRUE)
 		{
-			dup2(devNull, 1);
+			dup2((captureFd != -1) ? captureFd : devNull, 1);
 		}
 		
 		/* If input is not redirected, redirect it to dev/null/ for this background process. */
-		if (myCommand->inputFlag == FALSE)
+		if (replaceInput == TRUE)
 		{
 			dup2(devNull, 0);
 		}
 	}
 
-	/* If the ouput flag is set, open the requested file for writing and redirect output to it. */
-	if (myCommand->outputFlag == TRUE)
+	/* If output is being captured, send stderr to the capture pipe as well. */
+	if (captureFd != -1)
+	{
+		dup2(captureFd, 2);
+	}
+
+	/* If the output is being fanned out, the shell has opened the files, so redirect output to its pipe. */
+	if (outputFd != -1)
+	{
+		dup2(outputFd, 1);
+	}
+
+	/* Otherwise, if the ouput flag is set, open the requested file for writing and redirect output to it. */
+	else if (myCommand->outputFlag == TRUE)
 	{
 		/* Declare output file descriptor and open output file for writing, truncating it if it exists
 		 * and creating it if it does not exist. */
@@ -223,10 +493,17 @@ void executeChild(struct CommandInfo* myCommand, int isBgCommand)
 		dup2(inputFileno, 0);
 	}
 	
-	/* Execute the command passed in through myCommand.
-	 * If control returns to this function after execvp() call,
+	/* Execute the command passed in through myCommand with the shell's environment,
+	 * plus any variables assigned before the command.
+	 * If control returns to this function after execve() call,
 	 * report error condition to user since the exec call failed and return exit status 1. */
-	execvp(myCommand->commandArgs[0], myCommand->commandArgs);
+	char** envp = getEnvp();
+	if (myCommand->numEnvAssignments > 0)
+	{
+		envp = overrideEnvp(myCommand->envAssignments, myCommand->numEnvAssignments);
+	}
+	sendChildTiming(timingFd, &setupStart);
+	execWithEnvironment(myCommand->commandArgs, envp);
 	perror(myCommand->commandArgs[0]); fflush(stderr);
 	exit(1);
 }
@@ -18,6 +18,14 @@
 /* My own header file inclusions. */
 #include "densmora.commands.h"
 #include "densmora.signalHandlers.h"
+#include "densmora.eventLog.h"
+#include "densmora.shellStats.h"
+#include "densmora.jobLog.h"
+#include "densmora.environment.h"
+#include "densmora.outputFanOut.h"
+#include "densmora.jobBoard.h"
+#include "densmora.admission.h"
+#include "densmora.jobserver.h"
 
 /* Struct to store either exit status or signal number of last executed foreground child process
  * as well as a flag indicating whether it exited normally or was terminated by a signal. */
@@ -26,13 +34,23 @@ struct ForegroundExitMethod
 {
 	int code;		/* Numeric exit code or signal number. */
 	int exitedNormally;	/* Flag indicating whether or not process exited normally. */
+	int timedOut;		/* Flag indicating whether the process was stopped by the timeout built-in. */
 };
 
+/* Pid of the child run by runForeground while the shell waits for it, or 0 if none. Needs to be
+ * accessible to built-ins (such as watch) whose timers and watchers must stop that child. */
+extern pid_t foregroundPid;
 
 /* Function prototypes. */
 struct ForegroundExitMethod* initForegroundExitMethod();
-void runForeground(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus);
-void runBackground(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList);
-void executeChild(struct CommandInfo* myCommand, int isBgCommand);
+void runForeground(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		   struct TimeoutRequest* timeoutRequest);
+void waitForChild(pid_t childPid, int* childExitMethod, struct rusage* usage);
+void wakeOnChildExit(int fd, void* arg);
+void setExitMethod(struct ForegroundExitMethod* lastFgStatus, int childExitMethod);
+void runBackground(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList,
+		   struct TimeoutRequest* timeoutRequest);
+struct BackgroundNode* launchBackground(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList);
+void executeChild(struct CommandInfo* myCommand, int isBgCommand, int captureFd, int outputFd, int timingFd);
 
 #endif
@@ -0,0 +1,133 @@
+/***************************************************************************************
+ * File: densmora.commandLists.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		decide from the ForegroundExitMethod struct whether the last command
+ * 		of a list succeeded, and that run the shell's startup file through
+ * 		the same parser as lines typed at the prompt (see densmora.script.c,
+ * 		which runs the lists themselves).
+ **************************************************************************************/
+
+#include "densmora.commandLists.h"
+#include "densmora.script.h"
+
+
+/***************************************************************************************
+ * Function Name: lastCommandSucceeded
+ * Description:	Receives the ForegroundExitMethod struct. Returns TRUE if the last
+ * 		foreground command exited with status 0, or FALSE otherwise.
+ **************************************************************************************/
+
+int lastCommandSucceeded(struct ForegroundExitMethod* lastFgStatus)
+{
+	return (lastFgStatus->exitedNormally == TRUE && lastFgStatus->code == 0) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: runStartupFile
+ * Description:	Receives the ForegroundExitMethod struct and the BackgroundCommands
+ * 		list. Runs each line of the startup file ($SMALLSH_RC if it is set,
+ * 		where an empty value means none, or ~/.smallshrc otherwise) as if it
+ * 		had been typed at the prompt, so that it can define aliases, export
+ * 		variables, and run commands. A block (such as a loop or function)
+ * 		may span several lines like at the prompt, and one left open at the
+ * 		end of the file is reported. A missing file is silently skipped.
+ * 		Plain alias lines (usually most of the file) are handed straight to
+ * 		the alias built-in, skipping the parsing that other lines go through.
+ * 		Returns TRUE if a line ran "exit", or FALSE otherwise.
+ **************************************************************************************/
+
+int runStartupFile(struct ForegroundExitMethod* lastFgStatus, struct BackgroundCommands* bgCommandsList)
+{
+	char path[PATH_MAX];
+	char* line = NULL;
+	size_t bufferSize = 0;
+	ssize_t charsRead;
+	int timeToExit = FALSE;
+	struct ScriptBuffer scriptBuffer = { NULL, 0 };
+
+	/* Find the file, returning if there is none. */
+	char* setting = getEnvVar("SMALLSH_RC");
+	char* home = getEnvVar("HOME");
+	if (setting != NULL)
+	{
+		snprintf(path, PATH_MAX, "%s", setting);
+	}
+	else if (home != NULL)
+	{
+		snprintf(path, PATH_MAX, "%s/.smallshrc", home);
+	}
+	else
+	{
+		return FALSE;
+	}
+	FILE* startupFile = (path[0] != '\0') ? fopen(path, "re") : NULL;
+	if (startupFile == NULL)
+	{
+		return FALSE;
+	}
+
+	/* Run each line (without its newline), rejecting lines that are too long like the prompt does. */
+	while (timeToExit == FALSE && (charsRead = getline(&line, &bufferSize, startupFile)) != -1)
+	{
+		if (charsRead > 0 && line[charsRead - 1] == '\n')
+		{
+			line[--charsRead] = '\0';
+		}
+		if (charsRead > MAX_COMMAND_CHARS)
+		{
+			fprintf(stderr, "%s: line longer than %d chars ignored\n", path, MAX_COMMAND_CHARS); fflush(stderr);
+			continue;
+		}
+		if (isScriptIncomplete(&scriptBuffer) == TRUE || defineStartupAlias(line) == FALSE)
+		{
+			timeToExit = runScriptLine(&scriptBuffer, line, lastFgStatus, bgCommandsList);
+		}
+	}
+	if (isScriptIncomplete(&scriptBuffer) == TRUE)
+	{
+		fprintf(stderr, "%s: unexpected end of file\n", path); fflush(stderr);
+		discardScriptBuffer(&scriptBuffer);
+	}
+	free(line);
+	fclose(startupFile);
+	return timeToExit;
+}
+
+
+/***************************************************************************************
+ * Function Name: defineStartupAlias
+ * Description:	Receives a line of the startup file (which is modified if it is used).
+ * 		If it is a lone "alias" command whose words need none of the parsing
+ * 		done by the script parser (no operators, redirections, comments, "$$", or
+ * 		"&"), splits it into words and runs the alias built-in on them.
+ * 		Returns TRUE if the line was handled, or FALSE if it must be run
+ * 		normally.
+ **************************************************************************************/
+
+int defineStartupAlias(char* line)
+{
+	char* args[MAX_COMMAND_ARGS + 2];
+	int numArgs = 0;
+	char* savePtr;
+
+	if (strncmp(line, "alias ", 6) != 0 || strpbrk(line, ";&|<>#") != NULL || strstr(line, "$$") != NULL)
+	{
+		return FALSE;
+	}
+	for (char* word = strtok_r(line, " ", &savePtr); word != NULL; word = strtok_r(NULL, " ", &savePtr))
+	{
+		if (numArgs == MAX_COMMAND_ARGS + 1)
+		{
+			fprintf(stderr, "alias: too many words\n"); fflush(stderr);
+			return TRUE;
+		}
+		args[numArgs++] = word;
+	}
+	args[numArgs] = NULL;
+	shellStats.commandsExecuted++;
+	smallshAlias(args);
+	return TRUE;
+}
@@ -0,0 +1,21 @@
+/***************************************************************************************
+ * File: densmora.commandLists.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing prototypes of the functions that check the
+ * 		status of the last command of a list and run the shell's startup
+ * 		file. See densmora.commandLists.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_COMMAND_LISTS
+#define DENSMORA_COMMAND_LISTS
+
+/* My own header file inclusion. */
+#include "densmora.dispatch.h"
+
+/* Function prototypes (see densmora.commandLists.c for function descriptions and implementations). */
+int lastCommandSucceeded(struct ForegroundExitMethod* lastFgStatus);
+int runStartupFile(struct ForegroundExitMethod* lastFgStatus, struct BackgroundCommands* bgCommandsList);
+int defineStartupAlias(char* line);
+
+#endif
@@ -10,6 +10,21 @@
 
 /* Inclusion of header file corresponding to this implementation file. */
 #include "densmora.commands.h"
+#include "densmora.eventLog.h"
+#include "densmora.shellStats.h"
+#include "densmora.jobLog.h"
+#include "densmora.environment.h"
+#include "densmora.outputFanOut.h"
+#include "densmora.childProcesses.h"
+#include "densmora.glob.h"
+#include "densmora.braces.h"
+#include "densmora.phaseStats.h"
+#include "densmora.jobGraph.h"
+#include "densmora.jobBoard.h"
+#include "densmora.jobserver.h"
+
+/* Time spent expanding words while parsing the current command (see prepareCommand). */
+static unsigned long long expansionNsec = 0;
 
 
 /***************************************************************************************
@@ -32,6 +47,78 @@
  **************************************************************************************/
 
 struct CommandInfo* newCommand(struct BackgroundCommands* bgCommandsList)
+{
+	/* Declare and allocate new CommandInfo pointer. */
+	struct CommandInfo* myCommand = allocateCommand();
+
+	/* Loop until a command within the maximum number of chars and maximum number of args has been read in. */
+	int tooManyArgs;	/* flag to track if too many arguments are in commandLine. */
+	do
+	{
+		/* Get input line, storing return value of line length in temporary variable. */
+		int lineLength = getCommandLine(myCommand, bgCommandsList, ": ");
+
+		/* Set background flag and parse command to set values of args and redir variables,
+		 * setting tooManyArgs flag to value returned by prepareCommand function. */
+		tooManyArgs = prepareCommand(myCommand, lineLength);
+	} while(tooManyArgs == TRUE);
+
+	/* Return the pointer to the command to the calling function. */
+	return myCommand;
+}
+
+
+/***************************************************************************************
+ * Function Name: newCommandFromLine
+ * Description:	Receives a command line that did not come from the prompt (such as
+ * 		one sent by a client of the job-execution server). Allocates a new
+ * 		CommandInfo struct holding a copy of the line and parses it with the
+ * 		same grammar as lines typed at the prompt. Returns the pointer to the
+ * 		CommandInfo struct, or NULL if the line is blank, a comment, too long,
+ * 		or has too many arguments (the last two are reported to the user).
+ **************************************************************************************/
+
+struct CommandInfo* newCommandFromLine(char* line)
+{
+	int lineLength = strlen(line);
+
+	/* Ignore blank lines (including lines of only spaces or a lone &) and comment lines. */
+	if (strspn(line, " &") == lineLength || line[0] == '#')
+	{
+		return NULL;
+	}
+
+	/* Reject lines that exceed the maximum command length. */
+	if (lineLength > MAX_COMMAND_CHARS)
+	{
+		fprintf(stderr, "Command Length Error: Commands can only be a maximum length of %d chars.\n",
+			MAX_COMMAND_CHARS);
+		fflush(stderr);
+		return NULL;
+	}
+
+	/* Allocate new CommandInfo struct holding a copy of line (since parsing modifies it). */
+	struct CommandInfo* myCommand = allocateCommand();
+	myCommand->commandLine = strdup(line);
+
+	/* Parse the line, deleting the command if it has too many args. */
+	if (prepareCommand(myCommand, lineLength) == TRUE)
+	{
+		deleteCommand(myCommand);
+		return NULL;
+	}
+	return myCommand;
+}
+
+
+/***************************************************************************************
+ * Function Name: allocateCommand
+ * Description:	Allocates memory for a new CommandInfo struct and initializes its
+ * 		members so that it is ready to receive a command line. Receives
+ * 		nothing. Returns the pointer to the CommandInfo struct.
+ **************************************************************************************/
+
+struct CommandInfo* allocateCommand()
 {
 	/* Declare and allocate new CommandInfo pointer. */
 	struct CommandInfo* myCommand;
@@ -40,10 +127,14 @@ struct CommandInfo* newCommand(struct BackgroundCommands* bgCommandsList)
 	/* Initialize pointers to hold pieces of command line to NULL. */
 	myCommand->commandLine = NULL;
 	myCommand->commandArgs = NULL;
+	myCommand->argsCapacity = 0;
 	myCommand->outputRedirDest = NULL;
+	myCommand->extraOutputDests = NULL;
+	myCommand->numExtraOutputDests = 0;
 	myCommand->inputRedirDest = NULL;
 	myCommand->expansionList = NULL;
-
+	myCommand->envAssignments = NULL;
+	myCommand->numEnvAssignments = 0;
 
 	/* Initialize all flags to FALSE. */
 	myCommand->backgroundFlag = FALSE;
@@ -58,38 +149,177 @@ struct CommandInfo* newCommand(struct BackgroundCommands* bgCommandsList)
 	pid_t rawParentPid = getpid();
 	sprintf(myCommand->parentPid, "%d", (int)rawParentPid);
 
-	/* Loop until a command within the maximum number of chars and maximum number of args has been read in. */
-	int tooManyArgs;	/* flag to track if too many arguments are in commandLine. */
-	do
-	{
-		/* Get input line, storing return value of line length in temporary variable. */
-		int lineLength = getCommandLine(myCommand, bgCommandsList);
+	/* Return the pointer to the command to the calling function. */
+	return myCommand;
+}
 
-		/* If & is the last word of commandLine, set backgroundFlag to true
-		 * and replace & and preceding space with null terminators. */
-		if (myCommand->commandLine[lineLength-1] == '&' && myCommand->commandLine[lineLength-2] == ' ')
-		{
-			myCommand->backgroundFlag = TRUE;
-			myCommand->commandLine[lineLength-1] = '\0';
-			myCommand->commandLine[lineLength-2] = '\0';
-		}
 
-		/* Parse command to set values of args and redir variables,
-		 * setting tooManyArgs flag to value returned by parseCommand function. */
-		tooManyArgs = parseCommand(myCommand);
+/***************************************************************************************
+ * Function Name: copyCommand
+ * Description:	Receives a parsed CommandInfo pointer and the index of the arg at which
+ * 		the copy's args should start. Returns a new CommandInfo holding
+ * 		copies of those args and of the command's redirections, variable
+ * 		assignments, and background flag, which stays valid after the
+ * 		original is deleted. The strings are copied into one block owned by
+ * 		the copy's expansionList, so deleteCommand frees the copy as usual.
+ **************************************************************************************/
+
+struct CommandInfo* copyCommand(struct CommandInfo* source, int firstArg)
+{
+	struct CommandInfo* copy = allocateCommand();
+	int numArgs = 0;
+	size_t totalLength = 0;
 
-		/* If too many args were entered, warn the user before looping again. */
-		if (tooManyArgs == TRUE)
+	/* Add up the room needed for every string. */
+	while (source->commandArgs[firstArg + numArgs] != NULL)
+	{
+		totalLength += strlen(source->commandArgs[firstArg + numArgs++]) + 1;
+	}
+	for (int i = 0; i < source->numEnvAssignments; i++)
+	{
+		totalLength += strlen(source->envAssignments[i]) + 1;
+	}
+	for (int i = 0; i < source->numExtraOutputDests; i++)
+	{
+		totalLength += strlen(source->extraOutputDests[i]) + 1;
+	}
+	totalLength += (source->inputFlag == TRUE) ? strlen(source->inputRedirDest) + 1 : 0;
+	totalLength += (source->outputFlag == TRUE) ? strlen(source->outputRedirDest) + 1 : 0;
+
+	/* Allocate the block and the vectors, and copy each string into the block in turn. */
+	char* block = (char*)malloc(totalLength + 1);
+	char* next = block;
+	copy->expansionList = newPidExpansions();
+	addPidNode(copy->expansionList, block);
+	growCommandArgs(copy, numArgs + 1);
+	for (int i = 0; i < numArgs; i++)
+	{
+		copy->commandArgs[i] = strcpy(next, source->commandArgs[firstArg + i]);
+		next += strlen(next) + 1;
+	}
+	if (source->numEnvAssignments > 0)
+	{
+		copy->envAssignments = (char**)malloc(source->numEnvAssignments * sizeof(char*));
+		copy->numEnvAssignments = source->numEnvAssignments;
+		for (int i = 0; i < source->numEnvAssignments; i++)
 		{
-			fprintf(stderr, "Num Args Error: Only a maximum of %d arguments\n", MAX_COMMAND_ARGS); 
-			fflush(stderr);
-			fprintf(stderr, "(excluding the command path and any io redirection) are allowed per command.\n");
-			fflush(stderr);
+			copy->envAssignments[i] = strcpy(next, source->envAssignments[i]);
+			next += strlen(next) + 1;
 		}
-	} while(tooManyArgs == TRUE);
+	}
+	if (source->numExtraOutputDests > 0)
+	{
+		copy->extraOutputDests = (char**)malloc(source->numExtraOutputDests * sizeof(char*));
+		copy->numExtraOutputDests = source->numExtraOutputDests;
+		for (int i = 0; i < source->numExtraOutputDests; i++)
+		{
+			copy->extraOutputDests[i] = strcpy(next, source->extraOutputDests[i]);
+			next += strlen(next) + 1;
+		}
+	}
+	if (source->inputFlag == TRUE)
+	{
+		copy->inputFlag = TRUE;
+		copy->inputRedirDest = strcpy(next, source->inputRedirDest);
+		next += strlen(next) + 1;
+	}
+	if (source->outputFlag == TRUE)
+	{
+		copy->outputFlag = TRUE;
+		copy->outputRedirDest = strcpy(next, source->outputRedirDest);
+	}
+	copy->backgroundFlag = source->backgroundFlag;
+	return copy;
+}
 
-	/* Return the pointer to the command to the calling function. */
-	return myCommand;
+
+/***************************************************************************************
+ * Function Name: prepareCommand
+ * Description:	Receives a CommandInfo pointer whose commandLine has been filled in
+ * 		and the length of that line. Sets backgroundFlag if the line ends
+ * 		with " &" (removing it from the line), and then calls parseCommand
+ * 		and takeEnvAssignments. Returns TRUE if too many arguments were
+ * 		entered or they expand to more than a command can be given (after
+ * 		warning the user), or FALSE otherwise.
+ **************************************************************************************/
+
+int prepareCommand(struct CommandInfo* myCommand, int lineLength)
+{
+	/* If & is the last word of commandLine, set backgroundFlag to true
+	 * and replace & and preceding space with null terminators. */
+	if (lineLength >= 2 && myCommand->commandLine[lineLength-1] == '&' && myCommand->commandLine[lineLength-2] == ' ')
+	{
+		myCommand->backgroundFlag = TRUE;
+		myCommand->commandLine[lineLength-1] = '\0';
+		myCommand->commandLine[lineLength-2] = '\0';
+	}
+
+	/* Parse command to set values of args and redir variables, timing the expansions apart from the rest. */
+	struct timespec parseStart, parseEnd;
+	clock_gettime(CLOCK_MONOTONIC, &parseStart);
+	expansionNsec = 0;
+	int parseResult = parseCommand(myCommand);
+	clock_gettime(CLOCK_MONOTONIC, &parseEnd);
+	unsigned long long parseNsec = elapsedNsec(&parseStart, &parseEnd);
+	recordPhase(PHASE_PARSE, (parseNsec > expansionNsec) ? parseNsec - expansionNsec : 0);
+	if (expansionNsec > 0)
+	{
+		recordPhase(PHASE_EXPAND, expansionNsec);
+	}
+	int tooManyArgs = (parseResult != FALSE) ? TRUE : FALSE;
+
+	/* If too many args were entered, warn the user (parseCommand has already reported args that
+	 * expanded to more than a command can be given). */
+	if (parseResult == TRUE)
+	{
+		fprintf(stderr, "Num Args Error: Only a maximum of %d arguments\n", MAX_COMMAND_ARGS); 
+		fflush(stderr);
+		fprintf(stderr, "(excluding the command path and any io redirection) are allowed per command.\n");
+		fflush(stderr);
+	}
+
+	/* Otherwise, move any leading variable assignments out of the args. */
+	else if (parseResult == FALSE)
+	{
+		takeEnvAssignments(myCommand);
+	}
+	return tooManyArgs;
+}
+
+
+/***************************************************************************************
+ * Function Name: takeEnvAssignments
+ * Description:	Receives a parsed CommandInfo pointer. Moves the NAME=value words at
+ * 		the start of commandArgs into envAssignments and shifts the remaining
+ * 		args to the front. If every word was an assignment, commandArgs[0] is
+ * 		left NULL (and the assignments apply to the shell itself).
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void takeEnvAssignments(struct CommandInfo* myCommand)
+{
+	char** args = myCommand->commandArgs;
+	int numAssignments = 0;
+
+	/* Count the leading assignments, returning if there are none. */
+	while (args[numAssignments] != NULL && isEnvAssignment(args[numAssignments]) == TRUE)
+	{
+		numAssignments++;
+	}
+	if (numAssignments == 0)
+	{
+		return;
+	}
+
+	/* Copy the assignments, and shift the rest of the args (including the terminating NULL) forward. */
+	myCommand->envAssignments = (char**)malloc(numAssignments * sizeof(char*));
+	memcpy(myCommand->envAssignments, args, numAssignments * sizeof(char*));
+	myCommand->numEnvAssignments = numAssignments;
+	int i = 0;
+	do
+	{
+		args[i] = args[i + numAssignments];
+	} while (args[i++] != NULL);
 }
 
 
@@ -99,13 +329,14 @@ struct CommandInfo* newCommand(struct BackgroundCommands* bgCommandsList)
  * 		Receives pointer to CommandInfo struct whose commandLine variable will
  * 		be filled with the command line as well as pointer to BackgroundCommands
  * 		struct so that background commands can be checked to see if they have
- * 		finished before each new command prompt.
+ * 		finished before each new command prompt, and the prompt to print
+ * 		(": ", or "> " while a block spanning several lines is being typed).
  * 		Returns number of chars read into commandLine.
  **************************************************************************************/
 
-int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList)
+int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList, char* prompt)
 {
-	/* Declare variable to store chars read in by getline() calls to use in do-while loop conditional below. */
+	/* Declare variable to store chars read in by readInputLine() calls to use in do-while loop conditional below. */
 	int charsRead;
 
 	/* Read in command from user, looping again if any of the following are true:
@@ -114,11 +345,11 @@ int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgC
 	 * 3. The line is a comment line beginning with '#' */
 	do
 	{
-		/* Declare local variable to store buffer size and initialize to 0 for getline call. */
+		/* Declare local variable to store buffer size and initialize to 0 for readInputLine call. */
 		size_t bufferSize = 0;
 		
-		/* If myCommand->commandLine is not NULL, a previous call to getline allocated memory for it.
-		 * Free the memory and reset myCommand->commandLine to NULL to prepare for next getline call. */
+		/* If myCommand->commandLine is not NULL, a previous call to readInputLine allocated memory for it.
+		 * Free the memory and reset myCommand->commandLine to NULL to prepare for next readInputLine call. */
 		if (myCommand->commandLine != NULL)
 		{
 			free(myCommand->commandLine);
@@ -133,23 +364,25 @@ int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgC
 			checkCommandStatuses(bgCommandsList);
 		}
 		
-		/* Prompt user for command with ':' symbol and read in command with getline */
-		printf(": "); fflush(stdout);
-		charsRead = getline(&(myCommand->commandLine), &bufferSize, stdin);
-			
-		/* If getline function call was interrupted by a signal and returned error status -1,
-		 * clear the error from stdin in preparation for next getline call. */
-		if (charsRead == -1)
-		{
-			clearerr(stdin);
-		}
-
-		/* Otherwise, if at least 1 char was read and the line does not begin with a '#',
-		 * remove the trailing newline character and decrement charsRead to reflect
-		 * total length of actual command. Note that blank lines and comment lines
-		 * will simply be ignored and cause the loop to iterate again. */
-		else if (charsRead >= 1 && myCommand->commandLine[0] != '#')
+		/* Flush any events recorded while the last command ran now that the shell is idle. */
+		flushEventLog();
+
+		/* Prompt user for command with the prompt given, service the event loop until input is available,
+		 * and read in command with readInputLine */
+		fprintf(shellOutput, "%s", prompt); fflush(shellOutput);
+		waitForInput();
+		struct timespec readStart;
+		clock_gettime(CLOCK_MONOTONIC, &readStart);
+		charsRead = readInputLine(&(myCommand->commandLine), &bufferSize);
+
+		/* If at least 1 char was read and the line does not begin with a '#',
+		 * record how long it took to read, remove the trailing newline character
+		 * and decrement charsRead to reflect total length of actual command.
+		 * Note that blank lines and comment lines will simply be ignored and
+		 * cause the loop to iterate again. */
+		if (charsRead >= 1 && myCommand->commandLine[0] != '#')
 		{
+			recordPhaseSince(PHASE_READ, &readStart);
 			myCommand->commandLine[charsRead-1] = '\0';
 			charsRead--;
 
@@ -180,6 +413,8 @@ int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgC
  * 		or outputRedirDest to the desired destinations if applicable.
  * 		Returns TRUE if the user has tried to pass in more than 
  * 		MAX_COMMAND_ARGS arguments and frees memory of commandArgs array.
+ * 		Likewise returns ARG_LIST_TOO_LONG (after reporting it) if the
+ * 		expanded args would not fit in a new process.
  * 		Otherwise, returns FALSE, leaving commandArgs array allocated
  * 		and filled as described above.
  **************************************************************************************/
@@ -190,37 +425,22 @@ int parseCommand(struct CommandInfo* myCommand)
 	int numArgs = 0;	/* Stores number of arguments passed in through commandLine (excluding command path). */
 	char* strToken;		/* Contains tokenized string returned by strtok_r. */
 	char* savePtr;		/* Contains savePtr for use by strtok_r. */
+	int tooLong = FALSE;	/* Set to TRUE once a word has expanded to more args than a command can be given. */
 		
 	/* Allocate space for args vector with size max number of arguments + 2 extra indices
-	 * (one for path variable at the first index, one for NULL pointer at final index). */
-	myCommand->commandArgs = (char**)malloc((MAX_COMMAND_ARGS + 2) * sizeof(char*));
-
-	/* Initialize all indices of commandArgs vector to NULL. */
-	for (int i = 0; i < MAX_COMMAND_ARGS + 2; i++)
-	{
-		myCommand->commandArgs[i] = NULL;
-	}
+	 * (one for path variable at the first index, one for NULL pointer at final index).
+	 * Wildcard words can expand past this, in which case the vector grows. */
+	myCommand->commandArgs = NULL;
+	myCommand->argsCapacity = 0;
+	growCommandArgs(myCommand, MAX_COMMAND_ARGS + 2);
 
-	/* Get path variable and store in first index of array. */
+	/* Get path variable and store in first index of array (expanding "$$" and wildcards in it). */
 	strToken = strtok_r(myCommand->commandLine, " ", &savePtr);
-	
-	/* If strToken contains the pattern "$$", send it to epxandPid function,
-	 * setting the path variable to the returned, expanded string. */
-	if (strstr(strToken, "$$") != NULL)
-	{
-		myCommand->commandArgs[0] = expandPid(myCommand, strToken);
-	}
-	
-	/* Otherwise, simply set path variable to strToken. */
-	else
-	{
-		myCommand->commandArgs[0] = strToken;
-	}
+	tooLong = addCommandArg(myCommand, strToken, &vectSize);
 
-	/* Increment vectSize but not numArgs since first element has been stored in vector,
+	/* Do not increment numArgs since first element has been stored in vector,
 	 * but it is the path (rather than an argument) of the command and, therefore, does not count
 	 * toward MAX_COMMAND_ARGS. */
-	vectSize++;
 
 	/* Get next token of commandLine in preparation for while loop below
 	 * (which will only run if there is at least 1 argument or io redirection after path variable). */
@@ -256,49 +476,51 @@ int parseCommand(struct CommandInfo* myCommand)
 		}
 
 		/* Else if output redirection operator is encountered,	
-		 * set outputFlag and set outputRedirDest to next token of commandLine. */
+		 * add the next token of commandLine as an output destination (setting outputFlag and
+		 * outputRedirDest for the first one, so that > a > b sends output to both files). */
 		else if (strlen(strToken) == 1 && strToken[0] == '>')
 		{
-			/* Set outputFlag to TRUE and get next token of commandLine for location of output redirection. */
-			myCommand->outputFlag = TRUE;
+			/* Get next token of commandLine for location of output redirection. */
 			strToken = strtok_r(NULL, " ", &savePtr);
 
 			/* If strToken contains the pattern "$$", send to expandPid function
-			 * so that all instances of "$$" in the token are expanded, assigning
-			 * its return value to outputRedirDest. */
+			 * so that all instances of "$$" in the token are expanded, adding
+			 * its return value as an output destination. */
 			if (strstr(strToken, "$$") != NULL)
 			{
-				myCommand->outputRedirDest = expandPid(myCommand, strToken);
+				addOutputDest(myCommand, expandPid(myCommand, strToken));
 			}
 
-			/* Otherwise, simply assign strToken to outputRedirDest. */
+			/* Otherwise, simply add strToken as an output destination. */
 			else
 			{
-				myCommand->outputRedirDest = strToken;
+				addOutputDest(myCommand, strToken);
 			}
 		}
 
+		/* Else if the fan-out operator >+ is encountered, add every following token up to the next
+		 * redirection operator (or the end of commandLine) as an output destination. */
+		else if (strcmp(strToken, ">+") == 0)
+		{
+			strToken = strtok_r(NULL, " ", &savePtr);
+			while (strToken != NULL && strcmp(strToken, "<") != 0 && strcmp(strToken, ">") != 0
+			       && strcmp(strToken, ">+") != 0)
+			{
+				addOutputDest(myCommand, (strstr(strToken, "$$") != NULL) ? expandPid(myCommand, strToken) : strToken);
+				strToken = strtok_r(NULL, " ", &savePtr);
+			}
+
+			/* The token that ended the list (if any) has not been handled yet, so skip fetching the next one. */
+			continue;
+		}
+
 		/* Otherwise, if less than the max number of arguments have been read in,
 		 * read in the next argument to the next open index of the args array
+		 * (or the files it matches, which do not count toward MAX_COMMAND_ARGS)
 		 * and increment vectSize and numArgs. */
 		else if (numArgs < MAX_COMMAND_ARGS)
 		{
-			/* If strToken contains the pattern "$$", send to expandPid function
-			 * so that all instances of "$$" in the token are expanded, assigning
-			 * its return value to the next open index of commandArgs. */
-			if (strstr(strToken, "$$") != NULL)
-			{
-				myCommand->commandArgs[vectSize] = expandPid(myCommand, strToken);
-			}
-
-			/* Otherwise, simply assign strToken to next open index of commandArgs. */
-			else
-			{
-				myCommand->commandArgs[vectSize] = strToken;
-			}
-			
-			/* Increment vectSize and numArgs. */
-			vectSize++;
+			tooLong = (tooLong == TRUE) ? TRUE : addCommandArg(myCommand, strToken, &vectSize);
 			numArgs++;
 		}
 
@@ -314,18 +536,7 @@ int parseCommand(struct CommandInfo* myCommand)
 		 * io redirection variables are ever changed from their initial values. */
 		else
 		{
-			/* Free commandArgs vector and reset pointer to NULL. */
-			free(myCommand->commandArgs);
-			myCommand->commandArgs = NULL;
-
-			/* If expansionList has been allocated, free its data and reset pointer to NULL
-			 * as well since new command is about to be read in after returning
-			 * to newCommand function. */
-			if (myCommand->expansionList != NULL)
-			{
-				deletePidExpansions(myCommand->expansionList);
-				myCommand->expansionList = NULL;
-			}
+			discardCommandArgs(myCommand);
 
 			/* Return TRUE to calling function to indicate that too many args were entered. */
 			return TRUE;
@@ -335,8 +546,193 @@ int parseCommand(struct CommandInfo* myCommand)
 		strToken = strtok_r(NULL, " ", &savePtr);
 	}
 
-	/* Since the loop above terminated without returning TRUE,
-	 * return FALSE to indicate that the number of args read in does not exceed the maximum. */
+	/* Since the loop above terminated without returning TRUE, the number of args read in does not exceed
+	 * the maximum, but their expansions may still be too large to give to a command. */
+	if (tooLong == TRUE || isArgListTooLong(myCommand->commandArgs) == TRUE)
+	{
+		discardCommandArgs(myCommand);
+		return ARG_LIST_TOO_LONG;
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: addCommandArg
+ * Description: Receives a CommandInfo pointer, a word of its command line, and the
+ * 		address of the number of elements stored in commandArgs. Expands any
+ * 		"$$" and then any braces in the word, and stores the resulting words
+ * 		at the end of commandArgs with addExpandedWord, updating the number
+ * 		of elements (and timing the expansion if there is one). Returns TRUE if the braces expand to more than a command
+ * 		can be given (after reporting it), or FALSE otherwise.
+ **************************************************************************************/
+
+int addCommandArg(struct CommandInfo* myCommand, char* word, int* vectSize)
+{
+	int tooLong = FALSE;
+	struct timespec expandStart;
+
+	/* Store a word with nothing to expand as it is. */
+	if (strpbrk(word, "${*?[") == NULL)
+	{
+		growCommandArgs(myCommand, *vectSize + 2);
+		myCommand->commandArgs[(*vectSize)++] = word;
+		return FALSE;
+	}
+
+	/* Otherwise, expand it, adding the time taken to the expansion phase. */
+	clock_gettime(CLOCK_MONOTONIC, &expandStart);
+	if (strstr(word, "$$") != NULL)
+	{
+		word = expandPid(myCommand, word);
+	}
+	int expanded = (strchr(word, '{') != NULL) ? expandBraces(myCommand, word, vectSize) : FALSE;
+	if (expanded == FALSE)
+	{
+		addExpandedWord(myCommand, word, vectSize);
+	}
+	tooLong = (expanded == -1) ? TRUE : FALSE;
+
+	struct timespec expandEnd;
+	clock_gettime(CLOCK_MONOTONIC, &expandEnd);
+	expansionNsec += elapsedNsec(&expandStart, &expandEnd);
+	return tooLong;
+}
+
+
+/***************************************************************************************
+ * Function Name: addExpandedWord
+ * Description: Receives a CommandInfo pointer, a word whose "$$" and braces have
+ * 		been expanded, and the address of the number of elements stored in
+ * 		commandArgs. If the word contains wildcards, stores the names of the
+ * 		matching files at the end of commandArgs; otherwise (or if no file
+ * 		matches), stores the word itself. Updates the number of elements.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void addExpandedWord(struct CommandInfo* myCommand, char* word, int* vectSize)
+{
+	if (hasGlobChars(word) == TRUE)
+	{
+		int numMatches = expandGlob(myCommand, word, *vectSize);
+		if (numMatches > 0)
+		{
+			*vectSize += numMatches;
+			return;
+		}
+	}
+
+	/* Leave room for the terminating NULL after the word. */
+	growCommandArgs(myCommand, *vectSize + 2);
+	myCommand->commandArgs[*vectSize] = word;
+	(*vectSize)++;
+}
+
+
+/***************************************************************************************
+ * Function Name: growCommandArgs
+ * Description: Receives a CommandInfo pointer and a number of elements. Makes sure
+ * 		commandArgs has room for at least that many, at least doubling its
+ * 		size when it grows and setting the new elements to NULL. Returns
+ * 		nothing.
+ **************************************************************************************/
+
+void growCommandArgs(struct CommandInfo* myCommand, int minCapacity)
+{
+	if (minCapacity <= myCommand->argsCapacity)
+	{
+		return;
+	}
+	int newCapacity = 2 * myCommand->argsCapacity;
+	if (newCapacity < minCapacity)
+	{
+		newCapacity = minCapacity;
+	}
+	myCommand->commandArgs = (char**)realloc(myCommand->commandArgs, newCapacity * sizeof(char*));
+	for (int i = myCommand->argsCapacity; i < newCapacity; i++)
+	{
+		myCommand->commandArgs[i] = NULL;
+	}
+	myCommand->argsCapacity = newCapacity;
+}
+
+
+/***************************************************************************************
+ * Function Name: discardCommandArgs
+ * Description: Receives a CommandInfo pointer whose command line could not be
+ * 		parsed. Frees its commandArgs, expanded words, and extra output
+ * 		destinations, resetting them so that another line can be parsed
+ * 		into the struct. Returns nothing.
+ **************************************************************************************/
+
+void discardCommandArgs(struct CommandInfo* myCommand)
+{
+	/* Free commandArgs vector and reset pointer to NULL. */
+	free(myCommand->commandArgs);
+	myCommand->commandArgs = NULL;
+	myCommand->argsCapacity = 0;
+
+	/* If expansionList has been allocated, free its data and reset pointer to NULL
+	 * as well since new command is about to be read in after returning
+	 * to newCommand function. */
+	if (myCommand->expansionList != NULL)
+	{
+		deletePidExpansions(myCommand->expansionList);
+		myCommand->expansionList = NULL;
+	}
+
+	/* Likewise drop any redirections and extra output destinations, and the background flag. */
+	free(myCommand->extraOutputDests);
+	myCommand->extraOutputDests = NULL;
+	myCommand->numExtraOutputDests = 0;
+	myCommand->inputFlag = FALSE;
+	myCommand->inputRedirDest = NULL;
+	myCommand->outputFlag = FALSE;
+	myCommand->outputRedirDest = NULL;
+	myCommand->backgroundFlag = FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: getArgListLimit
+ * Description: Returns the number of bytes left for the args of a new process (the
+ * 		system's ARG_MAX less the room taken by the environment passed to
+ * 		commands, counting a pointer and a null terminator per string).
+ * 		Receives nothing.
+ **************************************************************************************/
+
+long getArgListLimit()
+{
+	long limit = sysconf(_SC_ARG_MAX);
+	for (char** env = getEnvp(); *env != NULL; env++)
+	{
+		limit -= strlen(*env) + 1 + sizeof(char*);
+	}
+	return limit;
+}
+
+
+/***************************************************************************************
+ * Function Name: isArgListTooLong
+ * Description: Receives a NULL-terminated args vector. Returns TRUE if it takes more
+ * 		room than a new process can be given (after reporting it), or FALSE
+ * 		otherwise.
+ **************************************************************************************/
+
+int isArgListTooLong(char** args)
+{
+	long limit = getArgListLimit();
+	long needed = sizeof(char*);
+	for (int i = 0; args[i] != NULL && needed <= limit; i++)
+	{
+		needed += strlen(args[i]) + 1 + sizeof(char*);
+	}
+	if (needed > limit)
+	{
+		fprintf(stderr, "Arg List Error: the expanded args take more than the %ld bytes a command can be given.\n", limit);
+		fflush(stderr);
+		return TRUE;
+	}
 	return FALSE;
 }
 
@@ -445,8 +841,11 @@ void deleteCommand(struct CommandInfo* myCommand)
 		deletePidExpansions(myCommand->expansionList);
 	}
 	
-	/* Free dynamically allocated memory for commandLine, commandVector, parentPid, and command itself. */
+	/* Free dynamically allocated memory for commandLine, commandVector, envAssignments, extraOutputDests,
+	 * parentPid, and command itself. */
 	free(myCommand->commandArgs);
+	free(myCommand->envAssignments);
+	free(myCommand->extraOutputDests);
 	free(myCommand->commandLine);
 	free(myCommand->parentPid);
 	free(myCommand);
@@ -457,7 +856,8 @@ void deleteCommand(struct CommandInfo* myCommand)
  * Function Name: newBackgroundCommands
  * Description: Declares and allocates memory for a new, empty BackgroundCommands
  * 		linked list where each link contains the pid of a background child
- * 		process and a pointer to the next link. Receives nothing. Returns
+ * 		process and pointers to the links around it, along with an empty
+ * 		table of the links by pid. Receives nothing. Returns
  * 		pointer to the newly-allocated linked list.
  **************************************************************************************/
 
@@ -470,6 +870,14 @@ struct BackgroundCommands* newBackgroundCommands()
 	/* Initialize numNodes to 0 and head to NULL. */
 	commandsList->numNodes = 0;
 	commandsList->head = NULL;
+	memset(commandsList->byPid, 0, sizeof(commandsList->byPid));
+	commandsList->reapObserver = NULL;
+	commandsList->reapObserverArg = NULL;
+	commandsList->jobGraph = NULL;
+	commandsList->numReapHolds = 0;
+	commandsList->reapPipe[0] = -1;
+	commandsList->reapPipe[1] = -1;
+	commandsList->reapWatcher = NULL;
 
 	/* Return commandsList to calling function. */
 	return commandsList;
@@ -480,22 +888,42 @@ struct BackgroundCommands* newBackgroundCommands()
  * Function Name: addBackgroundNode
  * Description: Receives a pointer to a BackgroundCommands linked list and the pid
  * 		of a background process for which a node is to be added. Allocates
- * 		memory for the new load and adds it to the linked list. Returns nothing.
+ * 		memory for the new load and adds it to the linked list and to the
+ * 		table of nodes by pid. Returns a
+ * 		pointer to the new node so that callers can set its onDone handler.
  **************************************************************************************/
 
-void addBackgroundNode(struct BackgroundCommands* commandsList, pid_t pidIn)
+struct BackgroundNode* addBackgroundNode(struct BackgroundCommands* commandsList, pid_t pidIn)
 {
 	/* Declare and allocate memory for new BackgroundNode. */
 	struct BackgroundNode* newNode;
 	newNode = (struct BackgroundNode*)malloc(sizeof(struct BackgroundNode));
 
-	/* Initialize pid based on pid passed in. */
+	/* Initialize pid based on pid passed in, and record launch time for reporting its duration later. */
 	newNode->pid = pidIn;
+	clock_gettime(CLOCK_MONOTONIC, &newNode->startTime);
+
+	/* Nodes report their exit status to the user unless a caller sets an onDone handler. */
+	newNode->onDone = NULL;
+	newNode->owner = NULL;
+	newNode->timeout = NULL;
+	newNode->boardSlot = -1;
+	newNode->jobToken = -1;
 
 	/* Add commandNode to the front of the list by simply placing it before old head and incrementing numNodes. */
 	newNode->next = commandsList->head;
+	newNode->prev = NULL;
+	if (commandsList->head != NULL)
+	{
+		commandsList->head->prev = newNode;
+	}
 	commandsList->head = newNode;
 	commandsList->numNodes++;
+
+	/* Add it to its bucket of the table too, so that it can be found by pid once reaped. */
+	newNode->nextByPid = commandsList->byPid[pidIn % BACKGROUND_BUCKETS];
+	commandsList->byPid[pidIn % BACKGROUND_BUCKETS] = newNode;
+	return newNode;
 }
 
 
@@ -511,77 +939,278 @@ void addBackgroundNode(struct BackgroundCommands* commandsList, pid_t pidIn)
 
 void checkCommandStatuses(struct BackgroundCommands* commandsList)
 {
-	/* Initialize currentNode to list head
-	 * and previousNode (utilized by removeBackgroundNode function below) to NULL. */
+	/* Initialize currentNode to list head. */
 	struct BackgroundNode* currentNode = commandsList->head;
-	struct BackgroundNode* previousNode = NULL;
 
 	/* Iterate through commandsList, removing any nodes whose processes have terminated. */
 	while(currentNode != NULL)
 	{
 		/* See if process specified by currentNode->pid has completed. */
-		int childExitMethod;		/* Holds exit status int into which waitpid writes. */
-		pid_t pidReturned;		/* Holds pid returned by waitpid. */
-		pidReturned = waitpid(currentNode->pid, &childExitMethod, WNOHANG);
+		int childExitMethod;		/* Holds exit status int into which wait4 writes. */
+		struct rusage usage;		/* Holds resource usage into which wait4 writes. */
+		pid_t pidReturned;		/* Holds pid returned by wait4. */
+		pidReturned = wait4(currentNode->pid, &childExitMethod, WNOHANG, &usage);
 		
 		/* If pidReturned == currendNode->pid, process has terminated;
-		 * get next node in preparation for next iteration and remove this node. Report to user exit status. */
+		 * get next node in preparation for next iteration and finish this node (reporting
+		 * its exit status and removing it from commandsList). */
 		if (pidReturned == currentNode->pid)
 		{
-			/* If the child exited normally, print its exit status. */
-			if (WIFEXITED(childExitMethod) != 0)
-			{
-				int exitStatus = WEXITSTATUS(childExitMethod);
-				printf("background pid %d is done: exit value %d\n", (int)pidReturned, exitStatus);
-				fflush(stdout);
-			}
-			/* If the child was terminated by a signal, print its termination signal. */
-			if (WIFSIGNALED(childExitMethod) != 0)
-			{
-				int termSig = WTERMSIG(childExitMethod);
-				printf("background pid %d is done: terminated by signal %d\n", (int)pidReturned, termSig);
-				fflush(stdout);
-			}
-
-			/* Remove currentNode from commandsList so that its dynamically allocated data can be freed.
-			 * Leave value of previousNode the same since gap created by removing currentNode will leave
-			 * previousNode's value the same for next iteration. */
-			struct BackgroundNode* garbageNode = currentNode;
+			struct BackgroundNode* finishedNode = currentNode;
 			currentNode = currentNode->next;
-			removeBackgroundNode(commandsList, garbageNode, previousNode);
+			finishBackgroundNode(commandsList, finishedNode, childExitMethod, &usage);
 		}
 
-		/* Otherwise, the process has not exited; simply update previousNode and currentNode for next loop. */
+		/* Otherwise, the process has not exited; simply update currentNode for next loop. */
 		else
 		{
-			previousNode = currentNode;
 			currentNode = currentNode->next;
 		}
 	}
+
+	/* Launch any jobs that were waiting on the jobs just reaped, now that the list is no longer being walked. */
+	launchReadyJobs(commandsList);
+}
+
+
+/***************************************************************************************
+ * Function Name: holdBackgroundReaping
+ * Description:	Receives a BackgroundCommands linked list. Normally, finished jobs are
+ * 		only reaped before each prompt; while at least one hold is in place,
+ * 		they are also reaped as they exit, even while the shell sits at the
+ * 		prompt or runs a foreground command. This is done by watching a pipe
+ * 		that catchSIGCHLD writes to (through sigchldNotifyFd) along with the
+ * 		SIGCHLD self-pipe, which cannot be shared since the shell drains it
+ * 		while waiting for a foreground command. Used by code that must act as
+ * 		soon as jobs exit (such as launching the jobs waiting on them).
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void holdBackgroundReaping(struct BackgroundCommands* commandsList)
+{
+	if (commandsList->numReapHolds++ > 0)
+	{
+		return;
+	}
+	if (commandsList->reapPipe[0] == -1 && pipe2(commandsList->reapPipe, O_NONBLOCK | O_CLOEXEC) == 0)
+	{
+		commandsList->reapPipe[0] = raiseShellFd(commandsList->reapPipe[0]);
+		commandsList->reapPipe[1] = raiseShellFd(commandsList->reapPipe[1]);
+	}
+	if (commandsList->reapPipe[0] != -1)
+	{
+		commandsList->reapWatcher = addEventWatcher(commandsList->reapPipe[0], reapOnChildExit, commandsList);
+		sigchldNotifyFd = commandsList->reapPipe[1];
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: releaseBackgroundReaping
+ * Description:	Receives a BackgroundCommands linked list. Releases a hold placed by
+ * 		holdBackgroundReaping, no longer reaping jobs as they exit once none
+ * 		are left. Returns nothing.
+ **************************************************************************************/
+
+void releaseBackgroundReaping(struct BackgroundCommands* commandsList)
+{
+	if (--commandsList->numReapHolds > 0 || commandsList->reapWatcher == NULL)
+	{
+		return;
+	}
+	sigchldNotifyFd = -1;
+	removeEventWatcher(commandsList->reapWatcher);
+	commandsList->reapWatcher = NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: reapOnChildExit
+ * Description:	Event loop callback for the pipe watched while reaping is held.
+ * 		Receives the descriptor and the BackgroundCommands list. Drains the
+ * 		pipe and reaps finished background jobs. While a foreground command
+ * 		runs, jobs are reaped by pid so that its exit is left for the shell
+ * 		to collect. Returns nothing.
+ **************************************************************************************/
+
+void reapOnChildExit(int fd, void* arg)
+{
+	struct BackgroundCommands* commandsList = (struct BackgroundCommands*)arg;
+	char buffer[256];
+
+	while (read(fd, buffer, sizeof(buffer)) > 0)
+	{
+	}
+	if (foregroundActive == TRUE)
+	{
+		checkCommandStatuses(commandsList);
+	}
+	else
+	{
+		reapBackgroundCommands(commandsList);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: reapBackgroundCommands
+ * Description: Reaps every child process that has exited without waiting for any
+ * 		that are still running, finishing the node of each one found in
+ * 		commandsList. Unlike checkCommandStatuses, this makes one wait4 call
+ * 		per exited child rather than one per running child, so it is used
+ * 		when many children may be running and no foreground child exists
+ * 		(such as by the job-execution server on SIGCHLD). Receives the
+ * 		BackgroundCommands list. Returns nothing.
+ **************************************************************************************/
+
+void reapBackgroundCommands(struct BackgroundCommands* commandsList)
+{
+	int childExitMethod;		/* Holds exit status int into which wait4 writes. */
+	struct rusage usage;		/* Holds resource usage into which wait4 writes. */
+	pid_t pidReturned;		/* Holds pid returned by wait4. */
+
+	/* Reap exited children until none are left, finishing the node of each. */
+	while ((pidReturned = wait4(-1, &childExitMethod, WNOHANG, &usage)) > 0)
+	{
+		struct BackgroundNode* finishedNode = findBackgroundNode(commandsList, pidReturned);
+		if (finishedNode != NULL)
+		{
+			finishBackgroundNode(commandsList, finishedNode, childExitMethod, &usage);
+		}
+	}
+
+	/* Launch any jobs that were waiting on the jobs just reaped. */
+	launchReadyJobs(commandsList);
+}
+
+
+/***************************************************************************************
+ * Function Name: findBackgroundNode
+ * Description: Receives a BackgroundCommands linked list and a pid. Returns the node
+ * 		holding pid (looked up in the list's table of nodes by pid), or NULL
+ * 		if no node holds pid.
+ **************************************************************************************/
+
+struct BackgroundNode* findBackgroundNode(struct BackgroundCommands* commandsList, pid_t pid)
+{
+	/* Search only the bucket that pid hashes to. */
+	struct BackgroundNode* currentNode = commandsList->byPid[pid % BACKGROUND_BUCKETS];
+	while (currentNode != NULL && currentNode->pid != pid)
+	{
+		currentNode = currentNode->nextByPid;
+	}
+	return currentNode;
+}
+
+
+/***************************************************************************************
+ * Function Name: finishBackgroundNode
+ * Description: Receives a BackgroundCommands linked list, a node of that list whose
+ * 		process has been reaped, and the exit method and
+ * 		resource usage returned by wait4. Records the exit in the event log
+ * 		and stats, tells the job graph (if any) so that jobs defined with
+ * 		after that were waiting on it are queued, reports it (through the
+ * 		node's onDone handler if it has one, or to the user otherwise,
+ * 		noting if it was stopped by the timeout built-in), and removes the
+ * 		node from the list.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void finishBackgroundNode(struct BackgroundCommands* commandsList, struct BackgroundNode* finishedNode,
+			  int childExitMethod, struct rusage* usage)
+{
+	/* If the job had a deadline, stop it now that the pid may be recycled, noting whether it expired. */
+	char* timeoutNote = "";
+	if (finishedNode->timeout != NULL)
+	{
+		if (finishedNode->timeout->expired == TRUE)
+		{
+			timeoutNote = " (timed out)";
+		}
+		stopJobTimeout(finishedNode->timeout);
+		finishedNode->timeout = NULL;
+	}
+
+	/* Start the retention period of the job's captured output, if any. */
+	finishJobLog(finishedNode->pid);
+
+	/* Record the exit in the event log, stats, and job status board, and give back its jobserver token. */
+	logCommandExit(finishedNode->pid, TRUE, childExitMethod, &finishedNode->startTime, usage);
+	recordExitMethod(childExitMethod);
+	publishJobExit(finishedNode, childExitMethod);
+	releaseJobToken(commandsList, finishedNode);
+
+	/* Tell the list's observer (such as a running wait built-in) about the exit. */
+	if (commandsList->reapObserver != NULL)
+	{
+		commandsList->reapObserver(finishedNode->pid, childExitMethod, commandsList->reapObserverArg);
+	}
+
+	/* Queue the jobs defined with after that were waiting on this one. */
+	if (commandsList->jobGraph != NULL)
+	{
+		recordJobExit(commandsList->jobGraph, finishedNode->pid, childExitMethod);
+	}
+
+	/* If the node has its own handler, let it report the exit. */
+	if (finishedNode->onDone != NULL)
+	{
+		finishedNode->onDone(finishedNode, childExitMethod);
+	}
+
+	/* Otherwise, if the child exited normally, print its exit status. */
+	else if (WIFEXITED(childExitMethod) != 0)
+	{
+		int exitStatus = WEXITSTATUS(childExitMethod);
+		fprintf(shellOutput, "background pid %d is done: exit value %d%s\n", (int)finishedNode->pid, exitStatus, timeoutNote);
+		fflush(shellOutput);
+	}
+
+	/* Otherwise, if the child was terminated by a signal, print its termination signal. */
+	else if (WIFSIGNALED(childExitMethod) != 0)
+	{
+		int termSig = WTERMSIG(childExitMethod);
+		fprintf(shellOutput, "background pid %d is done: terminated by signal %d%s\n", (int)finishedNode->pid, termSig, timeoutNote);
+		fflush(shellOutput);
+	}
+
+	/* Remove finishedNode from commandsList so that its dynamically allocated data can be freed. */
+	removeBackgroundNode(commandsList, finishedNode);
 }
 
 
 /***************************************************************************************
  * Function Name: removeBackgroundNode
- * Description: Receives a BackgroundCommands linked list pointer, the node to be
- * 		removed (garbageNode), and the node before garbageNode. Removes
- * 		garbageNode from the linked list and deallocates its memory. 
+ * Description: Receives a BackgroundCommands linked list pointer and the node to be
+ * 		removed (garbageNode). Removes garbageNode from the linked list and
+ * 		from the table of nodes by pid, and deallocates its memory.
  * 		Returns nothing.
  **************************************************************************************/
 
-void removeBackgroundNode(struct BackgroundCommands* commandsList, 
-			  struct BackgroundNode* garbageNode, struct BackgroundNode* previousNode)
+void removeBackgroundNode(struct BackgroundCommands* commandsList, struct BackgroundNode* garbageNode)
 {
 	/* If garbageNode is list head, make head->next the new list head. */
 	if (garbageNode == commandsList->head)
 	{
 		commandsList->head = commandsList->head->next;
 	}
-	/* Otherwise, connect previousNode to garbageNode->next. */
+	/* Otherwise, connect the node before garbageNode to garbageNode->next. */
 	else
 	{
-		previousNode->next = garbageNode->next;
-	} 
+		garbageNode->prev->next = garbageNode->next;
+	}
+	if (garbageNode->next != NULL)
+	{
+		garbageNode->next->prev = garbageNode->prev;
+	}
+
+	/* Unlink garbageNode from its bucket, which holds few nodes. */
+	struct BackgroundNode** link = &commandsList->byPid[garbageNode->pid % BACKGROUND_BUCKETS];
+	while (*link != garbageNode)
+	{
+		link = &(*link)->nextByPid;
+	}
+	*link = garbageNode->nextByPid;
 
 	/* Now that gap that would be created by removing garbageNode has been eliminated, 
 	 * free all dynamically allocated data of garbageNode and decrement numNodes. */
@@ -595,44 +1224,183 @@ void removeBackgroundNode(struct BackgroundCommands* commandsList,
  * Function Name: deleteBackgroundCommands
  * Description: Frees all dynamically-allocated memory associated with a
  * 		BackgroundCommands linked list. Reaps child processes that are zombies,
- * 		and kills all child background processes that are still running (reaping
- * 		them after killing them). Receives pointer to a BackgroundCommands list.
- * 		Returns nothing.
+ * 		and stops all child background processes that are still running with
+ * 		terminateBackgroundCommands (reaping them as they exit). Receives
+ * 		pointer to a BackgroundCommands list. Returns nothing.
  **************************************************************************************/
 
 void deleteBackgroundCommands(struct BackgroundCommands* commandsList)
 {
-	/* Initialize pointer to currentNode to list head. */
-	struct BackgroundNode* currentNode = commandsList->head;
+	/* Drop the jobs still waiting, so that none are launched as the others exit. */
+	deleteJobGraph(commandsList);
 
-	/* Iterate through all nodes of list, terminating all processes and freeing all dynamically allocated memory. */
-	while (currentNode != NULL)
+	/* Stop reaping jobs as they exit (such as for jobs holding jobserver tokens), since every job
+	 * is reaped below. */
+	if (commandsList->reapWatcher != NULL)
 	{
-		/* Check to see if process with pid stored in current node has finished. */
-		pid_t pidReturned;	/* Pid returned by waitpid (will equal 0 if process has not exited) */
-		int childExitMethod;	/* Stores exit method of child process if it has returned. */
-		pidReturned = waitpid(currentNode->pid, &childExitMethod, WNOHANG);
+		sigchldNotifyFd = -1;
+		removeEventWatcher(commandsList->reapWatcher);
+		commandsList->reapWatcher = NULL;
+		freeRemovedWatchers();
+	}
 
-		/* Kill the process if it has not returned, and then call waitpid to clean it up. */
-		if (pidReturned == 0)
+	/* Stop and reap every job, which also frees every node (and gives back any jobserver tokens). */
+	terminateBackgroundCommands(commandsList);
+
+	/* Free memory dynamically allocated to commandsList itself. */
+	if (commandsList->reapPipe[0] != -1)
+	{
+		close(commandsList->reapPipe[0]);
+		close(commandsList->reapPipe[1]);
+	}
+	free(commandsList);
+}
+
+
+/***************************************************************************************
+ * Function Name: terminateBackgroundCommands
+ * Description: Receives a BackgroundCommands linked list. Sends SIGTERM to every
+ * 		running job at once, and then reaps jobs as they exit (sleeping in
+ * 		the event loop between SIGCHLDs) until all are gone or the grace
+ * 		period set by SMALLSH_EXIT_GRACE_MS (default DEFAULT_EXIT_GRACE_MS)
+ * 		ends. Jobs still running are then sent SIGKILL and reaped. The time
+ * 		taken is therefore bounded by the grace period rather than by the
+ * 		number of jobs. Every node is removed from the list.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void terminateBackgroundCommands(struct BackgroundCommands* commandsList)
+{
+	struct BackgroundNode* currentNode;
+
+	/* Read the grace period, where 0 sends SIGKILL right away. */
+	long graceMs = DEFAULT_EXIT_GRACE_MS;
+	char* setting = getEnvVar("SMALLSH_EXIT_GRACE_MS");
+	if (setting != NULL && setting[0] != '\0')
+	{
+		char* end;
+		long value = strtol(setting, &end, 10);
+		if (*end == '\0' && value >= 0)
 		{
-			kill(currentNode->pid, SIGKILL);
-			pidReturned = waitpid(currentNode->pid, &childExitMethod, 0);
+			graceMs = value;
 		}
-		
-		/* Declare temporary pointer variable to curentNode so that it can be deleted,
-		 * and update currentNode for next iteration. */
-		struct BackgroundNode* garbageNode = currentNode;
-		currentNode = currentNode->next;
+	}
 
-		/* Free all dynamically allocated data of garbageNode and decrement numNodes. */
-		free(garbageNode);
-		garbageNode = NULL;
-		commandsList->numNodes--;
+	/* Reap jobs that have already exited, and ask the rest to stop. */
+	reapExitedCommands(commandsList);
+	if (commandsList->head != NULL && graceMs > 0)
+	{
+		for (currentNode = commandsList->head; currentNode != NULL; currentNode = currentNode->next)
+		{
+			kill(currentNode->pid, SIGTERM);
+		}
+
+		/* Reap the jobs as they exit until none are left or the grace period ends (when the timer
+		 * clears graceTimer). If the SIGCHLD self-pipe cannot be watched, skip straight to SIGKILL. */
+		struct Timer* graceTimer = addTimer(graceMs * 1000L, endExitGrace, &graceTimer);
+		struct EventWatcher* sigchldWatcher = addEventWatcher(sigchldPipe[0], wakeOnChildExit, NULL);
+		while (sigchldWatcher != NULL && graceTimer != NULL)
+		{
+			drainSIGCHLDPipe();
+			reapExitedCommands(commandsList);
+			if (commandsList->head == NULL)
+			{
+				break;
+			}
+			runEventLoopOnce(-1);
+		}
+		if (graceTimer != NULL)
+		{
+			cancelTimer(graceTimer);
+		}
+		if (sigchldWatcher != NULL)
+		{
+			removeEventWatcher(sigchldWatcher);
+			freeRemovedWatchers();
+		}
 	}
 
-	/* Free memory dynamically allocated to commandsList itself. */
-	free(commandsList);
+	/* Kill every job that is still running, and then reap them all. */
+	for (currentNode = commandsList->head; currentNode != NULL; currentNode = currentNode->next)
+	{
+		kill(currentNode->pid, SIGKILL);
+	}
+	while (commandsList->head != NULL)
+	{
+		int childExitMethod;
+		struct rusage usage;
+		pid_t pidReturned = wait4(commandsList->head->pid, &childExitMethod, 0, &usage);
+		if (pidReturned == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		retireBackgroundNode(commandsList, commandsList->head, (pidReturned == -1) ? -1 : childExitMethod, &usage);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: reapExitedCommands
+ * Description: Receives a BackgroundCommands linked list. Reaps every child that has
+ * 		exited, without waiting, and retires its node without reporting the
+ * 		exit to the user (the shell is exiting). Returns nothing.
+ **************************************************************************************/
+
+void reapExitedCommands(struct BackgroundCommands* commandsList)
+{
+	int childExitMethod;
+	struct rusage usage;
+	pid_t pidReturned;
+
+	while ((pidReturned = wait4(-1, &childExitMethod, WNOHANG, &usage)) > 0)
+	{
+		struct BackgroundNode* exitedNode = findBackgroundNode(commandsList, pidReturned);
+		if (exitedNode != NULL)
+		{
+			retireBackgroundNode(commandsList, exitedNode, childExitMethod, &usage);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: retireBackgroundNode
+ * Description: Receives a BackgroundCommands linked list, a node whose job has been
+ * 		reaped while the shell exits, and the job's exit
+ * 		method (-1 if it could not be reaped) and resource usage. Records the
+ * 		exit in the event log and job status board, stops the job's deadline,
+ * 		gives back its jobserver token, and removes the node.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void retireBackgroundNode(struct BackgroundCommands* commandsList, struct BackgroundNode* node,
+			  int childExitMethod, struct rusage* usage)
+{
+	if (childExitMethod != -1)
+	{
+		logCommandExit(node->pid, TRUE, childExitMethod, &node->startTime, usage);
+		publishJobExit(node, childExitMethod);
+	}
+	if (node->timeout != NULL)
+	{
+		stopJobTimeout(node->timeout);
+	}
+	releaseJobToken(commandsList, node);
+	removeBackgroundNode(commandsList, node);
+}
+
+
+/***************************************************************************************
+ * Function Name: endExitGrace
+ * Description:	Timer callback for the end of the grace period given to jobs when the
+ * 		shell exits. Receives the address of the timer's pointer, which it
+ * 		clears to signal that the period is over (the timer is freed after
+ * 		this returns). Returns nothing.
+ **************************************************************************************/
+
+void endExitGrace(void* arg)
+{
+	*(struct Timer**)arg = NULL;
 }
 
 
@@ -19,9 +19,22 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
 
 /* My own header file inclusion. */
 #include "densmora.smallshConstants.h"
+#include "densmora.timers.h"
+
+/* Default number of milliseconds that background jobs are given to exit after SIGTERM
+ * when the shell exits, before they are sent SIGKILL. */
+#define DEFAULT_EXIT_GRACE_MS 1000
+
+/* Number of buckets in the table of background jobs by pid (hashed by pid like the job graph's). */
+#define BACKGROUND_BUCKETS 1024
+
+/* Value returned by parseCommand when the expanded args would not fit in a new process. */
+#define ARG_LIST_TOO_LONG 2
 
 /* Struct for storing node of PidExpansions linked list struct (defined below).
  * PidExpansions linked list is used to store strings of any words entered on the command line which contained "$$"
@@ -48,13 +61,18 @@ struct CommandInfo
 {
 	char* commandLine;			/* String storing raw command line (will be tokenized into vector). */
 	char** commandArgs;			/* String vector storing command path and all arguments. */
+	int argsCapacity;			/* Number of elements allocated for commandArgs. */
 	int outputFlag;				/* Set to true for output redirection. */
 	char* outputRedirDest;			/* Stores location of output redirection. */
+	char** extraOutputDests;		/* Further output destinations (> a > b or >+ a b), or NULL. */
+	int numExtraOutputDests;		/* Number of strings in extraOutputDests. */
 	int inputFlag;				/* Set to true for input redirection. */
 	char* inputRedirDest;			/* Stores location of input redirection. */
 	int backgroundFlag;			/* Set to true for background process command. */
 	char* parentPid;			/* Pid of the process sending command to child. */
 	struct PidExpansions* expansionList;	/* Ptr to linked list containing string expansions of words with "$$" */
+	char** envAssignments;			/* "NAME=value" words given before the command (NULL if none). */
+	int numEnvAssignments;			/* Number of strings in envAssignments. */
 };
 
 /* Struct storing node of BackgroundCommands linked list. 
@@ -65,7 +83,15 @@ struct CommandInfo
 struct BackgroundNode
 {
 	pid_t pid;				/* Pid of the child process. */
+	struct timespec startTime;		/* Time (CLOCK_MONOTONIC) at which the child was launched. */
+	void (*onDone)(struct BackgroundNode* node, int childExitMethod);	/* Reports exit (NULL to print it). */
+	void* owner;				/* Data used by onDone (such as the client that launched the job). */
+	struct JobTimeout* timeout;		/* Deadline set by the timeout built-in, or NULL if none. */
+	int boardSlot;				/* Slot of the job status board holding the job, or -1. */
+	int jobToken;				/* Jobserver token held by the job, or -1. */
 	struct BackgroundNode* next;		/* Address of next node in list. */
+	struct BackgroundNode* prev;		/* Address of previous node in list (NULL for the head). */
+	struct BackgroundNode* nextByPid;	/* Next node in the same bucket of pids. */
 };
 
 /* Struct containing linked list of BackgroundNode struct pointers described above. */
@@ -74,20 +100,49 @@ struct BackgroundCommands
 {
 	int numNodes;				/* Number of nodes in the list. */
 	struct BackgroundNode* head;		/* Address of the list head. */
+	struct BackgroundNode* byPid[BACKGROUND_BUCKETS];	/* Nodes by pid, so reaped pids are found without walking the list. */
+	void (*reapObserver)(pid_t pid, int childExitMethod, void* arg);	/* Told of every exit (if not NULL). */
+	void* reapObserverArg;			/* Argument passed to reapObserver. */
+	struct JobGraph* jobGraph;		/* Jobs defined with after (NULL until the first). */
+	int numReapHolds;			/* Number of holds on reaping jobs as they exit (see holdBackgroundReaping). */
+	int reapPipe[2];			/* Pipe written to on SIGCHLD while reaping is held (-1 until created). */
+	struct EventWatcher* reapWatcher;	/* Watcher of reapPipe[0] while reaping is held, or NULL. */
 };
 
 /* Function prototypes (see densmora.commands.c for function descriptions and implementations). */
 struct CommandInfo* newCommand(struct BackgroundCommands* bgCommandsList);
-int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList);
+struct CommandInfo* newCommandFromLine(char* line);
+struct CommandInfo* allocateCommand();
+struct CommandInfo* copyCommand(struct CommandInfo* source, int firstArg);
+int prepareCommand(struct CommandInfo* myCommand, int lineLength);
+void takeEnvAssignments(struct CommandInfo* myCommand);
+int getCommandLine(struct CommandInfo* myCommand, struct BackgroundCommands* bgCommandsList, char* prompt);
 int parseCommand(struct CommandInfo* myCommand);
+int addCommandArg(struct CommandInfo* myCommand, char* word, int* vectSize);
+void addExpandedWord(struct CommandInfo* myCommand, char* word, int* vectSize);
+void discardCommandArgs(struct CommandInfo* myCommand);
+long getArgListLimit();
+int isArgListTooLong(char** args);
+void growCommandArgs(struct CommandInfo* myCommand, int minCapacity);
 char* expandPid(struct CommandInfo* myCommand, char* originalStr);
 void deleteCommand(struct CommandInfo* myCommand);
 struct BackgroundCommands* newBackgroundCommands();
-void addBackgroundNode(struct BackgroundCommands* commandsList, pid_t pidIn);
+struct BackgroundNode* addBackgroundNode(struct BackgroundCommands* commandsList, pid_t pidIn);
 void checkCommandStatuses(struct BackgroundCommands* commandsList);
-void removeBackgroundNode(struct BackgroundCommands* commandsList, 
-			  struct BackgroundNode* garbageNode, struct BackgroundNode* previousNode);
+void holdBackgroundReaping(struct BackgroundCommands* commandsList);
+void releaseBackgroundReaping(struct BackgroundCommands* commandsList);
+void reapOnChildExit(int fd, void* arg);
+void reapBackgroundCommands(struct BackgroundCommands* commandsList);
+struct BackgroundNode* findBackgroundNode(struct BackgroundCommands* commandsList, pid_t pid);
+void finishBackgroundNode(struct BackgroundCommands* commandsList, struct BackgroundNode* finishedNode,
+			  int childExitMethod, struct rusage* usage);
+void removeBackgroundNode(struct BackgroundCommands* commandsList, struct BackgroundNode* garbageNode);
 void deleteBackgroundCommands(struct BackgroundCommands* commandsList);
+void terminateBackgroundCommands(struct BackgroundCommands* commandsList);
+void reapExitedCommands(struct BackgroundCommands* commandsList);
+void retireBackgroundNode(struct BackgroundCommands* commandsList, struct BackgroundNode* node,
+			  int childExitMethod, struct rusage* usage);
+void endExitGrace(void* arg);
 struct PidExpansions* newPidExpansions();
 void addPidNode(struct PidExpansions* expansionList, char* strExpansionIn);
 void deletePidExpansions(struct PidExpansions* expansionList);
@@ -0,0 +1,467 @@
+/***************************************************************************************
+ * File: densmora.daemon.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of functions that run
+ * 		smallsh as a job-execution server on a Unix domain socket. Clients
+ * 		send one command line per line of text, using the same grammar as
+ * 		the prompt (built-in commands are not supported). Every command is
+ * 		launched in the background, and the server replies in the order the
+ * 		lines were received with either "pid <pid>" or "error <message>".
+ * 		When a job finishes, the server later sends
+ * 		"done <pid> exit <status>" or "done <pid> signal <signal>".
+ * 		All clients and jobs are multiplexed on the shell's event loop, and
+ * 		jobs are reaped on SIGCHLD. The server stops on SIGTERM or SIGHUP.
+ **************************************************************************************/
+
+#include "densmora.daemon.h"
+
+/* Flag set by catchDaemonStop to tell the server loop to stop. */
+static volatile sig_atomic_t daemonStopRequested = FALSE;
+
+
+/***************************************************************************************
+ * Function Name: runDaemon
+ * Description:	Receives the path at which to create the server socket and the
+ * 		BackgroundCommands list in which to keep jobs. Serves clients until
+ * 		SIGTERM or SIGHUP is received, then closes every client, kills any
+ * 		jobs still running, and removes the socket. Returns 0 if the server
+ * 		ran and 1 if the socket could not be created.
+ **************************************************************************************/
+
+int runDaemon(char* socketPath, struct BackgroundCommands* bgCommandsList)
+{
+	struct DaemonState daemon;
+	daemon.socketPath = socketPath;
+	daemon.bgCommandsList = bgCommandsList;
+	daemon.clients = NULL;
+
+	/* Make sure the path fits in a socket address. */
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(struct sockaddr_un));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "%s: socket path is too long\n", socketPath); fflush(stderr);
+		return 1;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	/* Create the non-blocking listening socket, removing any stale socket left at the path. */
+	daemon.listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	unlink(socketPath);
+	if (daemon.listenFd == -1
+	    || bind(daemon.listenFd, (struct sockaddr*)&address, sizeof(struct sockaddr_un)) == -1
+	    || listen(daemon.listenFd, DAEMON_BACKLOG) == -1)
+	{
+		perror(socketPath); fflush(stderr);
+		return 1;
+	}
+
+	/* Register handlers so that SIGTERM and SIGHUP stop the server. SA_RESTART is not set
+	 * so that the event loop's wait is interrupted and the flag is noticed immediately. */
+	struct sigaction stop_action;
+	memset(&stop_action, 0, sizeof(struct sigaction));
+	stop_action.sa_handler = catchDaemonStop;
+	sigfillset(&stop_action.sa_mask);
+	sigaction(SIGTERM, &stop_action, NULL);
+	sigaction(SIGHUP, &stop_action, NULL);
+
+	/* Watch the listening socket for new clients and the SIGCHLD self-pipe for finished jobs. */
+	struct EventWatcher* listenWatcher = addEventWatcher(daemon.listenFd, acceptDaemonClient, &daemon);
+	struct EventWatcher* sigchldWatcher = addEventWatcher(sigchldPipe[0], reapDaemonJobs, &daemon);
+
+	/* Serve clients until asked to stop, flushing the event log whenever the loop is idle. */
+	while (daemonStopRequested == FALSE)
+	{
+		runEventLoopOnce(-1);
+		flushEventLog();
+	}
+
+	/* Stop accepting clients and reaping jobs, and close every client. */
+	removeEventWatcher(listenWatcher);
+	removeEventWatcher(sigchldWatcher);
+	close(daemon.listenFd);
+	unlink(socketPath);
+	while (daemon.clients != NULL)
+	{
+		deleteDaemonClient(&daemon, daemon.clients);
+	}
+	freeRemovedWatchers();
+	return 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: catchDaemonStop
+ * Description:	Sigaction handler for SIGTERM and SIGHUP while serving. Sets the flag
+ * 		that stops the server loop. Receives signal number (unused).
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void catchDaemonStop(int signo)
+{
+	daemonStopRequested = TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: acceptDaemonClient
+ * Description:	Event loop callback for the listening socket. Receives the listening
+ * 		descriptor and the DaemonState. Accepts every pending connection,
+ * 		allocating a DaemonClient for each and watching it for input.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void acceptDaemonClient(int fd, void* arg)
+{
+	struct DaemonState* daemon = (struct DaemonState*)arg;
+	int clientFd;
+
+	/* Accept connections until none are left pending. */
+	while ((clientFd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+	{
+		/* Declare and allocate memory for new DaemonClient, initializing it with no buffered data. */
+		struct DaemonClient* client;
+		client = (struct DaemonClient*)malloc(sizeof(struct DaemonClient));
+		client->fd = clientFd;
+		client->inLength = 0;
+		client->discardingLine = FALSE;
+		client->inputClosed = FALSE;
+		client->outBuffer = NULL;
+		client->outLength = 0;
+		client->outCapacity = 0;
+		client->jobsInFlight = 0;
+		client->daemon = daemon;
+
+		/* Add client to the front of the list and watch it for input. */
+		client->next = daemon->clients;
+		daemon->clients = client;
+		client->watcher = addEventWatcher(clientFd, readDaemonClient, client);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: readDaemonClient
+ * Description:	Event loop callback for a client socket. Receives the descriptor and
+ * 		the DaemonClient. Reads whatever the client has sent and handles each
+ * 		complete line. Once the client has finished sending, stops reading
+ * 		from it and keeps the connection open only until every job it
+ * 		launched has been reported. Disconnects the client on error or if
+ * 		it hangs up completely. Returns nothing.
+ **************************************************************************************/
+
+void readDaemonClient(int fd, void* arg)
+{
+	struct DaemonClient* client = (struct DaemonClient*)arg;
+	char chunk[DAEMON_READ_BYTES];
+
+	/* Read one chunk, disconnecting the client on error (or if it hangs up after it finished sending). */
+	int bytesRead = read(fd, chunk, DAEMON_READ_BYTES);
+	if ((bytesRead == -1 && errno != EAGAIN && errno != EINTR) || (bytesRead == 0 && client->inputClosed == TRUE))
+	{
+		disconnectDaemonClient(client->daemon, client);
+		return;
+	}
+
+	/* At end of file, stop reading and close the connection once nothing more is owed to the client. */
+	if (bytesRead == 0)
+	{
+		client->inputClosed = TRUE;
+		pauseReading(client->watcher);
+		closeFinishedDaemonClient(client);
+		return;
+	}
+
+	/* Copy the chunk into inBuffer a byte at a time, handling each line as soon as its newline arrives. */
+	for (int i = 0; i < bytesRead; i++)
+	{
+		/* At the end of a line, handle it unless it was too long. */
+		if (chunk[i] == '\n')
+		{
+			client->inBuffer[client->inLength] = '\0';
+			if (client->discardingLine == FALSE)
+			{
+				handleDaemonLine(client->daemon, client, client->inBuffer);
+			}
+			client->inLength = 0;
+			client->discardingLine = FALSE;
+		}
+
+		/* Otherwise, if the line is too long, report it once and skip the rest of it. */
+		else if (client->inLength >= MAX_COMMAND_CHARS)
+		{
+			if (client->discardingLine == FALSE)
+			{
+				sendToDaemonClient(client, "error command line too long\n");
+				client->discardingLine = TRUE;
+			}
+		}
+
+		/* Otherwise, add the byte to the current line (ignoring carriage returns). */
+		else if (chunk[i] != '\r')
+		{
+			client->inBuffer[client->inLength++] = chunk[i];
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: handleDaemonLine
+ * Description:	Receives the DaemonState, the client that sent a line, and the line.
+ * 		Parses the line with the prompt's grammar and launches it in the
+ * 		background, replying with the new job's pid or an error.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void handleDaemonLine(struct DaemonState* daemon, struct DaemonClient* client, char* line)
+{
+	char reply[64];
+
+	/* Parse the line, ignoring blank and comment lines and reporting lines that cannot be parsed. */
+	if (strspn(line, " &") == strlen(line) || line[0] == '#')
+	{
+		return;
+	}
+	struct CommandInfo* myCommand = newCommandFromLine(line);
+	if (myCommand == NULL)
+	{
+		sendToDaemonClient(client, "error invalid command line\n");
+		return;
+	}
+	shellStats.commandsExecuted++;
+
+	/* Built-in commands (and lines of only assignments) act on the shell itself,
+	 * so they cannot be run on behalf of a client. */
+	if (myCommand->commandArgs[0] == NULL)
+	{
+		sendToDaemonClient(client, "error missing command\n");
+	}
+	else if (isBuiltinName(myCommand->commandArgs[0]) == TRUE)
+	{
+		sendToDaemonClient(client, "error built-in commands are not supported\n");
+	}
+
+	/* Otherwise, launch the command in the background, having the client told when it finishes. */
+	else
+	{
+		struct BackgroundNode* newNode = launchBackground(myCommand, daemon->bgCommandsList);
+		if (newNode == NULL)
+		{
+			sendToDaemonClient(client, "error fork failed\n");
+		}
+		else
+		{
+			newNode->onDone = daemonJobDone;
+			newNode->owner = client;
+			client->jobsInFlight++;
+			snprintf(reply, sizeof(reply), "pid %d\n", (int)newNode->pid);
+			sendToDaemonClient(client, reply);
+		}
+	}
+
+	deleteCommand(myCommand);
+}
+
+
+/***************************************************************************************
+ * Function Name: daemonJobDone
+ * Description:	onDone handler of jobs launched for clients. Receives the finished
+ * 		job's BackgroundNode and its exit method. Tells the client that
+ * 		launched it how it exited, or, if that client has disconnected and
+ * 		this was its last job, frees the client. Returns nothing.
+ **************************************************************************************/
+
+void daemonJobDone(struct BackgroundNode* node, int childExitMethod)
+{
+	struct DaemonClient* client = (struct DaemonClient*)node->owner;
+	char reply[64];
+
+	client->jobsInFlight--;
+
+	/* If the client has disconnected, free it once it has no jobs left. */
+	if (client->fd == -1)
+	{
+		if (client->jobsInFlight == 0)
+		{
+			deleteDaemonClient(client->daemon, client);
+		}
+		return;
+	}
+
+	/* Otherwise, report the exit status or terminating signal. */
+	if (WIFSIGNALED(childExitMethod) != 0)
+	{
+		snprintf(reply, sizeof(reply), "done %d signal %d\n", (int)node->pid, WTERMSIG(childExitMethod));
+	}
+	else
+	{
+		snprintf(reply, sizeof(reply), "done %d exit %d\n", (int)node->pid, WEXITSTATUS(childExitMethod));
+	}
+	sendToDaemonClient(client, reply);
+	closeFinishedDaemonClient(client);
+}
+
+
+/***************************************************************************************
+ * Function Name: sendToDaemonClient
+ * Description:	Receives a client and a reply. Sends as much of the reply as the
+ * 		socket accepts without blocking and buffers the rest, which is sent by
+ * 		flushDaemonClient once the socket is writable. Replies are always sent
+ * 		in order. Returns nothing.
+ **************************************************************************************/
+
+void sendToDaemonClient(struct DaemonClient* client, char* text)
+{
+	int length = strlen(text);
+	int bytesSent = 0;
+
+	/* Send directly if nothing is already waiting to be sent. */
+	if (client->outLength == 0)
+	{
+		bytesSent = send(client->fd, text, length, MSG_NOSIGNAL);
+		if (bytesSent == -1)
+		{
+			bytesSent = 0;
+		}
+	}
+
+	/* Buffer whatever was not sent, growing the buffer if needed, and wait for the socket to be writable. */
+	if (bytesSent < length)
+	{
+		if (client->outLength + length - bytesSent > client->outCapacity)
+		{
+			client->outCapacity = 2 * (client->outLength + length - bytesSent);
+			client->outBuffer = (char*)realloc(client->outBuffer, client->outCapacity);
+		}
+		memcpy(client->outBuffer + client->outLength, text + bytesSent, length - bytesSent);
+		client->outLength += length - bytesSent;
+		watchWritable(client->watcher, flushDaemonClient);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: flushDaemonClient
+ * Description:	Event loop write callback for a client socket with buffered replies.
+ * 		Receives the descriptor and the DaemonClient. Sends as much of the
+ * 		buffer as possible, and stops watching for writability once it is
+ * 		empty. Returns nothing.
+ **************************************************************************************/
+
+void flushDaemonClient(int fd, void* arg)
+{
+	struct DaemonClient* client = (struct DaemonClient*)arg;
+
+	/* Send buffered replies, leaving them buffered if the socket is still full. */
+	int bytesSent = send(fd, client->outBuffer, client->outLength, MSG_NOSIGNAL);
+	if (bytesSent <= 0)
+	{
+		return;
+	}
+
+	/* Move unsent bytes to the front of the buffer, and stop watching for writability once it is empty. */
+	memmove(client->outBuffer, client->outBuffer + bytesSent, client->outLength - bytesSent);
+	client->outLength -= bytesSent;
+	if (client->outLength == 0)
+	{
+		watchWritable(client->watcher, NULL);
+		closeFinishedDaemonClient(client);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: closeFinishedDaemonClient
+ * Description:	Receives a client. Disconnects it if it has finished sending, has no
+ * 		jobs still running, and has no replies waiting to be sent.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void closeFinishedDaemonClient(struct DaemonClient* client)
+{
+	if (client->inputClosed == TRUE && client->jobsInFlight == 0 && client->outLength == 0)
+	{
+		disconnectDaemonClient(client->daemon, client);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: disconnectDaemonClient
+ * Description:	Receives the DaemonState and a client whose connection has closed.
+ * 		Closes the connection, and frees the client unless jobs it launched
+ * 		are still running (in which case the last one frees it). Returns
+ * 		nothing.
+ **************************************************************************************/
+
+void disconnectDaemonClient(struct DaemonState* daemon, struct DaemonClient* client)
+{
+	/* Stop watching and close the socket, marking the client as disconnected. */
+	removeEventWatcher(client->watcher);
+	close(client->fd);
+	client->fd = -1;
+
+	/* Free the client now if it has no jobs left. */
+	if (client->jobsInFlight == 0)
+	{
+		deleteDaemonClient(daemon, client);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: deleteDaemonClient
+ * Description:	Receives the DaemonState and a client. Closes the client's connection
+ * 		if it is still open, removes it from the list of clients, and frees
+ * 		all memory associated with it. Returns nothing.
+ **************************************************************************************/
+
+void deleteDaemonClient(struct DaemonState* daemon, struct DaemonClient* client)
+{
+	/* Close the connection if it is still open. */
+	if (client->fd != -1)
+	{
+		removeEventWatcher(client->watcher);
+		close(client->fd);
+	}
+
+	/* Unlink the client from the list of clients. */
+	struct DaemonClient** link = &daemon->clients;
+	while (*link != client)
+	{
+		link = &(*link)->next;
+	}
+	*link = client->next;
+
+	/* Detach any jobs still running from the client so that they do not report to freed memory. */
+	for (struct BackgroundNode* node = daemon->bgCommandsList->head; node != NULL; node = node->next)
+	{
+		if (node->owner == client)
+		{
+			node->onDone = NULL;
+			node->owner = NULL;
+		}
+	}
+
+	/* Free the client's buffers and the client itself. */
+	free(client->outBuffer);
+	free(client);
+}
+
+
+/***************************************************************************************
+ * Function Name: reapDaemonJobs
+ * Description:	Event loop callback for the SIGCHLD self-pipe. Receives the descriptor
+ * 		and the DaemonState. Drains the pipe and reaps every finished job,
+ * 		which reports to its client through daemonJobDone. Returns nothing.
+ **************************************************************************************/
+
+void reapDaemonJobs(int fd, void* arg)
+{
+	struct DaemonState* daemon = (struct DaemonState*)arg;
+	drainSIGCHLDPipe();
+	reapBackgroundCommands(daemon->bgCommandsList);
+}
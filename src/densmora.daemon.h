@@ -0,0 +1,74 @@
+/***************************************************************************************
+ * File: densmora.daemon.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions that run smallsh as a job-execution server
+ * 		(smallsh --serve path). See densmora.daemon.c for descriptions of
+ * 		the protocol and function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_DAEMON
+#define DENSMORA_DAEMON
+
+/* Built-in header file inclusions. */
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+#include "densmora.smallshBuiltins.h"
+#include "densmora.eventLoop.h"
+
+/* Maximum number of pending connections on the server socket. */
+#define DAEMON_BACKLOG 128
+
+/* Size of the chunks read from client sockets. */
+#define DAEMON_READ_BYTES 4096
+
+/* Struct storing the state of one client connected to the server. Clients form a linked
+ * list so that they can all be closed when the server stops. A client that finishes sending
+ * stays connected until all of its jobs have been reported, and a client that disconnects
+ * while it still has jobs running is kept (but no longer written to) until they finish. */
+
+struct DaemonClient
+{
+	int fd;					/* Connected socket, or -1 once disconnected. */
+	struct EventWatcher* watcher;		/* Event loop watcher of fd. */
+	char inBuffer[MAX_COMMAND_CHARS + 2];	/* Partial command line received so far. */
+	int inLength;				/* Number of bytes of inBuffer in use. */
+	int discardingLine;			/* Set to TRUE while skipping the rest of an overlong line. */
+	int inputClosed;			/* Set to TRUE once the client has finished sending. */
+	char* outBuffer;			/* Replies that could not be sent without blocking. */
+	int outLength;				/* Number of bytes of outBuffer in use. */
+	int outCapacity;			/* Number of bytes allocated to outBuffer. */
+	int jobsInFlight;			/* Number of jobs launched by this client that are still running. */
+	struct DaemonState* daemon;		/* Server the client is connected to. */
+	struct DaemonClient* next;		/* Address of next client in list. */
+};
+
+/* Struct storing the state of the server. */
+
+struct DaemonState
+{
+	int listenFd;				/* Listening socket. */
+	char* socketPath;			/* Path to which the listening socket is bound. */
+	struct BackgroundCommands* bgCommandsList;	/* Jobs launched on behalf of clients. */
+	struct DaemonClient* clients;		/* Head of list of clients. */
+};
+
+/* Function prototypes (see densmora.daemon.c for function descriptions and implementations). */
+int runDaemon(char* socketPath, struct BackgroundCommands* bgCommandsList);
+void catchDaemonStop(int signo);
+void acceptDaemonClient(int fd, void* arg);
+void readDaemonClient(int fd, void* arg);
+void handleDaemonLine(struct DaemonState* daemon, struct DaemonClient* client, char* line);
+void daemonJobDone(struct BackgroundNode* node, int childExitMethod);
+void sendToDaemonClient(struct DaemonClient* client, char* text);
+void flushDaemonClient(int fd, void* arg);
+void closeFinishedDaemonClient(struct DaemonClient* client);
+void disconnectDaemonClient(struct DaemonState* daemon, struct DaemonClient* client);
+void deleteDaemonClient(struct DaemonState* daemon, struct DaemonClient* client);
+void reapDaemonJobs(int fd, void* arg);
+
+#endif
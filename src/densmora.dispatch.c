@@ -0,0 +1,222 @@
+/***************************************************************************************
+ * File: densmora.dispatch.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that decide
+ * 		how each parsed command is run. Built-in commands are called
+ * 		directly, and all other commands are run in a child process in the
+ * 		background or foreground.
+ **************************************************************************************/
+
+#include "densmora.dispatch.h"
+
+
+/***************************************************************************************
+ * Function Name: dispatchCommand
+ * Description:	Receives a parsed command, the ForegroundExitMethod struct into which
+ * 		foreground exit statuses are written, and the BackgroundCommands list.
+ * 		Runs the command as a built-in if its first word names one, in the
+ * 		background if requested (and background commands are allowed), or in
+ * 		the foreground otherwise. Returns TRUE if the command was "exit" (in
+ * 		which case the caller should free memory and end the shell), or FALSE
+ * 		otherwise.
+ **************************************************************************************/
+
+int dispatchCommand(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		    struct BackgroundCommands* bgCommandsList)
+{
+	/* If the line held only variable assignments, set them in the shell's environment. */
+	if (myCommand->commandArgs[0] == NULL)
+	{
+		for (int i = 0; i < myCommand->numEnvAssignments; i++)
+		{
+			setEnvPair(myCommand->envAssignments[i]);
+		}
+	}
+
+	/* Otherwise, if user has chosen to exit, return TRUE so that the caller can free dynamically-allocated memory. */
+	else if (strcmp(myCommand->commandArgs[0], "exit") == 0)
+	{
+		return TRUE;
+	}
+	
+	/* Otherwise, if user has entered "cd" as first word of command line,
+	 * call built-in cd function. */
+	else if (strcmp(myCommand->commandArgs[0], "cd") == 0)
+	{
+		/* Call built-in cd function, passing argument stored at commandArgs[1].
+		 * Since commandArgs[0] contains the "cd" command itself, commandArgs[1] will
+		 * either contain a pathname or a NULL pointer since an index containing a NULL
+		 * pointer is always at the end of commandArgs for purposes of calling execvp(). */
+		smallshCd(myCommand->commandArgs[1]);
+	}
+
+	/* Otherwise, if user has entered "status" as first word on the command line,
+	 * call built-in status function, passing it lastFgStatus.  */
+	else if (strcmp(myCommand->commandArgs[0], "status") == 0)
+	{
+		smallshStatus(lastFgStatus);
+	}
+
+	/* Otherwise, if user has entered "wait" as first word on the command line,
+	 * call built-in wait function. Like a foreground command, it blocks the prompt,
+	 * so SIGTSTP is deferred until it returns. */
+	else if (strcmp(myCommand->commandArgs[0], "wait") == 0)
+	{
+		beginForegroundWait();
+		smallshWait(myCommand->commandArgs, lastFgStatus, bgCommandsList);
+		endForegroundWait();
+	}
+
+	/* Otherwise, if user has entered "export" or "unset" as first word on the command line,
+	 * call the built-in function that changes the environment passed to child processes. */
+	else if (strcmp(myCommand->commandArgs[0], "export") == 0)
+	{
+		smallshExport(myCommand->commandArgs);
+	}
+	else if (strcmp(myCommand->commandArgs[0], "unset") == 0)
+	{
+		smallshUnset(myCommand->commandArgs);
+	}
+
+	/* Otherwise, if user has entered "exec" as first word on the command line, call built-in exec
+	 * function, which changes the shell's own descriptors or replaces the shell with a command. */
+	else if (strcmp(myCommand->commandArgs[0], "exec") == 0)
+	{
+		smallshExec(myCommand, lastFgStatus);
+	}
+
+	/* Otherwise, if user has entered "alias" or "unalias" as first word on the command line,
+	 * call the built-in function that defines, prints, or removes aliases. */
+	else if (strcmp(myCommand->commandArgs[0], "alias") == 0)
+	{
+		smallshAlias(myCommand->commandArgs);
+	}
+	else if (strcmp(myCommand->commandArgs[0], "unalias") == 0)
+	{
+		smallshUnalias(myCommand->commandArgs);
+	}
+
+	/* Otherwise, if user has entered "joblog" as first word on the command line,
+	 * call built-in joblog function to list or print captured background output. */
+	else if (strcmp(myCommand->commandArgs[0], "joblog") == 0)
+	{
+		smallshJoblog(myCommand->commandArgs);
+	}
+
+	/* Otherwise, if user has entered "stats" as first word on the command line,
+	 * call built-in stats function to print (and optionally reset) the phase latencies. */
+	else if (strcmp(myCommand->commandArgs[0], "stats") == 0)
+	{
+		smallshStats(myCommand->commandArgs);
+	}
+
+	/* Otherwise, if user has entered "cached" as first word on the command line,
+	 * call built-in cached function, which replays or runs the rest of the command in the foreground. */
+	else if (strcmp(myCommand->commandArgs[0], "cached") == 0)
+	{
+		beginForegroundWait();
+		smallshCached(myCommand, lastFgStatus);
+		endForegroundWait();
+	}
+
+	/* Otherwise, if user has entered "bench" as first word on the command line,
+	 * call built-in bench function, which runs the rest of the command repeatedly in the foreground. */
+	else if (strcmp(myCommand->commandArgs[0], "bench") == 0)
+	{
+		beginForegroundWait();
+		smallshBench(myCommand, lastFgStatus);
+		endForegroundWait();
+	}
+
+	/* Otherwise, if user has entered "batch" as first word on the command line,
+	 * call built-in batch function, which runs the rest of the command over the items of its list. */
+	else if (strcmp(myCommand->commandArgs[0], "batch") == 0)
+	{
+		beginForegroundWait();
+		smallshBatch(myCommand, lastFgStatus, bgCommandsList);
+		endForegroundWait();
+	}
+
+	/* Otherwise, if user has entered "after" as first word on the command line,
+	 * call built-in after function, which defines a background job that waits for other jobs. */
+	else if (strcmp(myCommand->commandArgs[0], "after") == 0)
+	{
+		smallshAfter(myCommand, lastFgStatus, bgCommandsList);
+	}
+
+	/* Otherwise, if user has entered "watch" as first word on the command line, call built-in
+	 * watch function, which runs the rest of the command again whenever the files it watches change. */
+	else if (strcmp(myCommand->commandArgs[0], "watch") == 0)
+	{
+		smallshWatch(myCommand, lastFgStatus, bgCommandsList);
+	}
+
+	/* Otherwise, if user has entered "timeout" as first word on the command line,
+	 * call built-in timeout function, which runs the rest of the command with a deadline
+	 * (blocking the prompt like any other command unless it is run in the background). */
+	else if (strcmp(myCommand->commandArgs[0], "timeout") == 0)
+	{
+		beginForegroundWait();
+		smallshTimeout(myCommand, lastFgStatus, bgCommandsList);
+		endForegroundWait();
+	}
+	
+	/* Otherwise, if the user has requested that this command be run in the background
+	 * and background commands are currently allowed, run it in the background. */
+	else if (myCommand->backgroundFlag == TRUE && allowBackgroundCommands == TRUE)
+	{
+		runBackground(myCommand, bgCommandsList, NULL);
+	}
+
+	/* Otherwise, since this is either a foreground command or one requested
+	 * to be run in the backgroud but unable to be run there due to status of allowBackgroundCOmmands flag,
+	 * run the requested command in the foreground (copying in the shell itself if it is a plain cat). */
+	else
+	{
+		beginForegroundWait();
+		if (runFastCopy(myCommand, lastFgStatus) == FALSE)
+		{
+			runForeground(myCommand, lastFgStatus, NULL);
+		}
+		endForegroundWait();
+	}
+
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: beginForegroundWait
+ * Description:	Called before the shell blocks on a foreground command. Sets
+ * 		foregroundActive so that SIGTSTP is deferred until the command
+ * 		finishes. Receives and returns nothing.
+ **************************************************************************************/
+
+void beginForegroundWait()
+{
+	foregroundActive = TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: endForegroundWait
+ * Description:	Called after a foreground command finishes. Resets foregroundActive,
+ * 		and processes any SIGTSTP received while it ran. Receives and returns
+ * 		nothing.
+ **************************************************************************************/
+
+void endForegroundWait()
+{
+	foregroundActive = FALSE;
+
+	/* If sigtstpDuringForegroundProcess is TRUE,
+	 * set global flag to FALSE and raise the SIGTSTP signal
+	 * so that background command permissions are toggled
+	 * and message is printed by signal handler. */
+	if (sigtstpDuringForegroundProcess == TRUE)
+	{
+		raise(SIGTSTP);
+		sigtstpDuringForegroundProcess = FALSE;
+	}
+}
@@ -0,0 +1,24 @@
+/***************************************************************************************
+ * File: densmora.dispatch.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing prototypes of the functions that decide how
+ * 		each parsed command is run (as a built-in, in the background, or in
+ * 		the foreground). See densmora.dispatch.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_DISPATCH
+#define DENSMORA_DISPATCH
+
+/* My own header file inclusions. */
+#include "densmora.smallshBuiltins.h"
+#include "densmora.fastCopy.h"
+
+/* Function prototypes (see densmora.dispatch.c for function descriptions and implementations). */
+int dispatchCommand(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		    struct BackgroundCommands* bgCommandsList);
+void beginForegroundWait();
+void endForegroundWait();
+
+#endif
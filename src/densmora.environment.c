@@ -0,0 +1,438 @@
+/***************************************************************************************
+ * File: densmora.environment.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of functions that maintain
+ * 		the environment passed to child processes. Variables live in a hash
+ * 		table (filled from the shell's own environment at startup and changed
+ * 		by export, unset, and lines of only assignments). The envp array handed
+ * 		to execve is rebuilt from the table only when a command is launched
+ * 		after a change, and points at the strings stored in the table, so
+ * 		launching a command never copies the environment's strings. Per-command
+ * 		assignments (VAR=value cmd) are applied in the child after fork.
+ **************************************************************************************/
+
+#include "densmora.environment.h"
+
+/* Environment of the shell's children. */
+static struct EnvTable envTable;
+
+/* Environment of the shell itself, filled in by the C runtime. */
+extern char** environ;
+
+
+/***************************************************************************************
+ * Function Name: initEnvironment
+ * Description:	Creates the hash table and fills it with the shell's own environment.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void initEnvironment()
+{
+	envTable.numBuckets = INITIAL_ENV_BUCKETS;
+	envTable.buckets = (struct EnvEntry**)calloc(envTable.numBuckets, sizeof(struct EnvEntry*));
+	envTable.numEntries = 0;
+	envTable.envp = NULL;
+	envTable.envpIsStale = TRUE;
+
+	for (int i = 0; environ[i] != NULL; i++)
+	{
+		setEnvPair(environ[i]);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: hashEnvName
+ * Description:	Receives a variable name and its length (the name need not be
+ * 		null-terminated). Returns its FNV-1a hash.
+ **************************************************************************************/
+
+unsigned int hashEnvName(const char* name, int nameLength)
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < nameLength; i++)
+	{
+		hash ^= (unsigned char)name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/***************************************************************************************
+ * Function Name: findEnvEntry
+ * Description:	Receives a variable name, its length, and its hash. Returns the
+ * 		address of the link pointing at its entry (so that the entry can be
+ * 		replaced or removed), which holds NULL if the variable is not set.
+ **************************************************************************************/
+
+struct EnvEntry** findEnvEntry(const char* name, int nameLength, unsigned int hash)
+{
+	struct EnvEntry** link = &envTable.buckets[hash & (envTable.numBuckets - 1)];
+	while (*link != NULL
+	       && ((*link)->hash != hash || (*link)->nameLength != nameLength
+		   || strncmp((*link)->pair, name, nameLength) != 0))
+	{
+		link = &(*link)->next;
+	}
+	return link;
+}
+
+
+/***************************************************************************************
+ * Function Name: getEnvVar
+ * Description:	Receives a variable name. Returns its value (owned by the table), or
+ * 		NULL if it is not set.
+ **************************************************************************************/
+
+char* getEnvVar(const char* name)
+{
+	int nameLength = strlen(name);
+	struct EnvEntry* entry = *findEnvEntry(name, nameLength, hashEnvName(name, nameLength));
+	return (entry != NULL) ? entry->pair + nameLength + 1 : NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: setEnvVar
+ * Description:	Receives a variable name and value. Sets the variable, replacing any
+ * 		earlier value. Returns nothing.
+ **************************************************************************************/
+
+void setEnvVar(const char* name, const char* value)
+{
+	char* pair = (char*)malloc(strlen(name) + strlen(value) + 2);
+	sprintf(pair, "%s=%s", name, value);
+	setEnvPair(pair);
+	free(pair);
+}
+
+
+/***************************************************************************************
+ * Function Name: setEnvPair
+ * Description:	Receives a "NAME=VALUE" string. Sets the variable to a copy of it,
+ * 		replacing any earlier value. Returns FALSE if the string has no "=",
+ * 		or TRUE otherwise.
+ **************************************************************************************/
+
+int setEnvPair(const char* pair)
+{
+	char* equals = strchr(pair, '=');
+	if (equals == NULL)
+	{
+		return FALSE;
+	}
+	int nameLength = equals - pair;
+	unsigned int hash = hashEnvName(pair, nameLength);
+	struct EnvEntry** link = findEnvEntry(pair, nameLength, hash);
+
+	/* Replace the string of an existing entry. */
+	if (*link != NULL)
+	{
+		free((*link)->pair);
+		(*link)->pair = strdup(pair);
+	}
+
+	/* Otherwise, add a new entry to the front of its bucket, growing the table if it is getting full. */
+	else
+	{
+		struct EnvEntry* entry;
+		entry = (struct EnvEntry*)malloc(sizeof(struct EnvEntry));
+		entry->pair = strdup(pair);
+		entry->nameLength = nameLength;
+		entry->hash = hash;
+		entry->next = *link;
+		*link = entry;
+		envTable.numEntries++;
+		if (envTable.numEntries > envTable.numBuckets)
+		{
+			growEnvTable();
+		}
+	}
+	envTable.envpIsStale = TRUE;
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: unsetEnvVar
+ * Description:	Receives a variable name. Removes the variable if it is set.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void unsetEnvVar(const char* name)
+{
+	int nameLength = strlen(name);
+	struct EnvEntry** link = findEnvEntry(name, nameLength, hashEnvName(name, nameLength));
+	if (*link != NULL)
+	{
+		struct EnvEntry* entry = *link;
+		*link = entry->next;
+		free(entry->pair);
+		free(entry);
+		envTable.numEntries--;
+		envTable.envpIsStale = TRUE;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: growEnvTable
+ * Description:	Doubles the number of buckets and moves every entry to its new
+ * 		bucket (using its stored hash). Receives and returns nothing.
+ **************************************************************************************/
+
+void growEnvTable()
+{
+	int newNumBuckets = 2 * envTable.numBuckets;
+	struct EnvEntry** newBuckets = (struct EnvEntry**)calloc(newNumBuckets, sizeof(struct EnvEntry*));
+
+	for (int i = 0; i < envTable.numBuckets; i++)
+	{
+		struct EnvEntry* entry = envTable.buckets[i];
+		while (entry != NULL)
+		{
+			struct EnvEntry* nextEntry = entry->next;
+			entry->next = newBuckets[entry->hash & (newNumBuckets - 1)];
+			newBuckets[entry->hash & (newNumBuckets - 1)] = entry;
+			entry = nextEntry;
+		}
+	}
+	free(envTable.buckets);
+	envTable.buckets = newBuckets;
+	envTable.numBuckets = newNumBuckets;
+}
+
+
+/***************************************************************************************
+ * Function Name: getEnvp
+ * Description:	Returns the NULL-terminated envp array for execve, rebuilding it first
+ * 		if the environment has changed since it was last built. The array is
+ * 		owned by the table and stays valid until the next change.
+ **************************************************************************************/
+
+char** getEnvp()
+{
+	if (envTable.envpIsStale == TRUE)
+	{
+		envTable.envp = (char**)realloc(envTable.envp, (envTable.numEntries + 1) * sizeof(char*));
+		int numPairs = 0;
+		for (int i = 0; i < envTable.numBuckets; i++)
+		{
+			for (struct EnvEntry* entry = envTable.buckets[i]; entry != NULL; entry = entry->next)
+			{
+				envTable.envp[numPairs++] = entry->pair;
+			}
+		}
+		envTable.envp[numPairs] = NULL;
+		envTable.envpIsStale = FALSE;
+	}
+	return envTable.envp;
+}
+
+
+/***************************************************************************************
+ * Function Name: overrideEnvp
+ * Description:	Called in a child process after fork. Receives the "NAME=VALUE"
+ * 		assignments given before its command and their number. Returns a new
+ * 		envp array made of the pointers in the shell's envp, minus any variable
+ * 		that is assigned, followed by the assignments. No strings are copied.
+ **************************************************************************************/
+
+char** overrideEnvp(char** overrides, int numOverrides)
+{
+	char** baseEnvp = getEnvp();
+	char** envp = (char**)malloc((envTable.numEntries + numOverrides + 1) * sizeof(char*));
+	int numPairs = 0;
+
+	/* Copy every pair whose variable is not assigned. */
+	for (int i = 0; baseEnvp[i] != NULL; i++)
+	{
+		int nameLength = strchr(baseEnvp[i], '=') - baseEnvp[i] + 1;
+		int isOverridden = FALSE;
+		for (int j = 0; j < numOverrides && isOverridden == FALSE; j++)
+		{
+			isOverridden = (strncmp(baseEnvp[i], overrides[j], nameLength) == 0) ? TRUE : FALSE;
+		}
+		if (isOverridden == FALSE)
+		{
+			envp[numPairs++] = baseEnvp[i];
+		}
+	}
+
+	/* Add the assignments. A variable assigned twice is only added once, with its last value. */
+	for (int j = 0; j < numOverrides; j++)
+	{
+		int nameLength = strchr(overrides[j], '=') - overrides[j] + 1;
+		int assignedLater = FALSE;
+		for (int k = j + 1; k < numOverrides && assignedLater == FALSE; k++)
+		{
+			assignedLater = (strncmp(overrides[j], overrides[k], nameLength) == 0) ? TRUE : FALSE;
+		}
+		if (assignedLater == FALSE)
+		{
+			envp[numPairs++] = overrides[j];
+		}
+	}
+	envp[numPairs] = NULL;
+	return envp;
+}
+
+
+/***************************************************************************************
+ * Function Name: isEnvAssignment
+ * Description:	Receives a word of a command line. Returns TRUE if it has the form
+ * 		NAME=value (where NAME is a letter or underscore followed by letters,
+ * 		digits, or underscores), or FALSE otherwise.
+ **************************************************************************************/
+
+int isEnvAssignment(const char* word)
+{
+	if (!((word[0] >= 'a' && word[0] <= 'z') || (word[0] >= 'A' && word[0] <= 'Z') || word[0] == '_'))
+	{
+		return FALSE;
+	}
+	int i = 1;
+	while ((word[i] >= 'a' && word[i] <= 'z') || (word[i] >= 'A' && word[i] <= 'Z')
+	       || (word[i] >= '0' && word[i] <= '9') || word[i] == '_')
+	{
+		i++;
+	}
+	return (word[i] == '=') ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: compareEnvPairs
+ * Description:	qsort comparison function for an array of "NAME=VALUE" strings.
+ * 		Receives pointers to two elements. Returns their strcmp order.
+ **************************************************************************************/
+
+static int compareEnvPairs(const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+
+/***************************************************************************************
+ * Function Name: printEnvironment
+ * Description:	Prints every variable as "export NAME=VALUE", sorted by name.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void printEnvironment()
+{
+	char** envp = getEnvp();
+	char** sorted = (char**)malloc((envTable.numEntries + 1) * sizeof(char*));
+	memcpy(sorted, envp, (envTable.numEntries + 1) * sizeof(char*));
+	qsort(sorted, envTable.numEntries, sizeof(char*), compareEnvPairs);
+	for (int i = 0; i < envTable.numEntries; i++)
+	{
+		printf("export %s\n", sorted[i]);
+	}
+	fflush(stdout);
+	free(sorted);
+}
+
+
+/***************************************************************************************
+ * Function Name: execWithEnvironment
+ * Description:	Called in a child process. Receives the command's args and the envp
+ * 		to give it. Executes args[0] with execve, searching the PATH given in
+ * 		envp when args[0] contains no "/", and running files that are not
+ * 		executables as /bin/sh scripts (like execvp). Returns only if the
+ * 		command could not be executed, with errno describing why.
+ **************************************************************************************/
+
+void execWithEnvironment(char** args, char** envp)
+{
+	char candidate[PATH_MAX];
+	int savedErrno = ENOENT;
+
+	/* Run a path directly. */
+	if (strchr(args[0], '/') != NULL)
+	{
+		execve(args[0], args, envp);
+		if (errno == ENOEXEC)
+		{
+			execScript(args[0], args, envp);
+		}
+		return;
+	}
+
+	/* Find the search path in envp. */
+	char* searchPath = DEFAULT_EXEC_PATH;
+	for (int i = 0; envp[i] != NULL; i++)
+	{
+		if (strncmp(envp[i], "PATH=", 5) == 0)
+		{
+			searchPath = envp[i] + 5;
+		}
+	}
+
+	/* Try each directory in turn (an empty one is the working directory), remembering a
+	 * permission error so that it is reported if the command is not found elsewhere. */
+	while (TRUE)
+	{
+		int dirLength = strcspn(searchPath, ":");
+		if (dirLength == 0)
+		{
+			snprintf(candidate, PATH_MAX, "%s", args[0]);
+		}
+		else
+		{
+			snprintf(candidate, PATH_MAX, "%.*s/%s", dirLength, searchPath, args[0]);
+		}
+		execve(candidate, args, envp);
+
+		if (errno == ENOEXEC)
+		{
+			execScript(candidate, args, envp);
+			return;
+		}
+		else if (errno == EACCES)
+		{
+			savedErrno = EACCES;
+		}
+		else if (errno != ENOENT && errno != ENOTDIR && errno != ENAMETOOLONG)
+		{
+			return;
+		}
+
+		if (searchPath[dirLength] == '\0')
+		{
+			break;
+		}
+		searchPath += dirLength + 1;
+	}
+	errno = savedErrno;
+}
+
+
+/***************************************************************************************
+ * Function Name: execScript
+ * Description:	Called in a child process when execve reported that a file is not an
+ * 		executable. Receives the file's path, the command's args, and envp.
+ * 		Runs the file as a /bin/sh script. Returns only on failure.
+ **************************************************************************************/
+
+void execScript(char* path, char** args, char** envp)
+{
+	int numArgs = 0;
+	while (args[numArgs] != NULL)
+	{
+		numArgs++;
+	}
+
+	/* Build "/bin/sh path args[1]...". */
+	char** shellArgs = (char**)malloc((numArgs + 2) * sizeof(char*));
+	shellArgs[0] = "/bin/sh";
+	shellArgs[1] = path;
+	for (int i = 1; i <= numArgs; i++)
+	{
+		shellArgs[i + 1] = args[i];
+	}
+	execve(shellArgs[0], shellArgs, envp);
+	free(shellArgs);
+}
@@ -0,0 +1,69 @@
+/***************************************************************************************
+ * File: densmora.environment.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions that maintain the environment passed to child processes
+ * 		in a hash table, along with the envp array built from it. See
+ * 		densmora.environment.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_ENVIRONMENT
+#define DENSMORA_ENVIRONMENT
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* My own header file inclusion. */
+#include "densmora.smallshConstants.h"
+
+/* Initial number of buckets in the hash table (must be a power of 2; doubles as it fills). */
+#define INITIAL_ENV_BUCKETS 64
+
+/* Search path used by children when PATH is not set (the same default as execvp). */
+#define DEFAULT_EXEC_PATH "/bin:/usr/bin"
+
+/* Struct storing one variable. The "NAME=VALUE" string is stored whole so that envp can
+ * point straight at it, and the name is its first nameLength chars. */
+
+struct EnvEntry
+{
+	char* pair;				/* "NAME=VALUE" string. */
+	int nameLength;				/* Number of chars in NAME. */
+	unsigned int hash;			/* Hash of NAME. */
+	struct EnvEntry* next;			/* Address of next entry in the same bucket. */
+};
+
+/* Struct storing the environment. envp is rebuilt only when it is needed after a change. */
+
+struct EnvTable
+{
+	struct EnvEntry** buckets;		/* Chains of entries, indexed by hash. */
+	int numBuckets;				/* Number of buckets (a power of 2). */
+	int numEntries;				/* Number of variables set. */
+	char** envp;				/* NULL-terminated array of the pair of every entry. */
+	int envpIsStale;			/* Set to TRUE when a change has not yet been reflected in envp. */
+};
+
+/* Function prototypes (see densmora.environment.c for function descriptions and implementations). */
+void initEnvironment();
+unsigned int hashEnvName(const char* name, int nameLength);
+struct EnvEntry** findEnvEntry(const char* name, int nameLength, unsigned int hash);
+char* getEnvVar(const char* name);
+void setEnvVar(const char* name, const char* value);
+int setEnvPair(const char* pair);
+void unsetEnvVar(const char* name);
+void growEnvTable();
+char** getEnvp();
+char** overrideEnvp(char** overrides, int numOverrides);
+int isEnvAssignment(const char* word);
+void printEnvironment();
+void execWithEnvironment(char** args, char** envp);
+void execScript(char* path, char** args, char** envp);
+
+#endif
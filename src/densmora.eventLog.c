@@ -0,0 +1,392 @@
+/***************************************************************************************
+ * File: densmora.eventLog.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of functions that record
+ * 		structured command events into a lock-free ring buffer and flush them
+ * 		in batches as JSON lines to the event log named by the
+ * 		SMALLSH_EVENTLOG (path) or SMALLSH_EVENTLOG_FD (descriptor)
+ * 		environment variables. Recording only copies fixed-size data into
+ * 		a reserved record, so it never writes to the log synchronously and
+ * 		is safe to do from a signal handler. Records are flushed by the
+ * 		shell before each prompt, from the event loop once the shell has
+ * 		been idle for a moment, and whenever the shell waits (in the event
+ * 		loop or for a foreground command) with the buffer half full.
+ **************************************************************************************/
+
+#include "densmora.eventLog.h"
+
+/* Ring buffer of events shared by every function in this file. It is global
+ * (rather than passed around like the other structs in smallsh) so that it can
+ * be reached from signal handlers. */
+static struct EventLog eventLog = { -1, 0, 0, 0 };
+
+
+/***************************************************************************************
+ * Function Name: initEventLog
+ * Description:	Opens the event log if one was requested through the environment.
+ * 		SMALLSH_EVENTLOG names a file to which events are appended, and
+ * 		SMALLSH_EVENTLOG_FD names an already-open descriptor. If neither is
+ * 		set, logging stays disabled and every other function in this file
+ * 		returns immediately. Receives and returns nothing.
+ **************************************************************************************/
+
+void initEventLog()
+{
+	char* logPath = getenv("SMALLSH_EVENTLOG");
+	char* logFd = getenv("SMALLSH_EVENTLOG_FD");
+
+	/* If a path was given, open it for appending, creating it if it does not exist.
+	 * O_CLOEXEC keeps the log from leaking into child processes. */
+	if (logPath != NULL && logPath[0] != '\0')
+	{
+		eventLog.fd = raiseShellFd(open(logPath, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, FILE_PERMISSIONS));
+		if (eventLog.fd == -1)
+		{
+			perror(logPath); fflush(stderr);
+		}
+	}
+
+	/* Otherwise, if a descriptor was given, duplicate it with close-on-exec set
+	 * so that children do not inherit the shell's copy. */
+	else if (logFd != NULL && logFd[0] != '\0')
+	{
+		eventLog.fd = fcntl(atoi(logFd), F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+		if (eventLog.fd == -1)
+		{
+			perror("SMALLSH_EVENTLOG_FD"); fflush(stderr);
+		}
+	}
+
+	/* Have the event loop drain the buffer while the shell waits. */
+	if (eventLog.fd != -1)
+	{
+		setIdleCallback(drainEventLog);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: logCommandStart
+ * Description:	Receives a CommandInfo struct pointer, the pid of the child that was
+ * 		forked to run it, and a flag indicating whether it runs in the
+ * 		background. Records a command start (foreground) or background launch
+ * 		event containing the command line. Returns nothing.
+ **************************************************************************************/
+
+void logCommandStart(struct CommandInfo* myCommand, pid_t pid, int isBgCommand)
+{
+	/* Return immediately if logging is disabled or the ring buffer is full. */
+	if (eventLog.fd == -1)
+	{
+		return;
+	}
+	struct EventRecord* record = reserveEventRecord();
+	if (record == NULL)
+	{
+		return;
+	}
+
+	/* Fill in the fixed members of the record. */
+	record->type = (isBgCommand == TRUE) ? EVENT_BACKGROUND_LAUNCH : EVENT_COMMAND_START;
+	record->pid = pid;
+	record->isBgCommand = isBgCommand;
+	clock_gettime(CLOCK_REALTIME, &record->timestamp);
+
+	/* Rebuild the command line, truncating it if it does not fit in the record. */
+	formatCommandLine(myCommand, record->command, EVENT_LOG_COMMAND_CHARS);
+
+	/* Publish the record so that the next flush picks it up. */
+	__atomic_store_n(&record->ready, TRUE, __ATOMIC_RELEASE);
+}
+
+
+/***************************************************************************************
+ * Function Name: formatCommandLine
+ * Description:	Receives a CommandInfo struct pointer, a buffer, and its size. Rebuilds
+ * 		the command line from commandArgs and the io redirection destinations
+ * 		into the buffer, truncating it if it does not fit. Returns nothing.
+ **************************************************************************************/
+
+void formatCommandLine(struct CommandInfo* myCommand, char* buffer, int bufferSize)
+{
+	int idx = 0;
+	int last = bufferSize - 1;
+	for (int arg = 0; myCommand->commandArgs[arg] != NULL; arg++)
+	{
+		if (arg > 0 && idx < last)
+		{
+			buffer[idx++] = ' ';
+		}
+		for (char* c = myCommand->commandArgs[arg]; *c != '\0' && idx < last; c++)
+		{
+			buffer[idx++] = *c;
+		}
+	}
+	if (myCommand->inputFlag == TRUE)
+	{
+		for (char* c = " < "; *c != '\0' && idx < last; c++)
+		{
+			buffer[idx++] = *c;
+		}
+		for (char* c = myCommand->inputRedirDest; *c != '\0' && idx < last; c++)
+		{
+			buffer[idx++] = *c;
+		}
+	}
+	if (myCommand->outputFlag == TRUE)
+	{
+		for (char* c = " > "; *c != '\0' && idx < last; c++)
+		{
+			buffer[idx++] = *c;
+		}
+		for (char* c = myCommand->outputRedirDest; *c != '\0' && idx < last; c++)
+		{
+			buffer[idx++] = *c;
+		}
+	}
+	buffer[idx] = '\0';
+}
+
+
+/***************************************************************************************
+ * Function Name: logCommandExit
+ * Description:	Receives the pid of a child that has been reaped, a flag indicating
+ * 		whether it ran in the background, the exit method returned by wait4,
+ * 		the time at which the child was launched (CLOCK_MONOTONIC), and the
+ * 		resource usage returned by wait4. Records an exit event with the exit
+ * 		status or terminating signal, duration, and resource usage.
+ * 		Only calls async-signal-safe functions, so it may be called from
+ * 		a SIGCHLD handler. Returns nothing.
+ **************************************************************************************/
+
+void logCommandExit(pid_t pid, int isBgCommand, int childExitMethod,
+		    struct timespec* startTime, struct rusage* usage)
+{
+	/* Return immediately if logging is disabled or the ring buffer is full. */
+	if (eventLog.fd == -1)
+	{
+		return;
+	}
+	struct EventRecord* record = reserveEventRecord();
+	if (record == NULL)
+	{
+		return;
+	}
+
+	/* Fill in the identifying members of the record. */
+	record->type = EVENT_COMMAND_EXIT;
+	record->pid = pid;
+	record->isBgCommand = isBgCommand;
+	record->command[0] = '\0';
+	clock_gettime(CLOCK_REALTIME, &record->timestamp);
+
+	/* Store either the exit status or the terminating signal. */
+	if (WIFSIGNALED(childExitMethod) != 0)
+	{
+		record->code = WTERMSIG(childExitMethod);
+		record->exitedNormally = FALSE;
+	}
+	else
+	{
+		record->code = WEXITSTATUS(childExitMethod);
+		record->exitedNormally = TRUE;
+	}
+
+	/* Compute the duration from the launch time to now. */
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	record->durationUsec = (now.tv_sec - startTime->tv_sec) * 1000000L
+			       + (now.tv_nsec - startTime->tv_nsec) / 1000L;
+
+	/* Store resource usage returned by wait4. */
+	record->userUsec = usage->ru_utime.tv_sec * 1000000L + usage->ru_utime.tv_usec;
+	record->sysUsec = usage->ru_stime.tv_sec * 1000000L + usage->ru_stime.tv_usec;
+	record->maxRssKb = usage->ru_maxrss;
+
+	/* Publish the record so that the next flush picks it up. */
+	__atomic_store_n(&record->ready, TRUE, __ATOMIC_RELEASE);
+}
+
+
+/***************************************************************************************
+ * Function Name: reserveEventRecord
+ * Description:	Reserves the next free record of the ring buffer by advancing head
+ * 		with a compare-and-swap, so that the main program and a signal handler
+ * 		interrupting it can never be handed the same record. Receives nothing.
+ * 		Returns a pointer to the reserved record, or NULL (counting the event
+ * 		as dropped) if the buffer is full.
+ **************************************************************************************/
+
+struct EventRecord* reserveEventRecord()
+{
+	unsigned long head = __atomic_load_n(&eventLog.head, __ATOMIC_RELAXED);
+
+	/* Loop until head is advanced by this call or the buffer is found to be full. */
+	do
+	{
+		unsigned long tail = __atomic_load_n(&eventLog.tail, __ATOMIC_ACQUIRE);
+		if (head - tail >= EVENT_LOG_CAPACITY)
+		{
+			__atomic_add_fetch(&eventLog.dropped, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}
+	} while (__atomic_compare_exchange_n(&eventLog.head, &head, head + 1, FALSE,
+					     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == FALSE);
+
+	return &eventLog.records[head & (EVENT_LOG_CAPACITY - 1)];
+}
+
+
+/***************************************************************************************
+ * Function Name: drainEventLog
+ * Description:	Idle callback of the event loop (see setIdleCallback), also called
+ * 		by waitForChild. Receives a flag set to TRUE once the shell has been
+ * 		idle for a moment. Flushes the ring buffer if the shell is idle or the
+ * 		buffer holds at least EVENT_LOG_HIGH_WATER records, so that records
+ * 		are still written in batches. Returns TRUE if records are left
+ * 		waiting for the shell to become idle, or FALSE otherwise.
+ **************************************************************************************/
+
+int drainEventLog(int isIdle)
+{
+	unsigned long numWaiting = __atomic_load_n(&eventLog.head, __ATOMIC_ACQUIRE) - eventLog.tail;
+	if (eventLog.fd == -1 || (numWaiting == 0 && __atomic_load_n(&eventLog.dropped, __ATOMIC_RELAXED) == 0))
+	{
+		return FALSE;
+	}
+	if (isIdle == TRUE || numWaiting >= EVENT_LOG_HIGH_WATER)
+	{
+		flushEventLog();
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: flushEventLog
+ * Description:	Formats every published record at the tail of the ring buffer as a
+ * 		JSON line and writes them to the event log in as few write() calls as
+ * 		possible. Called by the shell before each prompt, by drainEventLog,
+ * 		and at exit, never from a signal handler. Receives and returns nothing.
+ **************************************************************************************/
+
+void flushEventLog()
+{
+	char batch[EVENT_LOG_BATCH_BYTES];	/* Buffer into which JSON lines are formatted. */
+	int batchLength = 0;			/* Number of bytes of batch currently in use. */
+
+	/* Return immediately if logging is disabled. */
+	if (eventLog.fd == -1)
+	{
+		return;
+	}
+
+	/* If any events were dropped since the last flush, report how many before the remaining events. */
+	unsigned long dropped = __atomic_exchange_n(&eventLog.dropped, 0, __ATOMIC_RELAXED);
+	if (dropped > 0)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_REALTIME, &now);
+		batchLength += snprintf(batch, sizeof(batch),
+					"{\"ts\":%ld.%06ld,\"event\":\"dropped\",\"count\":%lu}\n",
+					(long)now.tv_sec, now.tv_nsec / 1000L, dropped);
+	}
+
+	/* Consume records in order until one is reached that has not been published yet. */
+	while (TRUE)
+	{
+		struct EventRecord* record = &eventLog.records[eventLog.tail & (EVENT_LOG_CAPACITY - 1)];
+		if (__atomic_load_n(&record->ready, __ATOMIC_ACQUIRE) == FALSE)
+		{
+			break;
+		}
+
+		/* Format the record, writing out the batch first if the line might not fit in what is left of it. */
+		if (EVENT_LOG_BATCH_BYTES - batchLength < 2 * EVENT_LOG_COMMAND_CHARS * 6 + 512)
+		{
+			write(eventLog.fd, batch, batchLength);
+			batchLength = 0;
+		}
+		batchLength += formatEventRecord(record, batch + batchLength, EVENT_LOG_BATCH_BYTES - batchLength);
+
+		/* Hand the record back to producers. */
+		__atomic_store_n(&record->ready, FALSE, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&eventLog.tail, 1, __ATOMIC_RELEASE);
+	}
+
+	/* Write out whatever remains in the batch. */
+	if (batchLength > 0)
+	{
+		write(eventLog.fd, batch, batchLength);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: formatEventRecord
+ * Description:	Receives an EventRecord pointer and a buffer of bufferSize bytes.
+ * 		Writes the record into the buffer as a single JSON line (escaping the
+ * 		command line). Returns the number of bytes written.
+ **************************************************************************************/
+
+int formatEventRecord(struct EventRecord* record, char* buffer, int bufferSize)
+{
+	char* mode = (record->isBgCommand == TRUE) ? "background" : "foreground";
+	int length;
+
+	/* Write the members common to every event. */
+	char* eventNames[] = { "start", "launch", "exit" };
+	length = snprintf(buffer, bufferSize, "{\"ts\":%ld.%06ld,\"event\":\"%s\",\"pid\":%d,\"mode\":\"%s\"",
+			  (long)record->timestamp.tv_sec, record->timestamp.tv_nsec / 1000L,
+			  eventNames[record->type], (int)record->pid, mode);
+
+	/* Exit events report how the child exited along with its duration and resource usage. */
+	if (record->type == EVENT_COMMAND_EXIT)
+	{
+		length += snprintf(buffer + length, bufferSize - length,
+				   ",\"%s\":%d,\"duration_us\":%ld,\"utime_us\":%ld,\"stime_us\":%ld,\"maxrss_kb\":%ld}\n",
+				   (record->exitedNormally == TRUE) ? "exit_code" : "signal", record->code,
+				   record->durationUsec, record->userUsec, record->sysUsec, record->maxRssKb);
+		return length;
+	}
+
+	/* Start and launch events report the command line, escaped for JSON. */
+	length += snprintf(buffer + length, bufferSize - length, ",\"command\":\"");
+	for (char* c = record->command; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			buffer[length++] = '\\';
+			buffer[length++] = *c;
+		}
+		else if ((unsigned char)*c < 0x20)
+		{
+			length += snprintf(buffer + length, bufferSize - length, "\\u%04x", (unsigned char)*c);
+		}
+		else
+		{
+			buffer[length++] = *c;
+		}
+	}
+	length += snprintf(buffer + length, bufferSize - length, "\"}\n");
+	return length;
+}
+
+
+/***************************************************************************************
+ * Function Name: closeEventLog
+ * Description:	Flushes any remaining events and closes the event log. Called when
+ * 		the shell exits. Receives and returns nothing.
+ **************************************************************************************/
+
+void closeEventLog()
+{
+	if (eventLog.fd != -1)
+	{
+		flushEventLog();
+		close(eventLog.fd);
+		eventLog.fd = -1;
+	}
+}
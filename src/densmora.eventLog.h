@@ -0,0 +1,87 @@
+/***************************************************************************************
+ * File: densmora.eventLog.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions used to record structured command events (command
+ * 		starts, background launches, and exits) into an in-memory ring buffer
+ * 		and flush them in batches as JSON lines to an optional event log.
+ * 		See densmora.eventLog.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_EVENT_LOG
+#define DENSMORA_EVENT_LOG
+
+/* Built-in header file inclusions. */
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+/* My own header file inclusion. */
+#include "densmora.commands.h"
+
+/* Number of records the ring buffer can hold (must be a power of 2 so that
+ * indices can be reduced with a mask). */
+#define EVENT_LOG_CAPACITY 1024
+
+/* Number of records waiting in the ring buffer at which it is flushed whenever the shell next
+ * waits (rather than only once it is idle), so that long runs of commands do not fill it. */
+#define EVENT_LOG_HIGH_WATER (EVENT_LOG_CAPACITY / 2)
+
+/* Maximum number of chars of a command line stored in a single event record. */
+#define EVENT_LOG_COMMAND_CHARS 256
+
+/* Size of the buffer into which batches of JSON lines are formatted before being written. */
+#define EVENT_LOG_BATCH_BYTES 65536
+
+/* Event types stored in EventRecord structs. */
+#define EVENT_COMMAND_START 0
+#define EVENT_BACKGROUND_LAUNCH 1
+#define EVENT_COMMAND_EXIT 2
+
+/* Struct storing a single event in the ring buffer. All members are fixed-size
+ * so that records can be filled in without allocating memory (which keeps
+ * recording safe to do from within a signal handler). */
+
+struct EventRecord
+{
+	volatile sig_atomic_t ready;		/* Set to TRUE once the record has been completely written. */
+	int type;				/* One of the EVENT_* types defined above. */
+	pid_t pid;				/* Pid of the child process the event describes. */
+	int isBgCommand;			/* Flag indicating whether the child runs in the background. */
+	int code;				/* Exit status or terminating signal (exit events only). */
+	int exitedNormally;			/* Flag indicating whether the child exited normally (exit events only). */
+	struct timespec timestamp;		/* Wall-clock time at which the event was recorded. */
+	long durationUsec;			/* Microseconds between launch and exit (exit events only). */
+	long userUsec;				/* User CPU time consumed by the child (exit events only). */
+	long sysUsec;				/* System CPU time consumed by the child (exit events only). */
+	long maxRssKb;				/* Peak resident set size of the child (exit events only). */
+	char command[EVENT_LOG_COMMAND_CHARS];	/* Command line that was run (start and launch events only). */
+};
+
+/* Struct storing the ring buffer of event records along with the descriptor to which they are flushed.
+ * head is advanced by producers reserving records and tail is advanced by the consumer flushing them. */
+
+struct EventLog
+{
+	int fd;					/* Descriptor of the event log, or -1 if logging is disabled. */
+	unsigned long head;			/* Index of the next record to be reserved. */
+	unsigned long tail;			/* Index of the next record to be flushed. */
+	unsigned long dropped;			/* Number of events dropped because the buffer was full. */
+	struct EventRecord records[EVENT_LOG_CAPACITY];	/* Ring buffer of event records. */
+};
+
+/* Function prototypes (see densmora.eventLog.c for function descriptions and implementations). */
+void initEventLog();
+void logCommandStart(struct CommandInfo* myCommand, pid_t pid, int isBgCommand);
+void formatCommandLine(struct CommandInfo* myCommand, char* buffer, int bufferSize);
+void logCommandExit(pid_t pid, int isBgCommand, int childExitMethod,
+		    struct timespec* startTime, struct rusage* usage);
+struct EventRecord* reserveEventRecord();
+int drainEventLog(int isIdle);
+void flushEventLog();
+int formatEventRecord(struct EventRecord* record, char* buffer, int bufferSize);
+void closeEventLog();
+
+#endif
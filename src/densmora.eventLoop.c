@@ -0,0 +1,419 @@
+/***************************************************************************************
+ * File: densmora.eventLoop.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that make
+ * 		up the shell's epoll-based event loop. Other parts of the shell
+ * 		register descriptors along with a callback, and the loop calls each
+ * 		callback whenever its descriptor becomes readable. One idle callback
+ * 		may also be set to do deferred work before the loop sleeps.
+ **************************************************************************************/
+
+#include "densmora.eventLoop.h"
+
+/* Epoll instance shared by all watchers, list of watchers removed during the
+ * current dispatch (freed once it finishes), number of dispatches in progress,
+ * and flag set once the shell's input is readable while waitForInput waits for it. */
+static int epollFd = -1;
+static struct EventWatcher* removedWatchers = NULL;
+static int dispatchDepth = 0;
+static int inputReady = FALSE;
+
+/* Function called before the loop sleeps (see setIdleCallback), or NULL. It is global because it is
+ * set once at startup by the module that needs it and called by every run of the loop. */
+static int (*idleCallback)(int isIdle) = NULL;
+
+/* Bytes of the shell's input read ahead of the current line. It is global because it outlives
+ * each call to readInputLine (a single read may return several lines). */
+static struct InputBuffer input = { NULL, 0, 0 };
+
+/* Descriptor and stream for the shell's prompt and notices (see densmora.eventLoop.h), which are
+ * stdout itself until initShellOutput copies it. */
+int shellOutputFd = STDOUT_FILENO;
+FILE* shellOutput = NULL;
+
+
+/***************************************************************************************
+ * Function Name: initEventLoop
+ * Description:	Creates the epoll instance used by the event loop. Must be called
+ * 		before any other function in this file. Receives and returns nothing.
+ **************************************************************************************/
+
+void initEventLoop()
+{
+	epollFd = raiseShellFd(epoll_create1(EPOLL_CLOEXEC));
+	if (epollFd == -1)
+	{
+		perror("epoll_create1()"); fflush(stderr);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: initShellOutput
+ * Description:	Copies stdout to a close-on-exec descriptor at or above SHELL_FD_BASE
+ * 		and opens shellOutput on it, so that the prompt and notices keep
+ * 		going where stdout first went after exec > file changes stdout for
+ * 		commands and built-ins. Falls back to stdout itself if it cannot be
+ * 		copied. Must be called before anything is printed to shellOutput.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void initShellOutput()
+{
+	int outputFd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+	FILE* outputStream = (outputFd != -1) ? fdopen(outputFd, "w") : NULL;
+	if (outputStream == NULL)
+	{
+		if (outputFd != -1)
+		{
+			close(outputFd);
+		}
+		shellOutput = stdout;
+		return;
+	}
+	shellOutputFd = outputFd;
+	shellOutput = outputStream;
+}
+
+
+/***************************************************************************************
+ * Function Name: addEventWatcher
+ * Description:	Receives a descriptor, a callback, and an argument for the callback.
+ * 		Registers the descriptor with the event loop so that callback(fd, arg)
+ * 		is called each time it becomes readable. Returns a pointer to the new
+ * 		EventWatcher (needed to remove it later), or NULL if the descriptor
+ * 		cannot be watched (for example, because it refers to a regular file).
+ **************************************************************************************/
+
+struct EventWatcher* addEventWatcher(int fd, void (*callback)(int fd, void* arg), void* arg)
+{
+	/* Declare and allocate memory for new EventWatcher. */
+	struct EventWatcher* watcher;
+	watcher = (struct EventWatcher*)malloc(sizeof(struct EventWatcher));
+	watcher->fd = fd;
+	watcher->callback = callback;
+	watcher->arg = arg;
+	watcher->writeCallback = NULL;
+	watcher->readPaused = FALSE;
+	watcher->removed = FALSE;
+	watcher->nextRemoved = NULL;
+
+	/* Register the descriptor with epoll, storing the watcher itself as the event data
+	 * so that no lookup is needed when the descriptor becomes readable. */
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = watcher;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+	{
+		free(watcher);
+		return NULL;
+	}
+
+	return watcher;
+}
+
+
+/***************************************************************************************
+ * Function Name: removeEventWatcher
+ * Description:	Receives a pointer to an EventWatcher. Stops watching its descriptor
+ * 		(which the caller remains responsible for closing). Since the watcher
+ * 		may still appear among events already returned by epoll_wait, its
+ * 		memory is freed only after the current dispatch finishes.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void removeEventWatcher(struct EventWatcher* watcher)
+{
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, watcher->fd, NULL);
+	watcher->removed = TRUE;
+	watcher->nextRemoved = removedWatchers;
+	removedWatchers = watcher;
+}
+
+
+/***************************************************************************************
+ * Function Name: watchWritable
+ * Description:	Receives a pointer to an EventWatcher and a callback. If the callback
+ * 		is not NULL, it is called (with the watcher's arg) each time the
+ * 		descriptor is writable, in addition to the read callback when it is
+ * 		readable. Passing NULL stops watching for writability (as callers
+ * 		should once they have nothing left to write). Returns nothing.
+ **************************************************************************************/
+
+void watchWritable(struct EventWatcher* watcher, void (*writeCallback)(int fd, void* arg))
+{
+	watcher->writeCallback = writeCallback;
+	updateWatcherEvents(watcher);
+}
+
+
+/***************************************************************************************
+ * Function Name: pauseReading
+ * Description:	Receives a pointer to an EventWatcher. Stops watching its descriptor
+ * 		for input (for example, once a peer has finished sending), although
+ * 		the read callback is still called if the descriptor hangs up or
+ * 		reports an error. Returns nothing.
+ **************************************************************************************/
+
+void pauseReading(struct EventWatcher* watcher)
+{
+	watcher->readPaused = TRUE;
+	updateWatcherEvents(watcher);
+}
+
+
+/***************************************************************************************
+ * Function Name: updateWatcherEvents
+ * Description:	Receives a pointer to an EventWatcher. Tells epoll which events to
+ * 		report for its descriptor based on whether reading is paused and
+ * 		whether a write callback is set. Returns nothing.
+ **************************************************************************************/
+
+void updateWatcherEvents(struct EventWatcher* watcher)
+{
+	struct epoll_event event;
+	event.events = 0;
+	if (watcher->readPaused == FALSE)
+	{
+		event.events |= EPOLLIN;
+	}
+	if (watcher->writeCallback != NULL)
+	{
+		event.events |= EPOLLOUT;
+	}
+	event.data.ptr = watcher;
+	epoll_ctl(epollFd, EPOLL_CTL_MOD, watcher->fd, &event);
+}
+
+
+/***************************************************************************************
+ * Function Name: setIdleCallback
+ * Description:	Receives a function for the event loop to call before each sleep with
+ * 		isIdle set to FALSE. If it returns TRUE (it has work left for when the
+ * 		shell is idle), the loop sleeps at most IDLE_CALLBACK_MS first and, if
+ * 		nothing happened by then, calls it again with isIdle set to TRUE
+ * 		before sleeping for the rest of its timeout. Used to do work such as
+ * 		flushing the event log without a timer or thread. Returns nothing.
+ **************************************************************************************/
+
+void setIdleCallback(int (*callback)(int isIdle))
+{
+	idleCallback = callback;
+}
+
+
+/***************************************************************************************
+ * Function Name: runEventLoopOnce
+ * Description:	Waits up to timeoutMs milliseconds (forever if -1) for at least one
+ * 		watched descriptor to become readable, and calls the callback of each
+ * 		one that did. Callbacks may themselves run the event loop (for
+ * 		example, to wait on a child process). The idle callback, if any, is
+ * 		run before sleeping (see setIdleCallback). Receives the timeout.
+ * 		Returns the number of events dispatched, 0 on timeout, or -1 if the
+ * 		wait was interrupted by a signal.
+ **************************************************************************************/
+
+int runEventLoopOnce(int timeoutMs)
+{
+	struct epoll_event events[MAX_LOOP_EVENTS];
+	int numEvents;
+
+	/* Let the idle callback work before sleeping. If it has work left for when the shell is idle,
+	 * wait IDLE_CALLBACK_MS first, and call it again if nothing happened by then. */
+	if (idleCallback != NULL && idleCallback(FALSE) == TRUE && (timeoutMs == -1 || timeoutMs > IDLE_CALLBACK_MS))
+	{
+		numEvents = epoll_wait(epollFd, events, MAX_LOOP_EVENTS, IDLE_CALLBACK_MS);
+		if (numEvents == 0)
+		{
+			idleCallback(TRUE);
+			numEvents = epoll_wait(epollFd, events, MAX_LOOP_EVENTS,
+					       (timeoutMs == -1) ? -1 : timeoutMs - IDLE_CALLBACK_MS);
+		}
+	}
+
+	/* Otherwise, simply wait for events. Either way, return -1 if interrupted by a signal so that
+	 * callers can check their flags. */
+	else
+	{
+		numEvents = epoll_wait(epollFd, events, MAX_LOOP_EVENTS, timeoutMs);
+	}
+	if (numEvents == -1)
+	{
+		return -1;
+	}
+
+	/* Call the write callback of each watcher that is writable and the read callback of each one that is
+	 * readable (or has hung up), skipping any removed by an earlier callback. */
+	dispatchDepth++;
+	for (int i = 0; i < numEvents; i++)
+	{
+		struct EventWatcher* watcher = (struct EventWatcher*)events[i].data.ptr;
+		if (watcher->removed == FALSE && (events[i].events & EPOLLOUT) && watcher->writeCallback != NULL)
+		{
+			watcher->writeCallback(watcher->fd, watcher->arg);
+		}
+		if (watcher->removed == FALSE && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+		{
+			watcher->callback(watcher->fd, watcher->arg);
+		}
+	}
+	dispatchDepth--;
+
+	/* Free any watchers removed during this dispatch. */
+	freeRemovedWatchers();
+	return numEvents;
+}
+
+
+/***************************************************************************************
+ * Function Name: freeRemovedWatchers
+ * Description:	Frees the memory of every watcher removed since the last call, unless
+ * 		a dispatch is still in progress further up the stack (in which case
+ * 		its array of events may still refer to them). Receives and returns
+ * 		nothing.
+ **************************************************************************************/
+
+void freeRemovedWatchers()
+{
+	if (dispatchDepth > 0)
+	{
+		return;
+	}
+
+	while (removedWatchers != NULL)
+	{
+		struct EventWatcher* garbageWatcher = removedWatchers;
+		removedWatchers = removedWatchers->nextRemoved;
+		free(garbageWatcher);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: markInputReady
+ * Description:	Callback registered for the shell's input while waitForInput waits
+ * 		for it. Receives the descriptor and an unused argument. Sets the
+ * 		inputReady flag. Returns nothing.
+ **************************************************************************************/
+
+static void markInputReady(int fd, void* arg)
+{
+	inputReady = TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: waitForInput
+ * Description:	Runs the event loop, servicing every other watched descriptor, until
+ * 		the shell's input (stdin) is readable, so that the following read
+ * 		does not block the loop. Returns immediately if a complete line has
+ * 		already been read into the input buffer or if stdin cannot be watched
+ * 		(such as a regular file, which is always readable). Receives and
+ * 		returns nothing.
+ **************************************************************************************/
+
+void waitForInput()
+{
+	/* A line read ahead along with an earlier one can be returned without reading. */
+	if (input.length > 0 && memchr(input.data, '\n', input.length) != NULL)
+	{
+		return;
+	}
+
+	/* Watch stdin for the duration of this call, returning immediately if it cannot be watched. */
+	struct EventWatcher* inputWatcher = addEventWatcher(STDIN_FILENO, markInputReady, NULL);
+	if (inputWatcher == NULL)
+	{
+		return;
+	}
+
+	/* Dispatch events until stdin is readable. Signals that interrupt the wait
+	 * (such as SIGTSTP) simply cause the loop to iterate again. */
+	inputReady = FALSE;
+	while (inputReady == FALSE)
+	{
+		runEventLoopOnce(-1);
+	}
+
+	/* Stop watching stdin and free the watcher. */
+	removeEventWatcher(inputWatcher);
+	freeRemovedWatchers();
+}
+
+
+/***************************************************************************************
+ * Function Name: readInputLine
+ * Description:	Receives the address of a line buffer (which may be NULL) and of its
+ * 		size, like getline(). Returns the next line of the shell's input,
+ * 		reading stdin with read() (and waiting for it in the event loop) until
+ * 		the input buffer holds a newline or stdin reaches end of file. Stores
+ * 		the line, including its newline if it has one, with a null
+ * 		terminator, growing the line buffer as needed. Returns the number of
+ * 		chars stored, or -1 at end of file or if a read fails or is
+ * 		interrupted by a signal (in which case the caller may simply try
+ * 		again, since no input is lost).
+ **************************************************************************************/
+
+ssize_t readInputLine(char** line, size_t* bufferSize)
+{
+	char* newline;
+
+	/* Read until a complete line is buffered, returning what is left at end of file. */
+	while ((newline = (input.length > 0) ? memchr(input.data, '\n', input.length) : NULL) == NULL)
+	{
+		if (input.capacity - input.length < INPUT_READ_BYTES)
+		{
+			input.capacity = (input.capacity == 0) ? INPUT_READ_BYTES * 2 : input.capacity * 2;
+			input.data = (char*)realloc(input.data, input.capacity);
+		}
+		waitForInput();
+		ssize_t bytesRead = read(STDIN_FILENO, input.data + input.length, input.capacity - input.length);
+		if (bytesRead == -1 || (bytesRead == 0 && input.length == 0))
+		{
+			return -1;
+		}
+		if (bytesRead == 0)
+		{
+			break;
+		}
+		input.length += bytesRead;
+	}
+
+	/* Copy the line out, and keep the bytes after it for the next call. */
+	size_t lineLength = (newline != NULL) ? (size_t)(newline - input.data) + 1 : input.length;
+	if (*line == NULL || *bufferSize < lineLength + 1)
+	{
+		*bufferSize = lineLength + 1;
+		*line = (char*)realloc(*line, *bufferSize);
+	}
+	memcpy(*line, input.data, lineLength);
+	(*line)[lineLength] = '\0';
+	input.length -= lineLength;
+	memmove(input.data, input.data + lineLength, input.length);
+	return lineLength;
+}
+
+
+/***************************************************************************************
+ * Function Name: raiseShellFd
+ * Description:	Receives a close-on-exec descriptor that the shell keeps open for its
+ * 		whole run (or -1). Moves it to the lowest free descriptor at or above
+ * 		SHELL_FD_BASE, closing the original. Returns the new descriptor, or
+ * 		the one received if it is already there or cannot be moved.
+ **************************************************************************************/
+
+int raiseShellFd(int fd)
+{
+	if (fd == -1 || fd >= SHELL_FD_BASE)
+	{
+		return fd;
+	}
+	int newFd = fcntl(fd, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+	if (newFd == -1)
+	{
+		return fd;
+	}
+	close(fd);
+	return newFd;
+}
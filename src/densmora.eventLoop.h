@@ -0,0 +1,88 @@
+/***************************************************************************************
+ * File: densmora.eventLoop.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definition of the EventWatcher struct and
+ * 		prototypes of the functions that make up the shell's event loop. The
+ * 		event loop lets the shell service other descriptors (such as sockets)
+ * 		while it waits for the user to enter a command. See
+ * 		densmora.eventLoop.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_EVENT_LOOP
+#define DENSMORA_EVENT_LOOP
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+
+/* My own header file inclusion. */
+#include "densmora.smallshConstants.h"
+
+/* Lowest descriptor used for the shell's own long-lived descriptors, so that the low ones
+ * are left free for the exec built-in to redirect (as in exec 3< file). */
+#define SHELL_FD_BASE 10
+
+/* Maximum number of events handled per call to epoll_wait. */
+#define MAX_LOOP_EVENTS 64
+
+/* Milliseconds the loop must sit with nothing to do before the idle callback is told the shell
+ * is idle (see setIdleCallback). */
+#define IDLE_CALLBACK_MS 100
+
+/* Struct storing a descriptor watched by the event loop and the function to call
+ * (with arg) whenever that descriptor becomes readable (and, optionally, writable). */
+
+struct EventWatcher
+{
+	int fd;						/* Descriptor being watched. */
+	void (*callback)(int fd, void* arg);		/* Function called when fd is readable. */
+	void (*writeCallback)(int fd, void* arg);	/* Function called when fd is writable (if requested). */
+	int readPaused;					/* Set to TRUE to stop watching fd for input. */
+	void* arg;					/* Argument passed to callback. */
+	int removed;					/* Set to TRUE once removed; freed after dispatch. */
+	struct EventWatcher* nextRemoved;		/* Next watcher waiting to be freed. */
+};
+
+/* Number of bytes read from the shell's input at a time. */
+#define INPUT_READ_BYTES 4096
+
+/* Struct storing bytes read from the shell's input (stdin) that have not yet been returned as
+ * lines. The shell reads its input with read() rather than stdio, so that it alone knows whether
+ * a complete line is already waiting before it blocks in the event loop. */
+
+struct InputBuffer
+{
+	char* data;			/* Bytes read but not yet returned. */
+	size_t length;			/* Number of bytes in data. */
+	size_t capacity;		/* Number of bytes allocated to data. */
+};
+
+/* Copy of the shell's original stdout (kept above SHELL_FD_BASE), and a stream on it, on which the
+ * shell writes its prompt and notices (such as "background pid is ..."). They need to be accessible
+ * to every part of the shell that prints a notice (and to the SIGTSTP handler), and keep those notices
+ * on the terminal when the exec built-in redirects stdout for commands and built-ins. */
+extern int shellOutputFd;
+extern FILE* shellOutput;
+
+/* Function prototypes (see densmora.eventLoop.c for function descriptions and implementations). */
+void initEventLoop();
+void initShellOutput();
+struct EventWatcher* addEventWatcher(int fd, void (*callback)(int fd, void* arg), void* arg);
+void removeEventWatcher(struct EventWatcher* watcher);
+void watchWritable(struct EventWatcher* watcher, void (*writeCallback)(int fd, void* arg));
+void pauseReading(struct EventWatcher* watcher);
+void updateWatcherEvents(struct EventWatcher* watcher);
+void setIdleCallback(int (*callback)(int isIdle));
+int runEventLoopOnce(int timeoutMs);
+void freeRemovedWatchers();
+void waitForInput();
+ssize_t readInputLine(char** line, size_t* bufferSize);
+int raiseShellFd(int fd);
+
+#endif
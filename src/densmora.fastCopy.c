@@ -0,0 +1,351 @@
+/***************************************************************************************
+ * File: densmora.fastCopy.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that run
+ * 		plain "cat" copies inside the shell. A foreground cat with no options
+ * 		that reads from its < file or from files named as args is recognized
+ * 		by the dispatcher, and the data is moved with copy_file_range,
+ * 		falling back to sendfile, then splice, then read and write for pairs
+ * 		of files that a method does not support. Output and input files are
+ * 		opened, errors are reported, and the exit status is set as they would
+ * 		be for a cat child. Setting SMALLSH_FASTCOPY=0 (for example with
+ * 		export) turns the fast path off so that cat is executed normally.
+ **************************************************************************************/
+
+#include "densmora.fastCopy.h"
+
+
+/***************************************************************************************
+ * Function Name: runFastCopy
+ * Description:	Receives a parsed foreground command and the ForegroundExitMethod
+ * 		struct. If the command is a plain cat copy (see isFastCopyCommand),
+ * 		performs the copy in the shell and stores the exit status cat would
+ * 		have had (0, or 1 if any file could not be opened or copied, or
+ * 		SIGINT if the user interrupted the copy). Returns TRUE if the command
+ * 		was handled, or FALSE if it must be run normally.
+ **************************************************************************************/
+
+int runFastCopy(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus)
+{
+	int outputFd = STDOUT_FILENO;
+	int inputFd = -1;
+	struct stat outputStat;
+	int exitCode = 0;
+
+	if (isFastCopyCommand(myCommand) == FALSE)
+	{
+		return FALSE;
+	}
+
+	/* Open the > file and then the < file, exactly as executeChild would. */
+	fflush(stdout);
+	if (myCommand->outputFlag == TRUE)
+	{
+		outputFd = open(myCommand->outputRedirDest, O_WRONLY | O_TRUNC | O_CREAT | O_CLOEXEC, FILE_PERMISSIONS);
+		if (outputFd == -1)
+		{
+			fprintf(stderr, "cannot open %s for output\n", myCommand->outputRedirDest); fflush(stderr);
+			setExitMethod(lastFgStatus, 1 << 8);
+			return TRUE;
+		}
+	}
+	if (myCommand->inputFlag == TRUE)
+	{
+		inputFd = open(myCommand->inputRedirDest, O_RDONLY | O_CLOEXEC);
+		if (inputFd == -1)
+		{
+			fprintf(stderr, "cannot open %s for input\n", myCommand->inputRedirDest); fflush(stderr);
+			if (outputFd != STDOUT_FILENO)
+			{
+				close(outputFd);
+			}
+			setExitMethod(lastFgStatus, 1 << 8);
+			return TRUE;
+		}
+	}
+	fstat(outputFd, &outputStat);
+
+	/* Copy the < file if no files were named, or otherwise each named file in turn
+	 * (reporting files that fail like cat does and moving on), until interrupted. */
+	interruptOnSIGINT();
+	if (myCommand->commandArgs[1] == NULL)
+	{
+		exitCode = copyFastCopyInput(inputFd, myCommand->inputRedirDest, outputFd, &outputStat);
+	}
+	else
+	{
+		for (int i = 1; myCommand->commandArgs[i] != NULL && sigintReceived == FALSE; i++)
+		{
+			int fileFd = open(myCommand->commandArgs[i], O_RDONLY | O_CLOEXEC);
+			if (fileFd == -1)
+			{
+				fprintf(stderr, "cat: %s: %s\n", myCommand->commandArgs[i], strerror(errno)); fflush(stderr);
+				exitCode = 1;
+				continue;
+			}
+			if (copyFastCopyInput(fileFd, myCommand->commandArgs[i], outputFd, &outputStat) != 0)
+			{
+				exitCode = 1;
+			}
+			close(fileFd);
+		}
+	}
+	ignoreSIGINT();
+
+	/* Close the files and store the status. */
+	if (inputFd != -1)
+	{
+		close(inputFd);
+	}
+	if (outputFd != STDOUT_FILENO)
+	{
+		close(outputFd);
+	}
+	if (sigintReceived == TRUE)
+	{
+		fprintf(shellOutput, "terminated by signal %d\n", SIGINT); fflush(shellOutput);
+		setExitMethod(lastFgStatus, SIGINT);
+	}
+	else
+	{
+		setExitMethod(lastFgStatus, exitCode << 8);
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: isFastCopyCommand
+ * Description:	Receives a parsed command. Returns TRUE if the fast path is enabled and
+ * 		the command is "cat" with no options (no arg starts with "-", which
+ * 		also excludes "-" for stdin) reading from a < file or from named
+ * 		files, or FALSE otherwise. A bare cat reading the shell's own stdin,
+ * 		or one whose output goes to several files, is always executed
+ * 		normally.
+ **************************************************************************************/
+
+int isFastCopyCommand(struct CommandInfo* myCommand)
+{
+	char* setting = getEnvVar("SMALLSH_FASTCOPY");
+	if ((setting != NULL && strcmp(setting, "0") == 0) || strcmp(myCommand->commandArgs[0], "cat") != 0
+	    || myCommand->numExtraOutputDests > 0)
+	{
+		return FALSE;
+	}
+	for (int i = 1; myCommand->commandArgs[i] != NULL; i++)
+	{
+		if (myCommand->commandArgs[i][0] == '-')
+		{
+			return FALSE;
+		}
+	}
+	return (myCommand->inputFlag == TRUE || myCommand->commandArgs[1] != NULL) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: copyFastCopyInput
+ * Description:	Receives an open input file, its name (for messages), the output
+ * 		file, and the output's stat. Copies the input to the output, refusing
+ * 		(like cat) to copy a regular file onto itself when that would never
+ * 		end. Returns 0 on success, or 1 after reporting an error.
+ **************************************************************************************/
+
+int copyFastCopyInput(int inputFd, char* inputName, int outputFd, struct stat* outputStat)
+{
+	struct stat inputStat;
+
+	if (fstat(inputFd, &inputStat) == 0 && S_ISREG(outputStat->st_mode) && S_ISREG(inputStat.st_mode)
+	    && inputStat.st_dev == outputStat->st_dev && inputStat.st_ino == outputStat->st_ino
+	    && lseek(inputFd, 0, SEEK_CUR) < inputStat.st_size)
+	{
+		fprintf(stderr, "cat: %s: input file is output file\n", inputName); fflush(stderr);
+		return 1;
+	}
+	if (copyFileData(inputFd, outputFd) == -1 && sigintReceived == FALSE)
+	{
+		fprintf(stderr, "cat: %s: %s\n", inputName, strerror(errno)); fflush(stderr);
+		return 1;
+	}
+	return 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: copyFileData
+ * Description:	Receives an input and an output descriptor. Copies from the input's
+ * 		current position to its end, starting with copy_file_range and moving
+ * 		to the next method whenever the kernel reports that a method does not
+ * 		support this pair of files. Stops early if SIGINT is received.
+ * 		Returns 0 on success, or -1 with errno set on failure.
+ **************************************************************************************/
+
+int copyFileData(int inputFd, int outputFd)
+{
+	int method = COPY_FILE_RANGE;
+	int splicePipe[2] = { -1, -1 };
+	struct stat inputStat, outputStat;
+	ssize_t bytesCopied;
+	int result = 0;
+
+	/* splice needs a pipe at one end, so note whether one of the files already is one. */
+	fstat(inputFd, &inputStat);
+	fstat(outputFd, &outputStat);
+	int needsPipe = (S_ISFIFO(inputStat.st_mode) || S_ISFIFO(outputStat.st_mode)) ? FALSE : TRUE;
+
+	while (sigintReceived == FALSE)
+	{
+		bytesCopied = copyChunk(inputFd, outputFd, method, (needsPipe == TRUE) ? splicePipe : NULL);
+		if (bytesCopied == 0)
+		{
+			break;
+		}
+
+		/* Retry after a signal, and move to the next method if this one is not supported. */
+		if (bytesCopied == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if (method != COPY_READ_WRITE && (errno == EXDEV || errno == EINVAL || errno == ENOSYS
+							  || errno == EOPNOTSUPP || errno == EBADF))
+			{
+				method++;
+				continue;
+			}
+			result = -1;
+			break;
+		}
+	}
+
+	if (splicePipe[0] != -1)
+	{
+		int savedErrno = errno;
+		close(splicePipe[0]);
+		close(splicePipe[1]);
+		errno = savedErrno;
+	}
+	return result;
+}
+
+
+/***************************************************************************************
+ * Function Name: copyChunk
+ * Description:	Receives an input and an output descriptor, the method to use, and a
+ * 		two-element array for the intermediate pipe splice needs when neither
+ * 		file is a pipe (NULL if one is; the pipe is created on first use).
+ * 		Copies up to FAST_COPY_CHUNK_BYTES bytes. Returns the number of bytes
+ * 		copied, 0 at the end of the input, or -1 with errno set. If the
+ * 		output turns out not to support splice, the data already in the
+ * 		intermediate pipe is written out before EINVAL is returned.
+ **************************************************************************************/
+
+ssize_t copyChunk(int inputFd, int outputFd, int method, int* splicePipe)
+{
+	static char buffer[65536];
+
+	if (method == COPY_FILE_RANGE)
+	{
+		return copy_file_range(inputFd, NULL, outputFd, NULL, FAST_COPY_CHUNK_BYTES, 0);
+	}
+	else if (method == COPY_SENDFILE)
+	{
+		return sendfile(outputFd, inputFd, NULL, FAST_COPY_CHUNK_BYTES);
+	}
+	else if (method == COPY_SPLICE)
+	{
+		if (splicePipe == NULL)
+		{
+			return splice(inputFd, NULL, outputFd, NULL, FAST_COPY_CHUNK_BYTES, SPLICE_F_MOVE);
+		}
+
+		/* Move the data into the intermediate pipe and then out of it. */
+		if (splicePipe[0] == -1 && pipe2(splicePipe, O_CLOEXEC) == -1)
+		{
+			splicePipe[0] = splicePipe[1] = -1;
+			errno = EINVAL;
+			return -1;
+		}
+		ssize_t bytesIn = splice(inputFd, NULL, splicePipe[1], NULL, FAST_COPY_CHUNK_BYTES, SPLICE_F_MOVE);
+		for (ssize_t bytesLeft = bytesIn; bytesLeft > 0; )
+		{
+			ssize_t bytesOut = splice(splicePipe[0], NULL, outputFd, NULL, bytesLeft, SPLICE_F_MOVE);
+			if (bytesOut == -1 && errno == EINTR)
+			{
+				continue;
+			}
+			if (bytesOut == -1 && bytesLeft == bytesIn && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+			{
+				/* The output does not accept splice, so write out what is in the pipe and let
+				 * the caller move on to read and write. */
+				if (drainSplicePipe(splicePipe[0], outputFd, bytesLeft) == -1)
+				{
+					return -1;
+				}
+				errno = EINVAL;
+				return -1;
+			}
+			if (bytesOut <= 0)
+			{
+				errno = (bytesOut == 0) ? EIO : errno;
+				return -1;
+			}
+			bytesLeft -= bytesOut;
+		}
+		return bytesIn;
+	}
+
+	/* Otherwise, copy through user space, writing everything that was read. */
+	ssize_t bytesRead = read(inputFd, buffer, sizeof(buffer));
+	for (ssize_t bytesWritten = 0; bytesRead > 0 && bytesWritten < bytesRead; )
+	{
+		ssize_t result = write(outputFd, buffer + bytesWritten, bytesRead - bytesWritten);
+		if (result == -1 && errno != EINTR)
+		{
+			return -1;
+		}
+		bytesWritten += (result > 0) ? result : 0;
+	}
+	return bytesRead;
+}
+
+
+/***************************************************************************************
+ * Function Name: drainSplicePipe
+ * Description:	Receives the read end of the intermediate splice pipe, the output
+ * 		descriptor, and the number of bytes waiting in the pipe. Writes them
+ * 		to the output through user space. Returns 0 on success, or -1 with
+ * 		errno set on failure.
+ **************************************************************************************/
+
+int drainSplicePipe(int pipeFd, int outputFd, ssize_t numBytes)
+{
+	char buffer[4096];
+
+	while (numBytes > 0)
+	{
+		ssize_t bytesRead = read(pipeFd, buffer, (numBytes < (ssize_t)sizeof(buffer)) ? numBytes : (ssize_t)sizeof(buffer));
+		if (bytesRead == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (bytesRead <= 0)
+		{
+			errno = (bytesRead == 0) ? EIO : errno;
+			return -1;
+		}
+		for (ssize_t bytesWritten = 0; bytesWritten < bytesRead; )
+		{
+			ssize_t result = write(outputFd, buffer + bytesWritten, bytesRead - bytesWritten);
+			if (result == -1 && errno != EINTR)
+			{
+				return -1;
+			}
+			bytesWritten += (result > 0) ? result : 0;
+		}
+		numBytes -= bytesRead;
+	}
+	return 0;
+}
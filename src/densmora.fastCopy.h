@@ -0,0 +1,39 @@
+/***************************************************************************************
+ * File: densmora.fastCopy.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing prototypes of the functions that run plain
+ * 		"cat" copies (such as cat < in > out or cat a b > out) inside the
+ * 		shell with kernel-side copies instead of forking cat. See
+ * 		densmora.fastCopy.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_FAST_COPY
+#define DENSMORA_FAST_COPY
+
+/* Built-in header file inclusions. */
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+
+/* Largest number of bytes moved by a single copy_file_range, sendfile, or splice call
+ * (kept moderate so that SIGINT is noticed promptly during large copies). */
+#define FAST_COPY_CHUNK_BYTES (8 * 1024 * 1024)
+
+/* Ways of copying data, tried in order until one is supported by the pair of files. */
+#define COPY_FILE_RANGE 0
+#define COPY_SENDFILE 1
+#define COPY_SPLICE 2
+#define COPY_READ_WRITE 3
+
+/* Function prototypes (see densmora.fastCopy.c for function descriptions and implementations). */
+int runFastCopy(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus);
+int isFastCopyCommand(struct CommandInfo* myCommand);
+int copyFastCopyInput(int inputFd, char* inputName, int outputFd, struct stat* outputStat);
+int copyFileData(int inputFd, int outputFd);
+ssize_t copyChunk(int inputFd, int outputFd, int method, int* splicePipe);
+int drainSplicePipe(int pipeFd, int outputFd, ssize_t numBytes);
+
+#endif
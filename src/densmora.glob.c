@@ -0,0 +1,642 @@
+/***************************************************************************************
+ * File: densmora.glob.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		expand wildcard words into file names. A pattern is split at its
+ * 		slashes, and each component containing wildcards is compiled into
+ * 		tokens once and matched against the listing of every directory
+ * 		reached so far. Listings are read with getdents64 into a cache of
+ * 		recently used directories, so a directory that has not changed since
+ * 		it was last read is never read again. The matched paths are stored
+ * 		in one buffer and placed straight into the command's args.
+ **************************************************************************************/
+
+#include "densmora.glob.h"
+
+/* Recently read directory listings. */
+static struct GlobDir globCache[GLOB_CACHE_DIRS];
+
+/* Counter incremented on every cache lookup (to find the least recently used listing). */
+static unsigned long globUseCounter = 0;
+
+/* Buffer filled by getdents64 (allocated on first use). */
+static char* dentsBuffer = NULL;
+
+
+/***************************************************************************************
+ * Function Name: hasGlobChars
+ * Description:	Receives a word. Returns TRUE if it contains *, ?, or [ (and so may be
+ * 		a pattern), or FALSE otherwise.
+ **************************************************************************************/
+
+int hasGlobChars(const char* word)
+{
+	return (strpbrk(word, "*?[") != NULL) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: compareGlobMatches
+ * Description:	qsort comparison function ordering string pointers bytewise.
+ **************************************************************************************/
+
+static int compareGlobMatches(const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+
+/***************************************************************************************
+ * Function Name: expandGlob
+ * Description:	Receives a CommandInfo pointer, a word containing wildcards, and the
+ * 		index in commandArgs at which to store its matches. Stores the paths
+ * 		matching the word there (growing commandArgs as needed), sorted unless
+ * 		SMALLSH_GLOB_SORT is 0, and returns the number stored. Returns 0 and
+ * 		stores nothing if no path matches, so that the caller keeps the word
+ * 		as it is.
+ **************************************************************************************/
+
+int expandGlob(struct CommandInfo* myCommand, char* pattern, int vectSize)
+{
+	int patternLength = strlen(pattern);
+	char* patternCopy = strdup(pattern);
+	struct GlobComponent* components = (struct GlobComponent*)malloc((patternLength + 1) * sizeof(struct GlobComponent));
+	int numComponents = 0;
+	int hasWildcards = FALSE;
+	struct GlobMatches matches;
+	char path[PATH_MAX];
+	int pathLength = 0;
+	char* savePtr;
+
+	/* Compile each component, starting from the root directory if the pattern does. */
+	if (pattern[0] == '/')
+	{
+		path[pathLength++] = '/';
+	}
+	path[pathLength] = '\0';
+	for (char* text = strtok_r(patternCopy, "/", &savePtr); text != NULL; text = strtok_r(NULL, "/", &savePtr))
+	{
+		if (compileGlobComponent(&components[numComponents++], text) == TRUE)
+		{
+			hasWildcards = TRUE;
+		}
+	}
+
+	/* Collect the matching paths (a pattern ending in '/' only matches directories). */
+	memset(&matches, 0, sizeof(struct GlobMatches));
+	if (hasWildcards == TRUE)
+	{
+		walkGlob(components, numComponents, (pattern[patternLength - 1] == '/') ? TRUE : FALSE,
+			 path, pathLength, &matches);
+	}
+	for (int i = 0; i < numComponents; i++)
+	{
+		free(components[i].tokens);
+	}
+	free(components);
+	free(patternCopy);
+	if (matches.numMatches == 0)
+	{
+		free(matches.names);
+		free(matches.offsets);
+		return 0;
+	}
+
+	/* Point the args at the matches, and sort them in place. */
+	growCommandArgs(myCommand, vectSize + matches.numMatches + 1);
+	for (int i = 0; i < matches.numMatches; i++)
+	{
+		myCommand->commandArgs[vectSize + i] = matches.names + matches.offsets[i];
+	}
+	char* sortSetting = getEnvVar("SMALLSH_GLOB_SORT");
+	if (sortSetting == NULL || strcmp(sortSetting, "0") != 0)
+	{
+		qsort(myCommand->commandArgs + vectSize, matches.numMatches, sizeof(char*), compareGlobMatches);
+	}
+
+	/* Hand the names buffer to the command, which frees it with its other expanded words. */
+	if (myCommand->expansionList == NULL)
+	{
+		myCommand->expansionList = newPidExpansions();
+	}
+	addPidNode(myCommand->expansionList, matches.names);
+	free(matches.offsets);
+	return matches.numMatches;
+}
+
+
+/***************************************************************************************
+ * Function Name: compileGlobComponent
+ * Description:	Receives a GlobComponent pointer and the text of one component of a
+ * 		pattern (which it keeps pointing at). Compiles the text into tokens,
+ * 		collapsing runs of '*'. Returns TRUE if the text contains wildcards,
+ * 		or FALSE (leaving tokens NULL) if it is matched literally, as is a '['
+ * 		with no closing ']'.
+ **************************************************************************************/
+
+int compileGlobComponent(struct GlobComponent* component, char* text)
+{
+	int hasWildcards = FALSE;
+
+	component->text = text;
+	component->tokens = NULL;
+	component->numTokens = 0;
+	component->minLength = 0;
+	component->matchesHidden = (text[0] == '.') ? TRUE : FALSE;
+	if (hasGlobChars(text) == FALSE)
+	{
+		return FALSE;
+	}
+
+	component->tokens = (struct GlobToken*)malloc(strlen(text) * sizeof(struct GlobToken));
+	for (int i = 0; text[i] != '\0'; )
+	{
+		struct GlobToken* token = &component->tokens[component->numTokens];
+		int classLength;
+
+		if (text[i] == '*')
+		{
+			if (component->numTokens == 0 || token[-1].type != GLOB_STAR)
+			{
+				token->type = GLOB_STAR;
+				component->numTokens++;
+			}
+			hasWildcards = TRUE;
+			i++;
+			continue;
+		}
+		else if (text[i] == '?')
+		{
+			token->type = GLOB_ANY;
+			hasWildcards = TRUE;
+			i++;
+		}
+		else if (text[i] == '[' && (classLength = compileGlobClass(text + i, token)) > 0)
+		{
+			hasWildcards = TRUE;
+			i += classLength;
+		}
+		else
+		{
+			token->type = GLOB_LITERAL;
+			token->literal = (unsigned char)text[i];
+			i++;
+		}
+		component->numTokens++;
+		component->minLength++;
+	}
+
+	if (hasWildcards == FALSE)
+	{
+		free(component->tokens);
+		component->tokens = NULL;
+		component->numTokens = 0;
+	}
+	return hasWildcards;
+}
+
+
+/***************************************************************************************
+ * Function Name: compileGlobClass
+ * Description:	Receives text starting with '[' and a GlobToken pointer. Compiles the
+ * 		bracket expression (such as [abc], [a-z], or [!0-9], where a ']'
+ * 		right after the '[' or '!' is a member) into the token. Returns the
+ * 		number of chars it spans, or 0 if it is not closed.
+ **************************************************************************************/
+
+int compileGlobClass(const char* text, struct GlobToken* token)
+{
+	int i = 1;
+	int negate = FALSE;
+
+	if (text[i] == '!' || text[i] == '^')
+	{
+		negate = TRUE;
+		i++;
+	}
+
+	/* Set the bit of every member, and of every char in each range. */
+	memset(token->classBits, 0, sizeof(token->classBits));
+	int first = i;
+	while (text[i] != '\0' && (text[i] != ']' || i == first))
+	{
+		int low = (unsigned char)text[i];
+		int high = low;
+		if (text[i + 1] == '-' && text[i + 2] != ']' && text[i + 2] != '\0')
+		{
+			high = (unsigned char)text[i + 2];
+			i += 3;
+		}
+		else
+		{
+			i++;
+		}
+		for (int c = low; c <= high; c++)
+		{
+			token->classBits[c >> 3] |= 1 << (c & 7);
+		}
+	}
+	if (text[i] != ']')
+	{
+		return 0;
+	}
+
+	if (negate == TRUE)
+	{
+		for (int byte = 0; byte < 32; byte++)
+		{
+			token->classBits[byte] = ~token->classBits[byte];
+		}
+	}
+	token->type = GLOB_CLASS;
+	return i + 1;
+}
+
+
+/***************************************************************************************
+ * Function Name: matchGlobComponent
+ * Description:	Receives a compiled component and a file name with its length.
+ * 		Returns TRUE if the name matches, or FALSE otherwise. On a mismatch
+ * 		after a '*', the '*' takes one more char and matching resumes, which
+ * 		is never slower than the length of the name times that of the pattern.
+ **************************************************************************************/
+
+int matchGlobComponent(struct GlobComponent* component, const char* name, int nameLength)
+{
+	struct GlobToken* tokens = component->tokens;
+	int t = 0;
+	int n = 0;
+	int starToken = -1;
+	int starName = 0;
+
+	if (nameLength < component->minLength)
+	{
+		return FALSE;
+	}
+
+	while (n < nameLength)
+	{
+		unsigned char c = (unsigned char)name[n];
+		if (t < component->numTokens && tokens[t].type == GLOB_STAR)
+		{
+			starToken = ++t;
+			starName = n;
+		}
+		else if (t < component->numTokens
+			 && (tokens[t].type == GLOB_ANY
+			     || (tokens[t].type == GLOB_LITERAL && tokens[t].literal == c)
+			     || (tokens[t].type == GLOB_CLASS && (tokens[t].classBits[c >> 3] & (1 << (c & 7))) != 0)))
+		{
+			t++;
+			n++;
+		}
+		else if (starToken != -1)
+		{
+			t = starToken;
+			n = ++starName;
+		}
+		else
+		{
+			return FALSE;
+		}
+	}
+
+	/* Only trailing '*' tokens can match the empty rest of the name. */
+	while (t < component->numTokens && tokens[t].type == GLOB_STAR)
+	{
+		t++;
+	}
+	return (t == component->numTokens) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: walkGlob
+ * Description:	Receives the components of a pattern still to be matched, their
+ * 		number, whether the final match must be a directory, the path matched
+ * 		so far (in a PATH_MAX buffer that is appended to) with its length,
+ * 		and the GlobMatches receiving full matches. Matches the first
+ * 		component in the directory named by path, recursing into matching
+ * 		directories for the rest. Returns nothing.
+ **************************************************************************************/
+
+void walkGlob(struct GlobComponent* components, int numComponents, int dirOnly,
+	      char* path, int pathLength, struct GlobMatches* matches)
+{
+	struct GlobComponent* component = &components[0];
+	int isLast = (numComponents == 1) ? TRUE : FALSE;
+	int newLength;
+
+	/* A literal component is appended without reading the directory (checking that it exists if it is last). */
+	if (component->tokens == NULL)
+	{
+		struct stat entryStat;
+		newLength = appendGlobPath(path, pathLength, component->text, strlen(component->text));
+		if (newLength == -1)
+		{
+			return;
+		}
+		if (isLast == FALSE)
+		{
+			walkGlob(components + 1, numComponents - 1, dirOnly, path, newLength, matches);
+		}
+		else if (lstat(path, &entryStat) == 0 && dirOnly == FALSE)
+		{
+			addGlobMatch(matches, path, newLength);
+		}
+		else if (lstat(path, &entryStat) == 0 && isGlobDirectory(path, DT_UNKNOWN) == TRUE)
+		{
+			addGlobMatch(matches, path, appendGlobPath(path, newLength, "", 0));
+		}
+		return;
+	}
+
+	/* Otherwise, match the component against the directory's listing, keeping the listing in place until done. */
+	struct GlobDir* dir = getGlobDir(path);
+	if (dir == NULL)
+	{
+		return;
+	}
+	dir->pinCount++;
+	for (size_t offset = 0; offset < dir->entriesLength; )
+	{
+		unsigned char type = (unsigned char)dir->entries[offset];
+		char* name = dir->entries + offset + 1;
+		int nameLength = strlen(name);
+		offset += nameLength + 2;
+
+		/* Names starting with '.' only match patterns that do. */
+		if ((name[0] == '.' && component->matchesHidden == FALSE)
+		    || matchGlobComponent(component, name, nameLength) == FALSE
+		    || (newLength = appendGlobPath(path, pathLength, name, nameLength)) == -1)
+		{
+			continue;
+		}
+		if (isLast == FALSE)
+		{
+			if (isGlobDirectory(path, type) == TRUE)
+			{
+				walkGlob(components + 1, numComponents - 1, dirOnly, path, newLength, matches);
+			}
+		}
+		else if (dirOnly == FALSE)
+		{
+			addGlobMatch(matches, path, newLength);
+		}
+		else if (isGlobDirectory(path, type) == TRUE)
+		{
+			addGlobMatch(matches, path, appendGlobPath(path, newLength, "", 0));
+		}
+	}
+	dir->pinCount--;
+	releaseGlobDir(dir);
+}
+
+
+/***************************************************************************************
+ * Function Name: appendGlobPath
+ * Description:	Receives a path in a PATH_MAX buffer, its length, and a name with its
+ * 		length. Appends a '/' (unless the path is empty or already ends with
+ * 		one) and the name. Returns the new length, or -1 (leaving the path
+ * 		as it was) if it would not fit.
+ **************************************************************************************/
+
+int appendGlobPath(char* path, int pathLength, const char* name, int nameLength)
+{
+	int slash = (pathLength > 0 && path[pathLength - 1] != '/') ? 1 : 0;
+	if (pathLength + slash + nameLength >= PATH_MAX)
+	{
+		return -1;
+	}
+	path[pathLength] = '/';
+	memcpy(path + pathLength + slash, name, nameLength);
+	path[pathLength + slash + nameLength] = '\0';
+	return pathLength + slash + nameLength;
+}
+
+
+/***************************************************************************************
+ * Function Name: addGlobMatch
+ * Description:	Receives a GlobMatches pointer and a matched path with its length.
+ * 		Appends a copy of the path to the matches. Returns nothing.
+ **************************************************************************************/
+
+void addGlobMatch(struct GlobMatches* matches, const char* path, int pathLength)
+{
+	if (matches->namesLength + pathLength + 1 > matches->namesCapacity)
+	{
+		matches->namesCapacity = 2 * (matches->namesCapacity + pathLength + 1);
+		matches->names = (char*)realloc(matches->names, matches->namesCapacity);
+	}
+	if (matches->numMatches == matches->offsetsCapacity)
+	{
+		matches->offsetsCapacity = (matches->offsetsCapacity == 0) ? 64 : 2 * matches->offsetsCapacity;
+		matches->offsets = (size_t*)realloc(matches->offsets, matches->offsetsCapacity * sizeof(size_t));
+	}
+	matches->offsets[matches->numMatches++] = matches->namesLength;
+	memcpy(matches->names + matches->namesLength, path, pathLength + 1);
+	matches->namesLength += pathLength + 1;
+}
+
+
+/***************************************************************************************
+ * Function Name: isGlobDirectory
+ * Description:	Receives a path and the d_type reported for it. Returns TRUE if it is
+ * 		a directory (or a symbolic link to one), or FALSE otherwise. Only
+ * 		calls stat when the type does not already answer the question.
+ **************************************************************************************/
+
+int isGlobDirectory(const char* path, unsigned char type)
+{
+	struct stat pathStat;
+	if (type == DT_DIR)
+	{
+		return TRUE;
+	}
+	if (type != DT_LNK && type != DT_UNKNOWN)
+	{
+		return FALSE;
+	}
+	return (stat(path, &pathStat) == 0 && S_ISDIR(pathStat.st_mode)) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: getGlobDir
+ * Description:	Receives the path of a directory ("" for the working directory).
+ * 		Returns its listing, taken from the cache if the directory is the
+ * 		same one with the same mtime as when it was read, or read again
+ * 		into the least recently used slot otherwise. Returns NULL if the
+ * 		directory cannot be read. The caller passes the listing to
+ * 		releaseGlobDir when done with it.
+ **************************************************************************************/
+
+struct GlobDir* getGlobDir(const char* path)
+{
+	const char* openPath = (path[0] == '\0') ? "." : path;
+	struct stat dirStat;
+	struct GlobDir* dir = NULL;
+	unsigned int hash = 2166136261u;
+
+	if (stat(openPath, &dirStat) == -1 || !S_ISDIR(dirStat.st_mode))
+	{
+		return NULL;
+	}
+
+	/* Look for the directory in the cache, returning its listing if it is still current. */
+	for (const char* c = path; *c != '\0'; c++)
+	{
+		hash ^= (unsigned char)*c;
+		hash *= 16777619u;
+	}
+	globUseCounter++;
+	for (int i = 0; i < GLOB_CACHE_DIRS && dir == NULL; i++)
+	{
+		if (globCache[i].path != NULL && globCache[i].hash == hash && strcmp(globCache[i].path, path) == 0)
+		{
+			dir = &globCache[i];
+		}
+	}
+	if (dir != NULL && dir->trusted == TRUE && dir->dev == dirStat.st_dev && dir->ino == dirStat.st_ino
+	    && dir->mtime.tv_sec == dirStat.st_mtim.tv_sec && dir->mtime.tv_nsec == dirStat.st_mtim.tv_nsec)
+	{
+		dir->lastUsed = globUseCounter;
+		return dir;
+	}
+
+	/* Otherwise, pick the slot to read it into (its stale slot, or else the least recently used one). */
+	if (dir == NULL || dir->pinCount > 0)
+	{
+		dir = NULL;
+		for (int i = 0; i < GLOB_CACHE_DIRS; i++)
+		{
+			if (globCache[i].pinCount == 0 && (dir == NULL || globCache[i].lastUsed < dir->lastUsed))
+			{
+				dir = &globCache[i];
+			}
+		}
+	}
+
+	/* If every slot is in use by the walks above this one, read the listing without caching it. */
+	if (dir == NULL)
+	{
+		dir = (struct GlobDir*)calloc(1, sizeof(struct GlobDir));
+		if (scanGlobDir(dir, openPath) == FALSE)
+		{
+			free(dir);
+			return NULL;
+		}
+		return dir;
+	}
+
+	free(dir->path);
+	free(dir->entries);
+	dir->path = NULL;
+	dir->entries = NULL;
+	if (scanGlobDir(dir, openPath) == FALSE)
+	{
+		return NULL;
+	}
+	dir->path = strdup(path);
+	dir->hash = hash;
+	dir->lastUsed = globUseCounter;
+	dir->isCached = TRUE;
+	return dir;
+}
+
+
+/***************************************************************************************
+ * Function Name: scanGlobDir
+ * Description:	Receives a GlobDir pointer and the path to open. Reads the directory's
+ * 		entries (other than . and ..) into the GlobDir with getdents64, many
+ * 		at a time, and records its identity and mtime. Returns TRUE on
+ * 		success, or FALSE if the directory cannot be read.
+ *
+ * 		The listing is only trusted later if the mtime was older than the
+ * 		moment just before it was read (on the coarse clock the kernel uses
+ * 		for timestamps): a change made during or after the read then gets a
+ * 		different mtime, while a directory changed within the same tick is
+ * 		simply read again next time.
+ **************************************************************************************/
+
+int scanGlobDir(struct GlobDir* dir, const char* openPath)
+{
+	struct timespec scanStart;
+	struct stat dirStat;
+	size_t entriesCapacity;
+	long numBytes;
+
+	clock_gettime(CLOCK_REALTIME_COARSE, &scanStart);
+	int dirFd = open(openPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirFd == -1)
+	{
+		return FALSE;
+	}
+	fstat(dirFd, &dirStat);
+	dir->dev = dirStat.st_dev;
+	dir->ino = dirStat.st_ino;
+	dir->mtime = dirStat.st_mtim;
+	dir->trusted = (dirStat.st_mtim.tv_sec < scanStart.tv_sec
+			|| (dirStat.st_mtim.tv_sec == scanStart.tv_sec && dirStat.st_mtim.tv_nsec < scanStart.tv_nsec))
+		       ? TRUE : FALSE;
+
+	/* Copy each batch of entries into the listing (whose size starts at that of the directory file). */
+	if (dentsBuffer == NULL)
+	{
+		dentsBuffer = (char*)malloc(GLOB_DENTS_BYTES);
+	}
+	entriesCapacity = (dirStat.st_size > 4096) ? dirStat.st_size : 4096;
+	dir->entries = (char*)malloc(entriesCapacity);
+	dir->entriesLength = 0;
+	while ((numBytes = syscall(SYS_getdents64, dirFd, dentsBuffer, GLOB_DENTS_BYTES)) > 0)
+	{
+		for (long offset = 0; offset < numBytes; )
+		{
+			struct dirent64* entry = (struct dirent64*)(dentsBuffer + offset);
+			char* name = entry->d_name;
+			offset += entry->d_reclen;
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+			{
+				continue;
+			}
+
+			size_t nameLength = strlen(name);
+			if (dir->entriesLength + nameLength + 2 > entriesCapacity)
+			{
+				entriesCapacity = 2 * entriesCapacity + nameLength + 2;
+				dir->entries = (char*)realloc(dir->entries, entriesCapacity);
+			}
+			dir->entries[dir->entriesLength] = (char)entry->d_type;
+			memcpy(dir->entries + dir->entriesLength + 1, name, nameLength + 1);
+			dir->entriesLength += nameLength + 2;
+		}
+	}
+	close(dirFd);
+
+	if (numBytes == -1)
+	{
+		free(dir->entries);
+		dir->entries = NULL;
+		dir->entriesLength = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: releaseGlobDir
+ * Description:	Receives a listing returned by getGlobDir. Frees it if it was read
+ * 		outside the cache (cached listings stay for later globs). Returns
+ * 		nothing.
+ **************************************************************************************/
+
+void releaseGlobDir(struct GlobDir* dir)
+{
+	if (dir->isCached == FALSE)
+	{
+		free(dir->entries);
+		free(dir);
+	}
+}
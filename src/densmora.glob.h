@@ -0,0 +1,104 @@
+/***************************************************************************************
+ * File: densmora.glob.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions that expand words containing *, ?, or [...] into the
+ * 		names of matching files. Directory listings are read with large
+ * 		getdents64 batches and kept in a cache checked against each
+ * 		directory's mtime. See densmora.glob.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_GLOB
+#define DENSMORA_GLOB
+
+/* Built-in header file inclusions. */
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.environment.h"
+
+/* Size of the buffer filled by each getdents64 call. */
+#define GLOB_DENTS_BYTES (256 * 1024)
+
+/* Number of directory listings kept in the cache (the least recently used one is replaced). */
+#define GLOB_CACHE_DIRS 32
+
+/* Kinds of token in a compiled pattern. */
+#define GLOB_LITERAL 0
+#define GLOB_ANY 1
+#define GLOB_STAR 2
+#define GLOB_CLASS 3
+
+/* Struct storing one token of a compiled pattern. */
+
+struct GlobToken
+{
+	unsigned char type;			/* GLOB_LITERAL, GLOB_ANY, GLOB_STAR, or GLOB_CLASS. */
+	unsigned char literal;			/* Char matched by a GLOB_LITERAL token. */
+	unsigned char classBits[32];		/* Bitmap of the chars matched by a GLOB_CLASS token. */
+};
+
+/* Struct storing one path component of a pattern (the text between two slashes). */
+
+struct GlobComponent
+{
+	char* text;				/* Text of the component (used as is if it has no wildcards). */
+	struct GlobToken* tokens;		/* Compiled tokens (NULL if the component is literal). */
+	int numTokens;				/* Number of elements in tokens. */
+	int minLength;				/* Fewest chars a matching name can have. */
+	int matchesHidden;			/* Set to TRUE if the pattern starts with '.', so it matches dot files. */
+};
+
+/* Struct storing the cached listing of one directory. Each entry is stored as its
+ * d_type byte followed by its null-terminated name. */
+
+struct GlobDir
+{
+	char* path;				/* Directory as named in the pattern ("" for the working directory). */
+	unsigned int hash;			/* Hash of path. */
+	dev_t dev;				/* Device and inode of the directory when it was read. */
+	ino_t ino;
+	struct timespec mtime;			/* Modification time of the directory when it was read. */
+	int trusted;				/* Set to TRUE if mtime was older than the read (see scanGlobDir). */
+	char* entries;				/* Names of the entries other than . and .. */
+	size_t entriesLength;			/* Number of bytes used in entries. */
+	unsigned long lastUsed;			/* Value of the use counter when last used. */
+	int pinCount;				/* Number of walks reading entries (it is not replaced while above 0). */
+	int isCached;				/* Set to FALSE for a listing read while every slot was pinned. */
+};
+
+/* Struct storing the names matched by one pattern. The names are stored one after another
+ * in a single buffer, which becomes owned by the command once the names are in its args. */
+
+struct GlobMatches
+{
+	char* names;				/* Null-terminated matched paths. */
+	size_t namesLength;			/* Number of bytes used in names. */
+	size_t namesCapacity;			/* Number of bytes allocated for names. */
+	size_t* offsets;			/* Offset in names of each match. */
+	int numMatches;				/* Number of matches. */
+	int offsetsCapacity;			/* Number of elements allocated for offsets. */
+};
+
+/* Function prototypes (see densmora.glob.c for function descriptions and implementations). */
+int hasGlobChars(const char* word);
+int expandGlob(struct CommandInfo* myCommand, char* pattern, int vectSize);
+int compileGlobComponent(struct GlobComponent* component, char* text);
+int compileGlobClass(const char* text, struct GlobToken* token);
+int matchGlobComponent(struct GlobComponent* component, const char* name, int nameLength);
+void walkGlob(struct GlobComponent* components, int numComponents, int dirOnly,
+	      char* path, int pathLength, struct GlobMatches* matches);
+int appendGlobPath(char* path, int pathLength, const char* name, int nameLength);
+void addGlobMatch(struct GlobMatches* matches, const char* path, int pathLength);
+int isGlobDirectory(const char* path, unsigned char type);
+struct GlobDir* getGlobDir(const char* path);
+int scanGlobDir(struct GlobDir* dir, const char* openPath);
+void releaseGlobDir(struct GlobDir* dir);
+
+#endif
@@ -0,0 +1,370 @@
+/***************************************************************************************
+ * File: densmora.jobBoard.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		publish the shell's background jobs to the job status board named by
+ * 		SMALLSH_JOBBOARD, and of the functions monitors use to read a board
+ * 		(smallsh --jobs path...). The board is a file of fixed-size slots
+ * 		mapped into the shell, which writes each slot under a seqlock: the
+ * 		shell never waits for readers, and readers simply retry a slot that
+ * 		changed while they were copying it. Boards can be kept on a tmpfs
+ * 		such as /dev/shm so that nothing is ever written to disk.
+ **************************************************************************************/
+
+#include "densmora.jobBoard.h"
+
+/* The shell's board, shared by every function in this file. It is global (rather than passed
+ * around like the other structs in smallsh) since jobs are launched and reaped in many places. */
+static struct JobBoard jobBoard = { NULL, NULL, 0, NULL, 0, 0 };
+
+
+/***************************************************************************************
+ * Function Name: initJobBoard
+ * Description:	Creates the job status board if SMALLSH_JOBBOARD names a path, with
+ * 		SMALLSH_JOBBOARD_SLOTS slots (default DEFAULT_JOB_BOARD_SLOTS). Any
+ * 		file already at the path is removed first rather than truncated, so
+ * 		that a reader still mapping it is unaffected. The magic number is
+ * 		written last, so readers never accept a board that is still being
+ * 		set up. If the variable is not set, publishing stays disabled and
+ * 		the publishing functions return immediately. Receives and returns
+ * 		nothing.
+ **************************************************************************************/
+
+void initJobBoard()
+{
+	char* boardPath = getenv("SMALLSH_JOBBOARD");
+	char* slotsString = getenv("SMALLSH_JOBBOARD_SLOTS");
+	long numSlots = DEFAULT_JOB_BOARD_SLOTS;
+
+	if (boardPath == NULL || boardPath[0] == '\0')
+	{
+		return;
+	}
+	if (slotsString != NULL && slotsString[0] != '\0')
+	{
+		char* endPtr;
+		numSlots = strtol(slotsString, &endPtr, 10);
+		if (*endPtr != '\0' || numSlots < 1 || numSlots > MAX_JOB_BOARD_SLOTS)
+		{
+			fprintf(stderr, "SMALLSH_JOBBOARD_SLOTS: must be from 1 to %d\n", MAX_JOB_BOARD_SLOTS); fflush(stderr);
+			return;
+		}
+	}
+
+	/* Create a new file of the right size (its contents start out zero, so every slot is free). */
+	size_t mapSize = sizeof(struct JobBoardHeader) + numSlots * sizeof(struct JobBoardSlot);
+	unlink(boardPath);
+	int boardFd = open(boardPath, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, FILE_PERMISSIONS);
+	if (boardFd == -1 || ftruncate(boardFd, mapSize) == -1)
+	{
+		perror(boardPath); fflush(stderr);
+		if (boardFd != -1)
+		{
+			close(boardFd);
+			unlink(boardPath);
+		}
+		return;
+	}
+
+	/* Map it (the mapping outlives the descriptor). */
+	void* mapping = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, boardFd, 0);
+	close(boardFd);
+	if (mapping == MAP_FAILED)
+	{
+		perror(boardPath); fflush(stderr);
+		unlink(boardPath);
+		return;
+	}
+
+	/* Fill in the header, publishing the magic number once everything else is in place. */
+	jobBoard.header = (struct JobBoardHeader*)mapping;
+	jobBoard.slots = (struct JobBoardSlot*)((char*)mapping + sizeof(struct JobBoardHeader));
+	jobBoard.mapSize = mapSize;
+	jobBoard.path = strdup(boardPath);
+	jobBoard.header->version = JOB_BOARD_VERSION;
+	jobBoard.header->headerSize = sizeof(struct JobBoardHeader);
+	jobBoard.header->slotSize = sizeof(struct JobBoardSlot);
+	jobBoard.header->numSlots = (uint32_t)numSlots;
+	jobBoard.header->shellPid = (int32_t)getpid();
+	jobBoard.header->shellRunning = 1;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(jobBoard.header->magic, JOB_BOARD_MAGIC, sizeof(jobBoard.header->magic));
+}
+
+
+/***************************************************************************************
+ * Function Name: publishJobStart
+ * Description:	Receives the BackgroundNode of a job that was just launched and its
+ * 		CommandInfo struct. Puts the job in the first slot (from where the
+ * 		last search stopped) not holding a running job, so finished jobs stay
+ * 		on the board for as long as possible, and stores the slot in the
+ * 		node. If every slot holds a running job, counts the job as dropped
+ * 		instead. Returns nothing.
+ **************************************************************************************/
+
+void publishJobStart(struct BackgroundNode* node, struct CommandInfo* myCommand)
+{
+	if (jobBoard.header == NULL)
+	{
+		return;
+	}
+	int numSlots = (int)jobBoard.header->numSlots;
+	if (jobBoard.numRunning == numSlots)
+	{
+		__atomic_store_n(&jobBoard.header->dropped, jobBoard.header->dropped + 1, __ATOMIC_RELEASE);
+		return;
+	}
+
+	/* Find a slot, which must exist since not every slot holds a running job. */
+	int index = jobBoard.nextSlot;
+	while (jobBoard.slots[index].state == JOB_SLOT_RUNNING)
+	{
+		index = (index + 1) % numSlots;
+	}
+	jobBoard.nextSlot = (index + 1) % numSlots;
+	jobBoard.numRunning++;
+	node->boardSlot = index;
+
+	/* Fill it in. */
+	struct JobBoardSlot* slot = &jobBoard.slots[index];
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	beginSlotWrite(slot);
+	slot->pid = (int32_t)node->pid;
+	slot->state = JOB_SLOT_RUNNING;
+	slot->status = 0;
+	slot->startSec = now.tv_sec;
+	slot->startNsec = now.tv_nsec;
+	slot->endSec = 0;
+	slot->endNsec = 0;
+	formatCommandLine(myCommand, slot->command, JOB_BOARD_COMMAND_BYTES);
+	endSlotWrite(slot);
+}
+
+
+/***************************************************************************************
+ * Function Name: publishJobExit
+ * Description:	Receives the BackgroundNode of a job that was just reaped and its exit
+ * 		method. Marks the job's slot (if it has one) finished, with its exit
+ * 		value or terminating signal. Returns nothing.
+ **************************************************************************************/
+
+void publishJobExit(struct BackgroundNode* node, int childExitMethod)
+{
+	if (jobBoard.header == NULL || node->boardSlot == -1)
+	{
+		return;
+	}
+
+	struct JobBoardSlot* slot = &jobBoard.slots[node->boardSlot];
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	beginSlotWrite(slot);
+	if (WIFSIGNALED(childExitMethod) != 0)
+	{
+		slot->state = JOB_SLOT_SIGNALED;
+		slot->status = WTERMSIG(childExitMethod);
+	}
+	else
+	{
+		slot->state = JOB_SLOT_EXITED;
+		slot->status = WEXITSTATUS(childExitMethod);
+	}
+	slot->endSec = now.tv_sec;
+	slot->endNsec = now.tv_nsec;
+	endSlotWrite(slot);
+	jobBoard.numRunning--;
+	node->boardSlot = -1;
+}
+
+
+/***************************************************************************************
+ * Function Name: beginSlotWrite
+ * Description:	Receives a slot of the shell's board. Makes its sequence number odd
+ * 		before any of its other members change, so that a reader copying it
+ * 		meanwhile discards the copy. Returns nothing.
+ **************************************************************************************/
+
+void beginSlotWrite(struct JobBoardSlot* slot)
+{
+	__atomic_store_n(&slot->sequence, slot->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+/***************************************************************************************
+ * Function Name: endSlotWrite
+ * Description:	Receives a slot of the shell's board whose members have changed. Makes
+ * 		its sequence number even again once they are all written, and counts
+ * 		the change in the header's generation (so monitors can tell that
+ * 		nothing changed without reading every slot). Returns nothing.
+ **************************************************************************************/
+
+void endSlotWrite(struct JobBoardSlot* slot)
+{
+	__atomic_store_n(&slot->sequence, slot->sequence + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&jobBoard.header->generation, jobBoard.header->generation + 1, __ATOMIC_RELEASE);
+}
+
+
+/***************************************************************************************
+ * Function Name: closeJobBoard
+ * Description:	Marks the board as belonging to a shell that has exited (for readers
+ * 		that still have it mapped), removes its file, and unmaps it. Called
+ * 		as the shell exits, after its jobs have been reaped. Receives and
+ * 		returns nothing.
+ **************************************************************************************/
+
+void closeJobBoard()
+{
+	if (jobBoard.header == NULL)
+	{
+		return;
+	}
+	__atomic_store_n(&jobBoard.header->shellRunning, 0, __ATOMIC_RELEASE);
+	unlink(jobBoard.path);
+	munmap(jobBoard.header, jobBoard.mapSize);
+	free(jobBoard.path);
+	jobBoard.header = NULL;
+	jobBoard.slots = NULL;
+	jobBoard.path = NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: openJobBoard
+ * Description:	Receives the path of a board and the address of a size_t. Maps the
+ * 		board read-only, storing the size of the mapping in *mapSize (for
+ * 		munmap). Returns the board's header, or NULL (after reporting the
+ * 		error) if it cannot be mapped or is not a board of this version.
+ **************************************************************************************/
+
+struct JobBoardHeader* openJobBoard(char* path, size_t* mapSize)
+{
+	struct stat boardStat;
+	int boardFd = open(path, O_RDONLY | O_CLOEXEC);
+	if (boardFd == -1 || fstat(boardFd, &boardStat) == -1)
+	{
+		perror(path); fflush(stderr);
+		if (boardFd != -1)
+		{
+			close(boardFd);
+		}
+		return NULL;
+	}
+	if ((size_t)boardStat.st_size < sizeof(struct JobBoardHeader))
+	{
+		fprintf(stderr, "%s: not a job board\n", path); fflush(stderr);
+		close(boardFd);
+		return NULL;
+	}
+
+	/* Map it, and check that the header describes a board that fits in the file. */
+	void* mapping = mmap(NULL, boardStat.st_size, PROT_READ, MAP_SHARED, boardFd, 0);
+	close(boardFd);
+	if (mapping == MAP_FAILED)
+	{
+		perror(path); fflush(stderr);
+		return NULL;
+	}
+	struct JobBoardHeader* header = (struct JobBoardHeader*)mapping;
+	int isBoard = (memcmp(header->magic, JOB_BOARD_MAGIC, sizeof(header->magic)) == 0) ? TRUE : FALSE;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (isBoard == FALSE || header->version != JOB_BOARD_VERSION
+	    || header->headerSize != sizeof(struct JobBoardHeader) || header->slotSize != sizeof(struct JobBoardSlot)
+	    || header->headerSize + (size_t)header->numSlots * header->slotSize > (size_t)boardStat.st_size)
+	{
+		fprintf(stderr, "%s: not a job board of version %d\n", path, JOB_BOARD_VERSION); fflush(stderr);
+		munmap(mapping, boardStat.st_size);
+		return NULL;
+	}
+	*mapSize = boardStat.st_size;
+	return header;
+}
+
+
+/***************************************************************************************
+ * Function Name: readJobBoardSlot
+ * Description:	Receives a board's header (from openJobBoard), the index of one of its
+ * 		slots, and the address of a slot into which to copy it. Copies the
+ * 		slot, retrying (up to JOB_BOARD_READ_ATTEMPTS times) while the shell
+ * 		is changing it. Returns TRUE once it has a consistent copy, or FALSE
+ * 		if the slot never held still.
+ **************************************************************************************/
+
+int readJobBoardSlot(struct JobBoardHeader* header, int index, struct JobBoardSlot* copy)
+{
+	struct JobBoardSlot* slot = (struct JobBoardSlot*)((char*)header + header->headerSize) + index;
+
+	for (int attempt = 0; attempt < JOB_BOARD_READ_ATTEMPTS; attempt++)
+	{
+		uint32_t before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+		if ((before & 1) == 0)
+		{
+			memcpy(copy, slot, sizeof(struct JobBoardSlot));
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == before)
+			{
+				copy->command[JOB_BOARD_COMMAND_BYTES - 1] = '\0';
+				return TRUE;
+			}
+		}
+		sched_yield();
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: printJobBoards
+ * Description:	Receives a number of board paths and the paths (from smallsh --jobs).
+ * 		Prints one line for each job on each board, giving the shell's pid,
+ * 		the job's pid, its state, its exit value or signal (- while it runs),
+ * 		its start time in seconds since the epoch, and its command. Returns
+ * 		0, or 1 if any board could not be read.
+ **************************************************************************************/
+
+int printJobBoards(int numPaths, char** paths)
+{
+	int result = 0;
+
+	printf("SHELL\tPID\tSTATE\tSTATUS\tSTARTED\t\tCOMMAND\n");
+	for (int i = 0; i < numPaths; i++)
+	{
+		size_t mapSize;
+		struct JobBoardHeader* header = openJobBoard(paths[i], &mapSize);
+		if (header == NULL)
+		{
+			result = 1;
+			continue;
+		}
+
+		/* Print every slot that holds a job, skipping (and reporting) any that kept changing. */
+		for (int index = 0; index < (int)header->numSlots; index++)
+		{
+			struct JobBoardSlot slot;
+			if (readJobBoardSlot(header, index, &slot) == FALSE)
+			{
+				fprintf(stderr, "%s: slot %d kept changing\n", paths[i], index); fflush(stderr);
+				result = 1;
+				continue;
+			}
+			if (slot.state == JOB_SLOT_FREE)
+			{
+				continue;
+			}
+			char status[16] = "-";
+			if (slot.state != JOB_SLOT_RUNNING)
+			{
+				snprintf(status, sizeof(status), "%d", (int)slot.status);
+			}
+			printf("%d\t%d\t%s\t%s\t%lld.%03d\t%s\n", (int)header->shellPid, (int)slot.pid,
+			       (slot.state == JOB_SLOT_RUNNING) ? "running" : (slot.state == JOB_SLOT_EXITED) ? "exited" : "signaled",
+			       status, (long long)slot.startSec, (int)(slot.startNsec / 1000000), slot.command);
+		}
+		munmap(header, mapSize);
+	}
+	fflush(stdout);
+	return result;
+}
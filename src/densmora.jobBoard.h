@@ -0,0 +1,113 @@
+/***************************************************************************************
+ * File: densmora.jobBoard.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the layout of the job status board, a
+ * 		memory-mapped file in which the shell publishes its background jobs
+ * 		(pid, command, state, start and end time, and exit status) for
+ * 		external monitors, and prototypes of the functions that write and read
+ * 		it. Readers only map the file, so they never make a syscall into the
+ * 		shell or make it wait. See densmora.jobBoard.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_JOB_BOARD
+#define DENSMORA_JOB_BOARD
+
+/* Built-in header file inclusions. */
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.eventLog.h"
+
+/* First bytes of every board, and version of the layout below. The version changes whenever
+ * the meaning of an existing member changes; members may only be added in reserved space. */
+#define JOB_BOARD_MAGIC "SMSHJOBS"
+#define JOB_BOARD_VERSION 1
+
+/* Default and largest number of slots (set with SMALLSH_JOBBOARD_SLOTS). */
+#define DEFAULT_JOB_BOARD_SLOTS 1024
+#define MAX_JOB_BOARD_SLOTS 65536
+
+/* Number of bytes of the command line kept in each slot (including the terminating null). */
+#define JOB_BOARD_COMMAND_BYTES 200
+
+/* Number of times a reader retries a slot that keeps changing before giving up on it. */
+#define JOB_BOARD_READ_ATTEMPTS 1000
+
+/* States of a slot. A slot keeps a finished job until it is needed for a new one. */
+#define JOB_SLOT_FREE 0
+#define JOB_SLOT_RUNNING 1
+#define JOB_SLOT_EXITED 2		/* status holds the exit value. */
+#define JOB_SLOT_SIGNALED 3		/* status holds the terminating signal. */
+
+/* Header at the start of the board (64 bytes). Only generation and dropped change after the
+ * board is created, and shellRunning once the shell exits. */
+
+struct JobBoardHeader
+{
+	char magic[8];				/* JOB_BOARD_MAGIC (without its null), written last. */
+	uint32_t version;			/* JOB_BOARD_VERSION. */
+	uint32_t headerSize;			/* sizeof(struct JobBoardHeader): offset of the first slot. */
+	uint32_t slotSize;			/* sizeof(struct JobBoardSlot). */
+	uint32_t numSlots;			/* Number of slots following the header. */
+	int32_t shellPid;			/* Pid of the shell writing the board. */
+	uint32_t shellRunning;			/* 1 while the shell is running, and 0 once it has exited. */
+	uint64_t generation;			/* Incremented after each change to a slot. */
+	uint64_t dropped;			/* Jobs left off the board because every slot held a running job. */
+	uint8_t reserved[16];			/* Zero. */
+};
+
+/* Slot holding one job (256 bytes). sequence is a seqlock: the shell makes it odd before
+ * changing the slot and even again after, so a reader's copy is consistent if sequence was
+ * even and unchanged on both sides of it. Times are CLOCK_REALTIME. */
+
+struct JobBoardSlot
+{
+	uint32_t sequence;			/* Seqlock sequence number (odd while being written). */
+	int32_t pid;				/* Pid of the job. */
+	int32_t state;				/* One of the JOB_SLOT states. */
+	int32_t status;				/* Exit value or signal number once finished. */
+	int64_t startSec;			/* Time at which the job was launched. */
+	int64_t startNsec;
+	int64_t endSec;				/* Time at which the job was reaped (0 while running). */
+	int64_t endNsec;
+	char command[JOB_BOARD_COMMAND_BYTES];	/* Command line, truncated and null-terminated. */
+	uint8_t reserved[8];			/* Zero. */
+};
+
+/* The layout is fixed, so any change in size is a mistake. */
+_Static_assert(sizeof(struct JobBoardHeader) == 64, "job board header must be 64 bytes");
+_Static_assert(sizeof(struct JobBoardSlot) == 256, "job board slot must be 256 bytes");
+
+/* Struct storing the shell's side of the board. */
+
+struct JobBoard
+{
+	struct JobBoardHeader* header;		/* Mapping of the board, or NULL if not publishing. */
+	struct JobBoardSlot* slots;		/* First slot of the mapping. */
+	size_t mapSize;				/* Size of the mapping. */
+	char* path;				/* Path of the board, removed when the shell exits. */
+	int nextSlot;				/* Slot at which the search for an unused slot starts. */
+	int numRunning;				/* Number of slots holding running jobs. */
+};
+
+/* Function prototypes (see densmora.jobBoard.c for function descriptions and implementations). */
+void initJobBoard();
+void publishJobStart(struct BackgroundNode* node, struct CommandInfo* myCommand);
+void publishJobExit(struct BackgroundNode* node, int childExitMethod);
+void beginSlotWrite(struct JobBoardSlot* slot);
+void endSlotWrite(struct JobBoardSlot* slot);
+void closeJobBoard();
+struct JobBoardHeader* openJobBoard(char* path, size_t* mapSize);
+int readJobBoardSlot(struct JobBoardHeader* header, int index, struct JobBoardSlot* copy);
+int printJobBoards(int numPaths, char** paths);
+
+#endif
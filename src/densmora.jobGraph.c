@@ -0,0 +1,681 @@
+/***************************************************************************************
+ * File: densmora.jobGraph.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions behind
+ * 		the after built-in. Each job defined with after keeps a copy of its
+ * 		command and a count of the dependencies it is waiting for, and each
+ * 		job (including plain background jobs named by pid) keeps the list of
+ * 		jobs waiting on it. When finishBackgroundNode reaps a job, the graph
+ * 		is told of the exit, every dependent's count drops, and dependents
+ * 		that reach zero are queued; the queue is launched once the reaping
+ * 		pass is over, so the job list is never changed while it is walked.
+ * 		While any job is waiting, the graph holds reaping of background jobs
+ * 		as they exit, so their dependents are launched right away, even while
+ * 		the shell sits at the prompt or runs a foreground command. Names can be used
+ * 		before they are defined, and a definition that would close a cycle
+ * 		is refused.
+ **************************************************************************************/
+
+#include "densmora.jobGraph.h"
+
+
+/***************************************************************************************
+ * Function Name: getJobGraph
+ * Description:	Receives the BackgroundCommands list. Returns its job graph, creating
+ * 		an empty one the first time.
+ **************************************************************************************/
+
+struct JobGraph* getJobGraph(struct BackgroundCommands* bgCommandsList)
+{
+	if (bgCommandsList->jobGraph == NULL)
+	{
+		bgCommandsList->jobGraph = (struct JobGraph*)calloc(1, sizeof(struct JobGraph));
+	}
+	return bgCommandsList->jobGraph;
+}
+
+
+/***************************************************************************************
+ * Function Name: defineGraphJob
+ * Description:	Receives the BackgroundCommands list, the name of a new job (NULL if
+ * 		unnamed), its dependencies (pids of background jobs, or job names,
+ * 		which may not be defined yet) and their number, a flag indicating
+ * 		whether it should be cancelled if a dependency fails, and a copy of
+ * 		its command (which the graph takes over). Adds the job to the graph,
+ * 		queueing it (and launching it) right away if nothing it depends on
+ * 		is still pending. Returns TRUE, or FALSE (after reporting the error
+ * 		and deleting the command) if a dependency is not a job or the name
+ * 		is taken or would close a cycle.
+ **************************************************************************************/
+
+int defineGraphJob(struct BackgroundCommands* bgCommandsList, char* name, char** dependencies, int numDependencies,
+		   int requireSuccess, struct CommandInfo* command)
+{
+	struct JobGraph* graph = getJobGraph(bgCommandsList);
+	struct GraphJob* job = (name != NULL) ? findNamedJob(graph, name) : NULL;
+	int isValid = TRUE;
+
+	/* A name can be given to a job that other jobs are waiting on, or reused once its job is done. */
+	if (job != NULL && job->state != GRAPH_JOB_UNDEFINED && job->state != GRAPH_JOB_DONE)
+	{
+		fprintf(stderr, "after: %s: job is already defined\n", name); fflush(stderr);
+		isValid = FALSE;
+	}
+
+	/* Check every dependency before changing anything. Only a job that others are already waiting on
+	 * can close a cycle, which it does if one of its dependencies is waiting (through others) on it. */
+	for (int i = 0; i < numDependencies && isValid == TRUE; i++)
+	{
+		char* endPtr;
+		long pid = strtol(dependencies[i], &endPtr, 10);
+		if (*endPtr == '\0')
+		{
+			if (pid <= 0 || (findRunningJob(graph, (pid_t)pid) == NULL
+					 && findBackgroundNode(bgCommandsList, (pid_t)pid) == NULL))
+			{
+				fprintf(stderr, "after: pid %s is not a background job of this shell\n", dependencies[i]);
+				fflush(stderr);
+				isValid = FALSE;
+			}
+		}
+		else
+		{
+			struct GraphJob* dependency = findNamedJob(graph, dependencies[i]);
+			if ((name != NULL && strcmp(name, dependencies[i]) == 0)
+			    || (job != NULL && dependency != NULL && isGraphAncestor(graph, job, dependency) == TRUE))
+			{
+				fprintf(stderr, "after: %s: depending on %s would create a cycle\n", name, dependencies[i]);
+				fflush(stderr);
+				isValid = FALSE;
+			}
+		}
+	}
+	if (isValid == FALSE)
+	{
+		deleteCommand(command);
+		return FALSE;
+	}
+
+	/* Define the job, waiting on every dependency that has not finished yet. */
+	if (job == NULL)
+	{
+		job = newGraphJob(graph, name);
+	}
+	job->state = GRAPH_JOB_WAITING;
+	job->pid = 0;
+	job->command = command;
+	job->requireSuccess = requireSuccess;
+	job->numPending = 0;
+	job->dependencyFailed = FALSE;
+	job->cancelled = FALSE;
+	job->exitMethod = 0;
+	graph->numWaiting++;
+	for (int i = 0; i < numDependencies; i++)
+	{
+		struct GraphJob* dependency = findGraphDependency(bgCommandsList, dependencies[i]);
+		if (dependency->state != GRAPH_JOB_DONE)
+		{
+			addDependent(dependency, job);
+			job->numPending++;
+		}
+		else if (dependency->cancelled == TRUE || WIFEXITED(dependency->exitMethod) == 0
+			 || WEXITSTATUS(dependency->exitMethod) != 0)
+		{
+			job->dependencyFailed = TRUE;
+		}
+	}
+
+	/* If nothing is pending, start the job now (or cancel it if a finished dependency failed). */
+	if (job->numPending == 0)
+	{
+		if (job->requireSuccess == TRUE && job->dependencyFailed == TRUE)
+		{
+			finishGraphJob(graph, job, 0, TRUE);
+		}
+		else
+		{
+			queueReadyJob(graph, job);
+		}
+	}
+	launchReadyJobs(bgCommandsList);
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: findGraphDependency
+ * Description:	Receives the BackgroundCommands list and a dependency already checked
+ * 		by defineGraphJob: the pid of a background job or a job name. Returns
+ * 		its job, adding a running job for a background job the graph was not
+ * 		tracking, or an undefined job for a name not seen before.
+ **************************************************************************************/
+
+struct GraphJob* findGraphDependency(struct BackgroundCommands* bgCommandsList, char* dependency)
+{
+	struct JobGraph* graph = bgCommandsList->jobGraph;
+	char* endPtr;
+	long pid = strtol(dependency, &endPtr, 10);
+
+	/* Find or add a job by pid. */
+	if (*endPtr == '\0')
+	{
+		struct GraphJob* job = findRunningJob(graph, (pid_t)pid);
+		if (job == NULL)
+		{
+			job = newGraphJob(graph, NULL);
+			job->state = GRAPH_JOB_RUNNING;
+			job->pid = (pid_t)pid;
+			job->nextByPid = graph->byPid[pid % JOB_GRAPH_BUCKETS];
+			graph->byPid[pid % JOB_GRAPH_BUCKETS] = job;
+		}
+		return job;
+	}
+
+	/* Otherwise, find or add a job by name. */
+	struct GraphJob* job = findNamedJob(graph, dependency);
+	if (job == NULL)
+	{
+		job = newGraphJob(graph, dependency);
+	}
+	return job;
+}
+
+
+/***************************************************************************************
+ * Function Name: findNamedJob
+ * Description:	Receives a JobGraph and a name. Returns the job with that name, or
+ * 		NULL if there is none.
+ **************************************************************************************/
+
+struct GraphJob* findNamedJob(struct JobGraph* graph, char* name)
+{
+	struct GraphJob* job = graph->byName[hashJobName(name) % JOB_GRAPH_BUCKETS];
+	while (job != NULL && strcmp(job->name, name) != 0)
+	{
+		job = job->nextByName;
+	}
+	return job;
+}
+
+
+/***************************************************************************************
+ * Function Name: findRunningJob
+ * Description:	Receives a JobGraph and a pid. Returns the running job in the graph
+ * 		with that pid, or NULL if there is none.
+ **************************************************************************************/
+
+struct GraphJob* findRunningJob(struct JobGraph* graph, pid_t pid)
+{
+	struct GraphJob* job = graph->byPid[pid % JOB_GRAPH_BUCKETS];
+	while (job != NULL && job->pid != pid)
+	{
+		job = job->nextByPid;
+	}
+	return job;
+}
+
+
+/***************************************************************************************
+ * Function Name: newGraphJob
+ * Description:	Receives a JobGraph and a name (or NULL). Allocates an undefined job,
+ * 		adding it to the graph's list of jobs and, if it has a name, to the
+ * 		table of names. Returns the new job.
+ **************************************************************************************/
+
+struct GraphJob* newGraphJob(struct JobGraph* graph, char* name)
+{
+	struct GraphJob* job = (struct GraphJob*)calloc(1, sizeof(struct GraphJob));
+	job->state = GRAPH_JOB_UNDEFINED;
+	job->nextJob = graph->jobs;
+	if (graph->jobs != NULL)
+	{
+		graph->jobs->prevJob = job;
+	}
+	graph->jobs = job;
+	if (name != NULL)
+	{
+		unsigned int bucket = hashJobName(name) % JOB_GRAPH_BUCKETS;
+		job->name = strdup(name);
+		job->nextByName = graph->byName[bucket];
+		graph->byName[bucket] = job;
+	}
+	return job;
+}
+
+
+/***************************************************************************************
+ * Function Name: addDependent
+ * Description:	Receives a job and a job that waits for it to finish. Appends the
+ * 		second to the first's dependents, growing the array as needed.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void addDependent(struct GraphJob* job, struct GraphJob* dependent)
+{
+	if (job->numDependents == job->dependentsCapacity)
+	{
+		job->dependentsCapacity = (job->dependentsCapacity == 0) ? 4 : 2 * job->dependentsCapacity;
+		job->dependents = (struct GraphJob**)realloc(job->dependents, job->dependentsCapacity * sizeof(struct GraphJob*));
+	}
+	job->dependents[job->numDependents++] = dependent;
+}
+
+
+/***************************************************************************************
+ * Function Name: isGraphAncestor
+ * Description:	Receives a JobGraph and two of its jobs. Searches the jobs waiting
+ * 		(directly or through others) on job, visiting each job once, with
+ * 		an explicit stack so that long chains do not exhaust the C stack.
+ * 		Returns TRUE if target is one of them, or FALSE otherwise.
+ **************************************************************************************/
+
+int isGraphAncestor(struct JobGraph* graph, struct GraphJob* job, struct GraphJob* target)
+{
+	int stackCapacity = 64;
+	int stackSize = 0;
+	struct GraphJob** stack = (struct GraphJob**)malloc(stackCapacity * sizeof(struct GraphJob*));
+	int found = FALSE;
+
+	unsigned long mark = ++graph->lastVisitMark;
+	job->visitMark = mark;
+	stack[stackSize++] = job;
+	while (stackSize > 0 && found == FALSE)
+	{
+		struct GraphJob* current = stack[--stackSize];
+		for (int i = 0; i < current->numDependents && found == FALSE; i++)
+		{
+			struct GraphJob* dependent = current->dependents[i];
+			if (dependent == target)
+			{
+				found = TRUE;
+			}
+			else if (dependent->visitMark != mark)
+			{
+				dependent->visitMark = mark;
+				if (stackSize == stackCapacity)
+				{
+					stackCapacity *= 2;
+					stack = (struct GraphJob**)realloc(stack, stackCapacity * sizeof(struct GraphJob*));
+				}
+				stack[stackSize++] = dependent;
+			}
+		}
+	}
+	free(stack);
+	return found;
+}
+
+
+/***************************************************************************************
+ * Function Name: queueReadyJob
+ * Description:	Receives a JobGraph and a job whose dependencies have all finished.
+ * 		Appends it to the queue of jobs to launch. Returns nothing.
+ **************************************************************************************/
+
+void queueReadyJob(struct JobGraph* graph, struct GraphJob* job)
+{
+	job->state = GRAPH_JOB_READY;
+	job->nextQueued = NULL;
+	if (graph->readyTail == NULL)
+	{
+		graph->readyHead = job;
+	}
+	else
+	{
+		graph->readyTail->nextQueued = job;
+	}
+	graph->readyTail = job;
+}
+
+
+/***************************************************************************************
+ * Function Name: recordJobExit
+ * Description:	Called by finishBackgroundNode for every background job it reaps.
+ * 		Receives the JobGraph, the job's pid, and its exit method. If the
+ * 		graph tracks the job, finishes it (queueing the dependents that are
+ * 		now ready, but launching nothing). Returns nothing.
+ **************************************************************************************/
+
+void recordJobExit(struct JobGraph* graph, pid_t pid, int childExitMethod)
+{
+	struct GraphJob* job = findRunningJob(graph, pid);
+	if (job != NULL)
+	{
+		finishGraphJob(graph, job, childExitMethod, FALSE);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: finishGraphJob
+ * Description:	Receives a JobGraph, a job that has finished (or is being cancelled),
+ * 		its exit method, and a flag indicating whether it was cancelled.
+ * 		Marks it done and tells each of its dependents, queueing those with
+ * 		nothing left pending and cancelling those that required success from
+ * 		a job that failed (which in turn finishes their own dependents,
+ * 		through a queue rather than recursion). Done jobs without a name are
+ * 		freed. Returns nothing.
+ **************************************************************************************/
+
+void finishGraphJob(struct JobGraph* graph, struct GraphJob* job, int childExitMethod, int cancelled)
+{
+	struct GraphJob* doneHead = job;
+	struct GraphJob* doneTail = job;
+
+	job->exitMethod = childExitMethod;
+	job->cancelled = cancelled;
+	job->nextQueued = NULL;
+	while (doneHead != NULL)
+	{
+		struct GraphJob* doneJob = doneHead;
+		doneHead = doneHead->nextQueued;
+
+		/* Mark the job done, reporting it if it was cancelled. */
+		if (doneJob->state == GRAPH_JOB_WAITING)
+		{
+			graph->numWaiting--;
+		}
+		if (doneJob->state == GRAPH_JOB_RUNNING)
+		{
+			removeRunningJob(graph, doneJob);
+		}
+		doneJob->state = GRAPH_JOB_DONE;
+		if (doneJob->cancelled == TRUE)
+		{
+			fprintf(shellOutput, "after: %s cancelled: a job it depends on failed\n", describeGraphJob(doneJob)); fflush(shellOutput);
+		}
+		int failed = (doneJob->cancelled == TRUE || WIFEXITED(doneJob->exitMethod) == 0
+			      || WEXITSTATUS(doneJob->exitMethod) != 0) ? TRUE : FALSE;
+
+		/* Tell each dependent, queueing or cancelling those with nothing left pending. */
+		for (int i = 0; i < doneJob->numDependents; i++)
+		{
+			struct GraphJob* dependent = doneJob->dependents[i];
+			dependent->numPending--;
+			if (failed == TRUE)
+			{
+				dependent->dependencyFailed = TRUE;
+			}
+			if (dependent->numPending > 0)
+			{
+				continue;
+			}
+			if (dependent->requireSuccess == TRUE && dependent->dependencyFailed == TRUE)
+			{
+				dependent->cancelled = TRUE;
+				dependent->exitMethod = 0;
+				dependent->nextQueued = NULL;
+				if (doneHead == NULL)
+				{
+					doneHead = dependent;
+				}
+				else
+				{
+					doneTail->nextQueued = dependent;
+				}
+				doneTail = dependent;
+			}
+			else
+			{
+				queueReadyJob(graph, dependent);
+			}
+		}
+
+		/* Nothing waits on the job any longer, so keep it only if later jobs can refer to it by name. */
+		free(doneJob->dependents);
+		doneJob->dependents = NULL;
+		doneJob->numDependents = 0;
+		doneJob->dependentsCapacity = 0;
+		if (doneJob->command != NULL)
+		{
+			deleteCommand(doneJob->command);
+			doneJob->command = NULL;
+		}
+		if (doneJob->name == NULL)
+		{
+			freeGraphJob(graph, doneJob);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: launchReadyJobs
+ * Description:	Receives the BackgroundCommands list. Launches every queued job of
+ * 		its graph in the background (reporting its pid like any background
+ * 		command), finishing as failed any that cannot be launched. Jobs that
+ * 		nothing waits on and that have no name are no longer tracked once
+ * 		launched. Then starts or stops watching for exits as needed. Called
+ * 		once a reaping pass is over, since launching changes the job list.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void launchReadyJobs(struct BackgroundCommands* bgCommandsList)
+{
+	struct JobGraph* graph = bgCommandsList->jobGraph;
+	if (graph == NULL)
+	{
+		return;
+	}
+
+	while (graph->readyHead != NULL)
+	{
+		struct GraphJob* job = graph->readyHead;
+		graph->readyHead = job->nextQueued;
+		if (graph->readyHead == NULL)
+		{
+			graph->readyTail = NULL;
+		}
+		graph->numWaiting--;
+
+		/* Launch the job, treating a failed launch like a job that exited with status 1. */
+		struct BackgroundNode* newNode = launchBackground(job->command, bgCommandsList);
+		job->state = GRAPH_JOB_RUNNING;
+		if (newNode == NULL)
+		{
+			finishGraphJob(graph, job, 1 << 8, FALSE);
+			continue;
+		}
+		fprintf(shellOutput, "background pid is %d\n", (int)newNode->pid); fflush(shellOutput);
+		deleteCommand(job->command);
+		job->command = NULL;
+		job->pid = newNode->pid;
+
+		/* Track the job until it exits only if something refers to it. */
+		if (job->name == NULL && job->numDependents == 0)
+		{
+			freeGraphJob(graph, job);
+		}
+		else
+		{
+			job->nextByPid = graph->byPid[job->pid % JOB_GRAPH_BUCKETS];
+			graph->byPid[job->pid % JOB_GRAPH_BUCKETS] = job;
+		}
+	}
+	updateGraphWatcher(bgCommandsList);
+}
+
+
+/***************************************************************************************
+ * Function Name: updateGraphWatcher
+ * Description:	Receives the BackgroundCommands list. Holds reaping of background
+ * 		jobs as they exit (see holdBackgroundReaping) while jobs of its graph
+ * 		are waiting, and releases it once none are. Returns nothing.
+ **************************************************************************************/
+
+void updateGraphWatcher(struct BackgroundCommands* bgCommandsList)
+{
+	struct JobGraph* graph = bgCommandsList->jobGraph;
+
+	if (graph->numWaiting > 0 && graph->holdsReaping == FALSE)
+	{
+		holdBackgroundReaping(bgCommandsList);
+		graph->holdsReaping = TRUE;
+	}
+	else if (graph->numWaiting == 0 && graph->holdsReaping == TRUE)
+	{
+		releaseBackgroundReaping(bgCommandsList);
+		graph->holdsReaping = FALSE;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: removeRunningJob
+ * Description:	Receives a JobGraph and one of its running jobs. Removes the job
+ * 		from the table of pids (if it is there). Returns nothing.
+ **************************************************************************************/
+
+void removeRunningJob(struct JobGraph* graph, struct GraphJob* job)
+{
+	struct GraphJob** link = &graph->byPid[job->pid % JOB_GRAPH_BUCKETS];
+	while (*link != NULL && *link != job)
+	{
+		link = &(*link)->nextByPid;
+	}
+	if (*link != NULL)
+	{
+		*link = job->nextByPid;
+	}
+	job->nextByPid = NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: freeGraphJob
+ * Description:	Receives a JobGraph and one of its jobs that has no name and is in no
+ * 		table or queue. Removes it from the list of jobs and frees it.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void freeGraphJob(struct JobGraph* graph, struct GraphJob* job)
+{
+	if (job->prevJob != NULL)
+	{
+		job->prevJob->nextJob = job->nextJob;
+	}
+	else
+	{
+		graph->jobs = job->nextJob;
+	}
+	if (job->nextJob != NULL)
+	{
+		job->nextJob->prevJob = job->prevJob;
+	}
+	free(job->dependents);
+	free(job);
+}
+
+
+/***************************************************************************************
+ * Function Name: describeGraphJob
+ * Description:	Receives a job. Returns a string naming it in messages: its name, or
+ * 		otherwise its command (or "job" if it has neither).
+ **************************************************************************************/
+
+char* describeGraphJob(struct GraphJob* job)
+{
+	if (job->name != NULL)
+	{
+		return job->name;
+	}
+	return (job->command != NULL) ? job->command->commandArgs[0] : "job";
+}
+
+
+/***************************************************************************************
+ * Function Name: printJobGraph
+ * Description:	Receives a JobGraph (or NULL). Prints each job that is waiting or has
+ * 		a name, with its state. Returns nothing.
+ **************************************************************************************/
+
+void printJobGraph(struct JobGraph* graph)
+{
+	for (struct GraphJob* job = (graph != NULL) ? graph->jobs : NULL; job != NULL; job = job->nextJob)
+	{
+		char* label = describeGraphJob(job);
+		switch (job->state)
+		{
+			case GRAPH_JOB_UNDEFINED:
+				printf("%s: not defined (%d waiting on it)\n", label, job->numDependents);
+				break;
+			case GRAPH_JOB_WAITING:
+			case GRAPH_JOB_READY:
+				printf("%s: waiting for %d job%s\n", label, job->numPending, (job->numPending == 1) ? "" : "s");
+				break;
+			case GRAPH_JOB_RUNNING:
+				if (job->name != NULL)
+				{
+					printf("%s: running as pid %d\n", label, (int)job->pid);
+				}
+				break;
+			default:
+				if (job->cancelled == TRUE)
+				{
+					printf("%s: cancelled\n", label);
+				}
+				else if (WIFEXITED(job->exitMethod) != 0)
+				{
+					printf("%s: done: exit value %d\n", label, WEXITSTATUS(job->exitMethod));
+				}
+				else
+				{
+					printf("%s: done: terminated by signal %d\n", label, WTERMSIG(job->exitMethod));
+				}
+		}
+	}
+	fflush(stdout);
+}
+
+
+/***************************************************************************************
+ * Function Name: deleteJobGraph
+ * Description:	Receives the BackgroundCommands list. Stops watching for exits and
+ * 		frees its graph (if any), so that jobs still waiting are never
+ * 		launched. Called as the shell exits, before its jobs are stopped.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void deleteJobGraph(struct BackgroundCommands* bgCommandsList)
+{
+	struct JobGraph* graph = bgCommandsList->jobGraph;
+	if (graph == NULL)
+	{
+		return;
+	}
+	if (graph->holdsReaping == TRUE)
+	{
+		releaseBackgroundReaping(bgCommandsList);
+	}
+	while (graph->jobs != NULL)
+	{
+		struct GraphJob* job = graph->jobs;
+		graph->jobs = job->nextJob;
+		if (job->command != NULL)
+		{
+			deleteCommand(job->command);
+		}
+		free(job->name);
+		free(job->dependents);
+		free(job);
+	}
+	free(graph);
+	bgCommandsList->jobGraph = NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: hashJobName
+ * Description:	Receives a job name. Returns its djb2 hash.
+ **************************************************************************************/
+
+unsigned int hashJobName(char* name)
+{
+	unsigned int hash = 5381;
+	for (unsigned char* c = (unsigned char*)name; *c != '\0'; c++)
+	{
+		hash = hash * 33 + *c;
+	}
+	return hash;
+}
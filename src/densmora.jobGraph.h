@@ -0,0 +1,95 @@
+/***************************************************************************************
+ * File: densmora.jobGraph.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions behind the after built-in, which defines background
+ * 		jobs that are launched once the jobs they depend on (given by pid or
+ * 		by name) have finished. See densmora.jobGraph.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_JOB_GRAPH
+#define DENSMORA_JOB_GRAPH
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+
+/* Number of buckets in each of the graph's hash tables (of names and of pids). */
+#define JOB_GRAPH_BUCKETS 1024
+
+/* States of a job in the graph. */
+#define GRAPH_JOB_UNDEFINED 0		/* Named as a dependency, but not yet defined. */
+#define GRAPH_JOB_WAITING 1		/* Defined, and waiting for its dependencies. */
+#define GRAPH_JOB_READY 2		/* Dependencies finished, and queued to be launched. */
+#define GRAPH_JOB_RUNNING 3		/* Running in the background. */
+#define GRAPH_JOB_DONE 4		/* Finished (or cancelled). */
+
+/* Struct storing a job of the dependency graph. Jobs refer only to the jobs waiting on
+ * them (their dependents), so a job can be freed as soon as it is done unless it has a
+ * name that later jobs may refer to. */
+
+struct GraphJob
+{
+	char* name;				/* Name given with -n (NULL if none). */
+	int state;				/* One of the GRAPH_JOB states. */
+	pid_t pid;				/* Pid of the job once it is running (0 before). */
+	struct CommandInfo* command;		/* Copy of the command to launch (NULL for jobs started elsewhere). */
+	int requireSuccess;			/* Set to TRUE (-s) if it is cancelled when a dependency fails. */
+	int numPending;				/* Number of dependencies that have not finished. */
+	int dependencyFailed;			/* Set to TRUE once a dependency has failed or been cancelled. */
+	int exitMethod;				/* Exit method once done. */
+	int cancelled;				/* Set to TRUE if it was cancelled instead of run. */
+	struct GraphJob** dependents;		/* Jobs waiting for this one to finish. */
+	int numDependents;			/* Number of elements in dependents. */
+	int dependentsCapacity;			/* Number of elements allocated for dependents. */
+	unsigned long visitMark;		/* Search in which the job was last visited (for cycle detection). */
+	struct GraphJob* nextByName;		/* Next job in the same bucket of names. */
+	struct GraphJob* nextByPid;		/* Next job in the same bucket of pids. */
+	struct GraphJob* nextQueued;		/* Next job in the ready or done queue. */
+	struct GraphJob* prevJob;		/* Previous job in the graph's list of every job. */
+	struct GraphJob* nextJob;		/* Next job in that list. */
+};
+
+/* Struct storing the graph of jobs waiting on other jobs. */
+
+struct JobGraph
+{
+	struct GraphJob* jobs;			/* Every job in the graph, newest first. */
+	struct GraphJob* byName[JOB_GRAPH_BUCKETS];	/* Named jobs, by hash of name. */
+	struct GraphJob* byPid[JOB_GRAPH_BUCKETS];	/* Running jobs that have dependents or a name, by pid. */
+	struct GraphJob* readyHead;		/* Jobs queued to be launched, oldest first. */
+	struct GraphJob* readyTail;		/* Last job in that queue. */
+	int numWaiting;				/* Number of defined jobs not yet launched. */
+	unsigned long lastVisitMark;		/* Mark of the latest search of the graph. */
+	int holdsReaping;			/* Set to TRUE while jobs are waiting (see holdBackgroundReaping). */
+};
+
+/* Function prototypes (see densmora.jobGraph.c for function descriptions and implementations). */
+struct JobGraph* getJobGraph(struct BackgroundCommands* bgCommandsList);
+int defineGraphJob(struct BackgroundCommands* bgCommandsList, char* name, char** dependencies, int numDependencies,
+		   int requireSuccess, struct CommandInfo* command);
+struct GraphJob* findGraphDependency(struct BackgroundCommands* bgCommandsList, char* dependency);
+struct GraphJob* findNamedJob(struct JobGraph* graph, char* name);
+struct GraphJob* findRunningJob(struct JobGraph* graph, pid_t pid);
+struct GraphJob* newGraphJob(struct JobGraph* graph, char* name);
+void addDependent(struct GraphJob* job, struct GraphJob* dependent);
+int isGraphAncestor(struct JobGraph* graph, struct GraphJob* job, struct GraphJob* target);
+void queueReadyJob(struct JobGraph* graph, struct GraphJob* job);
+void recordJobExit(struct JobGraph* graph, pid_t pid, int childExitMethod);
+void finishGraphJob(struct JobGraph* graph, struct GraphJob* job, int childExitMethod, int cancelled);
+void launchReadyJobs(struct BackgroundCommands* bgCommandsList);
+void updateGraphWatcher(struct BackgroundCommands* bgCommandsList);
+void removeRunningJob(struct JobGraph* graph, struct GraphJob* job);
+void freeGraphJob(struct JobGraph* graph, struct GraphJob* job);
+char* describeGraphJob(struct GraphJob* job);
+void printJobGraph(struct JobGraph* graph);
+void deleteJobGraph(struct BackgroundCommands* bgCommandsList);
+unsigned int hashJobName(char* name);
+
+#endif
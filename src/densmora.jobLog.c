@@ -0,0 +1,414 @@
+/***************************************************************************************
+ * File: densmora.jobLog.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of functions that capture
+ * 		the output of background jobs in memory. When SMALLSH_JOBLOG_KB is
+ * 		set, each background job's stdout (unless redirected) and stderr go
+ * 		to a pipe that the event loop drains into a ring buffer holding the
+ * 		job's last SMALLSH_JOBLOG_KB KiB of output. All buffers share the
+ * 		budget given by SMALLSH_JOBLOG_BUDGET_KB, and the output of a finished
+ * 		job is kept for SMALLSH_JOBLOG_RETAIN seconds (or until its memory is
+ * 		needed for a new job) so that it can be read with the joblog built-in.
+ **************************************************************************************/
+
+#include "densmora.jobLog.h"
+
+/* Captured jobs (oldest first) and the limits read from the environment. */
+static struct JobLog* jobLogs = NULL;
+static int jobLogBytes = 0;
+static long jobLogBudgetBytes = 0;
+static long jobLogUsedBytes = 0;
+static long jobLogRetainUsec = 0;
+
+
+/***************************************************************************************
+ * Function Name: initJobLogs
+ * Description:	Reads the capture settings from the environment. If
+ * 		SMALLSH_JOBLOG_KB is not set to a positive number, capture stays
+ * 		disabled and background output goes to /dev/null as before.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void initJobLogs()
+{
+	char* perJobKb = getenv("SMALLSH_JOBLOG_KB");
+	char* budgetKb = getenv("SMALLSH_JOBLOG_BUDGET_KB");
+	char* retainSeconds = getenv("SMALLSH_JOBLOG_RETAIN");
+
+	/* Leave capture disabled unless a buffer size was given. */
+	if (perJobKb == NULL || atoi(perJobKb) <= 0)
+	{
+		return;
+	}
+	jobLogBytes = atoi(perJobKb) * 1024;
+
+	/* Use the default budget and retention period unless others were given. */
+	jobLogBudgetBytes = (long)DEFAULT_JOBLOG_BUDGET_KB * 1024;
+	if (budgetKb != NULL && atol(budgetKb) > 0)
+	{
+		jobLogBudgetBytes = atol(budgetKb) * 1024;
+	}
+	jobLogRetainUsec = (long)DEFAULT_JOBLOG_RETAIN_SECONDS * 1000000L;
+	if (retainSeconds != NULL && atol(retainSeconds) >= 0 && retainSeconds[0] != '\0')
+	{
+		jobLogRetainUsec = atol(retainSeconds) * 1000000L;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: openJobLog
+ * Description:	Called before a background job is forked. Receives the name of the
+ * 		command it runs. If capture is enabled, makes room in the budget (by
+ * 		freeing the output of the oldest finished jobs if needed), then
+ * 		creates the capture pipe and ring buffer. Returns the new JobLog, whose
+ * 		writeFd the child should use for its output, or NULL if capture is
+ * 		disabled or no memory is left in the budget.
+ **************************************************************************************/
+
+struct JobLog* openJobLog(char* command)
+{
+	int pipeFds[2];
+
+	/* Return if capture is disabled. */
+	if (jobLogBytes == 0)
+	{
+		return NULL;
+	}
+
+	/* Free the output of finished jobs, oldest first, until the new buffer fits in the budget. */
+	while (jobLogUsedBytes + jobLogBytes > jobLogBudgetBytes)
+	{
+		if (evictFinishedJobLog() == FALSE)
+		{
+			fprintf(stderr, "joblog: capture budget exhausted, output of %s will be discarded\n", command);
+			fflush(stderr);
+			return NULL;
+		}
+	}
+
+	/* Create the pipe. Both ends are close-on-exec (dup2 clears the flag on the child's copy), and only
+	 * the shell's read end is non-blocking, so a job that outpaces the shell blocks rather than failing. */
+	if (pipe2(pipeFds, O_CLOEXEC) == -1)
+	{
+		perror("pipe2()"); fflush(stderr);
+		return NULL;
+	}
+	fcntl(pipeFds[0], F_SETFL, O_NONBLOCK);
+
+	/* Declare and allocate memory for new JobLog, and add it to the end of the list. */
+	struct JobLog* jobLog;
+	jobLog = (struct JobLog*)malloc(sizeof(struct JobLog));
+	memset(jobLog, 0, sizeof(struct JobLog));
+	snprintf(jobLog->command, JOBLOG_COMMAND_CHARS, "%s", command);
+	jobLog->buffer = (char*)malloc(jobLogBytes);
+	jobLog->bufferSize = jobLogBytes;
+	jobLog->pipeFd = pipeFds[0];
+	jobLog->writeFd = pipeFds[1];
+	jobLogUsedBytes += jobLogBytes;
+
+	struct JobLog** lastNext = &jobLogs;
+	while (*lastNext != NULL)
+	{
+		lastNext = &(*lastNext)->next;
+	}
+	*lastNext = jobLog;
+
+	return jobLog;
+}
+
+
+/***************************************************************************************
+ * Function Name: attachJobLog
+ * Description:	Called in the shell after a background job has been forked. Receives
+ * 		the job's JobLog and pid. Closes the shell's copy of the write end
+ * 		(so that the pipe reaches EOF once the job and its children exit),
+ * 		frees any kept output of an earlier job with the same pid, and starts
+ * 		draining the pipe from the event loop. Returns nothing.
+ **************************************************************************************/
+
+void attachJobLog(struct JobLog* jobLog, pid_t pid)
+{
+	close(jobLog->writeFd);
+	jobLog->writeFd = -1;
+
+	/* A recycled pid must name only the new job. */
+	struct JobLog* earlierLog;
+	while ((earlierLog = findJobLog(pid)) != NULL)
+	{
+		freeJobLog(earlierLog);
+	}
+
+	jobLog->pid = pid;
+	jobLog->watcher = addEventWatcher(jobLog->pipeFd, readJobLog, jobLog);
+}
+
+
+/***************************************************************************************
+ * Function Name: discardJobLog
+ * Description:	Receives a JobLog whose job could not be forked, and frees it.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void discardJobLog(struct JobLog* jobLog)
+{
+	freeJobLog(jobLog);
+}
+
+
+/***************************************************************************************
+ * Function Name: finishJobLog
+ * Description:	Called when a background job is reaped. Receives its pid. If its
+ * 		output is being captured, marks it finished and starts the timer after
+ * 		which it is freed. Output still in the pipe keeps being drained.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void finishJobLog(pid_t pid)
+{
+	struct JobLog* jobLog = findJobLog(pid);
+	if (jobLog == NULL || jobLog->finished == TRUE)
+	{
+		return;
+	}
+	jobLog->finished = TRUE;
+	jobLog->expiryTimer = addTimer(jobLogRetainUsec, expireJobLog, jobLog);
+}
+
+
+/***************************************************************************************
+ * Function Name: findJobLog
+ * Description:	Receives a pid. Returns the JobLog capturing that job's output, or
+ * 		NULL if there is none.
+ **************************************************************************************/
+
+struct JobLog* findJobLog(pid_t pid)
+{
+	struct JobLog* currentLog = jobLogs;
+	while (currentLog != NULL && currentLog->pid != pid)
+	{
+		currentLog = currentLog->next;
+	}
+	return currentLog;
+}
+
+
+/***************************************************************************************
+ * Function Name: readJobLog
+ * Description:	Event loop callback for a capture pipe. Receives the read end and the
+ * 		JobLog. Appends everything that can be read without blocking to the
+ * 		ring buffer, closing the pipe once every writer has exited.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void readJobLog(int fd, void* arg)
+{
+	struct JobLog* jobLog = (struct JobLog*)arg;
+	char chunk[JOBLOG_READ_BYTES];
+	ssize_t bytesRead;
+
+	while (TRUE)
+	{
+		bytesRead = read(fd, chunk, JOBLOG_READ_BYTES);
+		if (bytesRead > 0)
+		{
+			appendJobLog(jobLog, chunk, (int)bytesRead);
+		}
+
+		/* On EOF, stop watching and close the pipe. */
+		else if (bytesRead == 0)
+		{
+			if (jobLog->watcher != NULL)
+			{
+				removeEventWatcher(jobLog->watcher);
+				jobLog->watcher = NULL;
+			}
+			close(jobLog->pipeFd);
+			jobLog->pipeFd = -1;
+			return;
+		}
+
+		/* Otherwise, stop once the pipe is empty (retrying reads interrupted by a signal). */
+		else if (errno != EINTR)
+		{
+			return;
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: appendJobLog
+ * Description:	Receives a JobLog and length bytes of output. Copies the output into
+ * 		the ring buffer, overwriting the oldest bytes once it is full.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void appendJobLog(struct JobLog* jobLog, char* data, int length)
+{
+	/* Only the last bufferSize bytes of a large chunk can be kept. */
+	if (length > jobLog->bufferSize)
+	{
+		jobLog->totalBytes += length - jobLog->bufferSize;
+		data += length - jobLog->bufferSize;
+		length = jobLog->bufferSize;
+	}
+
+	/* Copy the chunk in at most two pieces, wrapping around the end of the buffer. */
+	int position = (int)(jobLog->totalBytes % jobLog->bufferSize);
+	int firstPiece = jobLog->bufferSize - position;
+	if (firstPiece > length)
+	{
+		firstPiece = length;
+	}
+	memcpy(jobLog->buffer + position, data, firstPiece);
+	memcpy(jobLog->buffer, data + firstPiece, length - firstPiece);
+	jobLog->totalBytes += length;
+}
+
+
+/***************************************************************************************
+ * Function Name: printJobLog
+ * Description:	Receives a JobLog. Drains its pipe so that everything written so far
+ * 		is included, then writes the captured output to stdout, oldest byte
+ * 		first, noting on stderr how much earlier output was dropped.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void printJobLog(struct JobLog* jobLog)
+{
+	if (jobLog->pipeFd != -1)
+	{
+		readJobLog(jobLog->pipeFd, jobLog);
+	}
+
+	/* If the ring has wrapped, the oldest kept byte is the one after the newest. */
+	if (jobLog->totalBytes > (unsigned long)jobLog->bufferSize)
+	{
+		int position = (int)(jobLog->totalBytes % jobLog->bufferSize);
+		fprintf(stderr, "joblog: %lu earlier bytes of output from pid %d were dropped\n",
+			jobLog->totalBytes - jobLog->bufferSize, (int)jobLog->pid);
+		fflush(stderr);
+		fwrite(jobLog->buffer + position, 1, jobLog->bufferSize - position, stdout);
+		fwrite(jobLog->buffer, 1, position, stdout);
+	}
+	else
+	{
+		fwrite(jobLog->buffer, 1, jobLog->totalBytes, stdout);
+	}
+	fflush(stdout);
+}
+
+
+/***************************************************************************************
+ * Function Name: listJobLogs
+ * Description:	Prints one line per captured job giving its pid, whether it is still
+ * 		running, how many bytes it has written, and its command.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void listJobLogs()
+{
+	for (struct JobLog* currentLog = jobLogs; currentLog != NULL; currentLog = currentLog->next)
+	{
+		if (currentLog->pid != 0)
+		{
+			printf("%d %s %lu bytes %s\n", (int)currentLog->pid,
+			       (currentLog->finished == TRUE) ? "done" : "running", currentLog->totalBytes, currentLog->command);
+		}
+	}
+	fflush(stdout);
+}
+
+
+/***************************************************************************************
+ * Function Name: expireJobLog
+ * Description:	Timer callback for the end of a finished job's retention period.
+ * 		Receives the JobLog and frees it. Returns nothing.
+ **************************************************************************************/
+
+void expireJobLog(void* arg)
+{
+	struct JobLog* jobLog = (struct JobLog*)arg;
+
+	/* The timer is freed by the timer heap once this returns. */
+	jobLog->expiryTimer = NULL;
+	freeJobLog(jobLog);
+}
+
+
+/***************************************************************************************
+ * Function Name: evictFinishedJobLog
+ * Description:	Frees the output of the job that finished longest ago (the first
+ * 		finished log in the list). Receives nothing. Returns TRUE if a log was
+ * 		freed, or FALSE if every captured job is still running.
+ **************************************************************************************/
+
+int evictFinishedJobLog()
+{
+	for (struct JobLog* currentLog = jobLogs; currentLog != NULL; currentLog = currentLog->next)
+	{
+		if (currentLog->finished == TRUE)
+		{
+			freeJobLog(currentLog);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: freeJobLog
+ * Description:	Receives a JobLog. Removes it from the list, cancels its expiry timer,
+ * 		closes its pipe, returns its buffer to the budget, and frees it.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void freeJobLog(struct JobLog* jobLog)
+{
+	/* Remove the log from the list. */
+	struct JobLog** link = &jobLogs;
+	while (*link != jobLog)
+	{
+		link = &(*link)->next;
+	}
+	*link = jobLog->next;
+
+	/* Release everything the log holds. */
+	if (jobLog->expiryTimer != NULL)
+	{
+		cancelTimer(jobLog->expiryTimer);
+	}
+	if (jobLog->watcher != NULL)
+	{
+		removeEventWatcher(jobLog->watcher);
+	}
+	if (jobLog->pipeFd != -1)
+	{
+		close(jobLog->pipeFd);
+	}
+	if (jobLog->writeFd != -1)
+	{
+		close(jobLog->writeFd);
+	}
+	jobLogUsedBytes -= jobLog->bufferSize;
+	free(jobLog->buffer);
+	free(jobLog);
+}
+
+
+/***************************************************************************************
+ * Function Name: closeJobLogs
+ * Description:	Frees every captured job's output. Called when the shell exits.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void closeJobLogs()
+{
+	while (jobLogs != NULL)
+	{
+		freeJobLog(jobLogs);
+	}
+}
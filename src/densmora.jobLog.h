@@ -0,0 +1,71 @@
+/***************************************************************************************
+ * File: densmora.jobLog.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definition of the JobLog struct and
+ * 		prototypes of the functions that capture the output of background
+ * 		jobs into per-job in-memory ring buffers (enabled through
+ * 		SMALLSH_JOBLOG_KB). See densmora.jobLog.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_JOB_LOG
+#define DENSMORA_JOB_LOG
+
+/* Built-in header file inclusions. */
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/* My own header file inclusions. */
+#include "densmora.smallshConstants.h"
+#include "densmora.eventLoop.h"
+#include "densmora.timers.h"
+
+/* Default shell-wide memory budget (in KiB) for all capture buffers. */
+#define DEFAULT_JOBLOG_BUDGET_KB 4096
+
+/* Default number of seconds the output of a finished job is kept. */
+#define DEFAULT_JOBLOG_RETAIN_SECONDS 600
+
+/* Size of the chunks read from capture pipes. */
+#define JOBLOG_READ_BYTES 4096
+
+/* Maximum number of chars of the command name stored with a capture buffer. */
+#define JOBLOG_COMMAND_CHARS 64
+
+/* Struct storing the captured output of one background job. Only the last bufferSize
+ * bytes are kept: buffer is a ring, and totalBytes counts everything the job wrote. */
+
+struct JobLog
+{
+	pid_t pid;				/* Pid of the job (0 until it has been forked). */
+	char command[JOBLOG_COMMAND_CHARS];	/* Name of the command the job runs. */
+	char* buffer;				/* Ring holding the last bufferSize bytes of output. */
+	int bufferSize;				/* Number of bytes allocated to buffer. */
+	unsigned long totalBytes;		/* Number of bytes the job has written. */
+	int pipeFd;				/* Read end of the capture pipe, or -1 once closed. */
+	int writeFd;				/* Write end of the capture pipe, open only until the fork. */
+	struct EventWatcher* watcher;		/* Event loop watcher of pipeFd. */
+	int finished;				/* Set to TRUE once the job has been reaped. */
+	struct Timer* expiryTimer;		/* Timer that frees the log once it has been kept long enough. */
+	struct JobLog* next;			/* Address of next log in list (oldest first). */
+};
+
+/* Function prototypes (see densmora.jobLog.c for function descriptions and implementations). */
+void initJobLogs();
+struct JobLog* openJobLog(char* command);
+void attachJobLog(struct JobLog* jobLog, pid_t pid);
+void discardJobLog(struct JobLog* jobLog);
+void finishJobLog(pid_t pid);
+struct JobLog* findJobLog(pid_t pid);
+void readJobLog(int fd, void* arg);
+void appendJobLog(struct JobLog* jobLog, char* data, int length);
+void printJobLog(struct JobLog* jobLog);
+void listJobLogs();
+void expireJobLog(void* arg);
+int evictFinishedJobLog();
+void freeJobLog(struct JobLog* jobLog);
+void closeJobLogs();
+
+#endif
@@ -0,0 +1,426 @@
+/***************************************************************************************
+ * File: densmora.jobserver.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		take part in the GNU make jobserver protocol. A pool is a fifo or pipe
+ * 		holding one byte (token) per job slot beyond the one each user holds
+ * 		without a token; a user takes a token before running an extra job and
+ * 		writes the same byte back once the job is done. If MAKEFLAGS names a
+ * 		pool (the shell was run by a make), the shell uses it as a client.
+ * 		Otherwise, if SMALLSH_JOBSERVER is set, the shell creates a pool and
+ * 		names it in MAKEFLAGS, so every make the shell runs (without -j of
+ * 		its own) shares it. Either way, each background job launched by
+ * 		runBackground holds a token while it runs, and a launch that finds
+ * 		the pool empty waits in the admission controller's queue until a
+ * 		token comes back (see densmora.admission.c).
+ **************************************************************************************/
+
+#include "densmora.jobserver.h"
+
+/* The shell's side of the jobserver, shared by every function in this file. It is global
+ * (rather than passed around like the other structs in smallsh) since tokens are taken and
+ * given back wherever jobs are launched and reaped. */
+static struct Jobserver jobserver = { JOBSERVER_NONE, -1, -1, FALSE, { -1, -1 }, NULL, NULL, -1, NULL };
+
+
+/***************************************************************************************
+ * Function Name: initJobserver
+ * Description:	Joins the pool named in MAKEFLAGS, if any. Otherwise, creates a pool
+ * 		if SMALLSH_JOBSERVER is set: to that number of job slots, or one per
+ * 		cpu if it is 0 (at least MIN_JOBSERVER_SLOTS either way), as an
+ * 		inherited pipe (understood by every make with a jobserver) or, if
+ * 		SMALLSH_JOBSERVER_STYLE is "fifo", as a named fifo (understood by
+ * 		make 4.4 and later, and reachable by commands that close inherited
+ * 		descriptors).
+ * 		Called at startup, after the environment is loaded. Receives and
+ * 		returns nothing.
+ **************************************************************************************/
+
+void initJobserver()
+{
+	char* makeflags = getEnvVar("MAKEFLAGS");
+	char* slotsString = getenv("SMALLSH_JOBSERVER");
+
+	if (makeflags != NULL && joinJobserver(makeflags) == TRUE)
+	{
+		if (slotsString != NULL && slotsString[0] != '\0')
+		{
+			fprintf(stderr, "SMALLSH_JOBSERVER: using the jobserver in MAKEFLAGS instead\n"); fflush(stderr);
+		}
+		return;
+	}
+	if (slotsString != NULL && slotsString[0] != '\0')
+	{
+		createJobserver(slotsString, getenv("SMALLSH_JOBSERVER_STYLE"));
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: joinJobserver
+ * Description:	Receives the value of MAKEFLAGS. If it names a pool with
+ * 		--jobserver-auth=fifo:PATH or --jobserver-auth=R,W (or the older
+ * 		--jobserver-fds=R,W), opens it for the shell's own non-blocking use.
+ * 		Returns TRUE if the shell is now a client, or FALSE if MAKEFLAGS
+ * 		names no pool or one the shell cannot reach (after reporting it).
+ **************************************************************************************/
+
+int joinJobserver(char* makeflags)
+{
+	/* Find the last pool named (later options override earlier ones), ignoring the older
+	 * option if the newer one is present. */
+	char* option = NULL;
+	for (char* found = strstr(makeflags, "--jobserver-auth="); found != NULL;
+	     found = strstr(found + 1, "--jobserver-auth="))
+	{
+		option = found + strlen("--jobserver-auth=");
+	}
+	if (option == NULL)
+	{
+		for (char* found = strstr(makeflags, "--jobserver-fds="); found != NULL;
+		     found = strstr(found + 1, "--jobserver-fds="))
+		{
+			option = found + strlen("--jobserver-fds=");
+		}
+	}
+	if (option == NULL)
+	{
+		return FALSE;
+	}
+	char value[PATH_MAX];
+	int length = strcspn(option, " \t");
+	if (length >= PATH_MAX)
+	{
+		return FALSE;
+	}
+	memcpy(value, option, length);
+	value[length] = '\0';
+
+	/* Open a fifo by name, for both taking and giving back tokens. */
+	if (strncmp(value, "fifo:", strlen("fifo:")) == 0)
+	{
+		jobserver.readFd = raiseShellFd(open(value + strlen("fifo:"), O_RDWR | O_NONBLOCK | O_CLOEXEC));
+		if (jobserver.readFd == -1)
+		{
+			fprintf(stderr, "MAKEFLAGS: cannot open jobserver %s: %s\n", value + strlen("fifo:"), strerror(errno));
+			fflush(stderr);
+			return FALSE;
+		}
+		jobserver.writeFd = jobserver.readFd;
+		jobserver.ownsWriteFd = TRUE;
+	}
+
+	/* Otherwise, use an inherited pipe, which make only passes to commands it knows to be makes.
+	 * Reopening the read end gives the shell a non-blocking descriptor of its own, since the
+	 * one it inherited is shared with make, which expects it to block. */
+	else
+	{
+		int readFd;
+		int writeFd;
+		char procPath[64];
+		if (sscanf(value, "%d,%d", &readFd, &writeFd) != 2 || readFd < 0 || writeFd < 0
+		    || fcntl(readFd, F_GETFD) == -1 || fcntl(writeFd, F_GETFD) == -1)
+		{
+			fprintf(stderr, "MAKEFLAGS: jobserver %s is not available (mark the rule running smallsh with +)\n", value);
+			fflush(stderr);
+			return FALSE;
+		}
+		snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", readFd);
+		jobserver.readFd = raiseShellFd(open(procPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+		if (jobserver.readFd == -1)
+		{
+			fprintf(stderr, "MAKEFLAGS: cannot open jobserver %s: %s\n", value, strerror(errno)); fflush(stderr);
+			return FALSE;
+		}
+		jobserver.writeFd = writeFd;
+	}
+	jobserver.role = JOBSERVER_CLIENT;
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: createJobserver
+ * Description:	Receives the number of job slots (as a string, 0 for one per cpu) and
+ * 		the style of pool ("pipe" or NULL, or "fifo"). Creates the pool,
+ * 		fills it with one token fewer than the number of slots, and adds it
+ * 		to MAKEFLAGS (with -j) for the commands the shell runs. A fifo is
+ * 		made in a private directory so that no other user can reach it.
+ * 		Returns TRUE, or FALSE (after reporting the error) otherwise.
+ **************************************************************************************/
+
+int createJobserver(char* slotsString, char* style)
+{
+	char* endPtr;
+	long numSlots = strtol(slotsString, &endPtr, 10);
+	if (*endPtr != '\0' || numSlots < 0 || numSlots > MAX_JOBSERVER_SLOTS)
+	{
+		fprintf(stderr, "SMALLSH_JOBSERVER: must be 0 (one slot per cpu) or a number of slots up to %d\n",
+			MAX_JOBSERVER_SLOTS);
+		fflush(stderr);
+		return FALSE;
+	}
+	if (numSlots == 0)
+	{
+		numSlots = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (numSlots < MIN_JOBSERVER_SLOTS)
+	{
+		numSlots = MIN_JOBSERVER_SLOTS;
+	}
+	char auth[PATH_MAX + 64];
+
+	/* Create a fifo in a private directory, kept open for both taking and giving back tokens. */
+	if (style != NULL && strcmp(style, "fifo") == 0)
+	{
+		char dirTemplate[] = "/tmp/smallsh-jobserver.XXXXXX";
+		char* dir = mkdtemp(dirTemplate);
+		if (dir == NULL)
+		{
+			perror("SMALLSH_JOBSERVER"); fflush(stderr);
+			return FALSE;
+		}
+		jobserver.fifoDir = strdup(dir);
+		jobserver.fifoPath = (char*)malloc(strlen(dir) + strlen("/fifo") + 1);
+		sprintf(jobserver.fifoPath, "%s/fifo", dir);
+		if (mkfifo(jobserver.fifoPath, S_IRUSR | S_IWUSR) == 0)
+		{
+			jobserver.readFd = raiseShellFd(open(jobserver.fifoPath, O_RDWR | O_NONBLOCK | O_CLOEXEC));
+		}
+		jobserver.writeFd = jobserver.readFd;
+		jobserver.ownsWriteFd = TRUE;
+		snprintf(auth, sizeof(auth), "fifo:%s", jobserver.fifoPath);
+	}
+
+	/* Otherwise, create an inherited pipe (not close-on-exec, so that every command receives it),
+	 * and reopen its read end for the shell's own non-blocking use. */
+	else
+	{
+		int fds[2];
+		char procPath[64];
+		if (pipe(fds) == -1)
+		{
+			perror("SMALLSH_JOBSERVER"); fflush(stderr);
+			return FALSE;
+		}
+		for (int i = 0; i < 2; i++)
+		{
+			jobserver.pipeFds[i] = fcntl(fds[i], F_DUPFD, SHELL_FD_BASE);
+			if (jobserver.pipeFds[i] == -1)
+			{
+				jobserver.pipeFds[i] = fds[i];
+			}
+			else
+			{
+				close(fds[i]);
+			}
+		}
+		snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", jobserver.pipeFds[0]);
+		jobserver.readFd = raiseShellFd(open(procPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+		jobserver.writeFd = jobserver.pipeFds[1];
+		snprintf(auth, sizeof(auth), "%d,%d", jobserver.pipeFds[0], jobserver.pipeFds[1]);
+	}
+	if (jobserver.readFd == -1)
+	{
+		perror("SMALLSH_JOBSERVER"); fflush(stderr);
+		closeJobserver();
+		return FALSE;
+	}
+	jobserver.role = JOBSERVER_SERVER;
+
+	/* Fill the pool, and name it in MAKEFLAGS after whatever flags were already there. */
+	for (long i = 0; i < numSlots - 1; i++)
+	{
+		giveBackToken(JOBSERVER_TOKEN);
+	}
+	char* oldFlags = getEnvVar("MAKEFLAGS");
+	char* makeflags = (char*)malloc(((oldFlags != NULL) ? strlen(oldFlags) : 0) + strlen(auth) + 64);
+	sprintf(makeflags, "%s%s-j%ld --jobserver-auth=%s", (oldFlags != NULL) ? oldFlags : "",
+		(oldFlags != NULL && oldFlags[0] != '\0') ? " " : "", numSlots, auth);
+	setEnvVar("MAKEFLAGS", makeflags);
+	free(makeflags);
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: isJobserverActive
+ * Description:	Returns TRUE if the shell serves or uses a pool, or FALSE otherwise.
+ **************************************************************************************/
+
+int isJobserverActive()
+{
+	return (jobserver.role != JOBSERVER_NONE) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: acquireJobToken
+ * Description:	Takes a token from the pool for the next launch, without waiting,
+ * 		unless one was already taken and not yet attached to a job. Returns
+ * 		TRUE if a token is held for the launch, or FALSE if the pool is empty.
+ **************************************************************************************/
+
+int acquireJobToken()
+{
+	unsigned char token;
+
+	if (jobserver.pendingToken != -1)
+	{
+		return TRUE;
+	}
+	while (TRUE)
+	{
+		ssize_t bytesRead = read(jobserver.readFd, &token, 1);
+		if (bytesRead == 1)
+		{
+			jobserver.pendingToken = token;
+			return TRUE;
+		}
+		if (bytesRead == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		return FALSE;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: attachJobToken
+ * Description:	Receives the BackgroundCommands list and the node of a job that was
+ * 		just launched (or NULL if the launch failed). Hands the token taken
+ * 		for the launch (if any) to the job, which holds it until it is
+ * 		reaped, holding reaping meanwhile (so that the token comes back as
+ * 		soon as the job exits, not at the next prompt). If the launch failed,
+ * 		gives the token back. Returns nothing.
+ **************************************************************************************/
+
+void attachJobToken(struct BackgroundCommands* bgCommandsList, struct BackgroundNode* node)
+{
+	if (jobserver.pendingToken == -1)
+	{
+		return;
+	}
+	if (node == NULL)
+	{
+		giveBackToken(jobserver.pendingToken);
+	}
+	else
+	{
+		node->jobToken = jobserver.pendingToken;
+		holdBackgroundReaping(bgCommandsList);
+	}
+	jobserver.pendingToken = -1;
+}
+
+
+/***************************************************************************************
+ * Function Name: releaseJobToken
+ * Description:	Receives the BackgroundCommands list and the node of a job that has
+ * 		been reaped. Gives the job's token (if any) back to the pool.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void releaseJobToken(struct BackgroundCommands* bgCommandsList, struct BackgroundNode* node)
+{
+	if (node->jobToken == -1)
+	{
+		return;
+	}
+	giveBackToken(node->jobToken);
+	node->jobToken = -1;
+	releaseBackgroundReaping(bgCommandsList);
+}
+
+
+/***************************************************************************************
+ * Function Name: giveBackToken
+ * Description:	Receives a token. Writes it to the pool. Returns nothing.
+ **************************************************************************************/
+
+void giveBackToken(int token)
+{
+	unsigned char byte = (unsigned char)token;
+	while (write(jobserver.writeFd, &byte, 1) == -1 && errno == EINTR)
+	{
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: watchJobserver
+ * Description:	Receives an event loop callback. Calls it once the pool may hold a
+ * 		token (once its descriptor is readable), until stopWatchingJobserver
+ * 		is called. Returns nothing.
+ **************************************************************************************/
+
+void watchJobserver(void (*callback)(int fd, void* arg))
+{
+	if (jobserver.tokenWatcher == NULL)
+	{
+		jobserver.tokenWatcher = addEventWatcher(jobserver.readFd, callback, NULL);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: stopWatchingJobserver
+ * Description:	Stops calling the callback given to watchJobserver. Receives and
+ * 		returns nothing.
+ **************************************************************************************/
+
+void stopWatchingJobserver()
+{
+	if (jobserver.tokenWatcher != NULL)
+	{
+		removeEventWatcher(jobserver.tokenWatcher);
+		jobserver.tokenWatcher = NULL;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: closeJobserver
+ * Description:	Gives back any token not attached to a job, and closes the shell's
+ * 		descriptors of the pool, removing the fifo (and its directory) if the
+ * 		shell created one. Called as the shell exits, after its jobs have
+ * 		been reaped (which gives their tokens back). Receives and returns
+ * 		nothing.
+ **************************************************************************************/
+
+void closeJobserver()
+{
+	if (jobserver.pendingToken != -1)
+	{
+		giveBackToken(jobserver.pendingToken);
+		jobserver.pendingToken = -1;
+	}
+	stopWatchingJobserver();
+	if (jobserver.readFd != -1)
+	{
+		close(jobserver.readFd);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (jobserver.pipeFds[i] != -1)
+		{
+			close(jobserver.pipeFds[i]);
+			jobserver.pipeFds[i] = -1;
+		}
+	}
+	if (jobserver.fifoPath != NULL)
+	{
+		unlink(jobserver.fifoPath);
+		rmdir(jobserver.fifoDir);
+		free(jobserver.fifoPath);
+		free(jobserver.fifoDir);
+	}
+	jobserver.role = JOBSERVER_NONE;
+	jobserver.ownsWriteFd = FALSE;
+	jobserver.readFd = -1;
+	jobserver.writeFd = -1;
+	jobserver.fifoPath = NULL;
+	jobserver.fifoDir = NULL;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************************
+ * File: densmora.jobserver.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definition of the Jobserver struct and
+ * 		prototypes of the functions that take part in the GNU make jobserver
+ * 		protocol, either serving a pool of tokens to the commands the shell
+ * 		runs or taking tokens from the pool of a make that runs the shell, so
+ * 		that background jobs and parallel makes share one limit. See
+ * 		densmora.jobserver.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_JOBSERVER
+#define DENSMORA_JOBSERVER
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.eventLoop.h"
+#include "densmora.environment.h"
+
+/* Roles the shell can play. */
+#define JOBSERVER_NONE 0
+#define JOBSERVER_SERVER 1		/* The shell created the pool. */
+#define JOBSERVER_CLIENT 2		/* The pool belongs to a make running the shell. */
+
+/* Fewest and most job slots a pool created by the shell can have. Every user of a pool
+ * holds one slot without a token (the shell's runs its foreground commands), so the pool
+ * holds one token fewer than its number of slots. */
+#define MIN_JOBSERVER_SLOTS 2
+#define MAX_JOBSERVER_SLOTS 4096
+
+/* Byte written for each token of a pool created by the shell. */
+#define JOBSERVER_TOKEN '+'
+
+/* Struct storing the shell's side of the jobserver. */
+
+struct Jobserver
+{
+	int role;				/* One of the JOBSERVER roles. */
+	int readFd;				/* Non-blocking descriptor from which tokens are taken. */
+	int writeFd;				/* Descriptor to which tokens are given back. */
+	int ownsWriteFd;			/* Set to TRUE if writeFd was opened by the shell (and is closed by it). */
+	int pipeFds[2];				/* Inherited pipe of a pipe-style pool created by the shell (-1 if none). */
+	char* fifoPath;				/* Fifo of a fifo-style pool created by the shell (NULL if none). */
+	char* fifoDir;				/* Private directory holding the fifo. */
+	int pendingToken;			/* Token taken for a launch not yet attached to its job (-1 if none). */
+	struct EventWatcher* tokenWatcher;	/* Watcher of readFd while a launch waits for a token, or NULL. */
+};
+
+/* Function prototypes (see densmora.jobserver.c for function descriptions and implementations). */
+void initJobserver();
+int joinJobserver(char* makeflags);
+int createJobserver(char* slotsString, char* style);
+int isJobserverActive();
+int acquireJobToken();
+void attachJobToken(struct BackgroundCommands* bgCommandsList, struct BackgroundNode* node);
+void releaseJobToken(struct BackgroundCommands* bgCommandsList, struct BackgroundNode* node);
+void giveBackToken(int token);
+void watchJobserver(void (*callback)(int fd, void* arg));
+void stopWatchingJobserver();
+void closeJobserver();
+
+#endif
@@ -0,0 +1,499 @@
+/***************************************************************************************
+ * File: densmora.outputFanOut.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that send
+ * 		a command's stdout to several files. All of the files are opened by
+ * 		the shell before the fork, and the command writes to a pipe that the
+ * 		event loop empties. Every target but the last receives its copy with
+ * 		tee (into a pipe of its own, which is then spliced to the file), and
+ * 		the last target receives the data itself with splice, so the output
+ * 		never passes through user space. Files that do not accept splice are
+ * 		written with read and write instead. A file that cannot be written is
+ * 		reported and dropped, and the other files keep receiving the output.
+ **************************************************************************************/
+
+#include "densmora.outputFanOut.h"
+
+
+/***************************************************************************************
+ * Function Name: addOutputDest
+ * Description:	Receives a parsed command and the name of a file given after > or >+.
+ * 		Makes the file the command's output destination if it has none, or
+ * 		adds it to extraOutputDests otherwise. Returns nothing.
+ **************************************************************************************/
+
+void addOutputDest(struct CommandInfo* myCommand, char* dest)
+{
+	if (myCommand->outputFlag == FALSE)
+	{
+		myCommand->outputFlag = TRUE;
+		myCommand->outputRedirDest = dest;
+		return;
+	}
+	myCommand->extraOutputDests = (char**)realloc(myCommand->extraOutputDests,
+						      (myCommand->numExtraOutputDests + 1) * sizeof(char*));
+	myCommand->extraOutputDests[myCommand->numExtraOutputDests++] = dest;
+}
+
+
+/***************************************************************************************
+ * Function Name: openFanOut
+ * Description:	Receives a command with more than one output destination. Opens every
+ * 		destination (truncating or creating it, as executeChild does for a
+ * 		single >), the pipe the command will write to, and the pipes used by
+ * 		tee. Returns the new FanOut, or NULL (after reporting the error) if a
+ * 		file or pipe could not be opened, in which case the command must not
+ * 		be run.
+ **************************************************************************************/
+
+struct FanOut* openFanOut(struct CommandInfo* myCommand)
+{
+	int pipeFds[2];
+	struct FanOut* fanOut = (struct FanOut*)malloc(sizeof(struct FanOut));
+	memset(fanOut, 0, sizeof(struct FanOut));
+	fanOut->numTargets = myCommand->numExtraOutputDests + 1;
+	fanOut->targets = (struct FanOutTarget*)malloc(fanOut->numTargets * sizeof(struct FanOutTarget));
+	for (int i = 0; i < fanOut->numTargets; i++)
+	{
+		fanOut->targets[i].path = (i == 0) ? myCommand->outputRedirDest : myCommand->extraOutputDests[i - 1];
+		fanOut->targets[i].fd = -1;
+		fanOut->targets[i].pipeFds[0] = fanOut->targets[i].pipeFds[1] = -1;
+		fanOut->targets[i].spliceFailed = FALSE;
+	}
+
+	/* Open the pipe the command writes to. */
+	if (pipe2(pipeFds, O_CLOEXEC) == -1)
+	{
+		perror("pipe2()"); fflush(stderr);
+		fanOut->pipeFd = fanOut->writeFd = -1;
+		closeFanOut(fanOut);
+		return NULL;
+	}
+	fanOut->pipeFd = pipeFds[0];
+	fanOut->writeFd = pipeFds[1];
+	fcntl(fanOut->pipeFd, F_SETFL, O_NONBLOCK);
+	int pipeSize = fcntl(fanOut->pipeFd, F_GETPIPE_SZ);
+
+	/* Open the files in order, giving every target but the last a pipe as large as the command's,
+	 * so that tee can always copy everything waiting in the command's pipe at once. */
+	for (int i = 0; i < fanOut->numTargets; i++)
+	{
+		struct FanOutTarget* target = &fanOut->targets[i];
+		target->fd = open(target->path, O_WRONLY | O_TRUNC | O_CREAT | O_CLOEXEC, FILE_PERMISSIONS);
+		if (target->fd == -1)
+		{
+			fprintf(stderr, "cannot open %s for output\n", target->path); fflush(stderr);
+			closeFanOut(fanOut);
+			return NULL;
+		}
+		if (i < fanOut->numTargets - 1)
+		{
+			if (pipe2(target->pipeFds, O_CLOEXEC) == -1)
+			{
+				perror("pipe2()"); fflush(stderr);
+				target->pipeFds[0] = target->pipeFds[1] = -1;
+				closeFanOut(fanOut);
+				return NULL;
+			}
+			if (pipeSize > 0)
+			{
+				fcntl(target->pipeFds[1], F_SETPIPE_SZ, pipeSize);
+			}
+		}
+	}
+	return fanOut;
+}
+
+
+/***************************************************************************************
+ * Function Name: attachFanOut
+ * Description:	Receives a FanOut whose command has been forked, and a flag that is
+ * 		TRUE if nobody will wait for the output (a background job), in which
+ * 		case the FanOut frees itself once the output ends. Closes the shell's
+ * 		copy of the write end and starts copying the output from the event
+ * 		loop. Returns nothing.
+ **************************************************************************************/
+
+void attachFanOut(struct FanOut* fanOut, int detached)
+{
+	close(fanOut->writeFd);
+	fanOut->writeFd = -1;
+	fanOut->detached = detached;
+	fanOut->watcher = addEventWatcher(fanOut->pipeFd, copyFanOut, fanOut);
+
+	/* If the pipe cannot be watched, copy the output with blocking reads instead. */
+	if (fanOut->watcher == NULL)
+	{
+		fcntl(fanOut->pipeFd, F_SETFL, 0);
+		if (detached == TRUE)
+		{
+			fanOut->detached = FALSE;
+			finishFanOut(fanOut);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: finishFanOut
+ * Description:	Receives an attached FanOut of a foreground command. Keeps copying
+ * 		until every writer has closed the pipe, and then closes the files and
+ * 		frees the FanOut. Returns nothing.
+ **************************************************************************************/
+
+void finishFanOut(struct FanOut* fanOut)
+{
+	while (fanOut->finished == FALSE)
+	{
+		if (fanOut->watcher == NULL)
+		{
+			copyFanOut(fanOut->pipeFd, fanOut);
+		}
+		else
+		{
+			runEventLoopOnce(-1);
+		}
+	}
+	closeFanOut(fanOut);
+}
+
+
+/***************************************************************************************
+ * Function Name: copyFanOut
+ * Description:	Event loop callback for the pipe receiving a command's output.
+ * 		Receives the read end and the FanOut. Repeatedly tees what is waiting
+ * 		to each open target but the last and then moves it to the last one,
+ * 		until the pipe is empty. Marks the FanOut finished on EOF (freeing it
+ * 		if it is detached). Returns nothing.
+ **************************************************************************************/
+
+void copyFanOut(int fd, void* arg)
+{
+	struct FanOut* fanOut = (struct FanOut*)arg;
+	ssize_t numBytes;
+
+	while (TRUE)
+	{
+		/* The last open target consumes the data, and the ones before it get copies. */
+		int lastTarget = -1;
+		for (int i = 0; i < fanOut->numTargets; i++)
+		{
+			if (fanOut->targets[i].fd != -1)
+			{
+				lastTarget = i;
+			}
+		}
+
+		/* If every target has failed, keep emptying the pipe so that the command can finish. */
+		if (lastTarget == -1)
+		{
+			char chunk[FAN_OUT_CHUNK_BYTES];
+			numBytes = read(fd, chunk, FAN_OUT_CHUNK_BYTES);
+		}
+
+		/* Otherwise, copy the waiting data to every target. The first tee (or the move, if only
+		 * one target is left) decides how much data this round covers. */
+		else
+		{
+			int roundOver = FALSE;
+			numBytes = 0;
+			for (int i = 0; i < lastTarget && roundOver == FALSE; i++)
+			{
+				if (fanOut->targets[i].fd == -1)
+				{
+					continue;
+				}
+				ssize_t bytesTeed = teeFanOutTarget(fanOut, &fanOut->targets[i], numBytes);
+				if (numBytes == 0 && (bytesTeed == 0 || (bytesTeed == -1 && errno == EAGAIN)))
+				{
+					numBytes = bytesTeed;
+					roundOver = TRUE;
+				}
+				else if (numBytes == 0 && bytesTeed > 0)
+				{
+					numBytes = bytesTeed;
+				}
+			}
+			if (roundOver == FALSE)
+			{
+				numBytes = moveFanOutInput(fanOut, &fanOut->targets[lastTarget], numBytes);
+			}
+		}
+
+		/* On EOF, stop watching the pipe. */
+		if (numBytes == 0)
+		{
+			if (fanOut->watcher != NULL)
+			{
+				removeEventWatcher(fanOut->watcher);
+				fanOut->watcher = NULL;
+			}
+			fanOut->finished = TRUE;
+			if (fanOut->detached == TRUE)
+			{
+				closeFanOut(fanOut);
+			}
+			return;
+		}
+
+		/* Otherwise, stop once the pipe is empty (retrying calls interrupted by a signal). */
+		if (numBytes == -1 && errno != EINTR)
+		{
+			return;
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: teeFanOutTarget
+ * Description:	Receives a FanOut, one of its targets other than the last, and the
+ * 		number of bytes this round covers (0 if it is not yet known). Copies
+ * 		that many bytes (or, if 0, as many as are waiting) from the command's
+ * 		pipe into the target's pipe with tee, leaving them in the command's
+ * 		pipe, and then writes them to the target's file. Returns the number
+ * 		of bytes copied, 0 at EOF, or -1 with errno set (EAGAIN if nothing was
+ * 		waiting). If the target fails, it is reported and dropped.
+ **************************************************************************************/
+
+ssize_t teeFanOutTarget(struct FanOut* fanOut, struct FanOutTarget* target, ssize_t numBytes)
+{
+	ssize_t bytesTeed;
+	do
+	{
+		bytesTeed = tee(fanOut->pipeFd, target->pipeFds[1], (numBytes == 0) ? FAN_OUT_CHUNK_BYTES : numBytes,
+				SPLICE_F_NONBLOCK);
+	} while (bytesTeed == -1 && errno == EINTR);
+
+	/* Nothing was waiting (or the output ended), so this round is over before it began. */
+	if (numBytes == 0 && (bytesTeed == 0 || (bytesTeed == -1 && errno == EAGAIN)))
+	{
+		return bytesTeed;
+	}
+
+	/* The target's pipe is empty and as large as the command's, so tee can only come up short
+	 * if something is wrong with the target's pipe. */
+	if (bytesTeed <= 0 || (numBytes != 0 && bytesTeed != numBytes))
+	{
+		failFanOutTarget(target, (bytesTeed == -1) ? errno : EIO);
+		return (numBytes == 0) ? -1 : numBytes;
+	}
+
+	if (writeFanOutTarget(target, bytesTeed) == -1)
+	{
+		failFanOutTarget(target, errno);
+	}
+	return bytesTeed;
+}
+
+
+/***************************************************************************************
+ * Function Name: moveFanOutInput
+ * Description:	Receives a FanOut, its last open target, and the number of bytes this
+ * 		round covers (0 if no tee was done). Moves that many bytes (or, if 0,
+ * 		as many as are waiting) out of the command's pipe and into the file
+ * 		with splice. If the target fails, it is reported and dropped, and the
+ * 		rest of the round's bytes are discarded. Returns the number of bytes
+ * 		removed from the pipe, 0 at EOF, or -1 with errno set (EAGAIN if
+ * 		nothing was waiting).
+ **************************************************************************************/
+
+ssize_t moveFanOutInput(struct FanOut* fanOut, struct FanOutTarget* target, ssize_t numBytes)
+{
+	static char chunk[FAN_OUT_CHUNK_BYTES];
+	ssize_t bytesLeft = (numBytes == 0) ? FAN_OUT_CHUNK_BYTES : numBytes;
+	ssize_t bytesMoved;
+
+	while (bytesLeft > 0)
+	{
+		/* Move the data in the kernel if the file allows it, and otherwise through a buffer. */
+		if (target->spliceFailed == FALSE)
+		{
+			bytesMoved = splice(fanOut->pipeFd, NULL, target->fd, NULL, bytesLeft, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			if (bytesMoved == -1 && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+			{
+				target->spliceFailed = TRUE;
+				continue;
+			}
+		}
+		else
+		{
+			bytesMoved = read(fanOut->pipeFd, chunk, (bytesLeft < FAN_OUT_CHUNK_BYTES) ? bytesLeft : FAN_OUT_CHUNK_BYTES);
+			for (ssize_t bytesWritten = 0; bytesMoved > 0 && bytesWritten < bytesMoved; )
+			{
+				ssize_t result = write(target->fd, chunk + bytesWritten, bytesMoved - bytesWritten);
+				if (result == -1 && errno != EINTR)
+				{
+					failFanOutTarget(target, errno);
+					break;
+				}
+				bytesWritten += (result > 0) ? result : 0;
+			}
+		}
+		if (bytesMoved == -1 && errno == EINTR)
+		{
+			continue;
+		}
+
+		/* If the round's size is not known, whatever was moved (or EOF, or EAGAIN) ends it. */
+		if (numBytes == 0)
+		{
+			if (bytesMoved == -1 && errno != EAGAIN)
+			{
+				failFanOutTarget(target, errno);
+			}
+			return bytesMoved;
+		}
+
+		/* Otherwise the data is known to be waiting, so a failure to move it belongs to the file. */
+		if (bytesMoved <= 0 || target->fd == -1)
+		{
+			if (target->fd != -1)
+			{
+				failFanOutTarget(target, (bytesMoved == -1) ? errno : EIO);
+			}
+			discardFanOutInput(fanOut->pipeFd, bytesLeft - ((bytesMoved > 0) ? bytesMoved : 0));
+			return numBytes;
+		}
+		bytesLeft -= bytesMoved;
+	}
+	return numBytes;
+}
+
+
+/***************************************************************************************
+ * Function Name: writeFanOutTarget
+ * Description:	Receives a target (other than the last) whose pipe holds numBytes
+ * 		bytes from tee. Splices them to the target's file, or reads and
+ * 		writes them if the file does not accept splice. Returns 0 on
+ * 		success, or -1 with errno set on failure.
+ **************************************************************************************/
+
+int writeFanOutTarget(struct FanOutTarget* target, ssize_t numBytes)
+{
+	static char chunk[FAN_OUT_CHUNK_BYTES];
+
+	while (numBytes > 0)
+	{
+		ssize_t bytesMoved;
+		if (target->spliceFailed == FALSE)
+		{
+			bytesMoved = splice(target->pipeFds[0], NULL, target->fd, NULL, numBytes, SPLICE_F_MOVE);
+			if (bytesMoved == -1 && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+			{
+				target->spliceFailed = TRUE;
+				continue;
+			}
+		}
+		else
+		{
+			bytesMoved = read(target->pipeFds[0], chunk, (numBytes < FAN_OUT_CHUNK_BYTES) ? numBytes : FAN_OUT_CHUNK_BYTES);
+			for (ssize_t bytesWritten = 0; bytesMoved > 0 && bytesWritten < bytesMoved; )
+			{
+				ssize_t result = write(target->fd, chunk + bytesWritten, bytesMoved - bytesWritten);
+				if (result == -1 && errno != EINTR)
+				{
+					return -1;
+				}
+				bytesWritten += (result > 0) ? result : 0;
+			}
+		}
+		if (bytesMoved == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (bytesMoved <= 0)
+		{
+			errno = (bytesMoved == 0) ? EIO : errno;
+			return -1;
+		}
+		numBytes -= bytesMoved;
+	}
+	return 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: failFanOutTarget
+ * Description:	Receives a target that could not be written and the error number.
+ * 		Reports the error and closes the target's file and pipe (dropping any
+ * 		data left in the pipe), so that it receives no more output.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void failFanOutTarget(struct FanOutTarget* target, int errorNumber)
+{
+	fprintf(stderr, "cannot write to %s: %s\n", target->path, strerror(errorNumber)); fflush(stderr);
+	close(target->fd);
+	target->fd = -1;
+	if (target->pipeFds[0] != -1)
+	{
+		close(target->pipeFds[0]);
+		close(target->pipeFds[1]);
+		target->pipeFds[0] = target->pipeFds[1] = -1;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: discardFanOutInput
+ * Description:	Receives the command's pipe and a number of bytes known to be waiting
+ * 		in it. Reads and drops them, so that a round abandoned by a failed
+ * 		target does not reach the other targets twice. Returns nothing.
+ **************************************************************************************/
+
+void discardFanOutInput(int fd, ssize_t numBytes)
+{
+	char chunk[4096];
+	while (numBytes > 0)
+	{
+		ssize_t bytesRead = read(fd, chunk, (numBytes < (ssize_t)sizeof(chunk)) ? numBytes : (ssize_t)sizeof(chunk));
+		if (bytesRead == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (bytesRead <= 0)
+		{
+			return;
+		}
+		numBytes -= bytesRead;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: closeFanOut
+ * Description:	Receives a FanOut. Stops watching its pipe, closes every descriptor
+ * 		it still holds, and frees it. Returns nothing.
+ **************************************************************************************/
+
+void closeFanOut(struct FanOut* fanOut)
+{
+	if (fanOut->watcher != NULL)
+	{
+		removeEventWatcher(fanOut->watcher);
+	}
+	if (fanOut->pipeFd != -1)
+	{
+		close(fanOut->pipeFd);
+	}
+	if (fanOut->writeFd != -1)
+	{
+		close(fanOut->writeFd);
+	}
+	for (int i = 0; i < fanOut->numTargets; i++)
+	{
+		if (fanOut->targets[i].fd != -1)
+		{
+			close(fanOut->targets[i].fd);
+		}
+		if (fanOut->targets[i].pipeFds[0] != -1)
+		{
+			close(fanOut->targets[i].pipeFds[0]);
+			close(fanOut->targets[i].pipeFds[1]);
+		}
+	}
+	free(fanOut->targets);
+	free(fanOut);
+}
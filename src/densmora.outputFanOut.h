@@ -0,0 +1,64 @@
+/***************************************************************************************
+ * File: densmora.outputFanOut.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions that send one command's stdout to several files
+ * 		(> a > b, or >+ a b). The command writes to a pipe, and the shell
+ * 		duplicates the pipe's contents to every file in the kernel with tee
+ * 		and splice. See densmora.outputFanOut.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_OUTPUT_FAN_OUT
+#define DENSMORA_OUTPUT_FAN_OUT
+
+/* Built-in header file inclusions. */
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.eventLoop.h"
+
+/* Size of the chunks moved from the command's pipe (and of the buffer used when a file
+ * does not support splice). */
+#define FAN_OUT_CHUNK_BYTES 65536
+
+/* Struct storing one of the files receiving a command's output. */
+
+struct FanOutTarget
+{
+	char* path;				/* Name of the file (for error messages). */
+	int fd;					/* Descriptor of the file, or -1 once it has failed. */
+	int pipeFds[2];				/* Pipe holding the copy made by tee (unused by the last target). */
+	int spliceFailed;			/* Set to TRUE if the file does not accept splice. */
+};
+
+/* Struct storing the state of a command whose output is being fanned out. */
+
+struct FanOut
+{
+	int pipeFd;				/* Read end of the pipe receiving the command's stdout. */
+	int writeFd;				/* Write end of that pipe, open only until the fork. */
+	struct FanOutTarget* targets;		/* Files receiving the output, in command-line order. */
+	int numTargets;				/* Number of elements in targets. */
+	int finished;				/* Set to TRUE once the pipe reaches EOF. */
+	int detached;				/* Set to TRUE if the fan-out frees itself at EOF (background jobs). */
+	struct EventWatcher* watcher;		/* Event loop watcher of pipeFd. */
+};
+
+/* Function prototypes (see densmora.outputFanOut.c for function descriptions and implementations). */
+void addOutputDest(struct CommandInfo* myCommand, char* dest);
+struct FanOut* openFanOut(struct CommandInfo* myCommand);
+void attachFanOut(struct FanOut* fanOut, int detached);
+void finishFanOut(struct FanOut* fanOut);
+void copyFanOut(int fd, void* arg);
+ssize_t teeFanOutTarget(struct FanOut* fanOut, struct FanOutTarget* target, ssize_t numBytes);
+ssize_t moveFanOutInput(struct FanOut* fanOut, struct FanOutTarget* target, ssize_t numBytes);
+int writeFanOutTarget(struct FanOutTarget* target, ssize_t numBytes);
+void failFanOutTarget(struct FanOutTarget* target, int errorNumber);
+void discardFanOutInput(int fd, ssize_t numBytes);
+void closeFanOut(struct FanOut* fanOut);
+
+#endif
@@ -0,0 +1,373 @@
+/***************************************************************************************
+ * File: densmora.phaseStats.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		record how long each phase of running a command takes. Each phase has
+ * 		a histogram with a fixed set of log-linear buckets (as in HDR
+ * 		histograms), so recording a latency is a few arithmetic operations
+ * 		and an increment, with no allocation, and percentiles are read back
+ * 		by walking the buckets. The phases inside the child (setting up its
+ * 		redirections and exec) are timed by the child itself, which sends
+ * 		its clock readings through a close-on-exec pipe whose EOF tells the
+ * 		shell when the exec completed.
+ **************************************************************************************/
+
+#include "densmora.phaseStats.h"
+
+/* Latencies recorded for each phase since the shell started or the stats were reset. */
+static struct LatencyHistogram phaseHistograms[NUM_PHASES];
+
+/* Names of the phases, as printed by the stats built-in and the stats socket. */
+static const char* phaseNames[NUM_PHASES] = { "read", "parse", "expand", "fork", "setup", "exec", "wait" };
+
+
+/***************************************************************************************
+ * Function Name: elapsedNsec
+ * Description:	Receives two times from the same clock. Returns the nanoseconds from
+ * 		start to end (0 if end is earlier).
+ **************************************************************************************/
+
+unsigned long long elapsedNsec(struct timespec* start, struct timespec* end)
+{
+	long long nsec = (end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+	return (nsec > 0) ? (unsigned long long)nsec : 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: recordPhase
+ * Description:	Receives a phase and a latency in nanoseconds. Adds the latency to the
+ * 		phase's histogram. Returns nothing.
+ **************************************************************************************/
+
+void recordPhase(int phase, unsigned long long nsec)
+{
+	struct LatencyHistogram* histogram = &phaseHistograms[phase];
+	histogram->counts[getHistogramBucket(nsec)]++;
+	histogram->numValues++;
+	histogram->totalNsec += nsec;
+	if (nsec > histogram->maxNsec)
+	{
+		histogram->maxNsec = nsec;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: recordPhaseSince
+ * Description:	Receives a phase and the time (CLOCK_MONOTONIC) at which it started.
+ * 		Records the time from then until now for the phase. Returns nothing.
+ **************************************************************************************/
+
+void recordPhaseSince(int phase, struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	recordPhase(phase, elapsedNsec(start, &now));
+}
+
+
+/***************************************************************************************
+ * Function Name: getHistogramBucket
+ * Description:	Receives a latency in nanoseconds. Returns the index of the bucket
+ * 		holding it: the value itself if it is small, or else its power of 2
+ * 		and the next HISTOGRAM_SUB_BITS bits below its leading bit.
+ **************************************************************************************/
+
+int getHistogramBucket(unsigned long long nsec)
+{
+	if (nsec < HISTOGRAM_SUB_BUCKETS)
+	{
+		return (int)nsec;
+	}
+	int exponent = 63 - __builtin_clzll(nsec);
+	if (exponent >= HISTOGRAM_MAX_EXPONENT)
+	{
+		return HISTOGRAM_BUCKETS - 1;
+	}
+	int subBucket = (int)(nsec >> (exponent - HISTOGRAM_SUB_BITS)) - HISTOGRAM_SUB_BUCKETS;
+	return (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+
+/***************************************************************************************
+ * Function Name: getBucketHighest
+ * Description:	Receives a bucket index. Returns the largest latency the bucket holds.
+ **************************************************************************************/
+
+unsigned long long getBucketHighest(int bucket)
+{
+	if (bucket < HISTOGRAM_SUB_BUCKETS)
+	{
+		return bucket;
+	}
+	int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+	unsigned long long lowest = (unsigned long long)(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+	return lowest + (1ULL << shift) - 1;
+}
+
+
+/***************************************************************************************
+ * Function Name: getHistogramPercentile
+ * Description:	Receives a histogram and a percentile (0 to 100). Returns the latency
+ * 		at that percentile (the top of its bucket, but never more than the
+ * 		largest latency recorded), or 0 if the histogram is empty.
+ **************************************************************************************/
+
+unsigned long long getHistogramPercentile(struct LatencyHistogram* histogram, double percentile)
+{
+	unsigned long rank = (unsigned long)(percentile / 100.0 * histogram->numValues + 0.999999);
+	unsigned long seen = 0;
+
+	if (rank == 0)
+	{
+		rank = 1;
+	}
+	for (int bucket = 0; bucket < HISTOGRAM_BUCKETS && histogram->numValues > 0; bucket++)
+	{
+		seen += histogram->counts[bucket];
+		if (seen >= rank)
+		{
+			unsigned long long highest = getBucketHighest(bucket);
+			return (highest < histogram->maxNsec) ? highest : histogram->maxNsec;
+		}
+	}
+	return 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: printPhaseStats
+ * Description:	Prints a table of the number of latencies recorded for each phase and
+ * 		their mean, percentiles, and maximum. Receives and returns nothing.
+ **************************************************************************************/
+
+void printPhaseStats()
+{
+	static const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+	char latency[32];
+
+	printf("%-8s %8s %10s %10s %10s %10s %10s %10s\n", "phase", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+	for (int phase = 0; phase < NUM_PHASES; phase++)
+	{
+		struct LatencyHistogram* histogram = &phaseHistograms[phase];
+		printf("%-8s %8lu", phaseNames[phase], histogram->numValues);
+		if (histogram->numValues == 0)
+		{
+			printf("\n");
+			continue;
+		}
+		formatLatency(latency, sizeof(latency), histogram->totalNsec / histogram->numValues);
+		printf(" %10s", latency);
+		for (int i = 0; i < (int)(sizeof(percentiles) / sizeof(percentiles[0])); i++)
+		{
+			formatLatency(latency, sizeof(latency), getHistogramPercentile(histogram, percentiles[i]));
+			printf(" %10s", latency);
+		}
+		formatLatency(latency, sizeof(latency), histogram->maxNsec);
+		printf(" %10s\n", latency);
+	}
+	fflush(stdout);
+}
+
+
+/***************************************************************************************
+ * Function Name: resetPhaseStats
+ * Description:	Empties every phase's histogram. Receives and returns nothing.
+ **************************************************************************************/
+
+void resetPhaseStats()
+{
+	memset(phaseHistograms, 0, sizeof(phaseHistograms));
+}
+
+
+/***************************************************************************************
+ * Function Name: formatPhaseStats
+ * Description:	Receives a buffer of bufferSize bytes. Writes the count and the p50,
+ * 		p90, and p99 latencies (in microseconds) of every phase that has
+ * 		been recorded, one "name value" pair per line, as served by the stats
+ * 		socket. Returns the number of bytes written.
+ **************************************************************************************/
+
+int formatPhaseStats(char* buffer, int bufferSize)
+{
+	static const char* quantiles[] = { "0.5", "0.9", "0.99" };
+	static const double percentiles[] = { 50.0, 90.0, 99.0 };
+	int length = 0;
+
+	for (int phase = 0; phase < NUM_PHASES && length < bufferSize; phase++)
+	{
+		struct LatencyHistogram* histogram = &phaseHistograms[phase];
+		if (histogram->numValues == 0)
+		{
+			continue;
+		}
+		length += snprintf(buffer + length, bufferSize - length, "smallsh_phase_count{phase=\"%s\"} %lu\n",
+				   phaseNames[phase], histogram->numValues);
+		for (int i = 0; i < 3 && length < bufferSize; i++)
+		{
+			length += snprintf(buffer + length, bufferSize - length, "smallsh_phase_us{phase=\"%s\",quantile=\"%s\"} %.1f\n",
+					   phaseNames[phase], quantiles[i], getHistogramPercentile(histogram, percentiles[i]) / 1000.0);
+		}
+	}
+	return (length > bufferSize) ? bufferSize : length;
+}
+
+
+/***************************************************************************************
+ * Function Name: formatLatency
+ * Description:	Receives a buffer of bufferSize bytes and a latency in nanoseconds.
+ * 		Writes the latency in the largest unit (ns, us, ms, or s) that keeps
+ * 		it at least 1. Returns nothing.
+ **************************************************************************************/
+
+void formatLatency(char* buffer, int bufferSize, unsigned long long nsec)
+{
+	if (nsec < 1000ULL)
+	{
+		snprintf(buffer, bufferSize, "%lluns", nsec);
+	}
+	else if (nsec < 1000000ULL)
+	{
+		snprintf(buffer, bufferSize, "%.1fus", nsec / 1000.0);
+	}
+	else if (nsec < 1000000000ULL)
+	{
+		snprintf(buffer, bufferSize, "%.2fms", nsec / 1000000.0);
+	}
+	else
+	{
+		snprintf(buffer, bufferSize, "%.2fs", nsec / 1000000000.0);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: openChildTimingPipe
+ * Description:	Receives an array of two descriptors. Opens a close-on-exec,
+ * 		non-blocking pipe into it for a child to send its timing through.
+ * 		Returns TRUE on success, or FALSE (setting both descriptors to -1,
+ * 		so that the command simply goes untimed) otherwise.
+ **************************************************************************************/
+
+int openChildTimingPipe(int timingPipe[2])
+{
+	if (pipe2(timingPipe, O_CLOEXEC | O_NONBLOCK) == -1)
+	{
+		timingPipe[0] = -1;
+		timingPipe[1] = -1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: sendChildTiming
+ * Description:	Called by a child just before exec. Receives the write end of its
+ * 		timing pipe (-1 if it is not being timed) and the time at which it
+ * 		started its setup. Sends that time and the current time to the shell
+ * 		in a single write (which a pipe never splits). Returns nothing.
+ **************************************************************************************/
+
+void sendChildTiming(int fd, struct timespec* setupStart)
+{
+	struct ChildTiming timing;
+	if (fd == -1)
+	{
+		return;
+	}
+	timing.setupStart = *setupStart;
+	clock_gettime(CLOCK_MONOTONIC, &timing.execStart);
+	if (write(fd, &timing, sizeof(struct ChildTiming)) == -1)
+	{
+		return;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: watchChildTiming
+ * Description:	Receives the read end of a child's timing pipe (after the shell has
+ * 		closed the write end). Watches it in the event loop, so that the time
+ * 		its exec completes is noted while the shell waits for the child.
+ * 		Returns the ChildTimingReader to pass to finishChildTiming.
+ **************************************************************************************/
+
+struct ChildTimingReader* watchChildTiming(int fd)
+{
+	struct ChildTimingReader* reader;
+	reader = (struct ChildTimingReader*)calloc(1, sizeof(struct ChildTimingReader));
+	reader->fd = fd;
+	reader->watcher = addEventWatcher(fd, readChildTiming, reader);
+	return reader;
+}
+
+
+/***************************************************************************************
+ * Function Name: readChildTiming
+ * Description:	Event loop callback for a child's timing pipe. Receives the
+ * 		descriptor and its ChildTimingReader. Reads whatever the child has
+ * 		sent, and notes the time if the pipe has reached EOF (which happens
+ * 		when exec closes it). Returns nothing.
+ **************************************************************************************/
+
+void readChildTiming(int fd, void* arg)
+{
+	struct ChildTimingReader* reader = (struct ChildTimingReader*)arg;
+	char buffer[2 * sizeof(struct ChildTiming)];
+	ssize_t numBytes;
+
+	while ((numBytes = read(fd, buffer, sizeof(buffer))) > 0)
+	{
+		size_t wanted = sizeof(struct ChildTiming) - reader->bytesRead;
+		size_t copied = ((size_t)numBytes < wanted) ? (size_t)numBytes : wanted;
+		memcpy((char*)&reader->timing + reader->bytesRead, buffer, copied);
+		reader->bytesRead += copied;
+	}
+	if (numBytes == 0 && reader->reachedEOF == FALSE)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &reader->execDone);
+		reader->reachedEOF = TRUE;
+		if (reader->watcher != NULL)
+		{
+			removeEventWatcher(reader->watcher);
+			reader->watcher = NULL;
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: finishChildTiming
+ * Description:	Receives a ChildTimingReader and the time its child was reaped.
+ * 		Records the child's setup, exec, and wait phases if it reached exec
+ * 		(if the shell was not woken by the exec before the child exited, the
+ * 		exec is taken to have ended when the child was reaped). Closes the
+ * 		pipe and frees the reader. Returns nothing.
+ **************************************************************************************/
+
+void finishChildTiming(struct ChildTimingReader* reader, struct timespec* reapTime)
+{
+	if (reader->reachedEOF == FALSE)
+	{
+		readChildTiming(reader->fd, reader);
+		reader->execDone = *reapTime;
+	}
+	if (reader->bytesRead == sizeof(struct ChildTiming))
+	{
+		recordPhase(PHASE_SETUP, elapsedNsec(&reader->timing.setupStart, &reader->timing.execStart));
+		recordPhase(PHASE_EXEC, elapsedNsec(&reader->timing.execStart, &reader->execDone));
+		recordPhase(PHASE_WAIT, elapsedNsec(&reader->execDone, reapTime));
+	}
+
+	if (reader->watcher != NULL)
+	{
+		removeEventWatcher(reader->watcher);
+	}
+	freeRemovedWatchers();
+	close(reader->fd);
+	free(reader);
+}
@@ -0,0 +1,94 @@
+/***************************************************************************************
+ * File: densmora.phaseStats.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions that time each phase of running a command (reading
+ * 		the line, parsing, expansion, fork, the child's setup, exec, and the
+ * 		wait) into fixed-bucket latency histograms, which the stats built-in
+ * 		and the stats socket report. See densmora.phaseStats.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_PHASE_STATS
+#define DENSMORA_PHASE_STATS
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+/* My own header file inclusions. */
+#include "densmora.smallshConstants.h"
+#include "densmora.eventLoop.h"
+
+/* Phases of running a command. */
+#define PHASE_READ 0
+#define PHASE_PARSE 1
+#define PHASE_EXPAND 2
+#define PHASE_FORK 3
+#define PHASE_SETUP 4
+#define PHASE_EXEC 5
+#define PHASE_WAIT 6
+#define NUM_PHASES 7
+
+/* Histogram layout: values below 2^HISTOGRAM_SUB_BITS nanoseconds get a bucket each, and every
+ * power of 2 above that is split into 2^HISTOGRAM_SUB_BITS buckets (so a bucket is within about
+ * 3% of any value in it), up to 2^HISTOGRAM_MAX_EXPONENT nanoseconds (about 2.4 hours). */
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_EXPONENT 43
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+/* Struct storing the latencies recorded for one phase. */
+
+struct LatencyHistogram
+{
+	unsigned long counts[HISTOGRAM_BUCKETS];	/* Number of latencies falling in each bucket. */
+	unsigned long numValues;			/* Number of latencies recorded. */
+	unsigned long long totalNsec;			/* Sum of the latencies recorded. */
+	unsigned long long maxNsec;			/* Largest latency recorded. */
+};
+
+/* Struct storing the times (CLOCK_MONOTONIC) a child sends the shell just before exec. */
+
+struct ChildTiming
+{
+	struct timespec setupStart;		/* When the child started setting up its redirections. */
+	struct timespec execStart;		/* When the child called exec. */
+};
+
+/* Struct storing what the shell has learned from a child's timing pipe. The pipe is
+ * close-on-exec, so it reaches EOF at the moment the exec succeeds (or the child exits). */
+
+struct ChildTimingReader
+{
+	int fd;					/* Read end of the timing pipe. */
+	struct EventWatcher* watcher;		/* Event loop watcher of fd (NULL once at EOF). */
+	struct ChildTiming timing;		/* Times sent by the child. */
+	size_t bytesRead;			/* Number of bytes of timing received. */
+	struct timespec execDone;		/* When the pipe reached EOF. */
+	int reachedEOF;				/* Set to TRUE once the pipe has reached EOF. */
+};
+
+/* Function prototypes (see densmora.phaseStats.c for function descriptions and implementations). */
+unsigned long long elapsedNsec(struct timespec* start, struct timespec* end);
+void recordPhase(int phase, unsigned long long nsec);
+void recordPhaseSince(int phase, struct timespec* start);
+int getHistogramBucket(unsigned long long nsec);
+unsigned long long getBucketHighest(int bucket);
+unsigned long long getHistogramPercentile(struct LatencyHistogram* histogram, double percentile);
+void printPhaseStats();
+void resetPhaseStats();
+int formatPhaseStats(char* buffer, int bufferSize);
+void formatLatency(char* buffer, int bufferSize, unsigned long long nsec);
+int openChildTimingPipe(int timingPipe[2]);
+void sendChildTiming(int fd, struct timespec* setupStart);
+struct ChildTimingReader* watchChildTiming(int fd);
+void readChildTiming(int fd, void* arg);
+void finishChildTiming(struct ChildTimingReader* reader, struct timespec* reapTime);
+
+#endif
@@ -0,0 +1,708 @@
+/***************************************************************************************
+ * File: densmora.resultCache.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions behind
+ * 		the cached built-in. A command's cache key is a 128-bit FNV-1a hash of
+ * 		its args, the working directory, its variable assignments, the
+ * 		environment variables named with -e, and the contents of its < file
+ * 		and of every file named with -i. On a hit, the stored stdout is
+ * 		written to the terminal or the > file and the stored exit status is
+ * 		set without forking. On a miss, the command runs with its stdout
+ * 		going through a pipe that the shell copies both to its destination
+ * 		and to a new cache entry. Entries live in SMALLSH_CACHE_DIR (default
+ * 		$HOME/.cache/smallsh), whose size is kept under SMALLSH_CACHE_MAX_KB
+ * 		by deleting the least recently used entries (hits refresh an entry's
+ * 		modification time).
+ **************************************************************************************/
+
+#include "densmora.resultCache.h"
+
+/* Struct storing the name, size, and last use of one entry while the cache is trimmed. */
+
+struct CacheEntryInfo
+{
+	char name[CACHE_KEY_CHARS + 1];		/* File name of the entry (its key). */
+	long long size;				/* Size of the entry in bytes. */
+	struct timespec lastUsed;		/* Modification time of the entry. */
+};
+
+
+/***************************************************************************************
+ * Function Name: runCached
+ * Description:	Receives a parsed command (with the cached built-in's own args already
+ * 		removed), the inputs declared to the built-in, and the
+ * 		ForegroundExitMethod struct. Replays the command's result from the
+ * 		cache if an entry exists for its key, and otherwise runs it in the
+ * 		foreground and stores the result if it exits normally. A command
+ * 		whose inputs cannot all be read, or whose output goes to several
+ * 		files, is run without the cache.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void runCached(struct CommandInfo* myCommand, struct CacheRequest* request, struct ForegroundExitMethod* lastFgStatus)
+{
+	char key[CACHE_KEY_CHARS + 1];
+	char entryPath[PATH_MAX];
+	char* cacheDir = getCacheDir();
+
+	/* Run the command normally if its output is fanned out or its key or the cache directory is unavailable. */
+	if (myCommand->numExtraOutputDests > 0 || computeCacheKey(myCommand, request, key) == FALSE
+	    || makeCacheDir(cacheDir) == FALSE)
+	{
+		runForeground(myCommand, lastFgStatus, NULL);
+		free(cacheDir);
+		return;
+	}
+	snprintf(entryPath, PATH_MAX, "%s/%s", cacheDir, key);
+
+	/* Replay the entry if there is one, and otherwise run the command and store its result. */
+	if (replayCacheEntry(entryPath, myCommand, lastFgStatus) == TRUE)
+	{
+		shellStats.cacheHits++;
+	}
+	else
+	{
+		shellStats.cacheMisses++;
+		runAndStore(myCommand, entryPath, lastFgStatus);
+		evictCacheEntries(cacheDir);
+	}
+	free(cacheDir);
+}
+
+
+/***************************************************************************************
+ * Function Name: computeCacheKey
+ * Description:	Receives a command, the inputs declared to the cached built-in, and a
+ * 		buffer of CACHE_KEY_CHARS + 1 chars. Writes the command's key into the
+ * 		buffer as hex. Every piece is hashed with its length so that different
+ * 		commands cannot run together into the same bytes. Returns FALSE
+ * 		(after reporting it) if an input file cannot be read, or TRUE
+ * 		otherwise.
+ **************************************************************************************/
+
+int computeCacheKey(struct CommandInfo* myCommand, struct CacheRequest* request, char* key)
+{
+	/* Start from the FNV-1a 128-bit offset basis. */
+	unsigned __int128 hash = ((unsigned __int128)0x6c62272e07bb0142ULL << 64) | 0x62b821756295c58dULL;
+	char workingDir[PATH_MAX];
+
+	/* Hash the args and the working directory (which relative paths in the args depend on). */
+	for (int i = 0; myCommand->commandArgs[i] != NULL; i++)
+	{
+		hashCacheString(&hash, myCommand->commandArgs[i]);
+	}
+	hashCacheString(&hash, (getcwd(workingDir, PATH_MAX) != NULL) ? workingDir : "");
+
+	/* Hash the variable assignments, then the value of each requested variable
+	 * (taking an assignment before the command over the shell's environment). */
+	for (int i = 0; i < myCommand->numEnvAssignments; i++)
+	{
+		hashCacheString(&hash, myCommand->envAssignments[i]);
+	}
+	for (int i = 0; i < request->numEnvNames; i++)
+	{
+		char* value = getEnvVar(request->envNames[i]);
+		int nameLength = strlen(request->envNames[i]);
+		for (int j = 0; j < myCommand->numEnvAssignments; j++)
+		{
+			if (strncmp(myCommand->envAssignments[j], request->envNames[i], nameLength) == 0
+			    && myCommand->envAssignments[j][nameLength] == '=')
+			{
+				value = myCommand->envAssignments[j] + nameLength + 1;
+			}
+		}
+		hashCacheString(&hash, request->envNames[i]);
+		hashCacheString(&hash, (value != NULL) ? value : "");
+	}
+
+	/* Hash the contents of the < file and of every declared input file. */
+	if (myCommand->inputFlag == TRUE && hashCacheFile(&hash, myCommand->inputRedirDest) == FALSE)
+	{
+		perror(myCommand->inputRedirDest); fflush(stderr);
+		return FALSE;
+	}
+	for (int i = 0; i < request->numInputFiles; i++)
+	{
+		if (hashCacheFile(&hash, request->inputFiles[i]) == FALSE)
+		{
+			perror(request->inputFiles[i]); fflush(stderr);
+			return FALSE;
+		}
+	}
+
+	/* Write the hash as hex. */
+	snprintf(key, CACHE_KEY_CHARS + 1, "%016llx%016llx",
+		 (unsigned long long)(hash >> 64), (unsigned long long)hash);
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: hashCacheBytes
+ * Description:	Receives a running FNV-1a 128-bit hash and length bytes of data. Adds
+ * 		the data to the hash. Returns nothing.
+ **************************************************************************************/
+
+void hashCacheBytes(unsigned __int128* hash, const void* data, size_t length)
+{
+	/* FNV 128-bit prime: 2^88 + 2^8 + 0x3b. */
+	const unsigned __int128 prime = ((unsigned __int128)1 << 88) | 0x13b;
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		*hash ^= bytes[i];
+		*hash *= prime;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: hashCacheString
+ * Description:	Receives a running hash and a string. Adds the string's length and
+ * 		then its chars to the hash. Returns nothing.
+ **************************************************************************************/
+
+void hashCacheString(unsigned __int128* hash, const char* string)
+{
+	size_t length = strlen(string);
+	hashCacheBytes(hash, &length, sizeof(length));
+	hashCacheBytes(hash, string, length);
+}
+
+
+/***************************************************************************************
+ * Function Name: hashCacheFile
+ * Description:	Receives a running hash and the path of a file. Adds the file's
+ * 		contents and then their length to the hash. Returns FALSE (with errno
+ * 		set) if the file cannot be read, or TRUE otherwise.
+ **************************************************************************************/
+
+int hashCacheFile(unsigned __int128* hash, const char* path)
+{
+	char* chunk = (char*)malloc(CACHE_CHUNK_BYTES);
+	long long totalBytes = 0;
+	ssize_t bytesRead;
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+	{
+		free(chunk);
+		return FALSE;
+	}
+	while ((bytesRead = read(fd, chunk, CACHE_CHUNK_BYTES)) > 0)
+	{
+		hashCacheBytes(hash, chunk, bytesRead);
+		totalBytes += bytesRead;
+	}
+	int savedErrno = errno;
+	close(fd);
+	free(chunk);
+	if (bytesRead == -1)
+	{
+		errno = savedErrno;
+		return FALSE;
+	}
+	hashCacheBytes(hash, &totalBytes, sizeof(totalBytes));
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: getCacheDir
+ * Description:	Returns the path of the cache directory (SMALLSH_CACHE_DIR, or
+ * 		$HOME/.cache/smallsh by default) in newly allocated memory that the
+ * 		caller must free.
+ **************************************************************************************/
+
+char* getCacheDir()
+{
+	char* cacheDir = getEnvVar("SMALLSH_CACHE_DIR");
+	if (cacheDir != NULL && cacheDir[0] != '\0')
+	{
+		return strdup(cacheDir);
+	}
+
+	char* home = getEnvVar("HOME");
+	char* defaultDir = (char*)malloc(PATH_MAX);
+	snprintf(defaultDir, PATH_MAX, "%s/.cache/smallsh", (home != NULL) ? home : ".");
+	return defaultDir;
+}
+
+
+/***************************************************************************************
+ * Function Name: makeCacheDir
+ * Description:	Receives the path of the cache directory. Creates it and any missing
+ * 		parent directories. Returns FALSE (after reporting it) if it cannot be
+ * 		created, or TRUE otherwise.
+ **************************************************************************************/
+
+int makeCacheDir(char* path)
+{
+	/* Create each parent in turn by cutting the path short at each "/". */
+	for (char* slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/'))
+	{
+		*slash = '\0';
+		mkdir(path, 0700);
+		*slash = '/';
+	}
+	if (mkdir(path, 0700) == -1 && errno != EEXIST)
+	{
+		perror(path); fflush(stderr);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: replayCacheEntry
+ * Description:	Receives the path of a cache entry, the command it belongs to, and the
+ * 		ForegroundExitMethod struct. If the entry exists and is intact, writes
+ * 		its output to the command's destination, stores its exit status, and
+ * 		refreshes its modification time (marking it recently used). A damaged
+ * 		entry is deleted. Returns TRUE if the entry was replayed, or FALSE
+ * 		otherwise.
+ **************************************************************************************/
+
+int replayCacheEntry(char* entryPath, struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus)
+{
+	char header[CACHE_HEADER_BYTES + 1];
+	struct stat entryStat;
+	int exitCode;
+	long long outputBytes;
+
+	/* Open the entry and check that its header matches its size. */
+	int entryFd = open(entryPath, O_RDONLY | O_CLOEXEC);
+	if (entryFd == -1)
+	{
+		return FALSE;
+	}
+	memset(header, '\0', sizeof(header));
+	if (read(entryFd, header, CACHE_HEADER_BYTES) != CACHE_HEADER_BYTES
+	    || sscanf(header, "smallsh-cache exit %d size %lld", &exitCode, &outputBytes) != 2
+	    || fstat(entryFd, &entryStat) == -1 || entryStat.st_size != CACHE_HEADER_BYTES + outputBytes)
+	{
+		close(entryFd);
+		unlink(entryPath);
+		return FALSE;
+	}
+
+	/* Copy the output to its destination. */
+	int destFd = openCacheDestination(myCommand);
+	if (destFd == -1)
+	{
+		close(entryFd);
+		setExitMethod(lastFgStatus, 1 << 8);
+		return TRUE;
+	}
+	fflush(stdout);
+	char* chunk = (char*)malloc(CACHE_CHUNK_BYTES);
+	ssize_t bytesRead;
+	while ((bytesRead = read(entryFd, chunk, CACHE_CHUNK_BYTES)) > 0)
+	{
+		if (writeCacheBytes(destFd, chunk, bytesRead) == -1)
+		{
+			perror("cached"); fflush(stderr);
+			break;
+		}
+	}
+	free(chunk);
+	close(entryFd);
+	if (destFd != STDOUT_FILENO)
+	{
+		close(destFd);
+	}
+
+	/* Mark the entry as recently used, and store the exit status. */
+	utimensat(AT_FDCWD, entryPath, NULL, 0);
+	lastFgStatus->code = exitCode;
+	lastFgStatus->exitedNormally = TRUE;
+	lastFgStatus->timedOut = FALSE;
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: openCacheDestination
+ * Description:	Receives a command. Returns the descriptor its output should go to:
+ * 		its > file (opened like executeChild does) or stdout. Returns -1
+ * 		(after reporting it) if the > file cannot be opened.
+ **************************************************************************************/
+
+int openCacheDestination(struct CommandInfo* myCommand)
+{
+	if (myCommand->outputFlag == FALSE)
+	{
+		return STDOUT_FILENO;
+	}
+	int destFd = open(myCommand->outputRedirDest, O_WRONLY | O_TRUNC | O_CREAT | O_CLOEXEC, FILE_PERMISSIONS);
+	if (destFd == -1)
+	{
+		fprintf(stderr, "cannot open %s for output\n", myCommand->outputRedirDest); fflush(stderr);
+	}
+	return destFd;
+}
+
+
+/***************************************************************************************
+ * Function Name: runAndStore
+ * Description:	Receives a command that missed the cache, the path of its entry, and
+ * 		the ForegroundExitMethod struct. Runs the command in the foreground
+ * 		with its stdout going to a pipe, which the event loop copies to the
+ * 		command's destination and to a temporary file. If the command exits
+ * 		normally, the header is filled in and the file is renamed to the
+ * 		entry's path (so readers never see a partial entry). Returns nothing.
+ **************************************************************************************/
+
+void runAndStore(struct CommandInfo* myCommand, char* entryPath, struct ForegroundExitMethod* lastFgStatus)
+{
+	struct CacheCapture capture;
+	char tempPath[PATH_MAX];
+	int pipeFds[2];
+	pid_t childPid;
+	int childExitMethod;
+	struct rusage usage;
+	struct timespec startTime;
+
+	/* Open the destination and the pipe, running the command without the cache if the pipe fails. */
+	if (pipe2(pipeFds, O_CLOEXEC) == -1)
+	{
+		perror("pipe2()"); fflush(stderr);
+		runForeground(myCommand, lastFgStatus, NULL);
+		return;
+	}
+	memset(&capture, 0, sizeof(struct CacheCapture));
+	capture.destFd = openCacheDestination(myCommand);
+	if (capture.destFd == -1)
+	{
+		close(pipeFds[0]);
+		close(pipeFds[1]);
+		setExitMethod(lastFgStatus, 1 << 8);
+		return;
+	}
+	capture.pipeFd = pipeFds[0];
+	fcntl(capture.pipeFd, F_SETFL, O_NONBLOCK);
+
+	/* Create the temporary entry, leaving room for the header (the output is still shown if this fails). */
+	snprintf(tempPath, PATH_MAX, "%s.XXXXXX", entryPath);
+	capture.entryFd = mkstemp(tempPath);
+	if (capture.entryFd != -1)
+	{
+		fcntl(capture.entryFd, F_SETFD, FD_CLOEXEC);
+		lseek(capture.entryFd, CACHE_HEADER_BYTES, SEEK_SET);
+	}
+
+	/* Fork the command, recording the launch like runForeground does. */
+	fflush(stdout);
+	getEnvp();
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	childPid = fork();
+	if (childPid != 0)
+	{
+		recordLaunch(&startTime, childPid);
+	}
+
+	/* In the child, send stdout to the pipe (in place of the > file, which the shell writes) and execute. */
+	if (childPid == 0)
+	{
+		dup2(pipeFds[1], STDOUT_FILENO);
+		myCommand->outputFlag = FALSE;
+		executeChild(myCommand, FALSE, -1, -1, -1);
+	}
+	close(pipeFds[1]);
+
+	if (childPid == -1)
+	{
+		perror("fork()"); fflush(stderr);
+	}
+
+	/* In the parent, copy the output until every writer has closed the pipe, then wait for the child. */
+	else
+	{
+		logCommandStart(myCommand, childPid, FALSE);
+		capture.watcher = addEventWatcher(capture.pipeFd, copyCacheOutput, &capture);
+		while (capture.finished == FALSE)
+		{
+			if (capture.watcher == NULL)
+			{
+				copyCacheOutput(capture.pipeFd, &capture);
+			}
+			else
+			{
+				runEventLoopOnce(-1);
+			}
+		}
+		waitForChild(childPid, &childExitMethod, &usage);
+		logCommandExit(childPid, FALSE, childExitMethod, &startTime, &usage);
+		recordExitMethod(childExitMethod);
+
+		if (WIFSIGNALED(childExitMethod) != 0)
+		{
+			fprintf(shellOutput, "terminated by signal %d\n", WTERMSIG(childExitMethod)); fflush(shellOutput);
+		}
+		setExitMethod(lastFgStatus, childExitMethod);
+	}
+	close(capture.pipeFd);
+	if (capture.destFd != STDOUT_FILENO)
+	{
+		close(capture.destFd);
+	}
+
+	/* Store the entry only if the command ran and exited normally and the entry was written in full,
+	 * and otherwise remove the temporary file (including one abandoned after a failed write). */
+	if (capture.entryFd != -1 || capture.entryFailed == TRUE)
+	{
+		int stored = FALSE;
+		if (capture.entryFd != -1)
+		{
+			if (childPid != -1 && WIFEXITED(childExitMethod) != 0)
+			{
+				char header[CACHE_HEADER_BYTES + 1];
+				snprintf(header, sizeof(header), "smallsh-cache exit %d size %lld",
+					 WEXITSTATUS(childExitMethod), capture.numBytes);
+				memset(header + strlen(header), ' ', CACHE_HEADER_BYTES - strlen(header));
+				header[CACHE_HEADER_BYTES - 1] = '\n';
+				stored = (pwrite(capture.entryFd, header, CACHE_HEADER_BYTES, 0) == CACHE_HEADER_BYTES) ? TRUE : FALSE;
+			}
+			if (close(capture.entryFd) == -1)
+			{
+				stored = FALSE;
+			}
+			if (stored == TRUE && rename(tempPath, entryPath) == -1)
+			{
+				stored = FALSE;
+			}
+			if (stored == FALSE && childPid != -1 && WIFEXITED(childExitMethod) != 0)
+			{
+				perror("cached"); fflush(stderr);
+			}
+		}
+		if (stored == FALSE)
+		{
+			unlink(tempPath);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: copyCacheOutput
+ * Description:	Event loop callback for the pipe receiving a cached command's stdout.
+ * 		Receives the read end and the CacheCapture. Copies everything that can
+ * 		be read without blocking to the command's destination and its
+ * 		temporary entry, marking the capture finished on EOF. If the entry
+ * 		cannot be written, it is abandoned (and removed by runAndStore) but
+ * 		the output is still shown, and if the destination cannot be written,
+ * 		the error is reported once while the entry is still stored.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void copyCacheOutput(int fd, void* arg)
+{
+	struct CacheCapture* capture = (struct CacheCapture*)arg;
+	char chunk[CACHE_CHUNK_BYTES];
+	ssize_t bytesRead;
+
+	while (TRUE)
+	{
+		bytesRead = read(fd, chunk, CACHE_CHUNK_BYTES);
+		if (bytesRead > 0)
+		{
+			if (capture->destFailed == FALSE && writeCacheBytes(capture->destFd, chunk, bytesRead) == -1)
+			{
+				perror("cached"); fflush(stderr);
+				capture->destFailed = TRUE;
+			}
+			if (capture->entryFd != -1 && writeCacheBytes(capture->entryFd, chunk, bytesRead) == -1)
+			{
+				perror("cached"); fflush(stderr);
+				close(capture->entryFd);
+				capture->entryFd = -1;
+				capture->entryFailed = TRUE;
+			}
+			capture->numBytes += bytesRead;
+		}
+		else if (bytesRead == 0)
+		{
+			if (capture->watcher != NULL)
+			{
+				removeEventWatcher(capture->watcher);
+				capture->watcher = NULL;
+			}
+			capture->finished = TRUE;
+			return;
+		}
+		else if (errno != EINTR)
+		{
+			return;
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: compareCacheEntries
+ * Description:	qsort comparison function ordering CacheEntryInfo structs from least
+ * 		to most recently used. Receives pointers to two elements. Returns a
+ * 		negative, zero, or positive value.
+ **************************************************************************************/
+
+static int compareCacheEntries(const void* a, const void* b)
+{
+	const struct timespec* timeA = &((const struct CacheEntryInfo*)a)->lastUsed;
+	const struct timespec* timeB = &((const struct CacheEntryInfo*)b)->lastUsed;
+	if (timeA->tv_sec != timeB->tv_sec)
+	{
+		return (timeA->tv_sec < timeB->tv_sec) ? -1 : 1;
+	}
+	return (timeA->tv_nsec < timeB->tv_nsec) ? -1 : (timeA->tv_nsec > timeB->tv_nsec);
+}
+
+
+/***************************************************************************************
+ * Function Name: writeCacheBytes
+ * Description:	Receives a descriptor, data, and its length. Writes all of the data,
+ * 		continuing after short writes (as to a pipe) and signals. Returns 0,
+ * 		or -1 with errno set if a write fails.
+ **************************************************************************************/
+
+int writeCacheBytes(int fd, char* data, ssize_t numBytes)
+{
+	while (numBytes > 0)
+	{
+		ssize_t bytesWritten = write(fd, data, numBytes);
+		if (bytesWritten == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (bytesWritten <= 0)
+		{
+			errno = (bytesWritten == 0) ? EIO : errno;
+			return -1;
+		}
+		data += bytesWritten;
+		numBytes -= bytesWritten;
+	}
+	return 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: evictCacheEntries
+ * Description:	Receives the path of the cache directory. If its entries take up more
+ * 		than the size limit, deletes the least recently used ones until they
+ * 		fit. Temporary files of runs in progress are left alone.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void evictCacheEntries(char* cacheDir)
+{
+	char path[PATH_MAX];
+	struct dirent* dirEntry;
+	struct stat entryStat;
+	struct CacheEntryInfo* entries = NULL;
+	int numEntries = 0;
+	int entryCapacity = 0;
+	long long totalBytes = 0;
+	long long maxBytes = getCacheMaxBytes();
+
+	/* Collect every entry (named by exactly CACHE_KEY_CHARS chars) with its size and last use. */
+	DIR* dir = opendir(cacheDir);
+	if (dir == NULL)
+	{
+		return;
+	}
+	while ((dirEntry = readdir(dir)) != NULL)
+	{
+		snprintf(path, PATH_MAX, "%s/%s", cacheDir, dirEntry->d_name);
+		if (strlen(dirEntry->d_name) != CACHE_KEY_CHARS || stat(path, &entryStat) == -1)
+		{
+			continue;
+		}
+		if (numEntries == entryCapacity)
+		{
+			entryCapacity = (entryCapacity == 0) ? 64 : 2 * entryCapacity;
+			entries = (struct CacheEntryInfo*)realloc(entries, entryCapacity * sizeof(struct CacheEntryInfo));
+		}
+		strcpy(entries[numEntries].name, dirEntry->d_name);
+		entries[numEntries].size = entryStat.st_size;
+		entries[numEntries].lastUsed = entryStat.st_mtim;
+		totalBytes += entryStat.st_size;
+		numEntries++;
+	}
+	closedir(dir);
+
+	/* Delete the least recently used entries until the rest fit. */
+	if (totalBytes > maxBytes)
+	{
+		qsort(entries, numEntries, sizeof(struct CacheEntryInfo), compareCacheEntries);
+		for (int i = 0; i < numEntries && totalBytes > maxBytes; i++)
+		{
+			snprintf(path, PATH_MAX, "%s/%s", cacheDir, entries[i].name);
+			if (unlink(path) == 0)
+			{
+				totalBytes -= entries[i].size;
+				shellStats.cacheEvictions++;
+			}
+		}
+	}
+	free(entries);
+}
+
+
+/***************************************************************************************
+ * Function Name: getCacheMaxBytes
+ * Description:	Returns the size limit of the cache directory in bytes
+ * 		(SMALLSH_CACHE_MAX_KB, or DEFAULT_CACHE_MAX_KB if it is not set).
+ **************************************************************************************/
+
+long long getCacheMaxBytes()
+{
+	char* maxKb = getEnvVar("SMALLSH_CACHE_MAX_KB");
+	if (maxKb != NULL && atoll(maxKb) > 0)
+	{
+		return atoll(maxKb) * 1024;
+	}
+	return (long long)DEFAULT_CACHE_MAX_KB * 1024;
+}
+
+
+/***************************************************************************************
+ * Function Name: printCacheStats
+ * Description:	Prints the hits, misses, and evictions counted by this shell and the
+ * 		number and total size of the entries in the cache directory.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void printCacheStats()
+{
+	char path[PATH_MAX];
+	struct dirent* dirEntry;
+	struct stat entryStat;
+	int numEntries = 0;
+	long long totalBytes = 0;
+	char* cacheDir = getCacheDir();
+
+	DIR* dir = opendir(cacheDir);
+	if (dir != NULL)
+	{
+		while ((dirEntry = readdir(dir)) != NULL)
+		{
+			snprintf(path, PATH_MAX, "%s/%s", cacheDir, dirEntry->d_name);
+			if (strlen(dirEntry->d_name) == CACHE_KEY_CHARS && stat(path, &entryStat) == 0)
+			{
+				numEntries++;
+				totalBytes += entryStat.st_size;
+			}
+		}
+		closedir(dir);
+	}
+
+	printf("cache %s\nhits %lu\nmisses %lu\nevictions %lu\nentries %d\nbytes %lld (limit %lld)\n",
+	       cacheDir, shellStats.cacheHits, shellStats.cacheMisses, shellStats.cacheEvictions,
+	       numEntries, totalBytes, getCacheMaxBytes());
+	fflush(stdout);
+	free(cacheDir);
+}
@@ -0,0 +1,76 @@
+/***************************************************************************************
+ * File: densmora.resultCache.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions behind the cached built-in, which replays the output
+ * 		and exit status of deterministic commands from a content-addressed
+ * 		cache directory. See densmora.resultCache.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_RESULT_CACHE
+#define DENSMORA_RESULT_CACHE
+
+/* Built-in header file inclusions. */
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+
+/* Default size limit (in KiB) of the cache directory. */
+#define DEFAULT_CACHE_MAX_KB 65536
+
+/* Size of the fixed-width header at the start of every cache entry. */
+#define CACHE_HEADER_BYTES 64
+
+/* Size of the chunks read from files and pipes. */
+#define CACHE_CHUNK_BYTES 65536
+
+/* Number of hex digits in a cache key (a 128-bit hash). */
+#define CACHE_KEY_CHARS 32
+
+/* Struct storing the inputs declared to the cached built-in. */
+
+struct CacheRequest
+{
+	char** inputFiles;			/* Files (besides the < file) whose contents are part of the key. */
+	int numInputFiles;			/* Number of strings in inputFiles. */
+	char** envNames;			/* Environment variables whose values are part of the key. */
+	int numEnvNames;			/* Number of strings in envNames. */
+};
+
+/* Struct storing the state of a command whose output is being copied into a new cache entry. */
+
+struct CacheCapture
+{
+	int pipeFd;				/* Read end of the pipe receiving the command's stdout. */
+	int destFd;				/* Where the output goes (stdout or the > file). */
+	int entryFd;				/* Temporary cache entry, or -1 if the output is not being stored. */
+	int entryFailed;			/* Set to TRUE once a write to the entry failed (and it was closed). */
+	int destFailed;				/* Set to TRUE once a write to destFd failed (and was reported). */
+	long long numBytes;			/* Number of bytes of output copied so far. */
+	int finished;				/* Set to TRUE once the pipe reaches EOF. */
+	struct EventWatcher* watcher;		/* Event loop watcher of pipeFd. */
+};
+
+/* Function prototypes (see densmora.resultCache.c for function descriptions and implementations). */
+void runCached(struct CommandInfo* myCommand, struct CacheRequest* request, struct ForegroundExitMethod* lastFgStatus);
+int computeCacheKey(struct CommandInfo* myCommand, struct CacheRequest* request, char* key);
+void hashCacheBytes(unsigned __int128* hash, const void* data, size_t length);
+void hashCacheString(unsigned __int128* hash, const char* string);
+int hashCacheFile(unsigned __int128* hash, const char* path);
+char* getCacheDir();
+int makeCacheDir(char* path);
+int replayCacheEntry(char* entryPath, struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus);
+int openCacheDestination(struct CommandInfo* myCommand);
+void runAndStore(struct CommandInfo* myCommand, char* entryPath, struct ForegroundExitMethod* lastFgStatus);
+void copyCacheOutput(int fd, void* arg);
+int writeCacheBytes(int fd, char* data, ssize_t numBytes);
+void evictCacheEntries(char* cacheDir);
+long long getCacheMaxBytes();
+void printCacheStats();
+
+#endif
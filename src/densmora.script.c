@@ -0,0 +1,1624 @@
+/***************************************************************************************
+ * File: densmora.script.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that parse
+ * 		and run the shell's control flow: lists joined by ;, &&, ||, &, and
+ * 		newlines, if/elif/else, while and until loops, for loops, { } groups,
+ * 		and functions. A line (or a block of lines typed at the "> " prompt
+ * 		until it is complete) is split into tokens and parsed into a tree by
+ * 		recursive descent, and the tree is then run by the shell itself.
+ * 		Only the simple commands at its leaves are parsed and dispatched like
+ * 		a line of their own, so a loop forks only for the programs it runs,
+ * 		and conditions, && and || decide from the exit status recorded in the
+ * 		ForegroundExitMethod struct. Commands skipped by a condition are never
+ * 		parsed, let alone forked.
+ **************************************************************************************/
+
+#include "densmora.script.h"
+
+/* Table of defined functions, indexed by the hash of their names. It is global (like the table of
+ * aliases) because a function defined by one line is called from later lines. */
+static struct ScriptFunction* scriptFunctions[FUNCTION_BUCKETS];
+
+
+/***************************************************************************************
+ * Function Name: runScriptLine
+ * Description:	Receives the ScriptBuffer holding the lines of a block still being
+ * 		typed (if any), the next line, the ForegroundExitMethod struct, and
+ * 		the BackgroundCommands list. Adds the line to the buffer and parses
+ * 		it. If a statement is still open (such as an if without its fi),
+ * 		keeps the buffer so that the next line continues it. Otherwise empties
+ * 		the buffer and runs what was parsed (nothing if it held a syntax
+ * 		error, which is reported). Returns TRUE if a command was "exit" (in
+ * 		which case the caller should free memory and end the shell), or FALSE
+ * 		otherwise.
+ **************************************************************************************/
+
+int runScriptLine(struct ScriptBuffer* buffer, char* line, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList)
+{
+	struct ScriptStatement* tree = NULL;
+	size_t lineLength = strlen(line);
+
+	/* Add the line to the block, after a newline if it continues one. */
+	buffer->text = (char*)realloc(buffer->text, buffer->length + lineLength + 2);
+	if (buffer->length > 0)
+	{
+		buffer->text[buffer->length++] = '\n';
+	}
+	memcpy(buffer->text + buffer->length, line, lineLength + 1);
+	buffer->length += lineLength;
+
+	/* Wait for more lines if the block is incomplete, and otherwise run it if it parsed. */
+	int result = parseScript(buffer->text, &tree);
+	if (result == PARSE_INCOMPLETE)
+	{
+		return FALSE;
+	}
+	discardScriptBuffer(buffer);
+	return (result == PARSE_COMPLETE) ? runScriptTree(tree, lastFgStatus, bgCommandsList) : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: isScriptIncomplete
+ * Description:	Receives a ScriptBuffer. Returns TRUE if it holds the start of a
+ * 		block that needs more lines, or FALSE otherwise.
+ **************************************************************************************/
+
+int isScriptIncomplete(struct ScriptBuffer* buffer)
+{
+	return (buffer->text != NULL) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: discardScriptBuffer
+ * Description:	Receives a ScriptBuffer. Frees the lines it holds and empties it.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void discardScriptBuffer(struct ScriptBuffer* buffer)
+{
+	free(buffer->text);
+	buffer->text = NULL;
+	buffer->length = 0;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseScript
+ * Description:	Receives the text of a script (one or more lines) and the address at
+ * 		which to store its tree. Splits a copy of the text into tokens and
+ * 		parses them. Returns PARSE_COMPLETE (with the tree stored, or NULL if
+ * 		the text held no commands), PARSE_INCOMPLETE if the text ends inside
+ * 		a statement, or PARSE_ERROR after reporting a syntax error (storing
+ * 		NULL in either case).
+ **************************************************************************************/
+
+int parseScript(char* text, struct ScriptStatement** tree)
+{
+	struct ScriptParser parser;
+	parser.text = strdup(text);
+	parser.tokens = tokenizeScript(parser.text);
+	parser.position = 0;
+	parser.result = PARSE_COMPLETE;
+
+	/* Parse the list making up the script, which must use every token (it stops early at a closing
+	 * word such as "fi" that closes nothing). */
+	*tree = parseList(&parser);
+	if (parser.result == PARSE_COMPLETE && parser.tokens[parser.position].type != TOKEN_END)
+	{
+		failParse(&parser);
+	}
+	if (parser.result != PARSE_COMPLETE)
+	{
+		deleteStatements(*tree);
+		*tree = NULL;
+	}
+
+	/* The tree holds copies of everything it needs from the tokens. */
+	free(parser.tokens);
+	free(parser.text);
+	return parser.result;
+}
+
+
+/***************************************************************************************
+ * Function Name: tokenizeScript
+ * Description:	Receives the text of a script (which is modified so that each word
+ * 		ends with a null terminator). Splits it into words separated by spaces
+ * 		and newlines, turning ";", "&&", "||", "&", and newlines into
+ * 		operator tokens, and splitting a word ending in ";" into the word and
+ * 		a ";". A word starting with "#" where a command could start ends its
+ * 		line as a comment. Returns an allocated array of tokens ending with
+ * 		TOKEN_END.
+ **************************************************************************************/
+
+struct ScriptToken* tokenizeScript(char* text)
+{
+	/* Every char adds at most one token (a word ending in ";" has at least two chars). */
+	struct ScriptToken* tokens = (struct ScriptToken*)malloc((strlen(text) + 1) * sizeof(struct ScriptToken));
+	int numTokens = 0;
+	int atCommandStart = TRUE;	/* Set to TRUE while the next word could start a command. */
+	char* cursor = text;
+
+	while (*cursor != '\0')
+	{
+		/* Skip spaces, and turn each newline into a token. */
+		if (*cursor == ' ' || *cursor == '\n')
+		{
+			if (*cursor == '\n')
+			{
+				tokens[numTokens].type = TOKEN_NEWLINE;
+				tokens[numTokens++].word = NULL;
+				atCommandStart = TRUE;
+			}
+			cursor++;
+			continue;
+		}
+
+		/* Skip a comment up to (but not including) the end of its line. */
+		if (*cursor == '#' && atCommandStart == TRUE)
+		{
+			cursor += strcspn(cursor, "\n");
+			continue;
+		}
+
+		/* End the word, noting a newline right after it (which becomes a token once the word is added). */
+		char* word = cursor;
+		size_t wordLength = strcspn(cursor, " \n");
+		cursor += wordLength;
+		int endsLine = (*cursor == '\n') ? TRUE : FALSE;
+		if (*cursor != '\0')
+		{
+			*cursor++ = '\0';
+		}
+
+		/* Turn operators into their tokens. */
+		int type = TOKEN_WORD;
+		if (strcmp(word, ";") == 0)
+		{
+			type = TOKEN_SEMICOLON;
+		}
+		else if (strcmp(word, "&&") == 0)
+		{
+			type = TOKEN_AND;
+		}
+		else if (strcmp(word, "||") == 0)
+		{
+			type = TOKEN_OR;
+		}
+		else if (strcmp(word, "&") == 0)
+		{
+			type = TOKEN_AMPERSAND;
+		}
+		tokens[numTokens].type = type;
+		tokens[numTokens++].word = word;
+		atCommandStart = (type != TOKEN_WORD || (atCommandStart == TRUE && startsCommand(word) == TRUE)) ? TRUE : FALSE;
+
+		/* Split a ";" from the end of a word. */
+		if (type == TOKEN_WORD && wordLength > 1 && word[wordLength - 1] == ';')
+		{
+			word[wordLength - 1] = '\0';
+			tokens[numTokens].type = TOKEN_SEMICOLON;
+			tokens[numTokens++].word = ";";
+			atCommandStart = TRUE;
+		}
+		if (endsLine == TRUE)
+		{
+			tokens[numTokens].type = TOKEN_NEWLINE;
+			tokens[numTokens++].word = NULL;
+			atCommandStart = TRUE;
+		}
+	}
+	tokens[numTokens].type = TOKEN_END;
+	tokens[numTokens].word = NULL;
+	return tokens;
+}
+
+
+/***************************************************************************************
+ * Function Name: startsCommand
+ * Description:	Receives a word found where a command could start. Returns TRUE if
+ * 		it is a reserved word after which another command could start (such
+ * 		as "then" or "do"), or FALSE otherwise.
+ **************************************************************************************/
+
+int startsCommand(char* word)
+{
+	return (isReservedWord(word) == TRUE && strcmp(word, "for") != 0 && strcmp(word, "in") != 0
+		&& strcmp(word, "function") != 0) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseList
+ * Description:	Receives the parser. Parses statements joined by ";", "&&", "||",
+ * 		"&", and newlines, up to the end of the script or a word closing the
+ * 		statement around the list (such as "fi"), which is left for the
+ * 		caller. Returns the first statement of the list (or NULL if it is
+ * 		empty), which is partial if the parser's result is no longer
+ * 		PARSE_COMPLETE.
+ **************************************************************************************/
+
+struct ScriptStatement* parseList(struct ScriptParser* parser)
+{
+	struct ScriptStatement* head = NULL;
+	struct ScriptStatement** link = &head;
+	int joinOperator = LIST_ALWAYS;
+
+	skipNewlines(parser);
+	while (parser->result == PARSE_COMPLETE)
+	{
+		/* Stop at the end or a closing word, unless an && or || still needs a statement after it. */
+		struct ScriptToken* token = &parser->tokens[parser->position];
+		if (token->type == TOKEN_END || (token->type == TOKEN_WORD && isClosingWord(token->word) == TRUE))
+		{
+			if (joinOperator != LIST_ALWAYS)
+			{
+				failParse(parser);
+			}
+			break;
+		}
+		if (token->type != TOKEN_WORD)
+		{
+			failParse(parser);
+			break;
+		}
+
+		/* Add the statement to the list. */
+		struct ScriptStatement* statement = parseStatement(parser);
+		statement->joinOperator = joinOperator;
+		*link = statement;
+		link = &statement->next;
+		if (parser->result != PARSE_COMPLETE)
+		{
+			break;
+		}
+
+		/* Find the operator joining the next statement. Only ";" or a newline may follow a command
+		 * already ended by "&", which may also be followed directly by the next statement. */
+		int afterAmpersand = (parser->tokens[parser->position - 1].type == TOKEN_AMPERSAND) ? TRUE : FALSE;
+		token = &parser->tokens[parser->position];
+		joinOperator = LIST_ALWAYS;
+		if ((token->type == TOKEN_AND || token->type == TOKEN_OR) && afterAmpersand == FALSE)
+		{
+			joinOperator = (token->type == TOKEN_AND) ? LIST_AND : LIST_OR;
+			parser->position++;
+			skipNewlines(parser);
+		}
+		else if (token->type == TOKEN_SEMICOLON || token->type == TOKEN_NEWLINE)
+		{
+			parser->position++;
+			skipNewlines(parser);
+		}
+		else if (afterAmpersand == FALSE && token->type != TOKEN_END
+			 && (token->type != TOKEN_WORD || isClosingWord(token->word) == FALSE))
+		{
+			failParse(parser);
+		}
+	}
+	return head;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseStatement
+ * Description:	Receives the parser, whose next token is a word that does not close
+ * 		a statement. Parses the statement starting there. Returns the
+ * 		statement (which is partial if the parser's result is no longer
+ * 		PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseStatement(struct ScriptParser* parser)
+{
+	char* word = parser->tokens[parser->position].word;
+	size_t wordLength = strlen(word);
+
+	if (strcmp(word, "if") == 0)
+	{
+		return parseIf(parser);
+	}
+	if (strcmp(word, "while") == 0 || strcmp(word, "until") == 0)
+	{
+		return parseLoop(parser);
+	}
+	if (strcmp(word, "for") == 0)
+	{
+		return parseFor(parser);
+	}
+	if (strcmp(word, "{") == 0)
+	{
+		return parseGroup(parser);
+	}
+	if (strcmp(word, "function") == 0 || (wordLength > 2 && strcmp(word + wordLength - 2, "()") == 0)
+	    || (parser->tokens[parser->position + 1].type == TOKEN_WORD && strcmp(parser->tokens[parser->position + 1].word, "()") == 0))
+	{
+		return parseFunction(parser);
+	}
+
+	/* Anything else is a simple command, of which break, continue, and return are run by the shell itself. */
+	struct ScriptStatement* statement = parseSimpleCommand(parser);
+	if (strcmp(word, "break") == 0)
+	{
+		statement->type = STATEMENT_BREAK;
+	}
+	else if (strcmp(word, "continue") == 0)
+	{
+		statement->type = STATEMENT_CONTINUE;
+	}
+	else if (strcmp(word, "return") == 0)
+	{
+		statement->type = STATEMENT_RETURN;
+	}
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseSimpleCommand
+ * Description:	Receives the parser, whose next token is a word. Parses a simple
+ * 		command made of the words up to the next operator, keeping a
+ * 		following "&" at its end so that it runs in the background. Returns
+ * 		the statement.
+ **************************************************************************************/
+
+struct ScriptStatement* parseSimpleCommand(struct ScriptParser* parser)
+{
+	struct ScriptStatement* statement = newStatement(STATEMENT_COMMAND);
+	statement->text = joinWords(parser);
+	if (parser->tokens[parser->position].type == TOKEN_AMPERSAND)
+	{
+		size_t textLength = strlen(statement->text);
+		statement->text = (char*)realloc(statement->text, textLength + 3);
+		strcpy(statement->text + textLength, " &");
+		parser->position++;
+	}
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseIf
+ * Description:	Receives the parser, whose next token is "if" or "elif". Parses
+ * 		"if list; then list; [elif list; then list;]... [else list;] fi",
+ * 		where each elif is parsed as an if in the else-part of the one before
+ * 		it (sharing its fi). Returns the statement (which is partial if the
+ * 		parser's result is no longer PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseIf(struct ScriptParser* parser)
+{
+	struct ScriptStatement* statement = newStatement(STATEMENT_IF);
+	parser->position++;
+
+	statement->condition = parseBody(parser, "then");
+	if (parser->result != PARSE_COMPLETE)
+	{
+		return statement;
+	}
+	statement->body = parseBody(parser, NULL);
+	if (parser->result != PARSE_COMPLETE)
+	{
+		return statement;
+	}
+
+	/* The then-part ends at elif, else, or fi. */
+	if (isNextWord(parser, "elif") == TRUE)
+	{
+		statement->elseBody = parseIf(parser);
+	}
+	else if (isNextWord(parser, "else") == TRUE)
+	{
+		parser->position++;
+		statement->elseBody = parseBody(parser, "fi");
+	}
+	else
+	{
+		expectWord(parser, "fi");
+	}
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseLoop
+ * Description:	Receives the parser, whose next token is "while" or "until". Parses
+ * 		"while list; do list; done" (or the same with until). Returns the
+ * 		statement (which is partial if the parser's result is no longer
+ * 		PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseLoop(struct ScriptParser* parser)
+{
+	int type = (strcmp(parser->tokens[parser->position].word, "while") == 0) ? STATEMENT_WHILE : STATEMENT_UNTIL;
+	struct ScriptStatement* statement = newStatement(type);
+	parser->position++;
+
+	statement->condition = parseBody(parser, "do");
+	if (parser->result == PARSE_COMPLETE)
+	{
+		statement->body = parseBody(parser, "done");
+	}
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseFor
+ * Description:	Receives the parser, whose next token is "for". Parses
+ * 		"for name in words; do list; done", or "for name; do list; done" to
+ * 		loop over the args of the function being run. Returns the statement
+ * 		(which is partial if the parser's result is no longer PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseFor(struct ScriptParser* parser)
+{
+	struct ScriptStatement* statement = newStatement(STATEMENT_FOR);
+	parser->position++;
+
+	/* Take the name of the loop's variable. */
+	struct ScriptToken* token = &parser->tokens[parser->position];
+	if (token->type != TOKEN_WORD || isValidEnvName(token->word) == FALSE || isReservedWord(token->word) == TRUE)
+	{
+		failParse(parser);
+		return statement;
+	}
+	statement->text = strdup(token->word);
+	parser->position++;
+
+	/* Take the words after "in", which must end with ";" or a newline. Without "in", the ";" is optional. */
+	if (isNextWord(parser, "in") == TRUE)
+	{
+		parser->position++;
+		statement->words = (parser->tokens[parser->position].type == TOKEN_WORD) ? joinWords(parser) : strdup("");
+		token = &parser->tokens[parser->position];
+		if (token->type != TOKEN_SEMICOLON && token->type != TOKEN_NEWLINE)
+		{
+			failParse(parser);
+			return statement;
+		}
+		parser->position++;
+	}
+	else if (parser->tokens[parser->position].type == TOKEN_SEMICOLON)
+	{
+		parser->position++;
+	}
+	skipNewlines(parser);
+
+	expectWord(parser, "do");
+	if (parser->result == PARSE_COMPLETE)
+	{
+		statement->body = parseBody(parser, "done");
+	}
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseGroup
+ * Description:	Receives the parser, whose next token is "{". Parses "{ list; }",
+ * 		which runs the list as one statement (so that && or || can be
+ * 		applied to all of it). Returns the statement (which is partial if the
+ * 		parser's result is no longer PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseGroup(struct ScriptParser* parser)
+{
+	struct ScriptStatement* statement = newStatement(STATEMENT_GROUP);
+	parser->position++;
+	statement->body = parseBody(parser, "}");
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseFunction
+ * Description:	Receives the parser, whose next token starts a function definition:
+ * 		"function name { list; }" or "name() { list; }" (where "()" may also
+ * 		be a word of its own, and may follow the name after "function").
+ * 		Returns the statement, which holds the new function (and is partial
+ * 		if the parser's result is no longer PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseFunction(struct ScriptParser* parser)
+{
+	struct ScriptStatement* statement = newStatement(STATEMENT_FUNCTION);
+
+	/* Take the name (after "function" if it is used), removing or skipping the "()" after it. */
+	if (isNextWord(parser, "function") == TRUE)
+	{
+		parser->position++;
+		if (parser->tokens[parser->position].type != TOKEN_WORD)
+		{
+			failParse(parser);
+			return statement;
+		}
+	}
+	char* name = parser->tokens[parser->position++].word;
+	size_t nameLength = strlen(name);
+	if (nameLength > 2 && strcmp(name + nameLength - 2, "()") == 0)
+	{
+		name[nameLength - 2] = '\0';
+	}
+	else if (isNextWord(parser, "()") == TRUE)
+	{
+		parser->position++;
+	}
+	if (isValidEnvName(name) == FALSE || isReservedWord(name) == TRUE)
+	{
+		fprintf(stderr, "syntax error near %s\n", name); fflush(stderr);
+		parser->result = PARSE_ERROR;
+		return statement;
+	}
+
+	/* Create the function (held by the statement), and parse its body. */
+	struct ScriptFunction* function = (struct ScriptFunction*)malloc(sizeof(struct ScriptFunction));
+	function->name = strdup(name);
+	function->body = NULL;
+	function->numHolders = 1;
+	function->next = NULL;
+	statement->function = function;
+	skipNewlines(parser);
+	expectWord(parser, "{");
+	if (parser->result == PARSE_COMPLETE)
+	{
+		function->body = parseBody(parser, "}");
+	}
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: parseBody
+ * Description:	Receives the parser and the word that must close the body (or NULL
+ * 		if the caller checks which word closes it). Parses a list, which may
+ * 		not be empty, and the closing word. Returns the list (which is partial
+ * 		if the parser's result is no longer PARSE_COMPLETE).
+ **************************************************************************************/
+
+struct ScriptStatement* parseBody(struct ScriptParser* parser, char* closingWord)
+{
+	struct ScriptStatement* body = parseList(parser);
+	if (parser->result == PARSE_COMPLETE && body == NULL)
+	{
+		failParse(parser);
+	}
+	if (parser->result == PARSE_COMPLETE && closingWord != NULL)
+	{
+		expectWord(parser, closingWord);
+	}
+	return body;
+}
+
+
+/***************************************************************************************
+ * Function Name: joinWords
+ * Description:	Receives the parser, whose next token is a word. Takes the words up
+ * 		to the next operator. Returns an allocated string holding them,
+ * 		separated by single spaces.
+ **************************************************************************************/
+
+char* joinWords(struct ScriptParser* parser)
+{
+	size_t textLength = 0;
+	int end = parser->position;
+	while (parser->tokens[end].type == TOKEN_WORD)
+	{
+		textLength += strlen(parser->tokens[end++].word) + 1;
+	}
+
+	char* text = (char*)malloc(textLength + 1);
+	char* textEnd = text;
+	for (; parser->position < end; parser->position++)
+	{
+		if (textEnd != text)
+		{
+			*textEnd++ = ' ';
+		}
+		textEnd = stpcpy(textEnd, parser->tokens[parser->position].word);
+	}
+	*textEnd = '\0';
+	return text;
+}
+
+
+/***************************************************************************************
+ * Function Name: expectWord
+ * Description:	Receives the parser and a reserved word. Skips the next token if it
+ * 		is that word, or otherwise fails the parse. Returns nothing.
+ **************************************************************************************/
+
+void expectWord(struct ScriptParser* parser, char* word)
+{
+	if (isNextWord(parser, word) == TRUE)
+	{
+		parser->position++;
+	}
+	else
+	{
+		failParse(parser);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: isNextWord
+ * Description:	Receives the parser and a word. Returns TRUE if the next token is
+ * 		that word, or FALSE otherwise.
+ **************************************************************************************/
+
+int isNextWord(struct ScriptParser* parser, char* word)
+{
+	struct ScriptToken* token = &parser->tokens[parser->position];
+	return (token->type == TOKEN_WORD && strcmp(token->word, word) == 0) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: skipNewlines
+ * Description:	Receives the parser. Skips any newlines at its position. Returns
+ * 		nothing.
+ **************************************************************************************/
+
+void skipNewlines(struct ScriptParser* parser)
+{
+	while (parser->tokens[parser->position].type == TOKEN_NEWLINE)
+	{
+		parser->position++;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: failParse
+ * Description:	Receives the parser, whose next token cannot be parsed. If it is the
+ * 		end of the script, notes that more lines are needed, and otherwise
+ * 		reports a syntax error at it. Returns nothing.
+ **************************************************************************************/
+
+void failParse(struct ScriptParser* parser)
+{
+	struct ScriptToken* token = &parser->tokens[parser->position];
+	if (parser->result != PARSE_COMPLETE)
+	{
+		return;
+	}
+	if (token->type == TOKEN_END)
+	{
+		parser->result = PARSE_INCOMPLETE;
+		return;
+	}
+	fprintf(stderr, "syntax error near %s\n", (token->type == TOKEN_NEWLINE) ? "newline" : token->word);
+	fflush(stderr);
+	parser->result = PARSE_ERROR;
+}
+
+
+/***************************************************************************************
+ * Function Name: isReservedWord
+ * Description:	Receives a word. Returns TRUE if it has a meaning of its own where a
+ * 		statement starts (and so cannot name a function or loop variable), or
+ * 		FALSE otherwise.
+ **************************************************************************************/
+
+int isReservedWord(char* word)
+{
+	static char* reservedWords[] = { "if", "then", "elif", "else", "fi", "while", "until", "for", "in",
+					 "do", "done", "function", "{", "}", NULL };
+
+	for (int i = 0; reservedWords[i] != NULL; i++)
+	{
+		if (strcmp(word, reservedWords[i]) == 0)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: isClosingWord
+ * Description:	Receives a word. Returns TRUE if it ends a list within a statement
+ * 		(then, elif, else, fi, do, done, or }), or FALSE otherwise.
+ **************************************************************************************/
+
+int isClosingWord(char* word)
+{
+	return (strcmp(word, "then") == 0 || strcmp(word, "elif") == 0 || strcmp(word, "else") == 0
+		|| strcmp(word, "fi") == 0 || strcmp(word, "do") == 0 || strcmp(word, "done") == 0
+		|| strcmp(word, "}") == 0) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: newStatement
+ * Description:	Receives a kind of statement. Allocates a ScriptStatement struct of
+ * 		that kind with every other member empty. Returns the pointer to it.
+ **************************************************************************************/
+
+struct ScriptStatement* newStatement(int type)
+{
+	struct ScriptStatement* statement = (struct ScriptStatement*)malloc(sizeof(struct ScriptStatement));
+	statement->type = type;
+	statement->joinOperator = LIST_ALWAYS;
+	statement->text = NULL;
+	statement->words = NULL;
+	statement->condition = NULL;
+	statement->body = NULL;
+	statement->elseBody = NULL;
+	statement->function = NULL;
+	statement->next = NULL;
+	return statement;
+}
+
+
+/***************************************************************************************
+ * Function Name: deleteStatements
+ * Description:	Receives the first statement of a list (or NULL). Frees it and every
+ * 		statement after it and within it, letting go of the functions they
+ * 		define. Returns nothing.
+ **************************************************************************************/
+
+void deleteStatements(struct ScriptStatement* statement)
+{
+	while (statement != NULL)
+	{
+		struct ScriptStatement* next = statement->next;
+		free(statement->text);
+		free(statement->words);
+		deleteStatements(statement->condition);
+		deleteStatements(statement->body);
+		deleteStatements(statement->elseBody);
+		if (statement->function != NULL)
+		{
+			releaseScriptFunction(statement->function);
+		}
+		free(statement);
+		statement = next;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: runScriptTree
+ * Description:	Receives a parsed tree (or NULL), the ForegroundExitMethod struct, and
+ * 		the BackgroundCommands list. Runs the tree and then frees it, along
+ * 		with any loop variables it set. Returns TRUE if a command was "exit",
+ * 		or FALSE otherwise.
+ **************************************************************************************/
+
+int runScriptTree(struct ScriptStatement* tree, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList)
+{
+	struct ScriptFrame frame = { FALSE, NULL, 0, NULL };
+	struct ScriptContext context = { lastFgStatus, bgCommandsList, &frame, 0, 0, 0, 0 };
+	int succeeded = TRUE;
+
+	int flow = runStatements(tree, &context, &succeeded);
+	deleteScriptVariables(&frame);
+	deleteStatements(tree);
+	return (flow == FLOW_EXIT) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: runStatements
+ * Description:	Receives the first statement of a list, the ScriptContext, and the
+ * 		address of a flag holding whether the last statement that ran
+ * 		succeeded. Runs each statement in order, skipping one joined by "&&"
+ * 		if the last statement that ran failed and one joined by "||" if it
+ * 		succeeded, until one ends the list early (such as break). Returns the
+ * 		FLOW value with which the list ended.
+ **************************************************************************************/
+
+int runStatements(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	int flow = FLOW_NEXT;
+
+	for (; statement != NULL && flow == FLOW_NEXT; statement = statement->next)
+	{
+		if ((statement->joinOperator == LIST_AND && *succeeded == FALSE)
+		    || (statement->joinOperator == LIST_OR && *succeeded == TRUE))
+		{
+			continue;
+		}
+		flow = runStatement(statement, context, succeeded);
+	}
+	return flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: runStatement
+ * Description:	Receives a statement, the ScriptContext, and the address of the flag
+ * 		in which to store whether it succeeded. Runs the statement according
+ * 		to its kind. Returns the FLOW value with which it ended.
+ **************************************************************************************/
+
+int runStatement(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	switch (statement->type)
+	{
+		case STATEMENT_COMMAND:
+			return runSimpleCommand(statement, context, succeeded);
+		case STATEMENT_IF:
+			return runIf(statement, context, succeeded);
+		case STATEMENT_WHILE:
+		case STATEMENT_UNTIL:
+			return runLoop(statement, context, succeeded);
+		case STATEMENT_FOR:
+			return runFor(statement, context, succeeded);
+		case STATEMENT_GROUP:
+			return runStatements(statement->body, context, succeeded);
+		case STATEMENT_FUNCTION:
+			defineScriptFunction(statement->function);
+			setScriptStatus(context->lastFgStatus, 0);
+			*succeeded = TRUE;
+			return FLOW_NEXT;
+		default:
+			return runFlowStatement(statement, context, succeeded);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: runSimpleCommand
+ * Description:	Receives a simple command, the ScriptContext, and the address of the
+ * 		flag in which to store whether it succeeded. Expands the loop
+ * 		variables and function args in it and then an alias at its start,
+ * 		parses it like a line of its own, and calls the function it names or
+ * 		otherwise dispatches it. A command run in the background counts as
+ * 		succeeding and one that cannot be parsed as failing. Returns
+ * 		FLOW_EXIT if it was "exit", FLOW_INTERRUPT if it was a foreground
+ * 		command interrupted by SIGINT (or SIGINT was received during a loop),
+ * 		or what ended the function it called.
+ **************************************************************************************/
+
+int runSimpleCommand(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	struct ForegroundExitMethod* lastFgStatus = context->lastFgStatus;
+	int flow = FLOW_NEXT;
+
+	/* Parse the command, counting it as failing if it cannot be parsed. */
+	char* text = expandScriptVariables(statement->text, context->frame);
+	char* expanded = expandAlias(text);
+	struct CommandInfo* myCommand = newCommandFromLine((expanded != NULL) ? expanded : text);
+	free(expanded);
+	free(text);
+	if (myCommand == NULL)
+	{
+		*succeeded = FALSE;
+		return (checkForSIGINT(context) == TRUE) ? FLOW_INTERRUPT : FLOW_NEXT;
+	}
+	shellStats.commandsExecuted++;
+
+	/* Call a function in the shell itself, which its args are only passed to (so it can be neither
+	 * redirected nor run in the background). */
+	struct ScriptFunction* function = (myCommand->commandArgs[0] != NULL) ? getScriptFunction(myCommand->commandArgs[0]) : NULL;
+	if (function != NULL)
+	{
+		if (myCommand->backgroundFlag == TRUE || myCommand->inputFlag == TRUE || myCommand->outputFlag == TRUE
+		    || myCommand->numEnvAssignments > 0)
+		{
+			fprintf(stderr, "%s: functions cannot be redirected or run in the background\n", function->name);
+			fflush(stderr);
+			setUsageError(lastFgStatus);
+		}
+		else
+		{
+			flow = callScriptFunction(function, myCommand->commandArgs, context);
+		}
+		*succeeded = lastCommandSucceeded(lastFgStatus);
+	}
+
+	/* Otherwise, run the command, and note whether it succeeded. */
+	else
+	{
+		if (dispatchCommand(myCommand, lastFgStatus, context->bgCommandsList) == TRUE)
+		{
+			flow = FLOW_EXIT;
+		}
+		else if (myCommand->backgroundFlag == TRUE && allowBackgroundCommands == TRUE)
+		{
+			*succeeded = TRUE;
+		}
+		else
+		{
+			*succeeded = lastCommandSucceeded(lastFgStatus);
+
+			/* Like other shells, abandon the rest of the script if the user interrupted a foreground command. */
+			if (lastFgStatus->exitedNormally == FALSE && lastFgStatus->code == SIGINT)
+			{
+				flow = FLOW_INTERRUPT;
+			}
+		}
+	}
+	deleteCommand(myCommand);
+
+	if (flow == FLOW_NEXT && checkForSIGINT(context) == TRUE)
+	{
+		flow = FLOW_INTERRUPT;
+	}
+	return flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: runIf
+ * Description:	Receives an if statement, the ScriptContext, and the address of the
+ * 		flag in which to store whether it succeeded. Runs the condition, and
+ * 		then the then-part if it succeeded or the else-part otherwise. If no
+ * 		part runs, the status becomes 0. Returns the FLOW value with which it
+ * 		ended.
+ **************************************************************************************/
+
+int runIf(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	int flow = runStatements(statement->condition, context, succeeded);
+	if (flow != FLOW_NEXT)
+	{
+		return flow;
+	}
+	if (*succeeded == TRUE)
+	{
+		return runStatements(statement->body, context, succeeded);
+	}
+	if (statement->elseBody != NULL)
+	{
+		return runStatements(statement->elseBody, context, succeeded);
+	}
+	setScriptStatus(context->lastFgStatus, 0);
+	*succeeded = TRUE;
+	return FLOW_NEXT;
+}
+
+
+/***************************************************************************************
+ * Function Name: runLoop
+ * Description:	Receives a while or until statement, the ScriptContext, and the
+ * 		address of the flag in which to store whether it succeeded. Runs the
+ * 		body for as long as the condition succeeds (or until it does), or
+ * 		until break or SIGINT ends the loop. The status of the loop is that of
+ * 		the last command of the body, or 0 if the body never ran. Returns the
+ * 		FLOW value with which it ended.
+ **************************************************************************************/
+
+int runLoop(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	struct ForegroundExitMethod bodyStatus;
+	int bodyRan = FALSE;
+	int leaveLoop = FALSE;
+	int flow = FLOW_NEXT;
+
+	beginCatchingSIGINT(context);
+	context->loopDepth++;
+	while (leaveLoop == FALSE)
+	{
+		/* Run the condition (in which break and continue also apply to this loop). */
+		int conditionSucceeded = TRUE;
+		int conditionFlow = runStatements(statement->condition, context, &conditionSucceeded);
+		flow = endLoopPass(conditionFlow, context, &leaveLoop);
+		if (leaveLoop == TRUE || conditionFlow == FLOW_CONTINUE)
+		{
+			continue;
+		}
+		if (conditionSucceeded == ((statement->type == STATEMENT_UNTIL) ? TRUE : FALSE))
+		{
+			break;
+		}
+
+		/* Run the body, keeping its status to restore after the condition that ends the loop. */
+		flow = endLoopPass(runStatements(statement->body, context, succeeded), context, &leaveLoop);
+		bodyStatus = *context->lastFgStatus;
+		bodyRan = TRUE;
+	}
+	context->loopDepth--;
+	endCatchingSIGINT(context);
+
+	if (flow == FLOW_NEXT)
+	{
+		if (bodyRan == TRUE)
+		{
+			*context->lastFgStatus = bodyStatus;
+		}
+		else
+		{
+			setScriptStatus(context->lastFgStatus, 0);
+		}
+		*succeeded = lastCommandSucceeded(context->lastFgStatus);
+	}
+	return flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: runFor
+ * Description:	Receives a for statement, the ScriptContext, and the address of the
+ * 		flag in which to store whether it succeeded. Expands the loop's words
+ * 		like the args of a command (so that globs, braces, and "$$" expand),
+ * 		or takes the args of the function being run if it has no "in", and
+ * 		runs the body once with the variable set to each of them, until break
+ * 		or SIGINT ends the loop. The status of the loop is that of the last
+ * 		command of the body, or 0 if the body never ran. Returns the FLOW
+ * 		value with which it ended.
+ **************************************************************************************/
+
+int runFor(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	struct ScriptFrame* frame = context->frame;
+	struct CommandInfo* wordsCommand = NULL;
+	char** values = NULL;
+	int numValues = 0;
+	int leaveLoop = FALSE;
+	int flow = FLOW_NEXT;
+
+	/* Find the values, parsing the words as the args of a command named "for". */
+	if (statement->words != NULL)
+	{
+		char* words = expandScriptVariables(statement->words, frame);
+		char* line = (char*)malloc(strlen(words) + 5);
+		sprintf(line, "for %s", words);
+		wordsCommand = newCommandFromLine(line);
+		free(line);
+		free(words);
+		if (wordsCommand == NULL)
+		{
+			setScriptStatus(context->lastFgStatus, 1);
+			*succeeded = FALSE;
+			return FLOW_NEXT;
+		}
+		values = wordsCommand->commandArgs + 1;
+		while (values[numValues] != NULL)
+		{
+			numValues++;
+		}
+	}
+	else if (frame->isFunction == TRUE)
+	{
+		values = frame->args + 1;
+		numValues = frame->numArgs;
+	}
+
+	beginCatchingSIGINT(context);
+	context->loopDepth++;
+	for (int i = 0; i < numValues && leaveLoop == FALSE; i++)
+	{
+		setScriptVariable(frame, statement->text, values[i]);
+		flow = endLoopPass(runStatements(statement->body, context, succeeded), context, &leaveLoop);
+	}
+	context->loopDepth--;
+	endCatchingSIGINT(context);
+	if (wordsCommand != NULL)
+	{
+		deleteCommand(wordsCommand);
+	}
+
+	if (flow == FLOW_NEXT)
+	{
+		if (numValues == 0)
+		{
+			setScriptStatus(context->lastFgStatus, 0);
+		}
+		*succeeded = lastCommandSucceeded(context->lastFgStatus);
+	}
+	return flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: endLoopPass
+ * Description:	Receives the FLOW value with which a loop's condition or body ended,
+ * 		the ScriptContext, and the address of a flag to set to TRUE if the
+ * 		loop must stop. Applies break and continue to this loop, passing on
+ * 		those meant for an enclosing loop. Returns the FLOW value with which
+ * 		the loop itself ends if it stops.
+ **************************************************************************************/
+
+int endLoopPass(int flow, struct ScriptContext* context, int* leaveLoop)
+{
+	*leaveLoop = FALSE;
+	if (flow == FLOW_NEXT)
+	{
+		return FLOW_NEXT;
+	}
+	if (flow == FLOW_BREAK || flow == FLOW_CONTINUE)
+	{
+		context->flowLevels--;
+		if (context->flowLevels > 0)
+		{
+			*leaveLoop = TRUE;
+			return flow;
+		}
+		*leaveLoop = (flow == FLOW_BREAK) ? TRUE : FALSE;
+		return FLOW_NEXT;
+	}
+	*leaveLoop = TRUE;
+	return flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: runFlowStatement
+ * Description:	Receives a break, continue, or return statement, the ScriptContext,
+ * 		and the address of the flag in which to store whether it succeeded.
+ * 		"break [n]" and "continue [n]" apply to the nth enclosing loop (the
+ * 		outermost if there are fewer) and set the status to 0. "return [n]"
+ * 		leaves the function, with exit status n (or the status of the last
+ * 		command). Used outside of a loop or function, or with a bad argument,
+ * 		stores exit value 125 after reporting it. Returns the FLOW value with
+ * 		which it ended.
+ **************************************************************************************/
+
+int runFlowStatement(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded)
+{
+	struct ForegroundExitMethod* lastFgStatus = context->lastFgStatus;
+	char* text = expandScriptVariables(statement->text, context->frame);
+	char* savePtr;
+	char* end = NULL;
+	long value = 0;
+	int flow = FLOW_NEXT;
+
+	/* Take the name and at most one numeric argument (at least 1 for loops, or 0 to 255 for return). */
+	char* name = strtok_r(text, " ", &savePtr);
+	char* argument = strtok_r(NULL, " ", &savePtr);
+	if (argument != NULL)
+	{
+		value = strtol(argument, &end, 10);
+	}
+	long minValue = (statement->type == STATEMENT_RETURN) ? 0 : 1;
+	if (strtok_r(NULL, " ", &savePtr) != NULL
+	    || (argument != NULL && (end == argument || *end != '\0' || value < minValue || value > 255)))
+	{
+		fprintf(stderr, "usage: %s [n]\n", name); fflush(stderr);
+		setUsageError(lastFgStatus);
+	}
+
+	/* Leave the function, with the status given if any. */
+	else if (statement->type == STATEMENT_RETURN)
+	{
+		if (context->frame->isFunction == FALSE)
+		{
+			fprintf(stderr, "return: only meaningful in a function\n"); fflush(stderr);
+			setUsageError(lastFgStatus);
+		}
+		else
+		{
+			if (argument != NULL)
+			{
+				setScriptStatus(lastFgStatus, value);
+			}
+			flow = FLOW_RETURN;
+		}
+	}
+
+	/* Leave loops (or start their next iteration). */
+	else if (context->loopDepth == 0)
+	{
+		fprintf(stderr, "%s: only meaningful in a loop\n", name); fflush(stderr);
+		setUsageError(lastFgStatus);
+	}
+	else
+	{
+		context->flowLevels = (argument == NULL) ? 1 : ((value < context->loopDepth) ? value : context->loopDepth);
+		setScriptStatus(lastFgStatus, 0);
+		flow = (statement->type == STATEMENT_BREAK) ? FLOW_BREAK : FLOW_CONTINUE;
+	}
+
+	free(text);
+	*succeeded = lastCommandSucceeded(lastFgStatus);
+	return flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: callScriptFunction
+ * Description:	Receives a function, its args (starting with its name), and the
+ * 		ScriptContext. Runs the function's body in a new frame in which $1,
+ * 		$2, and so on expand to its args, and outside of any loop. The status
+ * 		of the call is that of the last command it ran (or the one given to
+ * 		return). Returns the FLOW value with which the call ended (FLOW_NEXT
+ * 		if it returned).
+ **************************************************************************************/
+
+int callScriptFunction(struct ScriptFunction* function, char** args, struct ScriptContext* context)
+{
+	if (context->functionDepth == MAX_FUNCTION_DEPTH)
+	{
+		fprintf(stderr, "%s: functions nested more than %d deep\n", function->name, MAX_FUNCTION_DEPTH);
+		fflush(stderr);
+		setScriptStatus(context->lastFgStatus, 1);
+		return FLOW_NEXT;
+	}
+
+	struct ScriptFrame frame = { TRUE, args, 0, NULL };
+	while (args[frame.numArgs + 1] != NULL)
+	{
+		frame.numArgs++;
+	}
+
+	/* Hold the function, since the call could redefine it, and run the body in the new frame. */
+	struct ScriptFrame* callerFrame = context->frame;
+	int callerLoopDepth = context->loopDepth;
+	int succeeded = TRUE;
+	function->numHolders++;
+	context->frame = &frame;
+	context->loopDepth = 0;
+	context->functionDepth++;
+	int flow = runStatements(function->body, context, &succeeded);
+	context->functionDepth--;
+	context->loopDepth = callerLoopDepth;
+	context->frame = callerFrame;
+	deleteScriptVariables(&frame);
+	releaseScriptFunction(function);
+
+	return (flow == FLOW_RETURN) ? FLOW_NEXT : flow;
+}
+
+
+/***************************************************************************************
+ * Function Name: setScriptStatus
+ * Description:	Receives the ForegroundExitMethod struct and an exit value. Stores
+ * 		the value as if a foreground command had exited with it. Returns
+ * 		nothing.
+ **************************************************************************************/
+
+void setScriptStatus(struct ForegroundExitMethod* lastFgStatus, int code)
+{
+	lastFgStatus->code = code;
+	lastFgStatus->exitedNormally = TRUE;
+	lastFgStatus->timedOut = FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: beginCatchingSIGINT
+ * Description:	Receives the ScriptContext. Called as a loop starts, so that SIGINT
+ * 		stops the loop even while it runs only built-ins. The outermost loop
+ * 		has the shell catch SIGINT rather than ignore it. Returns nothing.
+ **************************************************************************************/
+
+void beginCatchingSIGINT(struct ScriptContext* context)
+{
+	if (context->catchingSIGINT++ == 0)
+	{
+		interruptOnSIGINT();
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: endCatchingSIGINT
+ * Description:	Receives the ScriptContext. Called as a loop ends. Once the outermost
+ * 		loop ends, restores the shell's usual ignoring of SIGINT. Returns
+ * 		nothing.
+ **************************************************************************************/
+
+void endCatchingSIGINT(struct ScriptContext* context)
+{
+	if (--context->catchingSIGINT == 0)
+	{
+		ignoreSIGINT();
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: checkForSIGINT
+ * Description:	Receives the ScriptContext. Called after each command run within a
+ * 		loop (other than a foreground command interrupted by SIGINT, which
+ * 		was reported already). If SIGINT was received, reports it and stores
+ * 		SIGINT as the status. Otherwise has SIGINT caught again if the command restored
+ * 		the shell's usual handling (as built-ins that block do). Returns TRUE
+ * 		if SIGINT was received, or FALSE otherwise (or outside of loops).
+ **************************************************************************************/
+
+int checkForSIGINT(struct ScriptContext* context)
+{
+	struct ForegroundExitMethod* lastFgStatus = context->lastFgStatus;
+	struct sigaction SIGINT_action;
+
+	if (context->catchingSIGINT == 0)
+	{
+		return FALSE;
+	}
+	if (sigintReceived == TRUE)
+	{
+		fprintf(shellOutput, "\nloop interrupted by signal %d\n", SIGINT); fflush(shellOutput);
+		lastFgStatus->code = SIGINT;
+		lastFgStatus->exitedNormally = FALSE;
+		lastFgStatus->timedOut = FALSE;
+		return TRUE;
+	}
+	sigaction(SIGINT, NULL, &SIGINT_action);
+	if (SIGINT_action.sa_handler != catchSIGINT)
+	{
+		interruptOnSIGINT();
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: expandScriptVariables
+ * Description:	Receives the text of a command and the frame it runs in. Replaces
+ * 		$name and ${name} with the value of a loop variable of the frame and,
+ * 		within a function, $0 to $9 and ${n} with its args (empty beyond the
+ * 		last), $# with their number, and $@ and $* with all of them separated
+ * 		by spaces. "$$" and every other "$" are left for parsing like the
+ * 		rest of the command line. Returns the allocated text.
+ **************************************************************************************/
+
+char* expandScriptVariables(char* text, struct ScriptFrame* frame)
+{
+	size_t capacity = strlen(text) + 1;
+	size_t length = 0;
+	char* result = (char*)malloc(capacity);
+	char numberBuffer[24];
+
+	for (char* cursor = text; *cursor != '\0';)
+	{
+		/* Copy plain text up to the next "$", and "$$" as it is. */
+		size_t plainLength = strcspn(cursor, "$");
+		appendText(&result, &length, &capacity, cursor, plainLength);
+		cursor += plainLength;
+		if (*cursor == '\0')
+		{
+			break;
+		}
+		if (cursor[1] == '$')
+		{
+			appendText(&result, &length, &capacity, cursor, 2);
+			cursor += 2;
+			continue;
+		}
+
+		/* Find the name after the "$" (digits only in braces, where it must be followed by "}"). */
+		int braced = (cursor[1] == '{') ? TRUE : FALSE;
+		char* name = cursor + 1 + braced;
+		int nameLength = 0;
+		if (isdigit((unsigned char)name[0]) != 0)
+		{
+			nameLength = (braced == TRUE) ? strspn(name, "0123456789") : 1;
+		}
+		else if (name[0] == '#' || name[0] == '@' || name[0] == '*')
+		{
+			nameLength = 1;
+		}
+		else if (isalpha((unsigned char)name[0]) != 0 || name[0] == '_')
+		{
+			nameLength = 1;
+			while (isalnum((unsigned char)name[nameLength]) != 0 || name[nameLength] == '_')
+			{
+				nameLength++;
+			}
+		}
+		if (nameLength == 0 || (braced == TRUE && name[nameLength] != '}'))
+		{
+			appendText(&result, &length, &capacity, cursor++, 1);
+			continue;
+		}
+
+		/* Replace it with its value, or keep it if it has none. */
+		if ((name[0] == '@' || name[0] == '*') && frame->isFunction == TRUE)
+		{
+			for (int i = 1; i <= frame->numArgs; i++)
+			{
+				if (i > 1)
+				{
+					appendText(&result, &length, &capacity, " ", 1);
+				}
+				appendText(&result, &length, &capacity, frame->args[i], strlen(frame->args[i]));
+			}
+		}
+		else
+		{
+			char* value = findScriptVariable(frame, name, nameLength, numberBuffer);
+			if (value == NULL)
+			{
+				appendText(&result, &length, &capacity, cursor++, 1);
+				continue;
+			}
+			appendText(&result, &length, &capacity, value, strlen(value));
+		}
+		cursor = name + nameLength + braced;
+	}
+	result[length] = '\0';
+	return result;
+}
+
+
+/***************************************************************************************
+ * Function Name: appendText
+ * Description:	Receives the address of an allocated string, of its length, and of
+ * 		its capacity, and some text and its length. Appends the text, growing
+ * 		the string as needed (always leaving room for a null terminator).
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void appendText(char** text, size_t* length, size_t* capacity, char* addition, size_t additionLength)
+{
+	if (*length + additionLength + 1 > *capacity)
+	{
+		while (*length + additionLength + 1 > *capacity)
+		{
+			*capacity *= 2;
+		}
+		*text = (char*)realloc(*text, *capacity);
+	}
+	memcpy(*text + *length, addition, additionLength);
+	*length += additionLength;
+}
+
+
+/***************************************************************************************
+ * Function Name: findScriptVariable
+ * Description:	Receives a frame, a name (which need not end with a null terminator)
+ * 		and its length, and a buffer of at least 24 chars for a number.
+ * 		Returns the value of the function arg or loop variable it names (an
+ * 		arg beyond the last is empty, and the value of $# is written to the
+ * 		buffer), or NULL if it has none.
+ **************************************************************************************/
+
+char* findScriptVariable(struct ScriptFrame* frame, char* name, int nameLength, char* numberBuffer)
+{
+	if (name[0] == '#' || isdigit((unsigned char)name[0]) != 0)
+	{
+		if (frame->isFunction == FALSE)
+		{
+			return NULL;
+		}
+		if (name[0] == '#')
+		{
+			sprintf(numberBuffer, "%d", frame->numArgs);
+			return numberBuffer;
+		}
+		long index = strtol(name, NULL, 10);
+		return (nameLength < 10 && index <= frame->numArgs) ? frame->args[index] : "";
+	}
+
+	for (struct ScriptVariable* variable = frame->variables; variable != NULL; variable = variable->next)
+	{
+		if (strncmp(variable->name, name, nameLength) == 0 && variable->name[nameLength] == '\0')
+		{
+			return variable->value;
+		}
+	}
+	return NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: setScriptVariable
+ * Description:	Receives a frame, the name of a loop variable, and its new value.
+ * 		Stores a copy of the value, adding the variable to the frame if it is
+ * 		not there yet. Returns nothing.
+ **************************************************************************************/
+
+void setScriptVariable(struct ScriptFrame* frame, char* name, char* value)
+{
+	struct ScriptVariable* variable = frame->variables;
+	while (variable != NULL && strcmp(variable->name, name) != 0)
+	{
+		variable = variable->next;
+	}
+	if (variable == NULL)
+	{
+		variable = (struct ScriptVariable*)malloc(sizeof(struct ScriptVariable));
+		variable->name = strdup(name);
+		variable->value = NULL;
+		variable->next = frame->variables;
+		frame->variables = variable;
+	}
+	free(variable->value);
+	variable->value = strdup(value);
+}
+
+
+/***************************************************************************************
+ * Function Name: deleteScriptVariables
+ * Description:	Receives a frame. Frees its loop variables. Returns nothing.
+ **************************************************************************************/
+
+void deleteScriptVariables(struct ScriptFrame* frame)
+{
+	while (frame->variables != NULL)
+	{
+		struct ScriptVariable* next = frame->variables->next;
+		free(frame->variables->name);
+		free(frame->variables->value);
+		free(frame->variables);
+		frame->variables = next;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: getScriptFunction
+ * Description:	Receives a name. Returns the function defined with that name, or NULL
+ * 		if there is none.
+ **************************************************************************************/
+
+struct ScriptFunction* getScriptFunction(char* name)
+{
+	struct ScriptFunction* function = scriptFunctions[hashAliasName(name, strlen(name)) % FUNCTION_BUCKETS];
+	while (function != NULL && strcmp(function->name, name) != 0)
+	{
+		function = function->next;
+	}
+	return function;
+}
+
+
+/***************************************************************************************
+ * Function Name: defineScriptFunction
+ * Description:	Receives a function parsed from a definition being run. Adds it to
+ * 		the table of functions (which holds it from then on), replacing any
+ * 		function with the same name. Returns nothing.
+ **************************************************************************************/
+
+void defineScriptFunction(struct ScriptFunction* function)
+{
+	int bucket = hashAliasName(function->name, strlen(function->name)) % FUNCTION_BUCKETS;
+	struct ScriptFunction** link = &scriptFunctions[bucket];
+
+	/* Remove the function already defined with the name (unless the same definition is run again). */
+	while (*link != NULL && strcmp((*link)->name, function->name) != 0)
+	{
+		link = &(*link)->next;
+	}
+	if (*link == function)
+	{
+		return;
+	}
+	if (*link != NULL)
+	{
+		struct ScriptFunction* oldFunction = *link;
+		*link = oldFunction->next;
+		releaseScriptFunction(oldFunction);
+	}
+
+	function->numHolders++;
+	function->next = scriptFunctions[bucket];
+	scriptFunctions[bucket] = function;
+}
+
+
+/***************************************************************************************
+ * Function Name: releaseScriptFunction
+ * Description:	Receives a function whose holder (a tree, the table, or a call) no
+ * 		longer needs it. Frees it once nothing holds it. Returns nothing.
+ **************************************************************************************/
+
+void releaseScriptFunction(struct ScriptFunction* function)
+{
+	if (--function->numHolders == 0)
+	{
+		deleteStatements(function->body);
+		free(function->name);
+		free(function);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: clearScriptFunctions
+ * Description:	Removes every function from the table, freeing those that nothing
+ * 		else holds. Called as the shell exits. Receives and returns nothing.
+ **************************************************************************************/
+
+void clearScriptFunctions()
+{
+	for (int i = 0; i < FUNCTION_BUCKETS; i++)
+	{
+		while (scriptFunctions[i] != NULL)
+		{
+			struct ScriptFunction* function = scriptFunctions[i];
+			scriptFunctions[i] = function->next;
+			releaseScriptFunction(function);
+		}
+	}
+}
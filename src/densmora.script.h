@@ -0,0 +1,210 @@
+/***************************************************************************************
+ * File: densmora.script.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions that parse command lines (and blocks spanning several
+ * 		lines) into a tree of lists, if, while, until, and for statements,
+ * 		brace groups, and function definitions, and run the tree inside the
+ * 		shell. Only the simple commands at its leaves are dispatched like a
+ * 		line of their own. See densmora.script.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_SCRIPT
+#define DENSMORA_SCRIPT
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* My own header file inclusions. */
+#include "densmora.commandLists.h"
+#include "densmora.aliases.h"
+
+/* Operators joining a statement to the one before it. */
+#define LIST_ALWAYS 0		/* ; or & or a newline (or the first statement): always run. */
+#define LIST_AND 1		/* &&: run only if the previous statement succeeded. */
+#define LIST_OR 2		/* ||: run only if the previous statement failed. */
+
+/* Kinds of tokens a script is split into. Words are separated by spaces, and a word ending in
+ * ";" is split into the word and a ";". */
+#define TOKEN_WORD 0
+#define TOKEN_SEMICOLON 1
+#define TOKEN_NEWLINE 2
+#define TOKEN_AND 3
+#define TOKEN_OR 4
+#define TOKEN_AMPERSAND 5
+#define TOKEN_END 6
+
+/* Kinds of statements in the tree. */
+#define STATEMENT_COMMAND 0	/* Simple command, dispatched like a line of its own. */
+#define STATEMENT_IF 1
+#define STATEMENT_WHILE 2
+#define STATEMENT_UNTIL 3
+#define STATEMENT_FOR 4
+#define STATEMENT_GROUP 5	/* { list } */
+#define STATEMENT_FUNCTION 6	/* Function definition. */
+#define STATEMENT_BREAK 7
+#define STATEMENT_CONTINUE 8
+#define STATEMENT_RETURN 9
+
+/* Results of parsing a script. */
+#define PARSE_COMPLETE 0
+#define PARSE_INCOMPLETE 1	/* A statement is still open at the end (more lines are needed). */
+#define PARSE_ERROR 2
+
+/* How running a statement ended, so that enclosing statements know whether to go on. */
+#define FLOW_NEXT 0		/* Go on with the next statement. */
+#define FLOW_BREAK 1		/* Leave loops (ScriptContext's flowLevels of them). */
+#define FLOW_CONTINUE 2		/* Start the next iteration of the flowLevels-th enclosing loop. */
+#define FLOW_RETURN 3		/* Leave the function. */
+#define FLOW_EXIT 4		/* A command was "exit": leave everything, and end the shell. */
+#define FLOW_INTERRUPT 5	/* SIGINT was received: leave everything. */
+
+/* Deepest nesting of function calls (beyond which a call fails rather than exhausting the stack). */
+#define MAX_FUNCTION_DEPTH 1000
+
+/* Number of buckets in the table of functions. */
+#define FUNCTION_BUCKETS 64
+
+/* Struct storing one token of a script. */
+
+struct ScriptToken
+{
+	int type;				/* One of the TOKEN kinds. */
+	char* word;				/* Text of a TOKEN_WORD (within the parser's copy of the script). */
+};
+
+/* Struct storing one statement of the tree. Statements in the same list are chained by next. */
+
+struct ScriptStatement
+{
+	int type;				/* One of the STATEMENT kinds. */
+	int joinOperator;			/* LIST_ALWAYS, LIST_AND, or LIST_OR. */
+	char* text;				/* Words of a command (with a trailing " &" to run it in the background),
+						 * variable of a for loop, or argument of break, continue, or return (or NULL). */
+	char* words;				/* Words after "in" of a for loop, or NULL to loop over the function's args. */
+	struct ScriptStatement* condition;	/* Condition of an if, while, or until. */
+	struct ScriptStatement* body;		/* Then-part of an if, or body of a loop or group. */
+	struct ScriptStatement* elseBody;	/* Else-part of an if (an elif is an if in its own else-part), or NULL. */
+	struct ScriptFunction* function;	/* Function defined by a function definition. */
+	struct ScriptStatement* next;		/* Next statement of the same list, or NULL. */
+};
+
+/* Struct storing a function. A function is shared by the tree that defined it, the table of
+ * functions, and every call running it, so it is freed once none of them hold it. */
+
+struct ScriptFunction
+{
+	char* name;				/* Name of the function. */
+	struct ScriptStatement* body;		/* Statements run when it is called. */
+	int numHolders;				/* Number of trees, table entries, and calls holding it. */
+	struct ScriptFunction* next;		/* Next function in the same bucket of the table. */
+};
+
+/* Struct storing a variable set by a for loop. */
+
+struct ScriptVariable
+{
+	char* name;				/* Name of the variable. */
+	char* value;				/* Its value. */
+	struct ScriptVariable* next;		/* Next variable of the same frame. */
+};
+
+/* Struct storing the variables of the script or function call being run. */
+
+struct ScriptFrame
+{
+	int isFunction;				/* Set to TRUE for a function call (whose args can be expanded). */
+	char** args;				/* Name of the function followed by its args ($0, $1, ...). */
+	int numArgs;				/* Number of args after the name ($#). */
+	struct ScriptVariable* variables;	/* Variables set by for loops. */
+};
+
+/* Struct storing the state of a script being run. */
+
+struct ScriptContext
+{
+	struct ForegroundExitMethod* lastFgStatus;	/* Status of the last foreground command. */
+	struct BackgroundCommands* bgCommandsList;	/* List of background jobs. */
+	struct ScriptFrame* frame;		/* Variables of the script or innermost function call. */
+	int loopDepth;				/* Number of loops being run within the current frame. */
+	int functionDepth;			/* Number of function calls being run. */
+	int flowLevels;				/* Number of loops left by a FLOW_BREAK or FLOW_CONTINUE. */
+	int catchingSIGINT;			/* Number of loops being run (in any frame), during which SIGINT is caught. */
+};
+
+/* Struct storing the parser's progress through a script. */
+
+struct ScriptParser
+{
+	char* text;				/* Copy of the script, which the tokens point into. */
+	struct ScriptToken* tokens;		/* Tokens of the script, ending with TOKEN_END. */
+	int position;				/* Index of the next token. */
+	int result;				/* PARSE_COMPLETE until more lines are needed or an error is found. */
+};
+
+/* Struct storing the lines of a block typed at the prompt (or read from the startup file)
+ * until it is complete. */
+
+struct ScriptBuffer
+{
+	char* text;				/* Lines read so far, separated by newlines (NULL if none). */
+	size_t length;				/* Number of chars in text. */
+};
+
+/* Function prototypes (see densmora.script.c for function descriptions and implementations). */
+int runScriptLine(struct ScriptBuffer* buffer, char* line, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList);
+int isScriptIncomplete(struct ScriptBuffer* buffer);
+void discardScriptBuffer(struct ScriptBuffer* buffer);
+int parseScript(char* text, struct ScriptStatement** tree);
+struct ScriptToken* tokenizeScript(char* text);
+int startsCommand(char* word);
+struct ScriptStatement* parseList(struct ScriptParser* parser);
+struct ScriptStatement* parseStatement(struct ScriptParser* parser);
+struct ScriptStatement* parseSimpleCommand(struct ScriptParser* parser);
+struct ScriptStatement* parseIf(struct ScriptParser* parser);
+struct ScriptStatement* parseLoop(struct ScriptParser* parser);
+struct ScriptStatement* parseFor(struct ScriptParser* parser);
+struct ScriptStatement* parseGroup(struct ScriptParser* parser);
+struct ScriptStatement* parseFunction(struct ScriptParser* parser);
+struct ScriptStatement* parseBody(struct ScriptParser* parser, char* closingWord);
+char* joinWords(struct ScriptParser* parser);
+void expectWord(struct ScriptParser* parser, char* word);
+int isNextWord(struct ScriptParser* parser, char* word);
+void skipNewlines(struct ScriptParser* parser);
+void failParse(struct ScriptParser* parser);
+int isReservedWord(char* word);
+int isClosingWord(char* word);
+struct ScriptStatement* newStatement(int type);
+void deleteStatements(struct ScriptStatement* statement);
+int runScriptTree(struct ScriptStatement* tree, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList);
+int runStatements(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int runStatement(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int runSimpleCommand(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int runIf(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int runLoop(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int runFor(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int endLoopPass(int flow, struct ScriptContext* context, int* leaveLoop);
+int runFlowStatement(struct ScriptStatement* statement, struct ScriptContext* context, int* succeeded);
+int callScriptFunction(struct ScriptFunction* function, char** args, struct ScriptContext* context);
+void setScriptStatus(struct ForegroundExitMethod* lastFgStatus, int code);
+void beginCatchingSIGINT(struct ScriptContext* context);
+void endCatchingSIGINT(struct ScriptContext* context);
+int checkForSIGINT(struct ScriptContext* context);
+char* expandScriptVariables(char* text, struct ScriptFrame* frame);
+void appendText(char** text, size_t* length, size_t* capacity, char* addition, size_t additionLength);
+char* findScriptVariable(struct ScriptFrame* frame, char* name, int nameLength, char* numberBuffer);
+void setScriptVariable(struct ScriptFrame* frame, char* name, char* value);
+void deleteScriptVariables(struct ScriptFrame* frame);
+struct ScriptFunction* getScriptFunction(char* name);
+void defineScriptFunction(struct ScriptFunction* function);
+void releaseScriptFunction(struct ScriptFunction* function);
+void clearScriptFunctions();
+
+#endif
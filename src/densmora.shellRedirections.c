@@ -0,0 +1,227 @@
+/***************************************************************************************
+ * File: densmora.shellRedirections.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions that
+ * 		change the shell's own descriptors for the exec built-in. Since every
+ * 		command inherits the shell's descriptors, a file opened once this way
+ * 		(exec >> log) receives the output of every later command without being
+ * 		reopened or truncated by each one. The shell's own long-lived
+ * 		descriptors are close-on-exec and kept at or above SHELL_FD_BASE, and
+ * 		they can be neither replaced nor copied.
+ **************************************************************************************/
+
+#include "densmora.shellRedirections.h"
+
+
+/***************************************************************************************
+ * Function Name: parseShellRedirection
+ * Description:	Receives the remaining words of an exec command and the address of a
+ * 		ShellRedirection struct. If the first word is a redirection of the
+ * 		form [N]< [N]> [N]>> [N]<> (followed by a file name, either in the
+ * 		same word or the next), or [N]>&M [N]<&M [N]>&- [N]<&-, fills in the
+ * 		struct (N defaults to 0 for < and 1 for >). Returns the number of
+ * 		words used, 0 if the first word is not a redirection, or -1 if it is
+ * 		malformed (after reporting it).
+ **************************************************************************************/
+
+int parseShellRedirection(char** words, struct ShellRedirection* redir)
+{
+	char* word = words[0];
+	char* op = word;
+	long fd;
+
+	/* Read the optional descriptor number, and check that an operator follows it. */
+	while (isdigit((unsigned char)*op))
+	{
+		op++;
+	}
+	if (*op != '<' && *op != '>')
+	{
+		return 0;
+	}
+	fd = (op == word) ? ((*op == '<') ? 0 : 1) : strtol(word, NULL, 10);
+	if (fd > INT_MAX)
+	{
+		fprintf(stderr, "exec: %s: bad file descriptor\n", word); fflush(stderr);
+		return -1;
+	}
+	memset(redir, 0, sizeof(struct ShellRedirection));
+	redir->fd = (int)fd;
+	redir->savedFd = -1;
+
+	/* Copy or close a descriptor (the target is part of the same word). */
+	if (op[1] == '&')
+	{
+		char* target = op + 2;
+		char* endPtr;
+		if (strcmp(target, "-") == 0)
+		{
+			redir->type = SHELL_REDIR_CLOSE;
+			return 1;
+		}
+		long sourceFd = strtol(target, &endPtr, 10);
+		if (*target == '\0' || *endPtr != '\0' || !isdigit((unsigned char)*target) || sourceFd > INT_MAX)
+		{
+			fprintf(stderr, "exec: %s: bad file descriptor\n", word); fflush(stderr);
+			return -1;
+		}
+		redir->type = SHELL_REDIR_DUP;
+		redir->sourceFd = (int)sourceFd;
+		return 1;
+	}
+
+	/* Otherwise, open a file with the flags of the operator. */
+	redir->type = SHELL_REDIR_OPEN;
+	if (strncmp(op, "<>", 2) == 0)
+	{
+		redir->openFlags = O_RDWR | O_CREAT;
+		op += 2;
+	}
+	else if (strncmp(op, ">>", 2) == 0)
+	{
+		redir->openFlags = O_WRONLY | O_APPEND | O_CREAT;
+		op += 2;
+	}
+	else
+	{
+		redir->openFlags = (*op == '<') ? O_RDONLY : O_WRONLY | O_TRUNC | O_CREAT;
+		op++;
+	}
+
+	/* The file name is the rest of the word, or the next word if the operator stands alone. */
+	if (*op != '\0')
+	{
+		redir->path = op;
+		return 1;
+	}
+	if (words[1] == NULL)
+	{
+		fprintf(stderr, "exec: %s: missing file name\n", word); fflush(stderr);
+		return -1;
+	}
+	redir->path = words[1];
+	return 2;
+}
+
+
+/***************************************************************************************
+ * Function Name: applyShellRedirection
+ * Description:	Receives a parsed ShellRedirection and a flag indicating whether to
+ * 		keep a copy of what its descriptor referred to (so that it can be
+ * 		undone with undoShellRedirections). Changes the shell's descriptor,
+ * 		flushing stdio first if it is stdout or stderr. The new descriptor is
+ * 		not close-on-exec, so commands inherit it. Returns TRUE on success,
+ * 		or FALSE (after reporting the error and leaving the descriptor as it
+ * 		was) otherwise.
+ **************************************************************************************/
+
+int applyShellRedirection(struct ShellRedirection* redir, int saveOld)
+{
+	int newFd = -1;
+
+	/* Leave the shell's own descriptors alone, and only copy descriptors commands could see. */
+	if (isUserFd(redir->fd) == FALSE)
+	{
+		fprintf(stderr, "exec: %d: descriptor is in use by the shell\n", redir->fd); fflush(stderr);
+		return FALSE;
+	}
+	if (redir->type == SHELL_REDIR_DUP && (fcntl(redir->sourceFd, F_GETFD) == -1 || isUserFd(redir->sourceFd) == FALSE))
+	{
+		fprintf(stderr, "exec: %d: bad file descriptor\n", redir->sourceFd); fflush(stderr);
+		return FALSE;
+	}
+
+	/* Open the file first, so that nothing changes if it cannot be opened. */
+	if (redir->type == SHELL_REDIR_OPEN)
+	{
+		newFd = open(redir->path, redir->openFlags | O_CLOEXEC, FILE_PERMISSIONS);
+		if (newFd == -1)
+		{
+			fprintf(stderr, "cannot open %s for %s\n", redir->path,
+				((redir->openFlags & O_ACCMODE) == O_RDONLY) ? "input" : "output");
+			fflush(stderr);
+			return FALSE;
+		}
+	}
+
+	/* Keep a copy of what the descriptor referred to, if asked to. */
+	fflush(stdout);
+	fflush(stderr);
+	redir->savedFd = -1;
+	if (saveOld == TRUE && redir->fd != newFd && fcntl(redir->fd, F_GETFD) != -1)
+	{
+		redir->savedFd = fcntl(redir->fd, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+	}
+
+	/* Make the change. A file that was opened at the very descriptor only needs close-on-exec cleared. */
+	if (redir->type == SHELL_REDIR_CLOSE)
+	{
+		close(redir->fd);
+	}
+	else if (newFd == redir->fd)
+	{
+		fcntl(redir->fd, F_SETFD, 0);
+	}
+	else if (dup2((redir->type == SHELL_REDIR_OPEN) ? newFd : redir->sourceFd, redir->fd) == -1)
+	{
+		fprintf(stderr, "exec: %d: %s\n", redir->fd, strerror(errno)); fflush(stderr);
+		if (newFd != -1)
+		{
+			close(newFd);
+		}
+		if (redir->savedFd != -1)
+		{
+			close(redir->savedFd);
+			redir->savedFd = -1;
+		}
+		return FALSE;
+	}
+	if (newFd != -1 && newFd != redir->fd)
+	{
+		close(newFd);
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: undoShellRedirections
+ * Description:	Receives an array of ShellRedirection structs that were applied with
+ * 		saveOld set, and its number of elements. Restores each descriptor to
+ * 		what it referred to before (closing it if it was closed), in reverse
+ * 		order. Returns nothing.
+ **************************************************************************************/
+
+void undoShellRedirections(struct ShellRedirection* redirs, int numRedirs)
+{
+	fflush(stdout);
+	fflush(stderr);
+	for (int i = numRedirs - 1; i >= 0; i--)
+	{
+		if (redirs[i].savedFd != -1)
+		{
+			dup2(redirs[i].savedFd, redirs[i].fd);
+			close(redirs[i].savedFd);
+			redirs[i].savedFd = -1;
+		}
+		else
+		{
+			close(redirs[i].fd);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: isUserFd
+ * Description:	Receives a descriptor. Returns TRUE if it is closed or would be
+ * 		inherited by commands, or FALSE if it is one of the shell's own
+ * 		close-on-exec descriptors.
+ **************************************************************************************/
+
+int isUserFd(int fd)
+{
+	int flags = fcntl(fd, F_GETFD);
+	return (flags == -1 || (flags & FD_CLOEXEC) == 0) ? TRUE : FALSE;
+}
@@ -0,0 +1,52 @@
+/***************************************************************************************
+ * File: densmora.shellRedirections.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definitions of the structs and prototypes
+ * 		of the functions that change the shell's own descriptors for the exec
+ * 		built-in (exec > file, exec 3< file, exec 2>&1, exec 3>&-, and so on),
+ * 		so that every later command inherits them. See
+ * 		densmora.shellRedirections.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_SHELL_REDIRECTIONS
+#define DENSMORA_SHELL_REDIRECTIONS
+
+/* Built-in header file inclusions. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.eventLoop.h"
+
+/* Kinds of change made to a descriptor. */
+#define SHELL_REDIR_OPEN 0
+#define SHELL_REDIR_DUP 1
+#define SHELL_REDIR_CLOSE 2
+
+/* Struct storing one change to one of the shell's descriptors. */
+
+struct ShellRedirection
+{
+	int fd;					/* Descriptor being changed. */
+	int type;				/* SHELL_REDIR_OPEN, SHELL_REDIR_DUP, or SHELL_REDIR_CLOSE. */
+	char* path;				/* File opened by SHELL_REDIR_OPEN. */
+	int openFlags;				/* Flags the file is opened with. */
+	int sourceFd;				/* Descriptor copied by SHELL_REDIR_DUP. */
+	int savedFd;				/* Copy of what fd referred to before (-1 if it was closed or not saved). */
+};
+
+/* Function prototypes (see densmora.shellRedirections.c for function descriptions and implementations). */
+int parseShellRedirection(char** words, struct ShellRedirection* redir);
+int applyShellRedirection(struct ShellRedirection* redir, int saveOld);
+void undoShellRedirections(struct ShellRedirection* redirs, int numRedirs);
+int isUserFd(int fd);
+
+#endif
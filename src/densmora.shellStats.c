@@ -0,0 +1,249 @@
+/***************************************************************************************
+ * File: densmora.shellStats.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of functions that maintain
+ * 		counters about the commands the shell runs and serve them on the Unix
+ * 		domain socket named by the SMALLSH_STATS_SOCKET environment variable.
+ * 		Each connection receives one plain-text snapshot of the counters (one
+ * 		"name value" line per counter) and is then closed. The socket is
+ * 		serviced by the event loop, so a scraper never blocks the prompt.
+ **************************************************************************************/
+
+#include "densmora.shellStats.h"
+
+/* Define counters declared in densmora.shellStats.h. */
+struct ShellStats shellStats;
+
+
+/***************************************************************************************
+ * Function Name: initShellStats
+ * Description:	Receives the BackgroundCommands list of the shell (whose size is
+ * 		reported as the number of running background jobs). Resets all
+ * 		counters and, if SMALLSH_STATS_SOCKET is set, creates a non-blocking
+ * 		listening socket at that path and registers it with the event loop.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void initShellStats(struct BackgroundCommands* bgCommandsList)
+{
+	/* Reset all counters and remember bgCommandsList. */
+	memset(&shellStats, 0, sizeof(struct ShellStats));
+	shellStats.bgCommandsList = bgCommandsList;
+	shellStats.listenFd = -1;
+
+	/* Return if no stats socket was requested. */
+	char* socketPath = getenv("SMALLSH_STATS_SOCKET");
+	if (socketPath == NULL || socketPath[0] == '\0')
+	{
+		return;
+	}
+
+	/* Make sure the path fits in a socket address. */
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(struct sockaddr_un));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "%s: stats socket path is too long\n", socketPath); fflush(stderr);
+		return;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	/* Create the socket, removing any stale socket left at the path by an earlier shell. */
+	shellStats.listenFd = raiseShellFd(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+	unlink(socketPath);
+	if (shellStats.listenFd == -1
+	    || bind(shellStats.listenFd, (struct sockaddr*)&address, sizeof(struct sockaddr_un)) == -1
+	    || listen(shellStats.listenFd, 16) == -1)
+	{
+		perror(socketPath); fflush(stderr);
+		if (shellStats.listenFd != -1)
+		{
+			close(shellStats.listenFd);
+			shellStats.listenFd = -1;
+		}
+		return;
+	}
+
+	/* Have the event loop accept connections whenever the shell is waiting. */
+	shellStats.socketPath = socketPath;
+	shellStats.listenWatcher = addEventWatcher(shellStats.listenFd, acceptStatsClient, NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: recordLaunch
+ * Description:	Receives the time (CLOCK_MONOTONIC) just before fork() was called and
+ * 		the pid it returned in the parent. Counts a fork failure if the pid
+ * 		is -1 and otherwise adds the time fork() took to the launch latency
+ * 		(and to the fork phase histogram).
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void recordLaunch(struct timespec* forkStart, pid_t childPid)
+{
+	/* Count the failure and return if fork() failed. */
+	if (childPid == -1)
+	{
+		shellStats.forkFailures++;
+		return;
+	}
+
+	/* Add the time spent in fork() to the total launch latency and the fork phase histogram. */
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	unsigned long long forkNsec = elapsedNsec(forkStart, &now);
+	shellStats.launches++;
+	shellStats.launchLatencyNsec += forkNsec;
+	recordPhase(PHASE_FORK, forkNsec);
+}
+
+
+/***************************************************************************************
+ * Function Name: recordExitMethod
+ * Description:	Receives the exit method of a child returned by waitpid or wait4 and
+ * 		counts it in the exit code or terminating signal histogram.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void recordExitMethod(int childExitMethod)
+{
+	if (WIFEXITED(childExitMethod) != 0)
+	{
+		shellStats.exitCodes[WEXITSTATUS(childExitMethod)]++;
+	}
+	else if (WIFSIGNALED(childExitMethod) != 0 && WTERMSIG(childExitMethod) < NUM_SIGNALS)
+	{
+		shellStats.exitSignals[WTERMSIG(childExitMethod)]++;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: recordStartup
+ * Description:	Receives the time (CLOCK_MONOTONIC) at which main started. Records
+ * 		how long the shell took to get to its first prompt (including the
+ * 		startup file), and reports it if SMALLSH_STARTUP_TIME is set.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void recordStartup(struct timespec* mainStart)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	shellStats.startupUsec = (now.tv_sec - mainStart->tv_sec) * 1000000L + (now.tv_nsec - mainStart->tv_nsec) / 1000L;
+
+	char* report = getenv("SMALLSH_STARTUP_TIME");
+	if (report != NULL && report[0] != '\0')
+	{
+		fprintf(stderr, "startup took %lu us\n", shellStats.startupUsec); fflush(stderr);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: formatShellStats
+ * Description:	Receives a buffer of bufferSize bytes. Writes every counter into it,
+ * 		one "name value" pair per line (only non-zero histogram entries are
+ * 		included), followed by the phase latency percentiles. Returns the number of bytes written.
+ **************************************************************************************/
+
+int formatShellStats(char* buffer, int bufferSize)
+{
+	int length = 0;
+
+	/* Compute the average launch latency in microseconds, avoiding division by 0. */
+	double averageLatencyUsec = 0.0;
+	if (shellStats.launches > 0)
+	{
+		averageLatencyUsec = (double)shellStats.launchLatencyNsec / shellStats.launches / 1000.0;
+	}
+
+	/* Write scalar counters. */
+	length += snprintf(buffer + length, bufferSize - length,
+			   "smallsh_pid %d\n"
+			   "smallsh_commands_executed %lu\n"
+			   "smallsh_fork_failures %lu\n"
+			   "smallsh_background_running %d\n"
+			   "smallsh_background_queued %lu\n"
+			   "smallsh_launch_latency_avg_us %.1f\n"
+			   "smallsh_cache_hits %lu\n"
+			   "smallsh_cache_misses %lu\n"
+			   "smallsh_cache_evictions %lu\n"
+			   "smallsh_startup_us %lu\n",
+			   (int)getpid(), shellStats.commandsExecuted, shellStats.forkFailures,
+			   shellStats.bgCommandsList->numNodes, shellStats.backgroundQueued, averageLatencyUsec,
+			   shellStats.cacheHits, shellStats.cacheMisses, shellStats.cacheEvictions, shellStats.startupUsec);
+
+	/* Write histogram entries. */
+	for (int code = 0; code < NUM_EXIT_CODES && length < bufferSize; code++)
+	{
+		if (shellStats.exitCodes[code] > 0)
+		{
+			length += snprintf(buffer + length, bufferSize - length,
+					   "smallsh_exit_code{code=\"%d\"} %lu\n", code, shellStats.exitCodes[code]);
+		}
+	}
+	for (int sig = 0; sig < NUM_SIGNALS && length < bufferSize; sig++)
+	{
+		if (shellStats.exitSignals[sig] > 0)
+		{
+			length += snprintf(buffer + length, bufferSize - length,
+					   "smallsh_exit_signal{signal=\"%d\"} %lu\n", sig, shellStats.exitSignals[sig]);
+		}
+	}
+
+	/* snprintf reports the length it would have written, so clamp in case the buffer filled up. */
+	if (length > bufferSize)
+	{
+		length = bufferSize;
+	}
+
+	/* Write the latency percentiles of each phase of running commands. */
+	length += formatPhaseStats(buffer + length, bufferSize - length);
+	return length;
+}
+
+
+/***************************************************************************************
+ * Function Name: acceptStatsClient
+ * Description:	Event loop callback for the stats socket. Receives the listening
+ * 		descriptor and an unused argument. Accepts every pending connection,
+ * 		writes the current counters to each with a single non-blocking write,
+ * 		and closes it. A client whose socket buffer cannot hold the whole
+ * 		response gets a truncated one rather than stalling the shell.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void acceptStatsClient(int fd, void* arg)
+{
+	char response[STATS_RESPONSE_BYTES];
+	int clientFd;
+
+	/* Accept connections until none are left pending. */
+	while ((clientFd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+	{
+		int length = formatShellStats(response, STATS_RESPONSE_BYTES);
+		send(clientFd, response, length, MSG_NOSIGNAL);
+		close(clientFd);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: closeShellStats
+ * Description:	Closes the stats socket (if one was opened) and removes it from the
+ * 		filesystem. Called when the shell exits. Receives and returns nothing.
+ **************************************************************************************/
+
+void closeShellStats()
+{
+	if (shellStats.listenFd != -1)
+	{
+		removeEventWatcher(shellStats.listenWatcher);
+		close(shellStats.listenFd);
+		unlink(shellStats.socketPath);
+		shellStats.listenFd = -1;
+	}
+}
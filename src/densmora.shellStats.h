@@ -0,0 +1,66 @@
+/***************************************************************************************
+ * File: densmora.shellStats.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing the definition of the ShellStats struct and
+ * 		prototypes of the functions that maintain the shell's counters and
+ * 		serve them over an optional Unix domain socket. See
+ * 		densmora.shellStats.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_SHELL_STATS
+#define DENSMORA_SHELL_STATS
+
+/* Built-in header file inclusions. */
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* My own header file inclusions. */
+#include "densmora.commands.h"
+#include "densmora.eventLoop.h"
+#include "densmora.phaseStats.h"
+
+/* Number of distinct exit codes and signal numbers tracked by the histograms. */
+#define NUM_EXIT_CODES 256
+#define NUM_SIGNALS 65
+
+/* Size of the buffer into which the stats response is formatted. */
+#define STATS_RESPONSE_BYTES 16384
+
+/* Struct storing counters describing the activity of the shell since it started. */
+
+struct ShellStats
+{
+	unsigned long commandsExecuted;			/* Commands run, including built-ins. */
+	unsigned long forkFailures;			/* Calls to fork() that failed. */
+	unsigned long backgroundQueued;			/* Background commands waiting to be launched. */
+	unsigned long launches;				/* Successful calls to fork(). */
+	unsigned long launchLatencyNsec;		/* Total time spent in successful fork() calls. */
+	unsigned long exitCodes[NUM_EXIT_CODES];	/* Number of children that exited with each code. */
+	unsigned long exitSignals[NUM_SIGNALS];		/* Number of children terminated by each signal. */
+	unsigned long cacheHits;			/* Commands replayed by the cached built-in. */
+	unsigned long cacheMisses;			/* Commands run and stored by the cached built-in. */
+	unsigned long cacheEvictions;			/* Cache entries deleted to respect the size limit. */
+	unsigned long startupUsec;			/* Time from the start of main to the first prompt. */
+	struct BackgroundCommands* bgCommandsList;	/* List whose size is the number of running jobs. */
+	int listenFd;					/* Stats socket, or -1 if not serving stats. */
+	struct EventWatcher* listenWatcher;		/* Event loop watcher of the stats socket. */
+	char* socketPath;				/* Path to which the stats socket is bound. */
+};
+
+/* Counters shared by the whole shell (see densmora.shellStats.c). */
+extern struct ShellStats shellStats;
+
+/* Function prototypes (see densmora.shellStats.c for function descriptions and implementations). */
+void initShellStats(struct BackgroundCommands* bgCommandsList);
+void recordLaunch(struct timespec* forkStart, pid_t childPid);
+void recordExitMethod(int childExitMethod);
+void recordStartup(struct timespec* mainStart);
+int formatShellStats(char* buffer, int bufferSize);
+void acceptStatsClient(int fd, void* arg);
+void closeShellStats();
+
+#endif
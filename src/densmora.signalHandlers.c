@@ -19,6 +19,11 @@ volatile sig_atomic_t allowBackgroundCommands = TRUE;
 volatile sig_atomic_t foregroundActive = FALSE;
 volatile sig_atomic_t sigtstpDuringForegroundProcess = FALSE;
 
+/* Define self-pipe declared in densmora.signalHandlers.h (both ends -1 until created). */
+int sigchldPipe[2] = { -1, -1 };
+volatile sig_atomic_t sigchldNotifyFd = -1;
+volatile sig_atomic_t sigintReceived = FALSE;
+
 /***************************************************************************************
  * Function Name: initializeSignalHandlers
  * Description:	Defines non-default actions for SIGINT and SIGTSTP signals for process
@@ -94,13 +99,13 @@ void catchSIGTSTP(int signo)
 	else if (allowBackgroundCommands == TRUE)
 	{
 		allowBackgroundCommands = FALSE;
-		write(STDOUT_FILENO, backgroundDisabled, lenBackgroundDisabled);
+		write(shellOutputFd, backgroundDisabled, lenBackgroundDisabled);
 
 		/* Print out new prompt colon if this signal was not raised by main after
 		 * a child process exited. */
 		if (sigtstpDuringForegroundProcess == FALSE)
 		{
-			write(STDOUT_FILENO, reprompt, lenReprompt);
+			write(shellOutputFd, reprompt, lenReprompt);
 		}
 	}
 
@@ -109,13 +114,13 @@ void catchSIGTSTP(int signo)
 	else
 	{
 		allowBackgroundCommands = TRUE;
-		write(STDOUT_FILENO, backgroundEnabled, lenBackgroundEnabled);
+		write(shellOutputFd, backgroundEnabled, lenBackgroundEnabled);
 
 		/* Print out new prompt colon if this signal was not raised by main after
 		 * a child process exited. */
 		if (sigtstpDuringForegroundProcess == FALSE)
 		{
-			write(STDOUT_FILENO, reprompt, lenReprompt);
+			write(shellOutputFd, reprompt, lenReprompt);
 		}
 	}
 }
@@ -151,3 +156,121 @@ void ignoreSIGTSTP()
 	SIGTSTP_action.sa_handler = SIG_IGN;
 	sigaction(SIGTSTP, &SIGTSTP_action, NULL);
 }
+
+
+/***************************************************************************************
+ * Function Name: initializeSIGCHLDPipe
+ * Description: Creates the non-blocking, close-on-exec self-pipe and registers
+ * 		catchSIGCHLD as the SIGCHLD handler so that the read end of the pipe
+ * 		becomes readable whenever a child process exits. Receives and
+ * 		returns nothing.
+ **************************************************************************************/
+
+void initializeSIGCHLDPipe()
+{
+	/* Create the pipe, reporting an error if it could not be created. */
+	if (pipe2(sigchldPipe, O_NONBLOCK | O_CLOEXEC) == -1)
+	{
+		perror("pipe2()"); fflush(stderr);
+		return;
+	}
+	sigchldPipe[0] = raiseShellFd(sigchldPipe[0]);
+	sigchldPipe[1] = raiseShellFd(sigchldPipe[1]);
+
+	/* Register catchSIGCHLD, restarting interrupted system calls and ignoring stopped children. */
+	struct sigaction SIGCHLD_action;
+	memset(&SIGCHLD_action, 0, sizeof(struct sigaction));
+	SIGCHLD_action.sa_handler = catchSIGCHLD;
+	sigfillset(&SIGCHLD_action.sa_mask);
+	SIGCHLD_action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &SIGCHLD_action, NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: catchSIGCHLD
+ * Description:	Sigaction handler function for SIGCHLD. Writes a byte to the self-pipe
+ * 		and to sigchldNotifyFd if it is set (a byte is simply dropped if its
+ * 		pipe is already full, since one unread byte is enough to wake the
+ * 		event loop), preserving errno for the code that was interrupted.
+ * 		Receives signal number (unused). Returns nothing.
+ **************************************************************************************/
+
+void catchSIGCHLD(int signo)
+{
+	int savedErrno = errno;
+	write(sigchldPipe[1], "c", 1);
+	if (sigchldNotifyFd != -1)
+	{
+		write(sigchldNotifyFd, "c", 1);
+	}
+	errno = savedErrno;
+}
+
+
+/***************************************************************************************
+ * Function Name: drainSIGCHLDPipe
+ * Description:	Reads every byte currently in the self-pipe so that it stops being
+ * 		readable until the next SIGCHLD. Called before reaping children.
+ * 		Receives and returns nothing.
+ **************************************************************************************/
+
+void drainSIGCHLDPipe()
+{
+	char buffer[256];
+	while (read(sigchldPipe[0], buffer, sizeof(buffer)) > 0)
+	{
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: interruptOnSIGINT
+ * Description:	Called by built-ins that block the prompt (such as wait) so that the
+ * 		user can interrupt them. Clears sigintReceived and registers
+ * 		catchSIGINT as the shell's SIGINT handler until ignoreSIGINT is
+ * 		called. Receives and returns nothing.
+ **************************************************************************************/
+
+void interruptOnSIGINT()
+{
+	/* Register catchSIGINT without SA_RESTART so that blocking calls return immediately. */
+	struct sigaction SIGINT_action;
+	memset(&SIGINT_action, 0, sizeof(struct sigaction));
+	SIGINT_action.sa_handler = catchSIGINT;
+	sigfillset(&SIGINT_action.sa_mask);
+	sigintReceived = FALSE;
+	sigaction(SIGINT, &SIGINT_action, NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: catchSIGINT
+ * Description:	Sigaction handler registered by interruptOnSIGINT. Sets
+ * 		sigintReceived and writes a byte to the SIGCHLD self-pipe so that an
+ * 		event loop about to wait is woken even if the signal arrives just
+ * 		before it blocks. Receives signal number (unused). Returns nothing.
+ **************************************************************************************/
+
+void catchSIGINT(int signo)
+{
+	int savedErrno = errno;
+	sigintReceived = TRUE;
+	write(sigchldPipe[1], "i", 1);
+	errno = savedErrno;
+}
+
+
+/***************************************************************************************
+ * Function Name: ignoreSIGINT
+ * Description:	Restores the shell's normal behavior of ignoring SIGINT after a
+ * 		built-in called interruptOnSIGINT. Receives and returns nothing.
+ **************************************************************************************/
+
+void ignoreSIGINT()
+{
+	struct sigaction SIGINT_action;
+	memset(&SIGINT_action, 0, sizeof(struct sigaction));
+	SIGINT_action.sa_handler = SIG_IGN;
+	sigaction(SIGINT, &SIGINT_action, NULL);
+}
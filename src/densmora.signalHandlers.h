@@ -12,12 +12,16 @@
 #define DENSMORA_SIGNAL_HANDLERS
 
 /* Built-in header file inclusions. */
+#include <stdio.h>
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 
 /* My own header file inclusion. */
 #include "densmora.smallshConstants.h"
+#include "densmora.eventLoop.h"
 
 /* Global flag variables for use by signal handlers.
  * CLASS MATERIAL CITATION: idea of using volatile sig_atmoic_t variables so that
@@ -36,10 +40,30 @@ extern volatile sig_atomic_t foregroundActive;
  * a foreground child process was executing but has not yet been processed. */
 extern volatile sig_atomic_t sigtstpDuringForegroundProcess;
 
+/* Self-pipe written to by catchSIGCHLD each time a child process changes state, so that
+ * the event loop can wake up and reap children. Index 0 is read by the shell, and index 1
+ * is written by the signal handler. */
+extern int sigchldPipe[2];
+
+/* Write end of a second pipe that catchSIGCHLD also writes to (-1 if none), for a watcher that
+ * must see every exit even while the shell drains sigchldPipe in its own waits (see
+ * holdBackgroundReaping in densmora.commands.c). */
+extern volatile sig_atomic_t sigchldNotifyFd;
+
+/* Global flag variable set by catchSIGINT while a built-in that blocks (such as wait) has asked
+ * to be interrupted by SIGINT. */
+extern volatile sig_atomic_t sigintReceived;
+
 /* Function prototypes. */
 void initializeSignalHandlers();
 void catchSIGTSTP(int signo);
 void reenableSIGINT();
 void ignoreSIGTSTP();
+void initializeSIGCHLDPipe();
+void catchSIGCHLD(int signo);
+void drainSIGCHLDPipe();
+void interruptOnSIGINT();
+void catchSIGINT(int signo);
+void ignoreSIGINT();
 
 #endif
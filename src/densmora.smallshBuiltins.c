@@ -23,7 +23,7 @@ void smallshCd(char* cdPath)
 	/* If the path passed in is NULL, set it to HOME environment variable. */
 	if (cdPath == NULL)
 	{
-		cdPath = getenv("HOME");
+		cdPath = getEnvVar("HOME");
 	}
 
 	/* Change the current directory to that specified by cdPath, storing return value for inspection. */
@@ -46,15 +46,1188 @@ void smallshCd(char* cdPath)
 
 void smallshStatus(struct ForegroundExitMethod* lastFgStatus)
 {
+	/* Note if the child was stopped by the timeout built-in. */
+	char* timeoutNote = (lastFgStatus->timedOut == TRUE) ? " (timed out)" : "";
+
 	/* If the child exited normally, print its exit status. */
 	if (lastFgStatus->exitedNormally == TRUE)
 	{
-		printf("exit value %d\n", lastFgStatus->code); fflush(stdout);
+		printf("exit value %d%s\n", lastFgStatus->code, timeoutNote); fflush(stdout);
 	}
 	
 	/* Otherwise, if the child was terminated by a signal, print the terminating signal number. */
 	else
 	{
-		printf("terminated by signal %d\n", lastFgStatus->code); fflush(stdout);
+		printf("terminated by signal %d%s\n", lastFgStatus->code, timeoutNote); fflush(stdout);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshWait
+ * Description:	Receives the args of a wait command ("wait", "wait -n", or
+ * 		"wait PID..."), a ForegroundExitMethod struct pointer, and the
+ * 		BackgroundCommands list. Blocks until every background job, the first
+ * 		job to finish (-n), or every listed job has finished, sleeping in the
+ * 		event loop until SIGCHLD rather than polling. Jobs that finish are
+ * 		reported and removed through checkCommandStatuses, so they are not
+ * 		reported again at the next prompt. Stores the exit method of the
+ * 		finished job (the last listed pid, or the last job to finish) in
+ * 		lastFgStatus. SIGINT interrupts the wait. Returns nothing.
+ **************************************************************************************/
+
+void smallshWait(char** args, struct ForegroundExitMethod* lastFgStatus, struct BackgroundCommands* bgCommandsList)
+{
+	struct WaitRequest request;
+	int numArgs = 0;
+
+	/* Count the args after "wait" so that arrays for the listed pids can be allocated. */
+	while (args[numArgs + 1] != NULL)
+	{
+		numArgs++;
+	}
+	memset(&request, 0, sizeof(struct WaitRequest));
+	request.pids = (pid_t*)malloc((numArgs + 1) * sizeof(pid_t));
+	request.finished = (int*)calloc(numArgs + 1, sizeof(int));
+	request.exitMethods = (int*)calloc(numArgs + 1, sizeof(int));
+
+	/* Store "-n" as a flag and every other arg as a pid, reporting any that are not background jobs. */
+	for (int i = 1; args[i] != NULL; i++)
+	{
+		char* endPtr;
+		long pid = strtol(args[i], &endPtr, 10);
+
+		if (strcmp(args[i], "-n") == 0)
+		{
+			request.waitForAny = TRUE;
+		}
+		else if (*endPtr != '\0' || pid <= 0 || findBackgroundNode(bgCommandsList, (pid_t)pid) == NULL)
+		{
+			fprintf(stderr, "wait: pid %s is not a background job of this shell\n", args[i]); fflush(stderr);
+		}
+		else
+		{
+			request.pids[request.numPids++] = (pid_t)pid;
+		}
+	}
+
+	/* If pids were given but none were valid, or there is nothing to wait on for -n, exit with 127 like bash. */
+	if ((request.numPids == 0 && numArgs > (request.waitForAny == TRUE ? 1 : 0))
+	    || (request.waitForAny == TRUE && bgCommandsList->numNodes == 0))
+	{
+		lastFgStatus->code = 127;
+		lastFgStatus->exitedNormally = TRUE;
+		lastFgStatus->timedOut = FALSE;
+	}
+
+	/* Otherwise, wait for the requested jobs, being told of each exit by observeWaitReap. */
+	else
+	{
+		bgCommandsList->reapObserver = observeWaitReap;
+		bgCommandsList->reapObserverArg = &request;
+		interruptOnSIGINT();
+		struct EventWatcher* sigchldWatcher = addEventWatcher(sigchldPipe[0], wakeOnChildExit, NULL);
+
+		/* Reap finished jobs until the request is satisfied or SIGINT is received, sleeping in the event
+		 * loop in between. The self-pipe is drained before reaping, so a SIGCHLD that arrives after
+		 * reaping leaves a byte in it and the event loop will not sleep through that exit. */
+		while (TRUE)
+		{
+			drainSIGCHLDPipe();
+			checkCommandStatuses(bgCommandsList);
+			if (waitIsSatisfied(&request, bgCommandsList) == TRUE || sigintReceived == TRUE)
+			{
+				break;
+			}
+			runEventLoopOnce(-1);
+		}
+
+		/* Stop watching for exits and restore the shell's usual SIGINT handling. */
+		removeEventWatcher(sigchldWatcher);
+		freeRemovedWatchers();
+		ignoreSIGINT();
+		bgCommandsList->reapObserver = NULL;
+		bgCommandsList->reapObserverArg = NULL;
+
+		/* If interrupted, report it and store SIGINT as the status like an interrupted foreground command. */
+		if (sigintReceived == TRUE)
+		{
+			fprintf(shellOutput, "\nwait interrupted by signal %d\n", SIGINT); fflush(shellOutput);
+			lastFgStatus->code = SIGINT;
+			lastFgStatus->exitedNormally = FALSE;
+			lastFgStatus->timedOut = FALSE;
+		}
+
+		/* Otherwise, if pids were listed, store the exit method of the last one. */
+		else if (request.numPids > 0)
+		{
+			setExitMethod(lastFgStatus, request.exitMethods[request.numPids - 1]);
+		}
+
+		/* Otherwise, store the exit method of the last job to finish (or 0 if there were none). */
+		else if (request.anyFinished == TRUE)
+		{
+			setExitMethod(lastFgStatus, request.lastExitMethod);
+		}
+		else
+		{
+			lastFgStatus->code = 0;
+			lastFgStatus->exitedNormally = TRUE;
+			lastFgStatus->timedOut = FALSE;
+		}
+	}
+
+	/* Free memory allocated for the request. */
+	free(request.pids);
+	free(request.finished);
+	free(request.exitMethods);
+}
+
+
+/***************************************************************************************
+ * Function Name: observeWaitReap
+ * Description:	reapObserver of the BackgroundCommands list while wait is running.
+ * 		Receives the pid and exit method of a job that finished and the
+ * 		WaitRequest. Records the exit in the request. Returns nothing.
+ **************************************************************************************/
+
+void observeWaitReap(pid_t pid, int childExitMethod, void* arg)
+{
+	struct WaitRequest* request = (struct WaitRequest*)arg;
+
+	/* Record that a job finished and how. */
+	request->anyFinished = TRUE;
+	request->lastExitMethod = childExitMethod;
+
+	/* Mark the pid as finished if it was listed. */
+	for (int i = 0; i < request->numPids; i++)
+	{
+		if (request->pids[i] == pid)
+		{
+			request->finished[i] = TRUE;
+			request->exitMethods[i] = childExitMethod;
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: waitIsSatisfied
+ * Description:	Receives a WaitRequest and the BackgroundCommands list. Returns TRUE
+ * 		if the wait can return: any job has finished (-n), every listed pid
+ * 		has finished, or (with no pids) no background jobs remain. Returns
+ * 		FALSE otherwise.
+ **************************************************************************************/
+
+int waitIsSatisfied(struct WaitRequest* request, struct BackgroundCommands* bgCommandsList)
+{
+	/* For -n, return as soon as any job has finished (or no job is left that could). */
+	if (request->waitForAny == TRUE)
+	{
+		return (request->anyFinished == TRUE || bgCommandsList->numNodes == 0) ? TRUE : FALSE;
+	}
+
+	/* With no pids, wait until no background jobs remain. */
+	if (request->numPids == 0)
+	{
+		return (bgCommandsList->numNodes == 0) ? TRUE : FALSE;
+	}
+
+	/* Otherwise, wait until every listed pid has finished. */
+	for (int i = 0; i < request->numPids; i++)
+	{
+		if (request->finished[i] == FALSE)
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshTimeout
+ * Description:	Receives a parsed "timeout [-s SIG] [-k GRACE] DURATION command..."
+ * 		command, a ForegroundExitMethod struct pointer, and the
+ * 		BackgroundCommands list. Runs the command (in the background if
+ * 		requested and allowed, or the foreground otherwise), sending it SIG
+ * 		(SIGTERM by default) once DURATION passes and, if -k was given,
+ * 		SIGKILL once GRACE passes after that. Durations are numbers of seconds
+ * 		(fractions allowed) with an optional s, m, h, or d suffix. A DURATION
+ * 		of 0 runs the command with no deadline, and a GRACE of 0 never sends
+ * 		SIGKILL (as with GNU timeout). Deadlines
+ * 		are kept on the shell's timer heap, so no extra process or thread is
+ * 		used. On a usage error, stores exit value 125 in lastFgStatus.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void smallshTimeout(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		    struct BackgroundCommands* bgCommandsList)
+{
+	char** args = myCommand->commandArgs;
+	struct TimeoutRequest request;
+	int argIndex = 1;
+
+	/* Parse the options, defaulting to SIGTERM and no grace period. */
+	request.signal = SIGTERM;
+	request.graceUsec = 0;
+	while (args[argIndex] != NULL && args[argIndex + 1] != NULL
+	       && (strcmp(args[argIndex], "-s") == 0 || strcmp(args[argIndex], "-k") == 0))
+	{
+		if (strcmp(args[argIndex], "-s") == 0)
+		{
+			request.signal = parseSignal(args[argIndex + 1]);
+			if (request.signal == -1)
+			{
+				fprintf(stderr, "timeout: %s: invalid signal\n", args[argIndex + 1]); fflush(stderr);
+				setUsageError(lastFgStatus);
+				return;
+			}
+		}
+		else
+		{
+			request.graceUsec = parseDuration(args[argIndex + 1]);
+			if (request.graceUsec == -1)
+			{
+				fprintf(stderr, "timeout: %s: invalid time interval\n", args[argIndex + 1]); fflush(stderr);
+				setUsageError(lastFgStatus);
+				return;
+			}
+		}
+		argIndex += 2;
+	}
+
+	/* Parse the duration and make sure a command follows it. */
+	if (args[argIndex] == NULL || args[argIndex + 1] == NULL)
+	{
+		fprintf(stderr, "usage: timeout [-s signal] [-k grace] duration command [args...]\n"); fflush(stderr);
+		setUsageError(lastFgStatus);
+		return;
+	}
+	request.durationUsec = parseDuration(args[argIndex]);
+	if (request.durationUsec == -1)
+	{
+		fprintf(stderr, "timeout: %s: invalid time interval\n", args[argIndex]); fflush(stderr);
+		setUsageError(lastFgStatus);
+		return;
+	}
+	argIndex++;
+
+	/* Built-ins run inside the shell itself, so they cannot be signaled on their own. */
+	if (isBuiltinName(args[argIndex]) == TRUE)
+	{
+		fprintf(stderr, "timeout: %s: built-in commands cannot be timed\n", args[argIndex]); fflush(stderr);
+		setUsageError(lastFgStatus);
+		return;
+	}
+
+	/* Shift the command (including the terminating NULL) to the front of commandArgs. */
+	int shift = argIndex;
+	for (argIndex = 0; args[argIndex + shift - 1] != NULL; argIndex++)
+	{
+		args[argIndex] = args[argIndex + shift];
+	}
+
+	/* A duration of 0 means no deadline, so the command runs as if timeout had not been given. */
+	struct TimeoutRequest* deadline = (request.durationUsec > 0) ? &request : NULL;
+
+	/* Run the command in the background if requested and allowed, like any other background launch
+	 * (so that it may be delayed and holds a jobserver token), starting its deadline once launched. */
+	if (myCommand->backgroundFlag == TRUE && allowBackgroundCommands == TRUE)
+	{
+		runBackground(myCommand, bgCommandsList, deadline);
+	}
+
+	/* Otherwise, run it in the foreground with its deadline (if any). */
+	else
+	{
+		runForeground(myCommand, lastFgStatus, deadline);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: parseDuration
+ * Description:	Receives a duration given to the timeout built-in: a non-negative
+ * 		number of seconds (fractions allowed) with an optional s, m, h, or d
+ * 		suffix. Returns the duration in microseconds, or -1 if it is invalid.
+ **************************************************************************************/
+
+long parseDuration(char* durationString)
+{
+	char* endPtr;
+	double seconds = strtod(durationString, &endPtr);
+
+	/* Reject strings that do not start with a number or that are negative. */
+	if (endPtr == durationString || seconds < 0)
+	{
+		return -1;
+	}
+
+	/* Apply the unit suffix, if any. */
+	if (strcmp(endPtr, "m") == 0)
+	{
+		seconds *= 60;
+	}
+	else if (strcmp(endPtr, "h") == 0)
+	{
+		seconds *= 60 * 60;
+	}
+	else if (strcmp(endPtr, "d") == 0)
+	{
+		seconds *= 24 * 60 * 60;
+	}
+	else if (strcmp(endPtr, "") != 0 && strcmp(endPtr, "s") != 0)
+	{
+		return -1;
+	}
+
+	/* Reject durations too long to represent in microseconds. */
+	if (seconds > MAX_TIMEOUT_SECONDS)
+	{
+		return -1;
+	}
+	return (long)(seconds * 1000000.0);
+}
+
+
+/***************************************************************************************
+ * Function Name: parseSignal
+ * Description:	Receives a signal given to the timeout built-in as a number or a name
+ * 		(with or without the SIG prefix, such as "9", "KILL", or "SIGINT").
+ * 		Returns the signal number, or -1 if it is invalid.
+ **************************************************************************************/
+
+int parseSignal(char* signalString)
+{
+	/* Signals that can be given by name. */
+	static const struct { const char* name; int number; } signalNames[] = {
+		{ "HUP", SIGHUP }, { "INT", SIGINT }, { "QUIT", SIGQUIT }, { "ABRT", SIGABRT },
+		{ "KILL", SIGKILL }, { "USR1", SIGUSR1 }, { "USR2", SIGUSR2 }, { "PIPE", SIGPIPE },
+		{ "ALRM", SIGALRM }, { "TERM", SIGTERM }, { "CONT", SIGCONT }, { "STOP", SIGSTOP }
+	};
+	char* endPtr;
+
+	/* Accept a signal number. */
+	long number = strtol(signalString, &endPtr, 10);
+	if (endPtr != signalString && *endPtr == '\0')
+	{
+		return (number > 0 && number < NSIG) ? (int)number : -1;
+	}
+
+	/* Otherwise, look the name up, ignoring any SIG prefix. */
+	if (strncmp(signalString, "SIG", 3) == 0)
+	{
+		signalString += 3;
+	}
+	for (int i = 0; i < (int)(sizeof(signalNames) / sizeof(signalNames[0])); i++)
+	{
+		if (strcmp(signalString, signalNames[i].name) == 0)
+		{
+			return signalNames[i].number;
+		}
+	}
+	return -1;
+}
+
+
+/***************************************************************************************
+ * Function Name: isBuiltinName
+ * Description:	Receives the first word of a command. Returns TRUE if it names a
+ * 		command built into smallsh, or FALSE otherwise.
+ **************************************************************************************/
+
+int isBuiltinName(char* name)
+{
+	static const char* builtinNames[] = { "exit", "cd", "status", "wait", "timeout", "joblog", "export", "unset", "cached", "bench",
+						    "alias", "unalias", "stats", "batch", "exec", "after",
+						    "watch" };
+
+	for (int i = 0; i < (int)(sizeof(builtinNames) / sizeof(builtinNames[0])); i++)
+	{
+		if (strcmp(name, builtinNames[i]) == 0)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: setUsageError
+ * Description:	Receives a ForegroundExitMethod struct pointer. Stores exit value 125,
+ * 		the status timeout reports when it is used incorrectly. Returns nothing.
+ **************************************************************************************/
+
+void setUsageError(struct ForegroundExitMethod* lastFgStatus)
+{
+	lastFgStatus->code = 125;
+	lastFgStatus->exitedNormally = TRUE;
+	lastFgStatus->timedOut = FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshJoblog
+ * Description:	Receives the args of a joblog command. "joblog" lists the background
+ * 		jobs whose output has been captured, and "joblog PID" prints the
+ * 		captured output of that job (which is kept for a while after it
+ * 		finishes). Output is only captured when SMALLSH_JOBLOG_KB is set.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void smallshJoblog(char** args)
+{
+	/* With no args, list every captured job. */
+	if (args[1] == NULL)
+	{
+		listJobLogs();
+		return;
+	}
+
+	/* Otherwise, print the output of the requested job. */
+	char* endPtr;
+	long pid = strtol(args[1], &endPtr, 10);
+	struct JobLog* jobLog = NULL;
+	if (*endPtr == '\0' && pid > 0)
+	{
+		jobLog = findJobLog((pid_t)pid);
+	}
+	if (jobLog == NULL)
+	{
+		fprintf(stderr, "joblog: no captured output for pid %s\n", args[1]); fflush(stderr);
+		return;
+	}
+	printJobLog(jobLog);
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshStats
+ * Description:	Receives the args of a stats command. Prints the count, mean,
+ * 		percentiles, and maximum of the time taken by each phase of running
+ * 		commands, and then empties the histograms if the arg is -r.
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void smallshStats(char** args)
+{
+	if (args[1] != NULL && (strcmp(args[1], "-r") != 0 || args[2] != NULL))
+	{
+		fprintf(stderr, "usage: stats [-r]\n"); fflush(stderr);
+		return;
+	}
+	printPhaseStats();
+	if (args[1] != NULL)
+	{
+		resetPhaseStats();
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshExport
+ * Description:	Receives the args of an export command. Sets each NAME=value arg in
+ * 		the environment passed to child processes (a bare NAME is accepted
+ * 		and left unchanged, since every variable is exported). With no args,
+ * 		prints the environment. Returns nothing.
+ **************************************************************************************/
+
+void smallshExport(char** args)
+{
+	if (args[1] == NULL)
+	{
+		printEnvironment();
+		return;
+	}
+
+	for (int i = 1; args[i] != NULL; i++)
+	{
+		if (isEnvAssignment(args[i]) == TRUE)
+		{
+			setEnvPair(args[i]);
+		}
+		else if (strchr(args[i], '=') != NULL || isValidEnvName(args[i]) == FALSE)
+		{
+			fprintf(stderr, "export: %s: not a valid identifier\n", args[i]); fflush(stderr);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshUnset
+ * Description:	Receives the args of an unset command. Removes each named variable
+ * 		from the environment passed to child processes. Returns nothing.
+ **************************************************************************************/
+
+void smallshUnset(char** args)
+{
+	for (int i = 1; args[i] != NULL; i++)
+	{
+		unsetEnvVar(args[i]);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: isValidEnvName
+ * Description:	Receives a word. Returns TRUE if it is a valid variable name, or
+ * 		FALSE otherwise.
+ **************************************************************************************/
+
+int isValidEnvName(char* name)
+{
+	/* A name is valid exactly when "name=" is an assignment. */
+	char* assignment = (char*)malloc(strlen(name) + 2);
+	sprintf(assignment, "%s=", name);
+	int isValid = isEnvAssignment(assignment);
+	free(assignment);
+	return isValid;
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshCached
+ * Description:	Receives a parsed "cached [-i FILE]... [-e VAR]... command..." (or
+ * 		"cached --stats") command and a ForegroundExitMethod struct pointer.
+ * 		Runs the command in the foreground through the result cache, where
+ * 		-i names an input file and -e an environment variable that the
+ * 		command's result depends on (besides its args and < file). Prints the
+ * 		cache's statistics for --stats. On a usage error, stores exit value
+ * 		125 in lastFgStatus. Returns nothing.
+ **************************************************************************************/
+
+void smallshCached(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus)
+{
+	char** args = myCommand->commandArgs;
+	struct CacheRequest request;
+	int argIndex = 1;
+
+	if (args[1] != NULL && strcmp(args[1], "--stats") == 0)
+	{
+		printCacheStats();
+		return;
+	}
+
+	/* Collect the declared inputs (pointing into args, which can hold no more of them than it has words). */
+	int numWords = 0;
+	while (args[numWords] != NULL)
+	{
+		numWords++;
+	}
+	memset(&request, 0, sizeof(struct CacheRequest));
+	request.inputFiles = (char**)malloc((numWords + 1) * sizeof(char*));
+	request.envNames = (char**)malloc((numWords + 1) * sizeof(char*));
+	while (args[argIndex] != NULL && args[argIndex + 1] != NULL
+	       && (strcmp(args[argIndex], "-i") == 0 || strcmp(args[argIndex], "-e") == 0))
+	{
+		if (strcmp(args[argIndex], "-i") == 0)
+		{
+			request.inputFiles[request.numInputFiles++] = args[argIndex + 1];
+		}
+		else
+		{
+			request.envNames[request.numEnvNames++] = args[argIndex + 1];
+		}
+		argIndex += 2;
+	}
+
+	/* Make sure an external command follows. */
+	if (args[argIndex] == NULL)
+	{
+		fprintf(stderr, "usage: cached [-i file]... [-e variable]... command [args...]\n"); fflush(stderr);
+		setUsageError(lastFgStatus);
+	}
+	else if (isBuiltinName(args[argIndex]) == TRUE)
+	{
+		fprintf(stderr, "cached: %s: built-in commands cannot be cached\n", args[argIndex]); fflush(stderr);
+		setUsageError(lastFgStatus);
+	}
+
+	/* Otherwise, shift the command (including the terminating NULL) to the front of commandArgs and run it. */
+	else
+	{
+		int shift = argIndex;
+		for (argIndex = 0; args[argIndex + shift - 1] != NULL; argIndex++)
+		{
+			args[argIndex] = args[argIndex + shift];
+		}
+		runCached(myCommand, &request, lastFgStatus);
+	}
+	free(request.inputFiles);
+	free(request.envNames);
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshBench
+ * Description:	Receives a parsed "bench [-n RUNS] [-w WARMUP] [--prepare words... --]
+ * 		[--export-csv FILE] [--export-json FILE] command..." command and a
+ * 		ForegroundExitMethod struct pointer. Runs the command WARMUP times
+ * 		(default 0) and then RUNS times (default 10) in the foreground with
+ * 		its output discarded, running the prepare command before each run,
+ * 		and reports latency statistics. On a usage error, stores exit value
+ * 		125 in lastFgStatus. Returns nothing.
+ **************************************************************************************/
+
+void smallshBench(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus)
+{
+	char** args = myCommand->commandArgs;
+	struct BenchRequest request;
+	int argIndex = 1;
+	int usageError = FALSE;
+
+	memset(&request, 0, sizeof(struct BenchRequest));
+	request.numRuns = DEFAULT_BENCH_RUNS;
+	request.numWarmup = DEFAULT_BENCH_WARMUP;
+
+	/* Parse the options. */
+	while (args[argIndex] != NULL && args[argIndex + 1] != NULL && args[argIndex][0] == '-' && usageError == FALSE)
+	{
+		char* option = args[argIndex];
+		char* value = args[argIndex + 1];
+		char* endPtr;
+		argIndex += 2;
+
+		if (strcmp(option, "-n") == 0 || strcmp(option, "-w") == 0)
+		{
+			long count = strtol(value, &endPtr, 10);
+			if (*endPtr != '\0' || count < (option[1] == 'n' ? 1 : 0) || count > MAX_BENCH_RUNS)
+			{
+				fprintf(stderr, "bench: %s: invalid number of runs\n", value); fflush(stderr);
+				usageError = TRUE;
+			}
+			*(option[1] == 'n' ? &request.numRuns : &request.numWarmup) = (int)count;
+		}
+		else if (strcmp(option, "--export-csv") == 0)
+		{
+			request.csvPath = value;
+		}
+		else if (strcmp(option, "--export-json") == 0)
+		{
+			request.jsonPath = value;
+		}
+
+		/* The prepare command is every word up to "--", parsed like a line of its own. */
+		else if (strcmp(option, "--prepare") == 0 && request.prepareCommand == NULL)
+		{
+			int firstWord = argIndex - 1;
+			while (args[argIndex - 1] != NULL && strcmp(args[argIndex - 1], "--") != 0)
+			{
+				argIndex++;
+			}
+			if (args[argIndex - 1] == NULL)
+			{
+				usageError = TRUE;
+				break;
+			}
+			char* prepareLine = (char*)calloc(MAX_COMMAND_CHARS + 1, 1);
+			for (int i = firstWord; i < argIndex - 1; i++)
+			{
+				strncat(prepareLine, args[i], MAX_COMMAND_CHARS - strlen(prepareLine));
+				strncat(prepareLine, " ", MAX_COMMAND_CHARS - strlen(prepareLine));
+			}
+			prepareLine[strlen(prepareLine) - 1] = '\0';
+			request.prepareCommand = newCommandFromLine(prepareLine);
+			free(prepareLine);
+			if (request.prepareCommand == NULL || request.prepareCommand->commandArgs[0] == NULL
+			    || isBuiltinName(request.prepareCommand->commandArgs[0]) == TRUE)
+			{
+				fprintf(stderr, "bench: the prepare command must be an external command\n"); fflush(stderr);
+				usageError = TRUE;
+			}
+		}
+		else
+		{
+			argIndex -= 2;
+			break;
+		}
+	}
+
+	/* Make sure an external command follows the options. */
+	if (usageError == FALSE && (args[argIndex] == NULL || args[argIndex][0] == '-'))
+	{
+		usageError = TRUE;
+	}
+	if (usageError == FALSE && isBuiltinName(args[argIndex]) == TRUE)
+	{
+		fprintf(stderr, "bench: %s: built-in commands cannot be benchmarked\n", args[argIndex]); fflush(stderr);
+		usageError = TRUE;
+	}
+
+	if (usageError == TRUE)
+	{
+		fprintf(stderr, "usage: bench [-n runs] [-w warmup] [--prepare command... --] "
+			"[--export-csv file] [--export-json file] command [args...]\n");
+		fflush(stderr);
+		setUsageError(lastFgStatus);
+	}
+
+	/* Otherwise, shift the command (including the terminating NULL) to the front of commandArgs and measure it. */
+	else
+	{
+		int shift = argIndex;
+		for (argIndex = 0; args[argIndex + shift - 1] != NULL; argIndex++)
+		{
+			args[argIndex] = args[argIndex + shift];
+		}
+		runBenchmark(myCommand, &request, lastFgStatus);
+	}
+
+	if (request.prepareCommand != NULL)
+	{
+		deleteCommand(request.prepareCommand);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshBatch
+ * Description:	Receives a parsed "batch [-n MAX] [-P JOBS] command... [< list]"
+ * 		command, a ForegroundExitMethod struct pointer, and the
+ * 		BackgroundCommands list. Runs the command with the items of the list
+ * 		(one per line, read from stdin if there is no < file) appended to its
+ * 		args, packing as many into each invocation as fit (or MAX, if -n is
+ * 		given), with up to JOBS invocations running at once (default 1, or
+ * 		one per CPU for -P 0). On a usage error, stores exit value 125 in
+ * 		lastFgStatus. Returns nothing.
+ **************************************************************************************/
+
+void smallshBatch(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList)
+{
+	char** args = myCommand->commandArgs;
+	struct BatchRun run;
+	int argIndex = 1;
+	int usageError = FALSE;
+
+	memset(&run, 0, sizeof(struct BatchRun));
+	run.maxJobs = 1;
+
+	/* Parse the options. */
+	while (args[argIndex] != NULL && args[argIndex + 1] != NULL && usageError == FALSE
+	       && (strcmp(args[argIndex], "-n") == 0 || strcmp(args[argIndex], "-P") == 0))
+	{
+		char* endPtr;
+		long value = strtol(args[argIndex + 1], &endPtr, 10);
+		if (args[argIndex][1] == 'n')
+		{
+			if (*endPtr != '\0' || value < 1)
+			{
+				fprintf(stderr, "batch: %s: invalid number of items\n", args[argIndex + 1]); fflush(stderr);
+				usageError = TRUE;
+			}
+			run.maxItems = value;
+		}
+		else
+		{
+			if (*endPtr != '\0' || value < 0 || value > MAX_BATCH_JOBS)
+			{
+				fprintf(stderr, "batch: %s: invalid number of jobs\n", args[argIndex + 1]); fflush(stderr);
+				usageError = TRUE;
+			}
+			run.maxJobs = (value == 0) ? (int)sysconf(_SC_NPROCESSORS_ONLN) : (int)value;
+		}
+		argIndex += 2;
+	}
+
+	/* Make sure an external command follows the options, and that its output goes to at most one file. */
+	if (usageError == FALSE && args[argIndex] == NULL)
+	{
+		fprintf(stderr, "usage: batch [-n max] [-P jobs] command [args...] [< list]\n"); fflush(stderr);
+		usageError = TRUE;
+	}
+	else if (usageError == FALSE && isBuiltinName(args[argIndex]) == TRUE)
+	{
+		fprintf(stderr, "batch: %s: built-in commands cannot be batched\n", args[argIndex]); fflush(stderr);
+		usageError = TRUE;
+	}
+	else if (usageError == FALSE && myCommand->numExtraOutputDests > 0)
+	{
+		fprintf(stderr, "batch: output can only be redirected to one file\n"); fflush(stderr);
+		usageError = TRUE;
+	}
+
+	if (usageError == TRUE)
+	{
+		setUsageError(lastFgStatus);
+	}
+
+	/* Otherwise, shift the command (including the terminating NULL) to the front of commandArgs and run it. */
+	else
+	{
+		int shift = argIndex;
+		for (argIndex = 0; args[argIndex + shift - 1] != NULL; argIndex++)
+		{
+			args[argIndex] = args[argIndex + shift];
+		}
+		if (run.maxJobs < 1)
+		{
+			run.maxJobs = 1;
+		}
+		runBatchCommand(myCommand, &run, lastFgStatus, bgCommandsList);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshExec
+ * Description:	Receives a parsed "exec [redirection...] [command...] [< file]
+ * 		[> file]" command and a ForegroundExitMethod struct pointer. Without
+ * 		a command, applies the redirections (see parseShellRedirection) to
+ * 		the shell's own descriptors, so that every later command inherits
+ * 		them, storing 0 in lastFgStatus, or 1 if one fails (the ones before
+ * 		it stay in effect). With a command, applies them and replaces the
+ * 		shell with the command; if it cannot be executed, the redirections
+ * 		are undone and 127 (not found) or 126 is stored. Returns nothing.
+ **************************************************************************************/
+
+void smallshExec(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus)
+{
+	char** args = myCommand->commandArgs;
+	int numArgs = 0;
+	int numRedirs = 0;
+	int argIndex = 1;
+	int exitStatus = 0;
+
+	while (args[numArgs] != NULL)
+	{
+		numArgs++;
+	}
+	struct ShellRedirection* redirs = (struct ShellRedirection*)malloc((numArgs + 2) * sizeof(struct ShellRedirection));
+
+	/* Parse the redirections given as words, and then the < and > redirections of the command line. */
+	while (args[argIndex] != NULL && exitStatus == 0)
+	{
+		int numWords = parseShellRedirection(args + argIndex, &redirs[numRedirs]);
+		if (numWords == 0)
+		{
+			break;
+		}
+		else if (numWords == -1)
+		{
+			exitStatus = 1;
+		}
+		else
+		{
+			numRedirs++;
+			argIndex += numWords;
+		}
+	}
+	if (myCommand->numExtraOutputDests > 0)
+	{
+		fprintf(stderr, "exec: output can only be redirected to one file\n"); fflush(stderr);
+		exitStatus = 1;
+	}
+	if (myCommand->outputFlag == TRUE)
+	{
+		char* words[] = { ">", myCommand->outputRedirDest, NULL };
+		parseShellRedirection(words, &redirs[numRedirs++]);
+	}
+	if (myCommand->inputFlag == TRUE)
+	{
+		char* words[] = { "<", myCommand->inputRedirDest, NULL };
+		parseShellRedirection(words, &redirs[numRedirs++]);
+	}
+
+	/* Apply the redirections in order, keeping copies of the old descriptors if a command is to replace the shell. */
+	int replaceShell = (args[argIndex] != NULL) ? TRUE : FALSE;
+	for (int i = 0; i < numRedirs && exitStatus == 0; i++)
+	{
+		if (applyShellRedirection(&redirs[i], replaceShell) == FALSE)
+		{
+			exitStatus = 1;
+			if (replaceShell == TRUE)
+			{
+				undoShellRedirections(redirs, i);
+			}
+		}
+	}
+
+	/* Replace the shell with the command, with SIGINT back to its default action and any events
+	 * still buffered written out. If that fails, report it and put everything back. */
+	if (replaceShell == TRUE && exitStatus == 0)
+	{
+		char** envp = getEnvp();
+		if (myCommand->numEnvAssignments > 0)
+		{
+			envp = overrideEnvp(myCommand->envAssignments, myCommand->numEnvAssignments);
+		}
+		flushEventLog();
+		fflush(stdout);
+		fflush(stderr);
+		reenableSIGINT();
+		execWithEnvironment(args + argIndex, envp);
+		int execErrno = errno;
+		ignoreSIGINT();
+		undoShellRedirections(redirs, numRedirs);
+		fprintf(stderr, "exec: %s: %s\n", args[argIndex], strerror(execErrno)); fflush(stderr);
+		exitStatus = (execErrno == ENOENT) ? 127 : 126;
+		if (myCommand->numEnvAssignments > 0)
+		{
+			free(envp);
+		}
+	}
+
+	setExitMethod(lastFgStatus, exitStatus << 8);
+	free(redirs);
+}
+
+/***************************************************************************************
+ * Function Name: smallshAfter
+ * Description:	Receives a parsed "after [-s] [-n NAME] [PID|NAME]... -- command..."
+ * 		command, a ForegroundExitMethod struct pointer, and the
+ * 		BackgroundCommands list. Defines a background job that is launched
+ * 		once every background job and named job it depends on has finished
+ * 		(right away if none are pending), named NAME if -n is given, and
+ * 		cancelled instead if -s is given and a dependency failed. Without
+ * 		args, lists the jobs defined this way. Stores exit value 0, 1 if the
+ * 		job cannot be defined, or 125 on a usage error. Returns nothing.
+ **************************************************************************************/
+
+void smallshAfter(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList)
+{
+	char** args = myCommand->commandArgs;
+	char* name = NULL;
+	int requireSuccess = FALSE;
+	int argIndex = 1;
+	int usageError = FALSE;
+
+	/* Without args, list the jobs. */
+	if (args[1] == NULL)
+	{
+		printJobGraph(bgCommandsList->jobGraph);
+		setExitMethod(lastFgStatus, 0);
+		return;
+	}
+
+	/* Parse the options. */
+	while (args[argIndex] != NULL && usageError == FALSE
+	       && (strcmp(args[argIndex], "-s") == 0 || strcmp(args[argIndex], "-n") == 0))
+	{
+		if (args[argIndex][1] == 's')
+		{
+			requireSuccess = TRUE;
+			argIndex++;
+		}
+		else if (args[argIndex + 1] == NULL || isValidEnvName(args[argIndex + 1]) == FALSE)
+		{
+			fprintf(stderr, "after: %s: invalid job name\n", (args[argIndex + 1] != NULL) ? args[argIndex + 1] : "");
+			fflush(stderr);
+			usageError = TRUE;
+		}
+		else
+		{
+			name = args[argIndex + 1];
+			argIndex += 2;
+		}
+	}
+
+	/* The dependencies run up to "--", and each is a pid or a job name. */
+	int firstDependency = argIndex;
+	while (usageError == FALSE && args[argIndex] != NULL && strcmp(args[argIndex], "--") != 0)
+	{
+		char* endPtr;
+		strtol(args[argIndex], &endPtr, 10);
+		if (*endPtr != '\0' && isValidEnvName(args[argIndex]) == FALSE)
+		{
+			fprintf(stderr, "after: %s: not a pid or job name\n", args[argIndex]); fflush(stderr);
+			usageError = TRUE;
+		}
+		argIndex++;
+	}
+	int numDependencies = argIndex - firstDependency;
+
+	/* Make sure an external command follows. */
+	if (usageError == FALSE && (args[argIndex] == NULL || args[argIndex + 1] == NULL))
+	{
+		fprintf(stderr, "usage: after [-s] [-n name] [pid|name]... -- command [args...]\n"); fflush(stderr);
+		usageError = TRUE;
+	}
+	else if (usageError == FALSE && isBuiltinName(args[argIndex + 1]) == TRUE)
+	{
+		fprintf(stderr, "after: %s: built-in commands cannot be run by after\n", args[argIndex + 1]); fflush(stderr);
+		usageError = TRUE;
+	}
+
+	if (usageError == TRUE)
+	{
+		setUsageError(lastFgStatus);
+	}
+
+	/* Otherwise, define the job with a copy of the command, which outlives this line. */
+	else
+	{
+		struct CommandInfo* command = copyCommand(myCommand, argIndex + 1);
+		command->backgroundFlag = TRUE;
+		int defined = defineGraphJob(bgCommandsList, name, args + firstDependency, numDependencies,
+					     requireSuccess, command);
+		setExitMethod(lastFgStatus, (defined == TRUE) ? 0 : 1 << 8);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshWatch
+ * Description:	Receives a parsed "watch [-d DEBOUNCE] [-s SIGNAL] PATH... -- command..."
+ * 		command, a ForegroundExitMethod struct pointer, and the
+ * 		BackgroundCommands list. Runs the command in the foreground, and
+ * 		again each time files under the paths change, gathering the changes
+ * 		made within DEBOUNCE (default 0.1 seconds) of the first into one run
+ * 		and sending SIGNAL (default SIGTERM) to a run still going, until
+ * 		SIGINT is received. On a usage error, stores exit value 125 in
+ * 		lastFgStatus. Returns nothing.
+ **************************************************************************************/
+
+void smallshWatch(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList)
+{
+	char** args = myCommand->commandArgs;
+	struct WatchRun run;
+	int argIndex = 1;
+	int usageError = FALSE;
+
+	run.debounceUsec = DEFAULT_WATCH_DEBOUNCE_USEC;
+	run.signal = SIGTERM;
+
+	/* Parse the options. */
+	while (args[argIndex] != NULL && args[argIndex + 1] != NULL && usageError == FALSE
+	       && (strcmp(args[argIndex], "-d") == 0 || strcmp(args[argIndex], "-s") == 0))
+	{
+		char* value = args[argIndex + 1];
+		if (args[argIndex][1] == 'd')
+		{
+			run.debounceUsec = parseDuration(value);
+			if (run.debounceUsec == -1)
+			{
+				fprintf(stderr, "watch: %s: invalid duration\n", value); fflush(stderr);
+				usageError = TRUE;
+			}
+		}
+		else
+		{
+			run.signal = parseSignal(value);
+			if (run.signal == -1)
+			{
+				fprintf(stderr, "watch: %s: invalid signal\n", value); fflush(stderr);
+				usageError = TRUE;
+			}
+		}
+		argIndex += 2;
+	}
+
+	/* The paths run up to "--", and a command follows. */
+	int firstPath = argIndex;
+	while (args[argIndex] != NULL && strcmp(args[argIndex], "--") != 0)
+	{
+		argIndex++;
+	}
+	int numPaths = argIndex - firstPath;
+	if (usageError == FALSE && (numPaths == 0 || args[argIndex] == NULL || args[argIndex + 1] == NULL))
+	{
+		usageError = TRUE;
+	}
+	else if (usageError == FALSE && (strcmp(args[argIndex + 1], "exit") == 0 || strcmp(args[argIndex + 1], "watch") == 0))
+	{
+		fprintf(stderr, "watch: %s: cannot be run by watch\n", args[argIndex + 1]); fflush(stderr);
+		usageError = TRUE;
+	}
+
+	if (usageError == TRUE)
+	{
+		fprintf(stderr, "usage: watch [-d debounce] [-s signal] path... -- command [args...]\n"); fflush(stderr);
+		setUsageError(lastFgStatus);
+	}
+
+	/* Otherwise, watch with a copy of the command, which always runs in the foreground. */
+	else
+	{
+		struct CommandInfo* command = copyCommand(myCommand, argIndex + 1);
+		command->backgroundFlag = FALSE;
+		runWatch(command, args + firstPath, numPaths, &run, lastFgStatus, bgCommandsList);
+		deleteCommand(command);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshAlias
+ * Description:	Built-in alias function. Receives the command's args. With no args,
+ * 		prints every alias. "alias NAME=word..." defines NAME as the words
+ * 		after the "=" (the rest of the line, since words cannot be quoted),
+ * 		and "alias NAME..." prints the named aliases. Returns nothing.
+ **************************************************************************************/
+
+void smallshAlias(char** args)
+{
+	if (args[1] == NULL)
+	{
+		printAliases();
+		return;
+	}
+
+	/* Define an alias from the rest of the line. */
+	char* equals = strchr(args[1], '=');
+	if (equals != NULL)
+	{
+		*equals = '\0';
+		if (isValidAliasName(args[1]) == FALSE)
+		{
+			fprintf(stderr, "alias: %s: invalid alias name\n", args[1]); fflush(stderr);
+		}
+
+		/* The value is the word after the "=" (if it is not empty) followed by the remaining args. */
+		else if (equals[1] != '\0')
+		{
+			char* name = args[1];
+			args[1] = equals + 1;
+			setAlias(name, args + 1);
+		}
+		else
+		{
+			setAlias(args[1], args + 2);
+		}
+		return;
+	}
+
+	/* Otherwise, print each named alias. */
+	for (int i = 1; args[i] != NULL; i++)
+	{
+		struct Alias* alias = getAlias(args[i], strlen(args[i]));
+		if (alias == NULL)
+		{
+			fprintf(stderr, "alias: %s: not found\n", args[i]); fflush(stderr);
+		}
+		else
+		{
+			printAlias(alias);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: smallshUnalias
+ * Description:	Built-in unalias function. Receives the command's args. Removes each
+ * 		named alias, or every alias if the first arg is "-a".
+ * 		Returns nothing.
+ **************************************************************************************/
+
+void smallshUnalias(char** args)
+{
+	if (args[1] != NULL && strcmp(args[1], "-a") == 0)
+	{
+		clearAliases();
+		return;
+	}
+	for (int i = 1; args[i] != NULL; i++)
+	{
+		if (unsetAlias(args[i]) == FALSE)
+		{
+			fprintf(stderr, "unalias: %s: not found\n", args[i]); fflush(stderr);
+		}
 	}
 }
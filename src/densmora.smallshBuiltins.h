@@ -11,9 +11,57 @@
 
 /* My own header file inclusion. */
 #include "densmora.childProcesses.h"
+#include "densmora.resultCache.h"
+#include "densmora.bench.h"
+#include "densmora.aliases.h"
+#include "densmora.batch.h"
+#include "densmora.shellRedirections.h"
+#include "densmora.jobGraph.h"
+#include "densmora.watch.h"
+
+/* Longest duration (in seconds) accepted by the timeout built-in. */
+#define MAX_TIMEOUT_SECONDS 1000000000.0
+
+/* Struct storing what a running wait built-in is waiting for and what it has seen finish. */
+
+struct WaitRequest
+{
+	int waitForAny;			/* Set to TRUE for "wait -n" (return when any job finishes). */
+	int numPids;			/* Number of pids given as arguments (0 to wait for all jobs). */
+	pid_t* pids;			/* Pids given as arguments. */
+	int* finished;			/* Flag for each pid indicating whether it has finished. */
+	int* exitMethods;		/* Exit method of each pid that has finished. */
+	int anyFinished;		/* Set to TRUE once any job has finished. */
+	int lastExitMethod;		/* Exit method of the most recent job to finish. */
+};
 
 /* Function prototypes */
 void smallshCd(char* cdPath);
 void smallshStatus(struct ForegroundExitMethod* lastFgStatus);
+void smallshWait(char** args, struct ForegroundExitMethod* lastFgStatus, struct BackgroundCommands* bgCommandsList);
+void observeWaitReap(pid_t pid, int childExitMethod, void* arg);
+int waitIsSatisfied(struct WaitRequest* request, struct BackgroundCommands* bgCommandsList);
+void smallshTimeout(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		    struct BackgroundCommands* bgCommandsList);
+long parseDuration(char* durationString);
+int parseSignal(char* signalString);
+int isBuiltinName(char* name);
+void setUsageError(struct ForegroundExitMethod* lastFgStatus);
+void smallshJoblog(char** args);
+void smallshStats(char** args);
+void smallshExport(char** args);
+void smallshUnset(char** args);
+int isValidEnvName(char* name);
+void smallshCached(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus);
+void smallshBench(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus);
+void smallshBatch(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList);
+void smallshExec(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus);
+void smallshAfter(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList);
+void smallshWatch(struct CommandInfo* myCommand, struct ForegroundExitMethod* lastFgStatus,
+		  struct BackgroundCommands* bgCommandsList);
+void smallshAlias(char** args);
+void smallshUnalias(char** args);
 
 #endif
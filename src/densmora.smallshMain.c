@@ -7,21 +7,44 @@
  * 		requesting creation of new ForegroundExitMethod, BackgroundCommands,
  * 		and CommandInfo structs; determining which functions should process
  * 		each command; and freeing dynamically-allocated memory. Receives
- * 		no arguments when program is started from  command line. Returns 0
- * 		to indicate successful smallsh exit.
+ * 		no arguments when program is started from  command line, or
+ * 		"--serve path" to run as a job-execution server on the Unix domain
+ * 		socket at path instead of prompting (see densmora.daemon.c), or
+ * 		"--jobs path..." to print the jobs on the job status boards at the
+ * 		given paths and exit (see densmora.jobBoard.c).
+ * 		Returns 0 to indicate successful smallsh exit.
  **************************************************************************************/
 
 /* My own header file inclusions. */
 #include "densmora.commands.h"
 #include "densmora.smallshBuiltins.h"
+#include "densmora.commandLists.h"
+#include "densmora.script.h"
 #include "densmora.signalHandlers.h"
+#include "densmora.eventLog.h"
+#include "densmora.shellStats.h"
+#include "densmora.daemon.h"
+#include "densmora.jobBoard.h"
+#include "densmora.jobserver.h"
 
 /* Implementation of main function (see description at top of file). */
 
-int main()
+int main(int argc, char* argv[])
 {
 	int timeToExit = FALSE;			/* Flag set to TRUE once user enters "exit" command. */
+	struct ScriptBuffer scriptBuffer = { NULL, 0 };	/* Lines of a block still being typed. */
+	struct timespec mainStart;		/* Time at which the shell started, for measuring startup. */
+	clock_gettime(CLOCK_MONOTONIC, &mainStart);
+
+	/* If asked to read job status boards, print them and exit without starting the shell. */
+	if (argc >= 3 && strcmp(argv[1], "--jobs") == 0)
+	{
+		return printJobBoards(argc - 2, argv + 2);
+	}
 	
+	/* Keep a copy of stdout for the prompt and notices, so that exec > file redirects only commands. */
+	initShellOutput();
+
 	/* Set global foregroundActive flag to FALSE at beginning of execution of program. */
 	foregroundActive = FALSE;
 
@@ -37,79 +60,85 @@ int main()
 	/* Call initializeSignalHandlers() function to define how the parent shell should handle
 	 * SIGINT and SIGTSTP signals. */
 	initializeSignalHandlers();
+
+	/* Load the environment passed to child processes, and create the empty alias table. */
+	initEnvironment();
+	initAliases();
+
+	/* Open the event log if one was requested through the environment. */
+	initEventLog();
+
+	/* Create the event loop and its timers, read the output capture settings, reset stats (opening
+	 * the stats socket if one was requested), join or create a jobserver, and read the limits on
+	 * background launches. */
+	initEventLoop();
+	initTimers();
+	initJobLogs();
+	initShellStats(bgCommandsList);
+	initJobserver();
+	initAdmission(bgCommandsList);
+
+	/* Create the job status board if one was requested. */
+	initJobBoard();
+
+	/* Create the self-pipe through which SIGCHLD wakes the event loop. */
+	initializeSIGCHLDPipe();
+
+	/* If asked to serve, run the job-execution server instead of prompting for commands,
+	 * and free memory and kill any jobs still running once it stops. */
+	if (argc == 3 && strcmp(argv[1], "--serve") == 0)
+	{
+		int serveResult = runDaemon(argv[2], bgCommandsList);
+		closeAdmission();
+		free(lastFgStatus);
+		deleteBackgroundCommands(bgCommandsList);
+		closeJobserver();
+		closeEventLog();
+		closeShellStats();
+		closeJobLogs();
+		closeJobBoard();
+		return serveResult;
+	}
 	
+	/* Run the startup file (which may define aliases or even exit), and note how long it took to get here. */
+	timeToExit = runStartupFile(lastFgStatus, bgCommandsList);
+	recordStartup(&mainStart);
+
 	/* Iterate repeatedly to get new user commands until user chooses to exit. */
 	while (timeToExit == FALSE)
 	{
-		/* Declare CommandInfo struct pointer,
-		 * initializing it with pointer returned by newCommand function. */
-		struct CommandInfo* myCommand = newCommand(bgCommandsList);
-		
-		/* If user has chosen to exit, set timeToExit to TRUE and free dynamically-allocated memory. */
-		if (strcmp(myCommand->commandArgs[0], "exit") == 0)
-		{
-			/* Set timeToExit flag to TRUE and delete myCOmmand. */
-			timeToExit = TRUE;
-			
-			/* Free memory associated with lastFgStatus and bgCommandsList. */
-			free(lastFgStatus);
-			lastFgStatus = NULL;
-			deleteBackgroundCommands(bgCommandsList);
-			bgCommandsList = NULL;
-		}
+		/* Declare CommandInfo struct pointer, and read the next line into its commandLine
+		 * (prompting with "> " if it continues a block). */
+		struct CommandInfo* myCommand = allocateCommand();
+		getCommandLine(myCommand, bgCommandsList, (isScriptIncomplete(&scriptBuffer) == TRUE) ? "> " : ": ");
 		
-		/* Otherwise, if user has entered "cd" as first word of command line,
-		 * call built-in cd function. */
-		else if (strcmp(myCommand->commandArgs[0], "cd") == 0)
-		{
-			/* Call built-in cd function, passing argument stored at commandArgs[1].
-			 * Since commandArgs[0] contains the "cd" command itself, commandArgs[1] will
-			 * either contain a pathname or a NULL pointer since an index containing a NULL
-			 * pointer is always at the end of commandArgs for purposes of calling execvp(). */
-			smallshCd(myCommand->commandArgs[1]);
-		}
-
-		/* Otherwise, if user has entered "status" as first word on the command line,
-		 * call built-in status function, passing it lastFgStatus.  */
-		else if (strcmp(myCommand->commandArgs[0], "status") == 0)
-		{
-			smallshStatus(lastFgStatus);
-		}
-		
-		/* Otherwise, if the user has requested that this command be run in the background
-		 * and background commands are currently allowed, run it in the background. */
-		else if (myCommand->backgroundFlag == TRUE && allowBackgroundCommands == TRUE)
-		{
-			runBackground(myCommand, bgCommandsList);
-		}
-
-		/* Otherwise, since this is either a foreground command or one requested
-		 * to be run in the backgroud but unable to be run there due to status of allowBackgroundCOmmands flag,
-		 * run the requested command in the foreground. */
-		else
-		{
-			/* Set foregroundActive to TRUE, run foreground command,
-			 * and then reset foregroundActive to FALSE. */
-			foregroundActive = TRUE;
-			runForeground(myCommand, lastFgStatus);
-			foregroundActive = FALSE;
-
-			/* If sigtstpDuringForegroundProcess is TRUE,
-			 * set global flag to FALSE and raise the SIGTSTP signal
-			 * so that background command permissions are toggled
-			 * and message is printed by signal handler. */
-			if (sigtstpDuringForegroundProcess == TRUE)
-			{
-				raise(SIGTSTP);
-				sigtstpDuringForegroundProcess = FALSE;
-			}
-		}
+		/* Run the line (or the block it completes), setting timeToExit to TRUE if a command was "exit". */
+		timeToExit = runScriptLine(&scriptBuffer, myCommand->commandLine, lastFgStatus, bgCommandsList);
 		
 		/* Delete the command just processed in preparation for next iteration. */
 		deleteCommand(myCommand);
 		myCommand = NULL;
 	}
 
+	/* Now that the user has chosen to exit, discard any delayed launches, and free memory associated
+	 * with functions, lastFgStatus, and bgCommandsList. */
+	closeAdmission();
+	clearScriptFunctions();
+	free(lastFgStatus);
+	lastFgStatus = NULL;
+	deleteBackgroundCommands(bgCommandsList);
+	bgCommandsList = NULL;
+
+	/* Leave or remove the jobserver, now that every job has given back its token. */
+	closeJobserver();
+
+	/* Flush any remaining events, close the event log and stats socket, free captured output,
+	 * and remove the job status board. */
+	closeEventLog();
+	closeShellStats();
+	closeJobLogs();
+	closeJobBoard();
+
 	/* Now that loop has exited since user typed "exit" as first word of command line,
 	 * return 0 to terminate shell and indicate successful execution to operating system. */
 	return 0;
@@ -0,0 +1,338 @@
+/***************************************************************************************
+ * File: densmora.timers.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of functions that manage
+ * 		deadlines in a binary min-heap ordered by expiry time, driven by a
+ * 		single timerfd that the event loop watches. Also contains the
+ * 		functions used by the timeout built-in to signal commands that run
+ * 		past their deadline and escalate to SIGKILL after a grace period.
+ **************************************************************************************/
+
+#include "densmora.timers.h"
+
+/* Heap of pending timers (earliest deadline at index 0) and the timerfd armed for its root. */
+static struct Timer** timerHeap = NULL;
+static int numTimers = 0;
+static int timerCapacity = 0;
+static int timerFd = -1;
+
+
+/***************************************************************************************
+ * Function Name: initTimers
+ * Description:	Creates the timerfd and registers it with the event loop. Must be
+ * 		called after initEventLoop and before any timer is added. Receives
+ * 		and returns nothing.
+ **************************************************************************************/
+
+void initTimers()
+{
+	timerFd = raiseShellFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+	if (timerFd == -1)
+	{
+		perror("timerfd_create()"); fflush(stderr);
+		return;
+	}
+	addEventWatcher(timerFd, fireTimers, NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: addTimer
+ * Description:	Receives a delay in microseconds, a callback, and an argument for the
+ * 		callback. Adds a timer to the heap that calls callback(arg) from the
+ * 		event loop once the delay has passed, re-arming the timerfd if the
+ * 		new timer is now the earliest. Returns a pointer to the timer (needed
+ * 		to cancel it). The timer is freed after it fires.
+ **************************************************************************************/
+
+struct Timer* addTimer(long delayUsec, void (*callback)(void* arg), void* arg)
+{
+	/* Declare and allocate memory for new Timer, computing its absolute deadline. */
+	struct Timer* timer;
+	timer = (struct Timer*)malloc(sizeof(struct Timer));
+	clock_gettime(CLOCK_MONOTONIC, &timer->deadline);
+	timer->deadline.tv_sec += delayUsec / 1000000L;
+	timer->deadline.tv_nsec += (delayUsec % 1000000L) * 1000L;
+	if (timer->deadline.tv_nsec >= 1000000000L)
+	{
+		timer->deadline.tv_sec++;
+		timer->deadline.tv_nsec -= 1000000000L;
+	}
+	timer->callback = callback;
+	timer->arg = arg;
+
+	/* Grow the heap if it is full. */
+	if (numTimers == timerCapacity)
+	{
+		timerCapacity = (timerCapacity == 0) ? INITIAL_TIMER_CAPACITY : 2 * timerCapacity;
+		timerHeap = (struct Timer**)realloc(timerHeap, timerCapacity * sizeof(struct Timer*));
+	}
+
+	/* Add the timer at the bottom of the heap and move it up to its place. */
+	timer->heapIndex = numTimers;
+	timerHeap[numTimers++] = timer;
+	siftTimerUp(timer->heapIndex);
+
+	/* Re-arm the timerfd if this timer is now the earliest. */
+	if (timer->heapIndex == 0)
+	{
+		armTimerFd();
+	}
+	return timer;
+}
+
+
+/***************************************************************************************
+ * Function Name: cancelTimer
+ * Description:	Receives a pointer to a pending timer. Removes it from the heap
+ * 		without calling its callback and frees it. Returns nothing.
+ **************************************************************************************/
+
+void cancelTimer(struct Timer* timer)
+{
+	int index = timer->heapIndex;
+
+	/* Replace the timer with the last one in the heap, and move that one to its place. */
+	numTimers--;
+	if (index != numTimers)
+	{
+		timerHeap[index] = timerHeap[numTimers];
+		timerHeap[index]->heapIndex = index;
+		siftTimerUp(index);
+		siftTimerDown(timerHeap[index]->heapIndex);
+	}
+
+	/* Re-arm the timerfd in case the earliest timer changed. */
+	if (index == 0)
+	{
+		armTimerFd();
+	}
+	free(timer);
+}
+
+
+/***************************************************************************************
+ * Function Name: fireTimers
+ * Description:	Event loop callback for the timerfd. Receives the descriptor and an
+ * 		unused argument. Removes every timer whose deadline has passed from the
+ * 		heap and calls its callback (which may add new timers), then re-arms
+ * 		the timerfd for the earliest remaining timer. Returns nothing.
+ **************************************************************************************/
+
+void fireTimers(int fd, void* arg)
+{
+	unsigned long long expirations;
+	struct timespec now;
+
+	/* Clear the timerfd's expiration count. */
+	read(fd, &expirations, sizeof(expirations));
+
+	/* Fire timers in deadline order until the earliest one is still in the future. */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	while (numTimers > 0
+	       && (timerHeap[0]->deadline.tv_sec < now.tv_sec
+		   || (timerHeap[0]->deadline.tv_sec == now.tv_sec && timerHeap[0]->deadline.tv_nsec <= now.tv_nsec)))
+	{
+		/* Remove the earliest timer from the heap before calling its callback,
+		 * so that the callback may safely add or cancel other timers. */
+		struct Timer* expiredTimer = timerHeap[0];
+		numTimers--;
+		if (numTimers > 0)
+		{
+			timerHeap[0] = timerHeap[numTimers];
+			timerHeap[0]->heapIndex = 0;
+			siftTimerDown(0);
+		}
+		expiredTimer->callback(expiredTimer->arg);
+		free(expiredTimer);
+	}
+
+	/* Arm the timerfd for whatever timer is now earliest. */
+	armTimerFd();
+}
+
+
+/***************************************************************************************
+ * Function Name: armTimerFd
+ * Description:	Arms the timerfd to expire at the deadline of the earliest timer,
+ * 		or disarms it if there are no timers. Receives and returns nothing.
+ **************************************************************************************/
+
+void armTimerFd()
+{
+	struct itimerspec setting;
+	memset(&setting, 0, sizeof(struct itimerspec));
+	if (numTimers > 0)
+	{
+		setting.it_value = timerHeap[0]->deadline;
+
+		/* An all-zero it_value would disarm the timer, so make sure it is never zero. */
+		if (setting.it_value.tv_sec == 0 && setting.it_value.tv_nsec == 0)
+		{
+			setting.it_value.tv_nsec = 1;
+		}
+	}
+	timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &setting, NULL);
+}
+
+
+/***************************************************************************************
+ * Function Name: swapTimers
+ * Description:	Receives two heap indices. Swaps the timers at those indices, keeping
+ * 		their heapIndex members up to date. Returns nothing.
+ **************************************************************************************/
+
+void swapTimers(int indexA, int indexB)
+{
+	struct Timer* temp = timerHeap[indexA];
+	timerHeap[indexA] = timerHeap[indexB];
+	timerHeap[indexB] = temp;
+	timerHeap[indexA]->heapIndex = indexA;
+	timerHeap[indexB]->heapIndex = indexB;
+}
+
+
+/***************************************************************************************
+ * Function Name: timerIsEarlier
+ * Description:	Receives two heap indices. Returns TRUE if the timer at indexA expires
+ * 		before the timer at indexB, or FALSE otherwise.
+ **************************************************************************************/
+
+static int timerIsEarlier(int indexA, int indexB)
+{
+	struct timespec* a = &timerHeap[indexA]->deadline;
+	struct timespec* b = &timerHeap[indexB]->deadline;
+	return (a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec)) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: siftTimerUp
+ * Description:	Receives a heap index. Moves the timer at that index toward the root
+ * 		until its parent expires no later than it does. Returns nothing.
+ **************************************************************************************/
+
+void siftTimerUp(int index)
+{
+	while (index > 0 && timerIsEarlier(index, (index - 1) / 2) == TRUE)
+	{
+		swapTimers(index, (index - 1) / 2);
+		index = (index - 1) / 2;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: siftTimerDown
+ * Description:	Receives a heap index. Moves the timer at that index away from the
+ * 		root until neither child expires before it does. Returns nothing.
+ **************************************************************************************/
+
+void siftTimerDown(int index)
+{
+	while (TRUE)
+	{
+		/* Find the earliest of the timer and its children. */
+		int earliest = index;
+		int left = 2 * index + 1;
+		int right = 2 * index + 2;
+		if (left < numTimers && timerIsEarlier(left, earliest) == TRUE)
+		{
+			earliest = left;
+		}
+		if (right < numTimers && timerIsEarlier(right, earliest) == TRUE)
+		{
+			earliest = right;
+		}
+
+		/* Stop once the timer is in place, and otherwise swap it with its earliest child. */
+		if (earliest == index)
+		{
+			return;
+		}
+		swapTimers(index, earliest);
+		index = earliest;
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: startJobTimeout
+ * Description:	Receives the pid of a command started by the timeout built-in and the
+ * 		limits that were requested. Allocates a JobTimeout and starts a timer
+ * 		that signals the command once its duration passes. Returns a pointer
+ * 		to the JobTimeout, which must be stopped with stopJobTimeout once the
+ * 		command has been reaped.
+ **************************************************************************************/
+
+struct JobTimeout* startJobTimeout(pid_t pid, struct TimeoutRequest* request)
+{
+	/* Declare and allocate memory for new JobTimeout. */
+	struct JobTimeout* jobTimeout;
+	jobTimeout = (struct JobTimeout*)malloc(sizeof(struct JobTimeout));
+	jobTimeout->pid = pid;
+	jobTimeout->signal = request->signal;
+	jobTimeout->graceUsec = request->graceUsec;
+	jobTimeout->expired = FALSE;
+
+	/* Start the timer for the command's deadline. */
+	jobTimeout->timer = addTimer(request->durationUsec, expireJobTimeout, jobTimeout);
+	return jobTimeout;
+}
+
+
+/***************************************************************************************
+ * Function Name: expireJobTimeout
+ * Description:	Timer callback for a command's deadline. Receives the JobTimeout.
+ * 		Sends the requested signal to the command, marks it as expired, and
+ * 		starts the grace period timer if one was requested. Returns nothing.
+ **************************************************************************************/
+
+void expireJobTimeout(void* arg)
+{
+	struct JobTimeout* jobTimeout = (struct JobTimeout*)arg;
+
+	kill(jobTimeout->pid, jobTimeout->signal);
+	jobTimeout->expired = TRUE;
+	jobTimeout->timer = NULL;
+
+	/* Escalate to SIGKILL once the grace period passes (unless the signal already was SIGKILL). */
+	if (jobTimeout->graceUsec > 0 && jobTimeout->signal != SIGKILL)
+	{
+		jobTimeout->timer = addTimer(jobTimeout->graceUsec, killJobAfterGrace, jobTimeout);
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: killJobAfterGrace
+ * Description:	Timer callback for the end of a grace period. Receives the JobTimeout.
+ * 		Sends SIGKILL to the command, which has not exited since it was
+ * 		signaled. Returns nothing.
+ **************************************************************************************/
+
+void killJobAfterGrace(void* arg)
+{
+	struct JobTimeout* jobTimeout = (struct JobTimeout*)arg;
+
+	kill(jobTimeout->pid, SIGKILL);
+	jobTimeout->timer = NULL;
+}
+
+
+/***************************************************************************************
+ * Function Name: stopJobTimeout
+ * Description:	Receives a JobTimeout whose command has been reaped. Cancels its
+ * 		pending timer (so that a recycled pid is never signaled) and frees
+ * 		it. Returns nothing.
+ **************************************************************************************/
+
+void stopJobTimeout(struct JobTimeout* jobTimeout)
+{
+	if (jobTimeout->timer != NULL)
+	{
+		cancelTimer(jobTimeout->timer);
+	}
+	free(jobTimeout);
+}
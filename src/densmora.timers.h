@@ -0,0 +1,72 @@
+/***************************************************************************************
+ * File: densmora.timers.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions that manage deadlines. All deadlines are kept in one
+ * 		binary min-heap, and a single timerfd watched by the event loop is
+ * 		always armed for the earliest one. See densmora.timers.c for function
+ * 		implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_TIMERS
+#define DENSMORA_TIMERS
+
+/* Built-in header file inclusions. */
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/timerfd.h>
+
+/* My own header file inclusions. */
+#include "densmora.smallshConstants.h"
+#include "densmora.eventLoop.h"
+
+/* Initial number of entries allocated for the timer heap (it grows as needed). */
+#define INITIAL_TIMER_CAPACITY 64
+
+/* Struct storing a single deadline and the function to call (with arg) once it passes. */
+
+struct Timer
+{
+	struct timespec deadline;		/* Time (CLOCK_MONOTONIC) at which the timer expires. */
+	void (*callback)(void* arg);		/* Function called when the timer expires. */
+	void* arg;				/* Argument passed to callback. */
+	int heapIndex;				/* Position of the timer in the heap. */
+};
+
+/* Struct storing the limits requested by the timeout built-in. */
+
+struct TimeoutRequest
+{
+	int signal;				/* Signal sent when the duration passes. */
+	long durationUsec;			/* Time the command may run before it is signaled. */
+	long graceUsec;				/* Time after signal before SIGKILL is sent (0 for never). */
+};
+
+/* Struct storing the deadline of one running command started by the timeout built-in. */
+
+struct JobTimeout
+{
+	pid_t pid;				/* Pid of the command. */
+	int signal;				/* Signal sent when the duration passes. */
+	long graceUsec;				/* Time after signal before SIGKILL is sent (0 for never). */
+	int expired;				/* Set to TRUE once the command has been signaled. */
+	struct Timer* timer;			/* Pending timer, or NULL if none is pending. */
+};
+
+/* Function prototypes (see densmora.timers.c for function descriptions and implementations). */
+void initTimers();
+struct Timer* addTimer(long delayUsec, void (*callback)(void* arg), void* arg);
+void cancelTimer(struct Timer* timer);
+void fireTimers(int fd, void* arg);
+void armTimerFd();
+void swapTimers(int indexA, int indexB);
+void siftTimerUp(int index);
+void siftTimerDown(int index);
+struct JobTimeout* startJobTimeout(pid_t pid, struct TimeoutRequest* request);
+void expireJobTimeout(void* arg);
+void killJobAfterGrace(void* arg);
+void stopJobTimeout(struct JobTimeout* jobTimeout);
+
+#endif
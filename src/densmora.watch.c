@@ -0,0 +1,498 @@
+/***************************************************************************************
+ * File: densmora.watch.c
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Implementation file containing definitions of the functions behind
+ * 		the watch built-in. Each directory given (and every directory under
+ * 		it, including ones created later) is watched with inotify, and each
+ * 		file given is watched through its directory, so that it is still
+ * 		seen after an editor replaces it. The inotify descriptor is watched
+ * 		in the event loop, so changes are seen while the command runs as
+ * 		well as between runs. The first change of a burst starts a timer,
+ * 		and every change until it fires is part of the same burst; the
+ * 		command then runs again through dispatchCommand like a line typed at
+ * 		the prompt, after the run still going (if any) is stopped. SIGINT
+ * 		stops watching.
+ **************************************************************************************/
+
+#include "densmora.watch.h"
+#include "densmora.dispatch.h"
+
+
+/***************************************************************************************
+ * Function Name: runWatch
+ * Description:	Receives the command to run, the paths to watch and their number, a
+ * 		WatchRun struct whose debounceUsec and signal are set, the
+ * 		ForegroundExitMethod struct, and the BackgroundCommands list. Runs
+ * 		the command, and then again after each burst of changes under the
+ * 		paths, until SIGINT is received. lastFgStatus is left holding the
+ * 		status of the last run, or exit value 1 if the paths cannot be
+ * 		watched. Returns nothing.
+ **************************************************************************************/
+
+void runWatch(struct CommandInfo* command, char** paths, int numPaths, struct WatchRun* run,
+	      struct ForegroundExitMethod* lastFgStatus, struct BackgroundCommands* bgCommandsList)
+{
+	long debounceUsec = run->debounceUsec;
+	int signal = run->signal;
+
+	memset(run, 0, sizeof(struct WatchRun));
+	run->command = command;
+	run->debounceUsec = debounceUsec;
+	run->signal = signal;
+
+	/* Watch every path, failing if any cannot be watched. */
+	run->inotifyFd = raiseShellFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+	if (run->inotifyFd == -1)
+	{
+		perror("watch: inotify_init1()"); fflush(stderr);
+		setExitMethod(lastFgStatus, 1 << 8);
+		return;
+	}
+	for (int i = 0; i < numPaths; i++)
+	{
+		if (addWatchedPath(run, paths[i]) == FALSE)
+		{
+			closeWatch(run);
+			setExitMethod(lastFgStatus, 1 << 8);
+			return;
+		}
+	}
+	run->inotifyWatcher = addEventWatcher(run->inotifyFd, readWatchEvents, run);
+
+	/* Run the command right away, and then again after each burst, sleeping in the event loop in
+	 * between (woken by SIGINT through the SIGCHLD self-pipe) until SIGINT is received. */
+	interruptOnSIGINT();
+	run->runPending = TRUE;
+	while (sigintReceived == FALSE)
+	{
+		if (run->runPending == TRUE)
+		{
+			runWatchedCommand(run, lastFgStatus, bgCommandsList);
+			continue;
+		}
+		if (run->sigchldWatcher == NULL)
+		{
+			run->sigchldWatcher = addEventWatcher(sigchldPipe[0], wakeOnChildExit, NULL);
+		}
+		runEventLoopOnce((run->sigchldWatcher != NULL) ? -1 : WATCH_POLL_MS);
+	}
+	ignoreSIGINT();
+	fprintf(shellOutput, "watch stopped\n"); fflush(shellOutput);
+	closeWatch(run);
+}
+
+
+/***************************************************************************************
+ * Function Name: addWatchedPath
+ * Description:	Receives a WatchRun struct and a path given to watch. Watches the
+ * 		path and every directory under it if it is a directory, or otherwise
+ * 		watches its directory for changes to its name (so the file need not
+ * 		exist yet). Returns TRUE, or FALSE (after reporting the error) if it
+ * 		cannot be watched.
+ **************************************************************************************/
+
+int addWatchedPath(struct WatchRun* run, char* path)
+{
+	struct stat info;
+	char dirPath[PATH_MAX];
+
+	if (stat(path, &info) == 0 && S_ISDIR(info.st_mode))
+	{
+		return addWatchedTree(run, path);
+	}
+
+	/* Split the path into its directory and name. */
+	char* slash = strrchr(path, '/');
+	char* name = (slash != NULL) ? slash + 1 : path;
+	if (slash == NULL)
+	{
+		strcpy(dirPath, ".");
+	}
+	else if (slash == path)
+	{
+		strcpy(dirPath, "/");
+	}
+	else if (slash - path < PATH_MAX)
+	{
+		memcpy(dirPath, path, slash - path);
+		dirPath[slash - path] = '\0';
+	}
+	if (name[0] == '\0' || (slash != NULL && slash - path >= PATH_MAX))
+	{
+		fprintf(stderr, "watch: %s: not a file or directory\n", path); fflush(stderr);
+		return FALSE;
+	}
+
+	struct WatchedDir* dir = addWatchedDir(run, dirPath, FALSE);
+	if (dir == NULL)
+	{
+		fprintf(stderr, "watch: %s: %s\n", path, strerror(errno)); fflush(stderr);
+		return FALSE;
+	}
+	dir->names = (char**)realloc(dir->names, (dir->numNames + 1) * sizeof(char*));
+	dir->names[dir->numNames++] = strdup(name);
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: addWatchedTree
+ * Description:	Receives a WatchRun struct and the path of a directory. Watches it and
+ * 		every directory under it (without following symbolic links or
+ * 		entering hidden directories), so that any change in them counts.
+ * 		Directories that cannot be watched are reported and skipped.
+ * 		Returns TRUE, or FALSE if the directory itself cannot be watched.
+ **************************************************************************************/
+
+int addWatchedTree(struct WatchRun* run, char* path)
+{
+	struct WatchedDir* dir = addWatchedDir(run, path, TRUE);
+	if (dir == NULL)
+	{
+		/* Only report running out of watches once, since every directory after would fail too. */
+		if (errno != ENOSPC)
+		{
+			fprintf(stderr, "watch: %s: %s\n", path, strerror(errno)); fflush(stderr);
+		}
+		else if (run->watchesExhausted == FALSE)
+		{
+			fprintf(stderr, "watch: %s: too many directories to watch (see fs.inotify.max_user_watches)\n", path);
+			fflush(stderr);
+			run->watchesExhausted = TRUE;
+		}
+		return FALSE;
+	}
+
+	/* A directory already watched as a whole has already been searched (it was given twice, or
+	 * was created and then found again while searching its parent). */
+	if (dir->wholeDir == TRUE)
+	{
+		return TRUE;
+	}
+	dir->wholeDir = TRUE;
+
+	/* Watch each directory under this one in turn. */
+	DIR* stream = opendir(path);
+	if (stream == NULL)
+	{
+		return TRUE;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(stream)) != NULL)
+	{
+		char childPath[PATH_MAX];
+		struct stat info;
+		if (isIgnoredName(entry->d_name) == TRUE
+		    || snprintf(childPath, sizeof(childPath), "%s/%s", path, entry->d_name) >= (int)sizeof(childPath))
+		{
+			continue;
+		}
+		if (entry->d_type == DT_DIR
+		    || (entry->d_type == DT_UNKNOWN && lstat(childPath, &info) == 0 && S_ISDIR(info.st_mode)))
+		{
+			addWatchedTree(run, childPath);
+		}
+	}
+	closedir(stream);
+	return TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: addWatchedDir
+ * Description:	Receives a WatchRun struct, the path of a directory, and a flag
+ * 		indicating whether directories created in it should be watched too.
+ * 		Adds an inotify watch for it, or finds the entry of the directory if
+ * 		it is already watched (inotify returns the same watch descriptor).
+ * 		Returns the entry, or NULL (with errno set) if it cannot be watched.
+ **************************************************************************************/
+
+struct WatchedDir* addWatchedDir(struct WatchRun* run, char* path, int recursive)
+{
+	int wd = inotify_add_watch(run->inotifyFd, path, WATCH_EVENT_MASK | IN_ONLYDIR);
+	if (wd == -1)
+	{
+		return NULL;
+	}
+
+	/* Watch descriptors are small numbers handed out in increasing order, so they index dirs directly. */
+	if (wd >= run->dirsCapacity)
+	{
+		int newCapacity = (run->dirsCapacity == 0) ? 64 : run->dirsCapacity;
+		while (newCapacity <= wd)
+		{
+			newCapacity *= 2;
+		}
+		run->dirs = (struct WatchedDir**)realloc(run->dirs, newCapacity * sizeof(struct WatchedDir*));
+		memset(run->dirs + run->dirsCapacity, 0, (newCapacity - run->dirsCapacity) * sizeof(struct WatchedDir*));
+		run->dirsCapacity = newCapacity;
+	}
+	if (run->dirs[wd] == NULL)
+	{
+		struct WatchedDir* dir = (struct WatchedDir*)calloc(1, sizeof(struct WatchedDir));
+		dir->path = strdup(path);
+		run->dirs[wd] = dir;
+		run->numDirs++;
+	}
+	if (recursive == TRUE)
+	{
+		run->dirs[wd]->recursive = TRUE;
+	}
+	return run->dirs[wd];
+}
+
+
+/***************************************************************************************
+ * Function Name: isIgnoredName
+ * Description:	Receives the name of a directory entry. Returns TRUE if changes to it
+ * 		do not count unless it was given by name: it is "." or "..", hidden
+ * 		(such as .git or an editor's swap file), or an editor's backup file
+ * 		(ending in ~). Returns FALSE otherwise.
+ **************************************************************************************/
+
+int isIgnoredName(char* name)
+{
+	size_t length = strlen(name);
+	return (name[0] == '.' || (length > 0 && name[length - 1] == '~')) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: readWatchEvents
+ * Description:	Event loop callback for the inotify descriptor. Receives the
+ * 		descriptor and the WatchRun struct. Reads every pending event,
+ * 		watching directories created under recursively watched ones,
+ * 		forgetting directories whose watch has ended, and noting each change
+ * 		that counts. Returns nothing.
+ **************************************************************************************/
+
+void readWatchEvents(int fd, void* arg)
+{
+	struct WatchRun* run = (struct WatchRun*)arg;
+	static char buffer[WATCH_READ_BYTES] __attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t bytesRead;
+
+	while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+	{
+		char* next = buffer;
+		while (next < buffer + bytesRead)
+		{
+			struct inotify_event* event = (struct inotify_event*)next;
+			next += sizeof(struct inotify_event) + event->len;
+
+			/* If events were lost, anything may have changed. */
+			if ((event->mask & IN_Q_OVERFLOW) != 0)
+			{
+				noteWatchChange(run, NULL, "(too many changes to list)");
+				continue;
+			}
+			if (event->wd < 0 || event->wd >= run->dirsCapacity || run->dirs[event->wd] == NULL)
+			{
+				continue;
+			}
+			struct WatchedDir* dir = run->dirs[event->wd];
+
+			/* Forget a directory that was removed (its watch has ended). */
+			if ((event->mask & IN_IGNORED) != 0)
+			{
+				deleteWatchedDir(dir);
+				run->dirs[event->wd] = NULL;
+				run->numDirs--;
+				continue;
+			}
+			if (isWatchedChange(dir, event) == FALSE)
+			{
+				continue;
+			}
+
+			/* Watch directories created in (or moved into) a recursively watched one. */
+			if ((event->mask & IN_ISDIR) != 0 && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0
+			    && dir->recursive == TRUE && event->len > 0)
+			{
+				char childPath[PATH_MAX];
+				if (snprintf(childPath, sizeof(childPath), "%s/%s", dir->path, event->name) < (int)sizeof(childPath))
+				{
+					addWatchedTree(run, childPath);
+				}
+			}
+			noteWatchChange(run, dir, (event->len > 0) ? event->name : NULL);
+		}
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: isWatchedChange
+ * Description:	Receives a watched directory and an event in it. Returns TRUE if the
+ * 		change counts: it is to a file given by name, or to any entry (other
+ * 		than an ignored one) or the directory itself if the whole directory
+ * 		is watched. Returns FALSE otherwise.
+ **************************************************************************************/
+
+int isWatchedChange(struct WatchedDir* dir, struct inotify_event* event)
+{
+	if (event->len == 0)
+	{
+		return dir->wholeDir;
+	}
+	for (int i = 0; i < dir->numNames; i++)
+	{
+		if (strcmp(dir->names[i], event->name) == 0)
+		{
+			return TRUE;
+		}
+	}
+	return (dir->wholeDir == TRUE && isIgnoredName(event->name) == FALSE) ? TRUE : FALSE;
+}
+
+
+/***************************************************************************************
+ * Function Name: noteWatchChange
+ * Description:	Receives a WatchRun struct, the directory in which a change was seen
+ * 		(or NULL), and the name of the entry that changed (or NULL if it was
+ * 		the directory itself). Starts a burst, remembering the path for the
+ * 		user, unless one is already under way. Returns nothing.
+ **************************************************************************************/
+
+void noteWatchChange(struct WatchRun* run, struct WatchedDir* dir, char* name)
+{
+	if (run->debounceTimer != NULL)
+	{
+		return;
+	}
+	if (dir == NULL)
+	{
+		snprintf(run->changedPath, sizeof(run->changedPath), "%s", name);
+	}
+	else if (name == NULL)
+	{
+		snprintf(run->changedPath, sizeof(run->changedPath), "%s", dir->path);
+	}
+	else
+	{
+		snprintf(run->changedPath, sizeof(run->changedPath), "%s/%s", dir->path, name);
+	}
+	run->debounceTimer = addTimer(run->debounceUsec, endWatchBurst, run);
+}
+
+
+/***************************************************************************************
+ * Function Name: endWatchBurst
+ * Description:	Timer callback ending a burst of changes. Receives the WatchRun
+ * 		struct. Tells the user what changed and has the command run again,
+ * 		first sending the run still going in the foreground (if any) the
+ * 		signal given with -s. Returns nothing.
+ **************************************************************************************/
+
+void endWatchBurst(void* arg)
+{
+	struct WatchRun* run = (struct WatchRun*)arg;
+
+	/* The timer is freed once this returns. */
+	run->debounceTimer = NULL;
+
+	if (run->running == TRUE && foregroundPid != 0)
+	{
+		fprintf(shellOutput, "watch: %s changed, stopping pid %d\n", run->changedPath, (int)foregroundPid); fflush(shellOutput);
+		kill(foregroundPid, run->signal);
+	}
+	else
+	{
+		fprintf(shellOutput, "watch: %s changed\n", run->changedPath); fflush(shellOutput);
+	}
+	run->runPending = TRUE;
+}
+
+
+/***************************************************************************************
+ * Function Name: runWatchedCommand
+ * Description:	Receives a WatchRun struct, the ForegroundExitMethod struct, and the
+ * 		BackgroundCommands list. Runs a fresh copy of the command (built-ins
+ * 		may change their args) in the foreground through dispatchCommand,
+ * 		storing its status in lastFgStatus. Changes seen meanwhile are still
+ * 		read by the event loop while the shell waits for it. Returns nothing.
+ **************************************************************************************/
+
+void runWatchedCommand(struct WatchRun* run, struct ForegroundExitMethod* lastFgStatus,
+		       struct BackgroundCommands* bgCommandsList)
+{
+	/* Stop watching the self-pipe, which the shell watches itself while waiting for the command. */
+	if (run->sigchldWatcher != NULL)
+	{
+		removeEventWatcher(run->sigchldWatcher);
+		freeRemovedWatchers();
+		run->sigchldWatcher = NULL;
+	}
+
+	run->runPending = FALSE;
+	run->running = TRUE;
+	struct CommandInfo* command = copyCommand(run->command, 0);
+	dispatchCommand(command, lastFgStatus, bgCommandsList);
+	deleteCommand(command);
+	run->running = FALSE;
+
+	/* The command may have restored the shell's usual SIGINT handling (as built-ins that block do),
+	 * so have SIGINT stop watching again unless it already has. */
+	if (sigintReceived == FALSE)
+	{
+		interruptOnSIGINT();
+	}
+}
+
+
+/***************************************************************************************
+ * Function Name: deleteWatchedDir
+ * Description:	Receives a watched directory. Frees its memory. Returns nothing.
+ **************************************************************************************/
+
+void deleteWatchedDir(struct WatchedDir* dir)
+{
+	for (int i = 0; i < dir->numNames; i++)
+	{
+		free(dir->names[i]);
+	}
+	free(dir->names);
+	free(dir->path);
+	free(dir);
+}
+
+
+/***************************************************************************************
+ * Function Name: closeWatch
+ * Description:	Receives a WatchRun struct. Cancels the burst under way, stops
+ * 		watching its descriptors, closes the inotify instance (which removes
+ * 		every watch), and frees the directories. Returns nothing.
+ **************************************************************************************/
+
+void closeWatch(struct WatchRun* run)
+{
+	if (run->debounceTimer != NULL)
+	{
+		cancelTimer(run->debounceTimer);
+		run->debounceTimer = NULL;
+	}
+	if (run->inotifyWatcher != NULL)
+	{
+		removeEventWatcher(run->inotifyWatcher);
+		run->inotifyWatcher = NULL;
+	}
+	if (run->sigchldWatcher != NULL)
+	{
+		removeEventWatcher(run->sigchldWatcher);
+		run->sigchldWatcher = NULL;
+	}
+	freeRemovedWatchers();
+	close(run->inotifyFd);
+	for (int i = 0; i < run->dirsCapacity; i++)
+	{
+		if (run->dirs[i] != NULL)
+		{
+			deleteWatchedDir(run->dirs[i]);
+		}
+	}
+	free(run->dirs);
+	run->dirs = NULL;
+	run->dirsCapacity = 0;
+	run->numDirs = 0;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************************
+ * File: densmora.watch.h
+ * Author: Alexander Densmore
+ * Date: 10/18/26
+ * Description: Header file containing definitions of the structs and prototypes of
+ * 		the functions behind the watch built-in, which runs a command again
+ * 		each time files under the given paths change, as reported by
+ * 		inotify. See densmora.watch.c for function implementations.
+ **************************************************************************************/
+
+#ifndef DENSMORA_WATCH
+#define DENSMORA_WATCH
+
+/* Built-in header file inclusions. */
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+/* My own header file inclusions. */
+#include "densmora.childProcesses.h"
+#include "densmora.timers.h"
+#include "densmora.eventLoop.h"
+
+/* Default time (in microseconds) from the first change of a burst to the next run, during
+ * which further changes are gathered into the same run. */
+#define DEFAULT_WATCH_DEBOUNCE_USEC 100000L
+
+/* Changes reported by inotify that lead to a run: contents written or replaced, and entries
+ * created, removed, or renamed. */
+#define WATCH_EVENT_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM \
+			  | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+/* Size of the buffer into which events are read. */
+#define WATCH_READ_BYTES (64 * 1024)
+
+/* Milliseconds between checks for SIGINT while idle if the SIGCHLD self-pipe cannot be watched. */
+#define WATCH_POLL_MS 100
+
+/* Struct storing one directory watched with inotify. */
+
+struct WatchedDir
+{
+	char* path;				/* Path of the directory, as given or found under a given directory. */
+	int wholeDir;				/* Set to TRUE if any change in it counts (rather than only to names). */
+	int recursive;				/* Set to TRUE if directories created in it are watched as well. */
+	int numNames;				/* Number of files given as paths whose changes count. */
+	char** names;				/* Names (within the directory) of those files. */
+};
+
+/* Struct storing the state of a running watch built-in. */
+
+struct WatchRun
+{
+	struct CommandInfo* command;		/* Copy of the command to run, copied again for each run. */
+	long debounceUsec;			/* Time from the first change of a burst to the next run (-d). */
+	int signal;				/* Signal sent to a run still going when a change is seen (-s). */
+	int inotifyFd;				/* Inotify instance holding every watch. */
+	struct WatchedDir** dirs;		/* Watched directories, indexed by watch descriptor (NULL if unused). */
+	int dirsCapacity;			/* Number of elements allocated to dirs. */
+	int numDirs;				/* Number of directories watched. */
+	int watchesExhausted;			/* Set to TRUE once inotify has refused a watch for lack of room. */
+	struct Timer* debounceTimer;		/* Timer ending the current burst of changes, or NULL. */
+	char changedPath[PATH_MAX];		/* First path changed in the current burst. */
+	int runPending;				/* Set to TRUE once a burst has ended and the command should run. */
+	int running;				/* Set to TRUE while the command is running. */
+	struct EventWatcher* inotifyWatcher;	/* Event loop watcher of inotifyFd, or NULL. */
+	struct EventWatcher* sigchldWatcher;	/* Event loop watcher of the SIGCHLD self-pipe while idle, or NULL. */
+};
+
+/* Function prototypes (see densmora.watch.c for function descriptions and implementations). */
+void runWatch(struct CommandInfo* command, char** paths, int numPaths, struct WatchRun* run,
+	      struct ForegroundExitMethod* lastFgStatus, struct BackgroundCommands* bgCommandsList);
+int addWatchedPath(struct WatchRun* run, char* path);
+int addWatchedTree(struct WatchRun* run, char* path);
+struct WatchedDir* addWatchedDir(struct WatchRun* run, char* path, int recursive);
+int isIgnoredName(char* name);
+void readWatchEvents(int fd, void* arg);
+int isWatchedChange(struct WatchedDir* dir, struct inotify_event* event);
+void noteWatchChange(struct WatchRun* run, struct WatchedDir* dir, char* name);
+void endWatchBurst(void* arg);
+void runWatchedCommand(struct WatchRun* run, struct ForegroundExitMethod* lastFgStatus,
+		       struct BackgroundCommands* bgCommandsList);
+void deleteWatchedDir(struct WatchedDir* dir);
+void closeWatch(struct WatchRun* run);
+
+#endif